@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+服务器压力测试工具（负载生成器）
+
+用法示例:
+    # 建连速率: 8个进程持续"连接-断开"10秒，统计每秒建立连接数
+    python load_generator.py connect --procs 8 --duration 10
+
+    # 热重启验证: 持续"连接-发送-等待ACK"，期间执行 server --takeover，统计被拒绝次数
+    python load_generator.py churn --procs 4 --duration 30
+
+    # 推送扇出: 4个进程共建立10000个连接并订阅主题news，在服务器界面推送后统计每个连接的到达情况
+    python load_generator.py subscribe --procs 4 --connections 10000 --topic news --duration 60
+
+对比不同接收线程数时，分别以 `server --listen --acceptors K` 启动服务器后运行本工具。
+
+协议格式: [SOF(0xAA)] [VERSION(1)] [LENGTH(2,大端)] [PAYLOAD(n)] [CRC16(2,大端)] [EOF(0x55)]
+"""
+
+import argparse
+import multiprocessing
+import selectors
+import socket
+import struct
+import time
+
+
+def crc16_ccitt(data):
+    """CRC16-CCITT（多项式0x1021，初始值0xFFFF，与C++实现一致）"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= (byte << 8)
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = (crc << 1) ^ 0x1021
+            else:
+                crc <<= 1
+    return crc & 0xFFFF
+
+
+def create_frame(payload, version=0x01):
+    """按协议封装一帧"""
+    header_payload = bytes([version]) + struct.pack('>H', len(payload)) + payload
+    return bytes([0xAA]) + header_payload + struct.pack('>H', crc16_ccitt(header_payload)) + bytes([0x55])
+
+
+def connect_worker(host, port, duration, result_queue):
+    """单个进程内循环建立并关闭连接"""
+    ok = 0
+    refused = 0
+    failed = 0
+    deadline = time.perf_counter() + duration
+    while time.perf_counter() < deadline:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+        try:
+            sock.connect((host, port))
+            ok += 1
+        except ConnectionRefusedError:
+            refused += 1
+        except OSError:
+            failed += 1
+        finally:
+            sock.close()
+    result_queue.put((ok, refused, failed))
+
+
+def churn_worker(host, port, duration, result_queue):
+    """循环建立连接并完成一次请求/ACK往返，记录被拒绝与中断的次数"""
+    ok = 0
+    refused = 0
+    broken = 0
+    msg_id = 0
+    deadline = time.perf_counter() + duration
+    while time.perf_counter() < deadline:
+        msg_id = (msg_id + 1) & 0xFFFF
+        payload = bytes([0x01]) + struct.pack('>H', msg_id) + b"churn"
+        try:
+            with socket.create_connection((host, port), timeout=5.0) as sock:
+                sock.sendall(create_frame(payload))
+                if sock.recv(64):
+                    ok += 1
+                else:
+                    broken += 1
+        except ConnectionRefusedError:
+            refused += 1
+        except OSError:
+            broken += 1
+    result_queue.put((ok, refused, broken))
+
+
+def subscribe_worker(host, port, connections, topic, duration, result_queue):
+    """建立多个长连接并订阅主题，统计收到的推送帧(RespCode=0x80)数量"""
+    sel = selectors.DefaultSelector()
+    body = topic.encode('utf-8')
+    subscribe_frame = create_frame(bytes([0x11]) + struct.pack('>H', 1) + body)
+    opened = 0
+    for _ in range(connections):
+        try:
+            sock = socket.create_connection((host, port), timeout=5.0)
+        except OSError:
+            break
+        sock.sendall(subscribe_frame)
+        sock.setblocking(False)
+        sel.register(sock, selectors.EVENT_READ, {'buf': b'', 'notifies': 0})
+        opened += 1
+
+    deadline = time.perf_counter() + duration
+    while time.perf_counter() < deadline:
+        for key, _ in sel.select(timeout=0.5):
+            state = key.data
+            try:
+                chunk = key.fileobj.recv(65536)
+            except OSError:
+                chunk = b''
+            if not chunk:
+                sel.unregister(key.fileobj)
+                key.fileobj.close()
+                continue
+            buf = state['buf'] + chunk
+            while len(buf) >= 7:
+                length = struct.unpack('>H', buf[2:4])[0]
+                if len(buf) < 7 + length:
+                    break
+                if length > 0 and buf[4] == 0x80:
+                    state['notifies'] += 1
+                buf = buf[7 + length:]
+            state['buf'] = buf
+
+    counts = [key.data['notifies'] for key in sel.get_map().values()]
+    for key in list(sel.get_map().values()):
+        key.fileobj.close()
+    result_queue.put((opened, counts))
+
+
+def run_subscribe(args):
+    per_proc = max(1, args.connections // args.procs)
+    print(f"[推送] 目标 {args.host}:{args.port} 连接数={per_proc * args.procs} 主题='{args.topic}' "
+          f"时长={args.duration}s (连接较多时需先调高 ulimit -n)")
+    queue = multiprocessing.Queue()
+    procs = [multiprocessing.Process(target=subscribe_worker,
+                                     args=(args.host, args.port, per_proc, args.topic, args.duration, queue))
+             for _ in range(args.procs)]
+    for p in procs:
+        p.start()
+    results = [queue.get() for _ in procs]
+    for p in procs:
+        p.join()
+
+    opened = sum(r[0] for r in results)
+    counts = [c for r in results for c in r[1]]
+    if not counts:
+        print("  ✗ 没有存活的连接")
+        return
+    print(f"  建立连接: {opened}  存活: {len(counts)}")
+    print(f"  每连接收到推送: 最少 {min(counts)}  最多 {max(counts)}  合计 {sum(counts)}")
+
+
+def run_churn(args):
+    print(f"[热重启] 目标 {args.host}:{args.port} 进程数={args.procs} 时长={args.duration}s")
+    queue = multiprocessing.Queue()
+    procs = [multiprocessing.Process(target=churn_worker,
+                                     args=(args.host, args.port, args.duration, queue))
+             for _ in range(args.procs)]
+    for p in procs:
+        p.start()
+    results = [queue.get() for _ in procs]
+    for p in procs:
+        p.join()
+
+    ok = sum(r[0] for r in results)
+    refused = sum(r[1] for r in results)
+    broken = sum(r[2] for r in results)
+    print(f"  完成往返: {ok}  被拒绝: {refused}  中断/无响应: {broken}")
+    print("  ✓ 无拒绝连接" if refused == 0 else "  ✗ 出现被拒绝的连接")
+
+
+def run_connect(args):
+    print(f"[建连] 目标 {args.host}:{args.port} 进程数={args.procs} 时长={args.duration}s")
+    queue = multiprocessing.Queue()
+    procs = [multiprocessing.Process(target=connect_worker,
+                                     args=(args.host, args.port, args.duration, queue))
+             for _ in range(args.procs)]
+    start = time.perf_counter()
+    for p in procs:
+        p.start()
+    results = [queue.get() for _ in procs]
+    for p in procs:
+        p.join()
+    elapsed = time.perf_counter() - start
+
+    ok = sum(r[0] for r in results)
+    refused = sum(r[1] for r in results)
+    failed = sum(r[2] for r in results)
+    print(f"  成功连接: {ok}  被拒绝: {refused}  其他失败: {failed}")
+    print(f"  建连速率: {ok / elapsed:.0f} 连接/秒")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="C/S 服务器负载生成器")
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8080)
+    sub = parser.add_subparsers(dest='mode', required=True)
+
+    connect = sub.add_parser('connect', help='测量建连速率(连接/秒)')
+    connect.add_argument('--procs', type=int, default=4, help='并发进程数')
+    connect.add_argument('--duration', type=float, default=10.0, help='测试时长(秒)')
+    connect.set_defaults(func=run_connect)
+
+    churn = sub.add_parser('churn', help='热重启期间的连接拒绝统计')
+    churn.add_argument('--procs', type=int, default=4, help='并发进程数')
+    churn.add_argument('--duration', type=float, default=30.0, help='测试时长(秒)')
+    churn.set_defaults(func=run_churn)
+
+    subscribe = sub.add_parser('subscribe', help='大量订阅连接的推送扇出统计')
+    subscribe.add_argument('--procs', type=int, default=4, help='并发进程数')
+    subscribe.add_argument('--connections', type=int, default=10000, help='总连接数')
+    subscribe.add_argument('--topic', default='', help='订阅的主题，留空只接收广播')
+    subscribe.add_argument('--duration', type=float, default=60.0, help='测试时长(秒)')
+    subscribe.set_defaults(func=run_subscribe)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
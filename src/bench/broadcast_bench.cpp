@@ -0,0 +1,132 @@
+// 广播扇出基准：N个模拟会话分布在T个线程上，测量一次publish()的扇出耗时(编码一次+入队)
+// 与所有会话线程取到该帧的端到端耗时。会话只取帧不写socket，衡量的是服务器内部扇出开销。
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "broadcast_hub.hpp"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sessionsOption(QStringLiteral("sessions"), QStringLiteral("模拟会话数"), QStringLiteral("n"), QStringLiteral("10000"));
+    const QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("会话线程数"), QStringLiteral("n"), QStringLiteral("8"));
+    const QCommandLineOption messagesOption(QStringLiteral("messages"), QStringLiteral("推送次数"), QStringLiteral("n"), QStringLiteral("100"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("推送内容字节数"), QStringLiteral("bytes"), QStringLiteral("64"));
+    parser.addOption(sessionsOption);
+    parser.addOption(threadsOption);
+    parser.addOption(messagesOption);
+    parser.addOption(sizeOption);
+    parser.process(app);
+
+    const int sessions = qMax(1, parser.value(sessionsOption).toInt());
+    const int threadCount = qMax(1, parser.value(threadsOption).toInt());
+    const int messages = qMax(1, parser.value(messagesOption).toInt());
+    const QByteArray body(qMax(0, parser.value(sizeOption).toInt()), 'x');
+
+    BroadcastHub hub;
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.push_back(std::make_unique<QThread>());
+        threads.back()->start();
+    }
+
+    std::atomic<quint64> received{0};
+    std::atomic<quint64> sharedFrames{0};
+    std::atomic<const char *> currentData{nullptr};
+    std::vector<std::unique_ptr<QObject>> receivers(static_cast<std::size_t>(sessions));
+    std::vector<std::shared_ptr<BroadcastHub::Inbox>> inboxes(static_cast<std::size_t>(sessions));
+    for (int i = 0; i < sessions; ++i) {
+        const auto index = static_cast<std::size_t>(i);
+        receivers[index] = std::make_unique<QObject>();
+        receivers[index]->moveToThread(threads[index % threads.size()].get());
+        inboxes[index] = hub.attach(receivers[index].get(), [&inboxes, &received, &sharedFrames, &currentData, index]() {
+            QByteArray frame;
+            while (inboxes[index]->pop(&frame)) {
+                // 同一次推送所有会话取到的应是同一块内存：第一个取到的会话记下地址，其余与之比较
+                const char *first = nullptr;
+                currentData.compare_exchange_strong(first, frame.constData());
+                if (first == nullptr || first == frame.constData()) {
+                    sharedFrames.fetch_add(1, std::memory_order_relaxed);
+                }
+                received.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::vector<qint64> fanOutNs;
+    std::vector<qint64> endToEndNs;
+    QElapsedTimer timer;
+    quint64 expected = 0;
+    for (int m = 0; m < messages; ++m) {
+        currentData.store(nullptr);
+        timer.start();
+        const int recipients = hub.publish(QString(), body);
+        fanOutNs.push_back(timer.nsecsElapsed());
+        expected += static_cast<quint64>(recipients);
+        while (received.load(std::memory_order_acquire) < expected) {
+            QThread::yieldCurrentThread();
+        }
+        endToEndNs.push_back(timer.nsecsElapsed());
+    }
+
+    for (auto &inbox : inboxes) {
+        hub.detach(inbox);
+    }
+    for (auto &thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+
+    const auto summarize = [](std::vector<qint64> samples) {
+        std::sort(samples.begin(), samples.end());
+        qint64 total = 0;
+        for (qint64 v : samples) {
+            total += v;
+        }
+        struct Summary {
+            double avgUs;
+            double p50Us;
+            double p99Us;
+        };
+        const auto at = [&samples](double q) {
+            return samples[std::min(samples.size() - 1, static_cast<std::size_t>(q * double(samples.size())))] / 1000.0;
+        };
+        return Summary{total / 1000.0 / double(samples.size()), at(0.50), at(0.99)};
+    };
+    const auto fan = summarize(fanOutNs);
+    const auto e2e = summarize(endToEndNs);
+    const auto stats = hub.stats();
+
+    QTextStream out(stdout);
+    out << QStringLiteral("[广播基准] 会话=%1 线程=%2 推送=%3 内容=%4字节").arg(sessions).arg(threadCount).arg(messages).arg(body.size())
+        << Qt::endl;
+    out << QStringLiteral("  扇出(publish返回): 平均 %1 µs | p50 %2 µs | p99 %3 µs | 每会话 %4 ns")
+               .arg(fan.avgUs, 0, 'f', 1)
+               .arg(fan.p50Us, 0, 'f', 1)
+               .arg(fan.p99Us, 0, 'f', 1)
+               .arg(fan.avgUs * 1000.0 / sessions, 0, 'f', 1)
+        << Qt::endl;
+    out << QStringLiteral("  端到端(全部会话取到): 平均 %1 µs | p50 %2 µs | p99 %3 µs")
+               .arg(e2e.avgUs, 0, 'f', 1)
+               .arg(e2e.p50Us, 0, 'f', 1)
+               .arg(e2e.p99Us, 0, 'f', 1)
+        << Qt::endl;
+    out << QStringLiteral("  入队 %1 帧, 丢弃 %2 帧, 共享同一缓冲区 %3/%4")
+               .arg(stats.delivered)
+               .arg(stats.dropped)
+               .arg(sharedFrames.load())
+               .arg(received.load())
+        << Qt::endl;
+    return 0;
+}
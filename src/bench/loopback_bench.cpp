@@ -0,0 +1,143 @@
+// 会话处理基准：客户端与SessionWorker通过进程内回环传输直连，由确定性调度器驱动，
+// 不经过内核和Qt事件循环，测得的是每帧纯应用层开销(解析、路由、ACK编码与写出)。
+// --handlers 打开后请求会经业务线程池往返，额外包含跨线程投递的开销。
+// 以CS_ALLOC_TRACKING构建时另外输出各阶段每帧的分配次数，--max-allocs-per-frame 超限时以1退出(供ctest使用)。
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTextStream>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "common/alloc_tracker.hpp"
+#include "common/loopback_transport.hpp"
+#include "common/protocol.hpp"
+#include "message_dispatcher.hpp"
+#include "server_runtime.hpp"
+#include "server_stats.hpp"
+#include "session_worker.hpp"
+
+using namespace cs::protocol;
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption framesOption(QStringLiteral("frames"), QStringLiteral("请求帧总数"), QStringLiteral("n"), QStringLiteral("1000000"));
+    const QCommandLineOption burstOption(QStringLiteral("burst"), QStringLiteral("每次写入包含的帧数"), QStringLiteral("n"), QStringLiteral("64"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("请求内容字节数"), QStringLiteral("bytes"), QStringLiteral("32"));
+    const QCommandLineOption handlersOption(QStringLiteral("handlers"), QStringLiteral("注册空业务处理器，请求经线程池往返"));
+    parser.addOption(framesOption);
+    parser.addOption(burstOption);
+    parser.addOption(sizeOption);
+    const QCommandLineOption allocBudgetOption(QStringLiteral("max-allocs-per-frame"), QStringLiteral("已标注阶段每帧分配次数上限(需CS_ALLOC_TRACKING构建)"), QStringLiteral("n"));
+    parser.addOption(handlersOption);
+    parser.addOption(allocBudgetOption);
+    parser.process(app);
+
+    const int burst = qMax(1, parser.value(burstOption).toInt());
+    const int rounds = qMax(1, parser.value(framesOption).toInt() / burst);
+    const QByteArray body(qMax(0, parser.value(sizeOption).toInt()), 'x');
+    const bool withHandlers = parser.isSet(handlersOption);
+
+    auto runtime = std::make_shared<ServerRuntimeConfig>();
+    runtime->counters = std::make_shared<ServerCounters>();
+    if (withHandlers) {
+        runtime->dispatcher = std::make_shared<MessageDispatcher>();
+        runtime->dispatcher->registerHandler(MsgType::Text, [](const HandlerRequest &) { return HandlerResult{}; });
+    }
+
+    cs::common::LoopbackScheduler scheduler;
+    auto [client, server] = cs::common::LoopbackTransport::createPair(&scheduler);
+    std::unique_ptr<cs::common::LoopbackTransport> clientEnd(client);
+    SessionWorker worker(server, QStringLiteral("bench"), runtime);
+    worker.start();
+
+    // 预先编码好一次写入的全部帧，计时只覆盖服务器侧处理
+    QByteArray chunk;
+    for (int i = 0; i < burst; ++i) {
+        chunk.append(build_frame(kDefaultVersion, build_request_payload(MsgType::Text, static_cast<uint16_t>(i), body)));
+    }
+
+    std::vector<qint64> roundNs;
+    roundNs.reserve(static_cast<std::size_t>(rounds));
+    QByteArray discard;
+    using cs::common::AllocTracker;
+    AllocTracker::reset();  // 只统计计时循环内的分配，不含上面的准备工作
+    quint64 ackBytes = 0;
+    quint64 expected = 0;
+    QElapsedTimer total;
+    QElapsedTimer timer;
+    total.start();
+    for (int r = 0; r < rounds; ++r) {
+        timer.start();
+        client->write(chunk);
+        expected += static_cast<quint64>(burst);
+        scheduler.runUntilIdle();
+        while (runtime->counters->acks.load(std::memory_order_acquire) < expected) {
+            QCoreApplication::processEvents();  // 只有经线程池处理时才需要，结果通过排队调用送回
+            scheduler.runUntilIdle();
+        }
+        roundNs.push_back(timer.nsecsElapsed());
+        discard = client->readAll();
+        ackBytes += static_cast<quint64>(discard.size());
+    }
+    const qint64 totalNs = total.nsecsElapsed();
+
+    std::sort(roundNs.begin(), roundNs.end());
+    const auto perFrameAt = [&roundNs, burst](double q) {
+        const auto index = std::min(roundNs.size() - 1, static_cast<std::size_t>(q * double(roundNs.size())));
+        return double(roundNs[index]) / burst;
+    };
+    const quint64 frames = expected;
+    const auto latency = runtime->counters->ackLatency.counts();
+
+    QTextStream out(stdout);
+    out << QStringLiteral("[回环基准] 帧=%1 每次写入=%2帧 内容=%3字节 业务处理器=%4")
+               .arg(frames)
+               .arg(burst)
+               .arg(body.size())
+               .arg(withHandlers ? QStringLiteral("开") : QStringLiteral("关"))
+        << Qt::endl;
+    out << QStringLiteral("  每帧: 平均 %1 ns | p50 %2 ns | p99 %3 ns | 吞吐 %4 万帧/秒")
+               .arg(double(totalNs) / double(frames), 0, 'f', 1)
+               .arg(perFrameAt(0.50), 0, 'f', 1)
+               .arg(perFrameAt(0.99), 0, 'f', 1)
+               .arg(double(frames) * 1e9 / double(totalNs) / 1e4, 0, 'f', 1)
+        << Qt::endl;
+    out << QStringLiteral("  ACK延迟: p50 %1 µs | p99 %2 µs | 收到ACK %3 字节 | 解析错误 %4")
+               .arg(LatencyHistogram::quantileUs(latency, 0.50), 0, 'f', 1)
+               .arg(LatencyHistogram::quantileUs(latency, 0.99), 0, 'f', 1)
+               .arg(ackBytes)
+               .arg(runtime->counters->errors.load())
+        << Qt::endl;
+
+    if (!AllocTracker::available()) {
+        if (parser.isSet(allocBudgetOption)) {
+            out << QStringLiteral("  [警告] 未以CS_ALLOC_TRACKING构建，忽略--max-allocs-per-frame") << Qt::endl;
+        }
+        return 0;
+    }
+    out << AllocTracker::summary() << Qt::endl;
+    // Other包含基准自身的写入/读取，不计入上限
+    quint64 tagged = 0;
+    for (int i = 0; i < cs::common::kAllocTagCount; ++i) {
+        if (static_cast<cs::common::AllocTag>(i) != cs::common::AllocTag::Other) {
+            tagged += AllocTracker::stats(static_cast<cs::common::AllocTag>(i)).allocations;
+        }
+    }
+    const double perFrame = double(tagged) / double(qMax<quint64>(1, AllocTracker::frames()));
+    if (parser.isSet(allocBudgetOption)) {
+        const double budget = parser.value(allocBudgetOption).toDouble();
+        out << QStringLiteral("  已标注阶段每帧 %1 次分配，上限 %2：%3")
+                   .arg(perFrame, 0, 'f', 2)
+                   .arg(budget)
+                   .arg(perFrame <= budget ? QStringLiteral("通过") : QStringLiteral("超出"))
+            << Qt::endl;
+        return perFrame <= budget ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,317 @@
+// 会话线程池负载倾斜基准：同一进程内启动使用会话线程池的Listener。空闲时新会话按会话数轮流分到各线程，
+// 于是第0、K、2K…个连接落在同一个线程上，让其中前几个成为热点连接(在客户端线程上持续发送大批量帧)，
+// 其余为冷连接(主线程上每隔一段时间发一条小请求，逐条往返测延迟)。
+// 依次在"不迁移"与"按负载迁移"下各运行一次，比较预热期之后冷连接的RTT分位数。
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "common/protocol.hpp"
+#include "common/transport.hpp"
+#include "listener.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+struct BenchSettings {
+    int threads = 4;
+    int hot = 3;
+    int perThread = 8;
+    int seconds = 10;
+    int warmupSeconds = 3;
+    int window = 4;
+    int pingMs = 5;
+    QByteArray hotFrame;
+    QByteArray pingFrame;
+};
+
+struct RunResult {
+    bool ok = false;
+    QString error;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    std::size_t samples = 0;
+    double hotFramesPerSec = 0.0;
+    SessionScheduler::Stats placement;  // 全部连接建立后、施加负载前
+    SessionScheduler::Stats scheduler;  // 运行结束时
+};
+
+struct Connection {
+    std::unique_ptr<cs::common::Transport> transport;
+    ProtocolParser parser;
+    bool hot = false;
+    qint64 sentNs = 0;  // 冷连接在途请求的发送时刻，0表示没有在途请求
+};
+
+QString describe_threads(const SessionScheduler::Stats &stats) {
+    QStringList parts;
+    for (std::size_t i = 0; i < stats.threads.size(); ++i) {
+        parts.append(QStringLiteral("#%1 %2会话 %3%")
+                         .arg(i)
+                         .arg(stats.threads[i].sessions)
+                         .arg(stats.threads[i].busy * 100.0, 0, 'f', 0));
+    }
+    return parts.join(QStringLiteral(", "));
+}
+
+RunResult run_skewed(const BenchSettings &settings, bool rebalance) {
+    RunResult result;
+
+    // 服务器与热点客户端各用一个线程，主线程只驱动冷连接和计时
+    QThread serverThread;
+    serverThread.start();
+    QObject serverContext;
+    serverContext.moveToThread(&serverThread);
+    Listener *listener = nullptr;
+    quint16 port = 0;
+    QMetaObject::invokeMethod(&serverContext, [&]() {
+        listener = new Listener;
+        listener->setSessionThreads(settings.threads);
+        listener->setSessionRebalancing(rebalance);
+        listener->start(0);
+        port = listener->port();
+    }, Qt::BlockingQueuedConnection);
+    const auto schedulerStats = [&]() {
+        SessionScheduler::Stats stats;
+        QMetaObject::invokeMethod(&serverContext, [&]() { stats = listener->sessionSchedulerStats(); },
+                                  Qt::BlockingQueuedConnection);
+        return stats;
+    };
+    const auto placedSessions = [&]() {
+        int sessions = 0;
+        for (const auto &thread : schedulerStats().threads) {
+            sessions += thread.sessions;
+        }
+        return sessions;
+    };
+    const auto waitUntil = [](auto done, int timeoutMs) {
+        const QDeadlineTimer deadline(timeoutMs);
+        while (!done() && !deadline.hasExpired()) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+        }
+        return done();
+    };
+
+    // 逐个建立连接并等服务器分配完线程，保证接入顺序与连接顺序一致
+    const int total = settings.threads * settings.perThread;
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < total && result.error.isEmpty(); ++i) {
+        auto connection = std::make_unique<Connection>();
+        connection->transport.reset(cs::common::create_transport(cs::common::TransportKind::Tcp));
+        connection->hot = i % settings.threads == 0 && i / settings.threads < settings.hot;
+        connection->transport->connectToHost(QStringLiteral("127.0.0.1"), port);
+        if (!waitUntil([&]() { return connection->transport->isConnected() && placedSessions() == i + 1; }, 5000)) {
+            result.error = QStringLiteral("第 %1 个连接超时").arg(i);
+        }
+        connections.push_back(std::move(connection));
+    }
+    result.placement = schedulerStats();
+
+    QElapsedTimer clock;
+    clock.start();
+    QThread clientThread;
+    std::atomic<bool> pumping{true};
+    std::atomic<quint64> hotAcks{0};
+    std::vector<qint64> rttNs;
+    bool measuring = false;
+    for (auto &connection : connections) {
+        Connection *c = connection.get();
+        cs::common::Transport *transport = c->transport.get();
+        if (c->hot) {
+            // 热点连接移到客户端线程：每收到一个ACK补发一帧，保持window帧在途
+            transport->moveToThread(&clientThread);
+            QObject::connect(transport, &cs::common::Transport::readyRead, transport, [&, c, transport]() {
+                c->parser.append(transport->readAll());
+                FrameView view;
+                while (c->parser.nextFrameView(&view)) {
+                    hotAcks.fetch_add(1, std::memory_order_relaxed);
+                    if (pumping.load(std::memory_order_relaxed)) {
+                        transport->write(settings.hotFrame);
+                    }
+                }
+            });
+            continue;
+        }
+        QObject::connect(transport, &cs::common::Transport::readyRead, transport, [&, c, transport]() {
+            c->parser.append(transport->readAll());
+            FrameView view;
+            while (c->parser.nextFrameView(&view)) {
+                if (c->sentNs > 0 && measuring) {
+                    rttNs.push_back(clock.nsecsElapsed() - c->sentNs);
+                }
+                c->sentNs = 0;
+            }
+        });
+    }
+
+    if (result.error.isEmpty()) {
+        clientThread.start();
+        for (auto &connection : connections) {
+            if (connection->hot) {
+                cs::common::Transport *transport = connection->transport.get();
+                QMetaObject::invokeMethod(transport, [&settings, transport]() {
+                    for (int i = 0; i < settings.window; ++i) {
+                        transport->write(settings.hotFrame);
+                    }
+                }, Qt::QueuedConnection);
+            }
+        }
+        // 冷连接：上一条已应答才发下一条，应答慢的连接自然少发，不会自己制造排队
+        QTimer pinger;
+        pinger.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&pinger, &QTimer::timeout, [&]() {
+            for (auto &connection : connections) {
+                if (!connection->hot && connection->sentNs == 0) {
+                    connection->sentNs = qMax<qint64>(1, clock.nsecsElapsed());
+                    connection->transport->write(settings.pingFrame);
+                }
+            }
+        });
+        pinger.start(settings.pingMs);
+        quint64 hotAcksAtWarmup = 0;
+        qint64 warmupEndNs = 0;
+        QEventLoop loop;
+        QTimer::singleShot(settings.warmupSeconds * 1000, &loop, [&]() {
+            measuring = true;
+            hotAcksAtWarmup = hotAcks.load();
+            warmupEndNs = clock.nsecsElapsed();
+        });
+        QTimer::singleShot((settings.warmupSeconds + settings.seconds) * 1000, &loop, &QEventLoop::quit);
+        loop.exec();
+        pinger.stop();
+        pumping = false;
+        result.hotFramesPerSec = double(hotAcks.load() - hotAcksAtWarmup) * 1e9 /
+                                 double(qMax<qint64>(1, clock.nsecsElapsed() - warmupEndNs));
+        result.scheduler = schedulerStats();
+    }
+
+    // 客户端线程退出后才能在本线程释放其上的传输
+    clientThread.quit();
+    clientThread.wait();
+    connections.clear();
+    QMetaObject::invokeMethod(&serverContext, [&]() {
+        listener->stop();
+        delete listener;
+    }, Qt::BlockingQueuedConnection);
+    serverThread.quit();
+    serverThread.wait();
+
+    if (!result.error.isEmpty()) {
+        return result;
+    }
+    if (rttNs.empty()) {
+        result.error = QStringLiteral("预热后没有收到冷连接的应答");
+        return result;
+    }
+    std::sort(rttNs.begin(), rttNs.end());
+    const auto at = [&rttNs](double q) {
+        return rttNs[std::min(rttNs.size() - 1, static_cast<std::size_t>(q * double(rttNs.size())))] / 1000.0;
+    };
+    result.ok = true;
+    result.samples = rttNs.size();
+    result.p50Us = at(0.50);
+    result.p99Us = at(0.99);
+    result.p999Us = at(0.999);
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("会话线程池线程数"), QStringLiteral("n"), QStringLiteral("4"));
+    const QCommandLineOption perThreadOption(QStringLiteral("per-thread"), QStringLiteral("每个线程初始分到的连接数"), QStringLiteral("n"), QStringLiteral("8"));
+    const QCommandLineOption hotOption(QStringLiteral("hot"), QStringLiteral("热点连接数(全部落在线程#0)"), QStringLiteral("n"), QStringLiteral("3"));
+    const QCommandLineOption batchOption(QStringLiteral("batch"), QStringLiteral("热点连接每帧包含的批量条数"), QStringLiteral("n"), QStringLiteral("256"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("每条请求内容字节数"), QStringLiteral("bytes"), QStringLiteral("32"));
+    const QCommandLineOption windowOption(QStringLiteral("window"), QStringLiteral("热点连接在途帧数"), QStringLiteral("n"), QStringLiteral("4"));
+    const QCommandLineOption pingOption(QStringLiteral("ping-ms"), QStringLiteral("冷连接发送间隔(毫秒)"), QStringLiteral("ms"), QStringLiteral("5"));
+    const QCommandLineOption secondsOption(QStringLiteral("seconds"), QStringLiteral("预热后的测量时长(秒)"), QStringLiteral("s"), QStringLiteral("10"));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"), QStringLiteral("预热时长(秒)，期间不计延迟，留给调度器迁移"), QStringLiteral("s"), QStringLiteral("3"));
+    parser.addOption(threadsOption);
+    parser.addOption(perThreadOption);
+    parser.addOption(hotOption);
+    parser.addOption(batchOption);
+    parser.addOption(sizeOption);
+    parser.addOption(windowOption);
+    parser.addOption(pingOption);
+    parser.addOption(secondsOption);
+    parser.addOption(warmupOption);
+    parser.process(app);
+
+    BenchSettings settings;
+    settings.threads = qMax(2, parser.value(threadsOption).toInt());
+    settings.perThread = qMax(2, parser.value(perThreadOption).toInt());
+    settings.hot = qBound(1, parser.value(hotOption).toInt(), settings.perThread - 1);
+    settings.window = qMax(1, parser.value(windowOption).toInt());
+    settings.pingMs = qMax(1, parser.value(pingOption).toInt());
+    settings.seconds = qMax(1, parser.value(secondsOption).toInt());
+    settings.warmupSeconds = qMax(0, parser.value(warmupOption).toInt());
+    const QByteArray body(qMax(0, parser.value(sizeOption).toInt()), 'x');
+    const int batch = qMax(1, parser.value(batchOption).toInt());
+    QByteArray batchPayload = begin_batch_payload(1);
+    for (int i = 0; i < batch; ++i) {
+        append_batch_entry(batchPayload, build_request_payload(MsgType::Text, uint16_t(i), body));
+    }
+    settings.hotFrame = build_frame(kDefaultVersion, batchPayload);
+    settings.pingFrame = build_frame(kDefaultVersion, build_request_payload(MsgType::Text, 1, body));
+
+    QTextStream out(stdout);
+    out << QStringLiteral("[负载倾斜] 会话线程=%1 连接=%2 热点=%3(初始均在线程#0) 热点帧=%4条×%5字节 窗口=%6 冷连接间隔=%7ms 预热%8秒+测量%9秒")
+               .arg(settings.threads)
+               .arg(settings.threads * settings.perThread)
+               .arg(settings.hot)
+               .arg(batch)
+               .arg(body.size())
+               .arg(settings.window)
+               .arg(settings.pingMs)
+               .arg(settings.warmupSeconds)
+               .arg(settings.seconds)
+        << Qt::endl;
+
+    double baselineP99 = 0.0;
+    for (const bool rebalance : {false, true}) {
+        const QString name = rebalance ? QStringLiteral("按负载迁移") : QStringLiteral("不迁移");
+        const RunResult r = run_skewed(settings, rebalance);
+        if (!r.ok) {
+            out << QStringLiteral("  %1: 失败 (%2)").arg(name, r.error) << Qt::endl;
+            continue;
+        }
+        out << QStringLiteral("  %1: 冷连接RTT p50 %2 µs | p99 %3 µs | p99.9 %4 µs (%5次) | 热点 %6 帧/秒 | 迁移 %7 次")
+                   .arg(name)
+                   .arg(r.p50Us, 0, 'f', 1)
+                   .arg(r.p99Us, 0, 'f', 1)
+                   .arg(r.p999Us, 0, 'f', 1)
+                   .arg(r.samples)
+                   .arg(r.hotFramesPerSec, 0, 'f', 0)
+                   .arg(r.scheduler.migrations)
+            << Qt::endl;
+        out << QStringLiteral("    初始 %1").arg(describe_threads(r.placement)) << Qt::endl;
+        out << QStringLiteral("    结束 %1").arg(describe_threads(r.scheduler)) << Qt::endl;
+        if (!rebalance) {
+            baselineP99 = r.p99Us;
+        } else if (baselineP99 > 0.0 && r.p99Us > 0.0) {
+            out << QStringLiteral("  冷连接p99: %1 → %2 µs (%3倍)")
+                       .arg(baselineP99, 0, 'f', 1)
+                       .arg(r.p99Us, 0, 'f', 1)
+                       .arg(baselineP99 / r.p99Us, 0, 'f', 2)
+                << Qt::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// 同机传输对比基准：同一进程内启动完整的Listener(TCP + Unix域套接字 + 共享内存)，
+// 客户端依次经TCP回环、Unix域套接字、共享内存环连接，施加相同负载：
+// 先逐条往返测延迟(一次只有一条在途)，再保持固定在途窗口测吞吐。
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "common/protocol.hpp"
+#include "common/shm_transport.hpp"
+#include "common/transport.hpp"
+#include "listener.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+struct RunResult {
+    bool ok = false;
+    QString error;
+    double avgUs = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double framesPerSec = 0.0;
+    double megabytesPerSec = 0.0;
+};
+
+RunResult run_transport(const QString &address, quint16 port, int pings, int frames, int window, const QByteArray &frame) {
+    RunResult result;
+    std::unique_ptr<cs::common::Transport> transport;
+    QString endpoint;
+    transport.reset(cs::common::create_transport(cs::common::transport_kind(address, &endpoint)));
+
+    ProtocolParser parser;
+    quint64 acks = 0;
+    QObject::connect(transport.get(), &cs::common::Transport::readyRead, [&]() {
+        parser.append(transport->readAll());
+        FrameView view;
+        while (parser.nextFrameView(&view)) {
+            ++acks;
+        }
+    });
+    QObject::connect(transport.get(), &cs::common::Transport::errorOccurred, [&](const QString &message) {
+        result.error = message;
+    });
+
+    const auto waitUntil = [&](auto done, int timeoutMs) {
+        const QDeadlineTimer deadline(timeoutMs);
+        while (!done() && result.error.isEmpty() && !deadline.hasExpired()) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+        }
+        return done();
+    };
+
+    transport->connectToHost(endpoint, port);
+    if (!waitUntil([&]() { return transport->isConnected(); }, 5000)) {
+        result.error = result.error.isEmpty() ? QStringLiteral("连接超时") : result.error;
+        return result;
+    }
+
+    std::vector<qint64> rttNs;
+    rttNs.reserve(static_cast<std::size_t>(pings));
+    QElapsedTimer timer;
+    for (int i = 0; i < pings; ++i) {
+        const quint64 target = acks + 1;
+        timer.start();
+        transport->write(frame);
+        if (!waitUntil([&]() { return acks >= target; }, 5000)) {
+            result.error = QStringLiteral("等待ACK超时");
+            return result;
+        }
+        rttNs.push_back(timer.nsecsElapsed());
+    }
+
+    const quint64 base = acks;
+    quint64 sent = 0;
+    timer.start();
+    while (acks - base < static_cast<quint64>(frames)) {
+        while (sent < static_cast<quint64>(frames) && sent - (acks - base) < static_cast<quint64>(window)) {
+            transport->write(frame);
+            ++sent;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+        if (!result.error.isEmpty() || !transport->isConnected()) {
+            result.error = result.error.isEmpty() ? QStringLiteral("连接中断") : result.error;
+            return result;
+        }
+    }
+    const double seconds = double(timer.nsecsElapsed()) / 1e9;
+    transport->disconnectFromHost();
+
+    std::sort(rttNs.begin(), rttNs.end());
+    qint64 total = 0;
+    for (qint64 v : rttNs) {
+        total += v;
+    }
+    const auto at = [&rttNs](double q) {
+        return rttNs[std::min(rttNs.size() - 1, static_cast<std::size_t>(q * double(rttNs.size())))] / 1000.0;
+    };
+    result.ok = true;
+    result.avgUs = double(total) / 1000.0 / double(rttNs.size());
+    result.p50Us = at(0.50);
+    result.p99Us = at(0.99);
+    result.framesPerSec = double(frames) / seconds;
+    result.megabytesPerSec = double(frames) * double(frame.size()) / seconds / (1024.0 * 1024.0);
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption pingsOption(QStringLiteral("pings"), QStringLiteral("逐条往返次数(测延迟)"), QStringLiteral("n"), QStringLiteral("10000"));
+    const QCommandLineOption framesOption(QStringLiteral("frames"), QStringLiteral("吞吐阶段发送帧数"), QStringLiteral("n"), QStringLiteral("200000"));
+    const QCommandLineOption windowOption(QStringLiteral("window"), QStringLiteral("吞吐阶段在途帧数上限"), QStringLiteral("n"), QStringLiteral("64"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("请求内容字节数"), QStringLiteral("bytes"), QStringLiteral("32"));
+    parser.addOption(pingsOption);
+    parser.addOption(framesOption);
+    parser.addOption(windowOption);
+    parser.addOption(sizeOption);
+    parser.process(app);
+
+    const int pings = qMax(1, parser.value(pingsOption).toInt());
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const int window = qMax(1, parser.value(windowOption).toInt());
+    const QByteArray frame = build_frame(
+        kDefaultVersion, build_request_payload(MsgType::Text, 1, QByteArray(qMax(0, parser.value(sizeOption).toInt()), 'x')));
+
+    // 服务器放在独立线程：共享内存握手在客户端侧是阻塞的，需要服务器事件循环同时运行
+    QThread serverThread;
+    serverThread.start();
+    QObject serverContext;
+    serverContext.moveToThread(&serverThread);
+    Listener *listener = nullptr;
+    quint16 port = 0;
+    const QString localPath = QDir::tempPath() + QStringLiteral("/cs_transport_bench_%1").arg(QCoreApplication::applicationPid());
+    QMetaObject::invokeMethod(&serverContext, [&]() {
+        listener = new Listener;
+        listener->start(0);
+        listener->startLocal(localPath);
+        port = listener->port();
+    }, Qt::BlockingQueuedConnection);
+
+    struct Target {
+        QString name;
+        QString address;
+    };
+    std::vector<Target> targets = {
+        {QStringLiteral("TCP回环"), QStringLiteral("127.0.0.1")},
+        {QStringLiteral("Unix域套接字"), QStringLiteral("unix:") + localPath},
+    };
+    if (cs::common::ShmTransport::supported()) {
+        targets.push_back({QStringLiteral("共享内存环"), QStringLiteral("shm:") + localPath + QStringLiteral(".shm")});
+    }
+
+    QTextStream out(stdout);
+    out << QStringLiteral("[传输对比] 往返=%1 吞吐帧=%2 窗口=%3 帧长=%4字节").arg(pings).arg(frames).arg(window).arg(frame.size())
+        << Qt::endl;
+    for (const Target &target : targets) {
+        const RunResult r = run_transport(target.address, port, pings, frames, window, frame);
+        if (!r.ok) {
+            out << QStringLiteral("  %1: 失败 (%2)").arg(target.name, r.error) << Qt::endl;
+            continue;
+        }
+        out << QStringLiteral("  %1: RTT 平均 %2 µs | p50 %3 µs | p99 %4 µs | 吞吐 %5 帧/秒 (%6 MB/s)")
+                   .arg(target.name)
+                   .arg(r.avgUs, 0, 'f', 1)
+                   .arg(r.p50Us, 0, 'f', 1)
+                   .arg(r.p99Us, 0, 'f', 1)
+                   .arg(r.framesPerSec, 0, 'f', 0)
+                   .arg(r.megabytesPerSec, 0, 'f', 1)
+            << Qt::endl;
+    }
+
+    QMetaObject::invokeMethod(&serverContext, [&]() {
+        listener->stop();
+        delete listener;
+    }, Qt::BlockingQueuedConnection);
+    serverThread.quit();
+    serverThread.wait();
+    return 0;
+}
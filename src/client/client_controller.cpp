@@ -2,53 +2,106 @@
 
 #include <QtCore/QDateTime>
 
+#include <utility>
+
+#include "common/alloc_tracker.hpp"
+
 using namespace cs::protocol;
+using cs::common::SendPriority;
 
-ClientController::ClientController(QObject *parent) : QObject(parent) {
-    connect(&socket_, &QTcpSocket::connected, this, &ClientController::onConnected);
-    connect(&socket_, &QTcpSocket::disconnected, this, &ClientController::onDisconnected);
-    connect(&socket_, &QTcpSocket::readyRead, this, &ClientController::onReadyRead);
-    connect(&socket_, &QTcpSocket::errorOccurred, this, &ClientController::onErrorOccurred);
+// 成员对象以this为父对象，使moveToThread()能连同传输和定时器一起迁移
+ClientController::ClientController(QObject *parent)
+    : QObject(parent),
+      transport_(nullptr),
+      autoTimer_(this),
+      reconnectTimer_(this),
+      ackTimer_(this),
+      batchTimer_(this),
+      uiTimer_(this) {
+    attachTransport(new cs::common::TcpTransport);
 
+    // 自动发送与ACK超时直接影响测得的延迟，使用毫秒精度的定时器而不是默认的粗粒度(±5%)合并
+    autoTimer_.setTimerType(Qt::PreciseTimer);
     autoTimer_.setInterval(autoIntervalMs_);
     connect(&autoTimer_, &QTimer::timeout, this, &ClientController::handleAutoSend);
 
-    reconnectTimer_.setInterval(3000);
     reconnectTimer_.setSingleShot(true);
     connect(&reconnectTimer_, &QTimer::timeout, this, &ClientController::attemptReconnect);
 
+    ackTimer_.setTimerType(Qt::PreciseTimer);
     ackTimer_.setInterval(ackTimeoutMs_);
     ackTimer_.setSingleShot(true);
     connect(&ackTimer_, &QTimer::timeout, this, &ClientController::handleAckTimeout);
+
+    batchTimer_.setSingleShot(true);
+    connect(&batchTimer_, &QTimer::timeout, this, &ClientController::flushBatch);
+
+    uiTimer_.setSingleShot(true);
+    connect(&uiTimer_, &QTimer::timeout, this, &ClientController::flushUiUpdates);
+}
+
+void ClientController::setTransport(cs::common::Transport *transport) {
+    customTransport_ = true;
+    attachTransport(transport);
+}
+
+void ClientController::attachTransport(cs::common::Transport *transport) {
+    if (transport_) {
+        transport_->disconnect(this);
+        transport_->abort();
+        transport_->deleteLater();
+    }
+    sendQueue_.clear();
+    transport_ = transport;
+    transport_->setParent(this);
+    // 与SessionWorker一致：不带校验的0x03帧只在本机传输上接受，TCP上按不支持的版本丢弃
+    parser_.setAcceptUnchecked(transport_->isLocal());
+    connect(transport_, &cs::common::Transport::connected, this, &ClientController::onConnected);
+    connect(transport_, &cs::common::Transport::disconnected, this, &ClientController::onDisconnected);
+    connect(transport_, &cs::common::Transport::readyRead, this, &ClientController::onReadyRead);
+    connect(transport_, &cs::common::Transport::bytesWritten, this, [this]() { sendQueue_.pump(transport_); });
+    connect(transport_, &cs::common::Transport::errorOccurred, this, &ClientController::onErrorOccurred);
 }
 
 void ClientController::connectToHost(const QString &host, quint16 port) {
     host_ = host;
     port_ = port;
+    homeHost_ = host;
+    homePort_ = port;
+    awayFromHome_ = false;
+    redirectHops_ = 0;
+    const auto kind = cs::common::transport_kind(host, &endpoint_);
+    if (!customTransport_ && kind != transportKind_) {
+        attachTransport(cs::common::create_transport(kind));
+        transportKind_ = kind;
+    }
     shouldReconnect_ = true;
     reconnectTimer_.stop();
+    reconnectPolicy_.reset();
     emit statusChanged(tr("连接中..."));
-    socket_.connectToHost(host, port);
-    emit logMessage(tr("[连接] 正在连接 %1:%2").arg(host).arg(port));
+    transport_->connectToHost(endpoint_, port);
+    log(tr("[连接] 正在连接 %1:%2").arg(host).arg(port));
 }
 
 void ClientController::disconnectFromHost() {
+    flushBatch();
     autoTimer_.stop();
     shouldReconnect_ = false;
     reconnectTimer_.stop();
     ackTimer_.stop();
     awaitingAck_ = false;
-    socket_.disconnectFromHost();
+    sendQueue_.flush(transport_);
+    transport_->disconnectFromHost();
 }
 
 void ClientController::sendPayload(const QByteArray &payload) {
-    writeFrame(payload, false);
+    writeFrame(payload, false, SendPriority::Interactive);
 }
 
 void ClientController::setAutoInterval(int milliseconds) {
     autoIntervalMs_ = milliseconds;
     autoTimer_.setInterval(autoIntervalMs_);
-    emit logMessage(tr("[配置] 本地自动发送间隔设置为 %1 毫秒").arg(autoIntervalMs_));
+    log(tr("[配置] 本地自动发送间隔设置为 %1 毫秒").arg(autoIntervalMs_));
 }
 
 void ClientController::setAutoPayload(const QByteArray &payload) {
@@ -57,21 +110,163 @@ void ClientController::setAutoPayload(const QByteArray &payload) {
 
 void ClientController::setAutoSending(bool enabled) {
     autoEnabled_ = enabled;
-    if (autoEnabled_ && socket_.state() == QAbstractSocket::ConnectedState) {
+    if (autoEnabled_ && transport_->isConnected()) {
         autoTimer_.start();
     } else {
         autoTimer_.stop();
     }
 }
 
+void ClientController::setReconnectBackoff(int baseMs, int maxMs) {
+    reconnectPolicy_.setBackoff(baseMs, maxMs);
+}
+
+void ClientController::setFrameVersion(uint8_t version) {
+    frameVersion_ = version;
+}
+
+void ClientController::setClientId(const QString &id) {
+    clientId_ = id.toUtf8().left(kMaxClientIdBytes);
+}
+
+void ClientController::setTrafficLogging(bool enabled) {
+    logTraffic_ = enabled;
+}
+
+ClientStream *ClientController::openStream(SendPriority priority) {
+    if (streams_.size() >= kMaxStreamsPerSession) {
+        return nullptr;
+    }
+    while (nextStreamId_ == 0 || streams_.contains(nextStreamId_)) {
+        ++nextStreamId_;
+    }
+    auto *stream = new ClientStream(this, nextStreamId_++, priority);
+    streams_.insert(stream->id(), stream);
+    return stream;
+}
+
+void ClientController::closeStream(ClientStream *stream) {
+    streams_.remove(stream->id());
+    if (transport_->isConnected()) {
+        writeRequest(build_stream_payload(stream->id(), QByteArray()), SendPriority::Control);
+    }
+}
+
+bool ClientController::writeStreamRequest(uint16_t streamId, const QByteArray &requestPayload, SendPriority priority) {
+    if (!transport_->isConnected()) {
+        return false;
+    }
+    return writeRequest(build_stream_payload(streamId, requestPayload), priority);
+}
+
+void ClientController::routeStreamAck(const AckMessage &ack) {
+    // 流已在本地关闭时忽略
+    if (ClientStream *stream = streams_.value(stream_ack_id(ack.cmdPayload))) {
+        stream->onAck(ack.code == RespCode::Ok, stream_ack_credit(ack.cmdPayload));
+    }
+}
+
+cs::common::SendQueue::ClassStats ClientController::sendQueueStats(SendPriority priority) const {
+    return sendQueue_.stats(priority);
+}
+
+void ClientController::setUpdateCoalescing(int intervalMs, int maxLines) {
+    flushUiUpdates();
+    coalesceMs_ = qMax(0, intervalMs);
+    maxLogLines_ = qMax(1, maxLines);
+    uiTimer_.setInterval(coalesceMs_);
+}
+
+void ClientController::subscribe(const QString &topic) {
+    if (topic.isEmpty() || topics_.contains(topic)) {
+        return;
+    }
+    topics_.insert(topic);
+    if (transport_->isConnected()) {
+        writeRequest(build_request_payload(MsgType::Subscribe, nextMsgId_++, topic.toUtf8()), SendPriority::Control);
+    }
+    log(tr("[订阅] 主题 %1").arg(topic));
+}
+
+void ClientController::unsubscribe(const QString &topic) {
+    if (!topics_.remove(topic)) {
+        return;
+    }
+    if (transport_->isConnected()) {
+        writeRequest(build_request_payload(MsgType::Unsubscribe, nextMsgId_++, topic.toUtf8()), SendPriority::Control);
+    }
+    log(tr("[订阅] 取消主题 %1").arg(topic));
+}
+
+void ClientController::setBatching(int maxBytes, int maxDelayMs) {
+    flushBatch();
+    batchMaxBytes_ = qMin(maxBytes, int(kMaxPayloadBytes));
+    batchTimer_.setInterval(qMax(0, maxDelayMs));
+    if (batchMaxBytes_ > 0) {
+        log(tr("[配置] 合并发送: 上限 %1 字节 / %2 毫秒").arg(batchMaxBytes_).arg(batchTimer_.interval()));
+    }
+}
+
+void ClientController::queuePayload(const QByteArray &payload) {
+    if (batchMaxBytes_ <= 0) {
+        writeFrame(payload, false, SendPriority::Bulk);
+        return;
+    }
+    const QByteArray entry = buildRequestPayload(payload);
+    const int entryBytes = kBatchEntryOverhead + entry.size();
+    if (kBatchHeaderBytes + entryBytes > batchMaxBytes_) {
+        // 单条消息已超出批量预算，保持顺序后单独发送
+        flushBatch();
+        writeRequest(entry, SendPriority::Bulk);
+        return;
+    }
+    if (!batchPayload_.isEmpty() && batchPayload_.size() + entryBytes > batchMaxBytes_) {
+        flushBatch();
+    }
+    if (batchPayload_.isEmpty()) {
+        batchPayload_ = begin_batch_payload(nextMsgId_++);
+        batchTimer_.start();
+    }
+    append_batch_entry(batchPayload_, entry);
+    ++batchCount_;
+    if (batchPayload_.size() + kBatchEntryOverhead + kRequestHeaderBytes >= batchMaxBytes_) {
+        flushBatch();
+    }
+}
+
+void ClientController::flushBatch() {
+    batchTimer_.stop();
+    if (batchPayload_.isEmpty()) {
+        return;
+    }
+    if (writeRequest(batchPayload_, SendPriority::Bulk) && trafficLogWanted()) {
+        log(tr("[发送] 批量发送 %1 条消息, %2 字节").arg(batchCount_).arg(batchPayload_.size()));
+    }
+    batchPayload_.clear();
+    batchCount_ = 0;
+}
+
 void ClientController::onConnected() {
     emit statusChanged(tr("已连接"));
-    emit logMessage(tr("[连接] 成功连接到服务器"));
+    log(tr("[连接] 成功连接到服务器"));
     emit connected();
     ackTimer_.stop();
     awaitingAck_ = false;
+    reconnectTimer_.stop();
     sentCount_ = 0;
     receivedCount_ = 0;
+    // 标识必须是连接上的第一帧，服务器据此决定是否把本连接重定向到其他节点
+    if (!clientId_.isEmpty()) {
+        writeRequest(build_request_payload(MsgType::Hello, nextMsgId_++, clientId_), SendPriority::Control);
+    }
+    for (const QString &topic : std::as_const(topics_)) {
+        writeRequest(build_request_payload(MsgType::Subscribe, nextMsgId_++, topic.toUtf8()), SendPriority::Control);
+    }
+    // 服务器侧的流状态随旧连接消失，各流以满额度重新开始并发出断线期间排队的消息
+    for (ClientStream *stream : std::as_const(streams_)) {
+        stream->onConnectionReset();
+        stream->pump();
+    }
     updateStatistics();
     if (autoEnabled_) {
         autoTimer_.start();
@@ -80,47 +275,54 @@ void ClientController::onConnected() {
 
 void ClientController::onDisconnected() {
     emit statusChanged(tr("已断开"));
-    emit logMessage(tr("[连接] 与服务器断开连接"));
+    log(tr("[连接] 与服务器断开连接"));
     emit disconnected();
+    sendQueue_.clear();  // 排队的帧属于旧连接，重连后不再补发
     autoTimer_.stop();
     ackTimer_.stop();
     awaitingAck_ = false;
-    if (shouldReconnect_) {
-        emit logMessage(tr("[重连] 准备在 %1 秒后重连").arg(reconnectTimer_.interval() / 1000));
-        reconnectTimer_.start();
-    }
+    scheduleReconnect();
 }
 
-void ClientController::onErrorOccurred(QAbstractSocket::SocketError) {
+void ClientController::onErrorOccurred(const QString &message) {
     emit statusChanged(tr("发生错误"));
-    emit logMessage(tr("[错误] 网络错误: %1").arg(socket_.errorString()));
-    if (shouldReconnect_ && !reconnectTimer_.isActive()) {
-        emit logMessage(tr("[重连] 将在 %1 秒后尝试重连").arg(reconnectTimer_.interval() / 1000));
-        reconnectTimer_.start();
-    }
+    log(tr("[错误] 网络错误: %1").arg(message));
+    scheduleReconnect();
 }
 
 void ClientController::onReadyRead() {
-    parser_.append(socket_.readAll());
+    CS_ALLOC_SCOPE(Receive);
+    parser_.append(transport_->readAll());
     while (true) {
+        CS_ALLOC_SCOPE(Parse);
         FrameError error = FrameError::None;
         QString reason;
         auto frame = parser_.nextFrame(&error, &reason);
         if (!frame.has_value()) {
             if (error != FrameError::None) {
-                emit logMessage(tr("[错误] 解析响应失败: %1").arg(reason));
+                log(tr("[错误] 解析响应失败: %1").arg(reason));
             }
             break;
         }
+        cs::common::AllocTracker::addFrames(1);
+        const QByteArray &payload = frame->frame.payload;
+        if (!payload.isEmpty() && static_cast<uint8_t>(payload.at(0)) == uint8_t(RespCode::Notify)) {
+            handleNotification(payload);  // 推送不是ACK，不影响确认计数与超时
+            continue;
+        }
+        if (!payload.isEmpty() && static_cast<uint8_t>(payload.at(0)) == uint8_t(RespCode::Command)) {
+            handleServerCommand(payload);
+            continue;
+        }
         receivedCount_++;
-        handleAckPayload(frame->frame.payload);
+        handleAckPayload(payload);
         updateStatistics();
     }
 }
 
 void ClientController::handleAutoSend() {
     if (!autoPayload_.isEmpty()) {
-        if (writeFrame(autoPayload_, true)) {
+        if (writeFrame(autoPayload_, true, SendPriority::Interactive)) {
             awaitingAck_ = true;
             ackTimer_.start();
         }
@@ -132,89 +334,245 @@ void ClientController::handleAckTimeout() {
         return;
     }
     awaitingAck_ = false;
-    emit logMessage(tr("[超时] 自动发送等待服务器响应超时,准备重连"));
-    socket_.abort();
-    attemptReconnect();
+    log(tr("[超时] 自动发送等待服务器响应超时,准备重连"));
+    transport_->abort();
+    scheduleReconnect();
+}
+
+void ClientController::scheduleReconnect() {
+    if (!shouldReconnect_ || reconnectTimer_.isActive()) {
+        return;
+    }
+    // 重定向目标故障或拒绝时回到初始节点，由它按最新的成员表重新分配
+    if (awayFromHome_) {
+        returnHome();
+    }
+    const int delayMs = reconnectPolicy_.nextDelayMs();
+    log(tr("[重连] 第 %1 次重连将在 %2 毫秒后进行").arg(reconnectPolicy_.attempts()).arg(delayMs));
+    reconnectTimer_.start(delayMs);
 }
 
 void ClientController::attemptReconnect() {
     if (!shouldReconnect_) {
         return;
     }
-    if (host_.isEmpty() || port_ == 0) {
-        emit logMessage(tr("[重连] 缺少重连目标配置,取消自动重连"));
+    if (host_.isEmpty() || (port_ == 0 && transportKind_ == cs::common::TransportKind::Tcp)) {
+        log(tr("[重连] 缺少重连目标配置,取消自动重连"));
         return;
     }
     ackTimer_.stop();
     awaitingAck_ = false;
-    emit logMessage(tr("[重连] 正在重连 %1:%2").arg(host_).arg(port_));
-    socket_.abort();
-    socket_.connectToHost(host_, port_);
+    log(tr("[重连] 正在重连 %1:%2").arg(host_).arg(port_));
+    transport_->abort();
+    transport_->connectToHost(endpoint_, port_);
     emit statusChanged(tr("连接中..."));
 }
 
 QByteArray ClientController::buildRequestPayload(const QByteArray &content) {
-    static quint16 msgCounter = 1;
-    QByteArray payload;
-    payload.append(char(0x01));  // 文本消息
-    payload.append(char((msgCounter >> 8) & 0xFF));
-    payload.append(char(msgCounter & 0xFF));
-    payload.append(content);
-    ++msgCounter;
-    return payload;
+    return build_request_payload(MsgType::Text, nextMsgId_++, content);
 }
 
 void ClientController::handleAckPayload(const QByteArray &payload) {
+    CS_ALLOC_SCOPE(Ack);
     emit responseReceived(payload);
-    if (payload.size() < 10) {
-        emit logMessage(tr("[警告] 服务器响应长度不足"));
+    AckMessage ack;
+    if (!decode_ack_payload(payload.constData(), payload.size(), &ack)) {
+        log(tr("[警告] 服务器响应长度不足"));
+        return;
+    }
+    // 收到确认才算恢复正常：连上即被断开(如服务器已满)的情况继续累积退避
+    reconnectPolicy_.reset();
+    redirectHops_ = 0;
+    // 流帧的ACK与非流帧交错到达，不能结束非流帧的ACK等待
+    if (ack.cmd == CmdId::StreamAck) {
+        routeStreamAck(ack);
         return;
     }
     if (awaitingAck_) {
         awaitingAck_ = false;
         ackTimer_.stop();
     }
-    const uint8_t respCode = static_cast<uint8_t>(payload.at(0));
-    quint64 timestamp = 0;
-    for (int i = 0; i < 8; ++i) {
-        timestamp = (timestamp << 8) | static_cast<uint8_t>(payload.at(1 + i));
-    }
-    const uint8_t cmdId = static_cast<uint8_t>(payload.at(9));
-    emit logMessage(tr("[接收] 服务器确认 | code=%1 ts=%2 cmd=%3").arg(respCode).arg(timestamp).arg(cmdId));
-    if (cmdId == 0x01 && payload.size() >= 14) {
-        quint32 newInterval = 0;
-        for (int i = 0; i < 4; ++i) {
-            newInterval = (newInterval << 8) | static_cast<uint8_t>(payload.at(10 + i));
+    if (trafficLogWanted()) {
+        log(tr("[接收] 服务器确认 | code=%1 ts=%2 cmd=%3")
+                            .arg(uint8_t(ack.code))
+                            .arg(ack.timestamp)
+                            .arg(uint8_t(ack.cmd)));
+    }
+    applyCommand(ack);
+}
+
+void ClientController::handleServerCommand(const QByteArray &payload) {
+    AckMessage command;
+    if (!decode_ack_payload(payload.constData(), payload.size(), &command)) {
+        log(tr("[警告] 服务器命令格式错误"));
+        return;
+    }
+    if (trafficLogWanted()) {
+        log(tr("[命令] 服务器主动下发 | cmd=%1 参数=%2").arg(uint8_t(command.cmd)).arg(command.cmdPayload));
+    }
+    if (command.cmd == CmdId::Redirect) {
+        followRedirect(QString::fromUtf8(redirect_host(payload)), static_cast<quint16>(command.cmdPayload));
+        return;
+    }
+    applyCommand(command);
+}
+
+void ClientController::followRedirect(const QString &host, quint16 port) {
+    if (customTransport_ || transportKind_ != cs::common::TransportKind::Tcp || port == 0) {
+        log(tr("[重定向] 当前传输不支持重定向，忽略"));
+        return;
+    }
+    if (++redirectHops_ > kMaxRedirectHops) {
+        // 服务器随后会断开本连接，断开后按退避重连初始节点
+        log(tr("[重定向] 连续 %1 次重定向未被接受，稍后回到 %2:%3").arg(kMaxRedirectHops).arg(homeHost_).arg(homePort_));
+        redirectHops_ = 0;
+        returnHome();
+        return;
+    }
+    host_ = host.isEmpty() ? host_ : host;
+    endpoint_ = host_;
+    port_ = port;
+    awayFromHome_ = host_ != homeHost_ || port_ != homePort_;
+    log(tr("[重定向] 服务器要求改连 %1:%2").arg(host_).arg(port_));
+    emit endpointChanged(host_, port_, true);
+    // 旧连接上尚未处理的字节与排队的帧都作废；立即改连，不计入退避
+    parser_.clear();
+    sendQueue_.clear();
+    reconnectTimer_.start(0);
+    transport_->abort();
+}
+
+void ClientController::returnHome() {
+    host_ = homeHost_;
+    port_ = homePort_;
+    cs::common::transport_kind(host_, &endpoint_);
+    awayFromHome_ = false;
+    emit endpointChanged(host_, port_, false);
+}
+
+void ClientController::applyCommand(const AckMessage &ack) {
+    if (ack.cmd == CmdId::RetryAfter) {
+        // 服务器将要断开本连接(已满或停机)，按其分配的时间重连；已排好的重连也改期
+        reconnectPolicy_.setRetryAfter(static_cast<int>(ack.cmdPayload));
+        log(tr("[重连] 服务器要求 %1 毫秒后再重连").arg(ack.cmdPayload));
+        if (reconnectTimer_.isActive()) {
+            reconnectTimer_.stop();
+            scheduleReconnect();
         }
-        setAutoInterval(static_cast<int>(newInterval));
-        emit intervalUpdated(static_cast<int>(newInterval));
-        if (autoEnabled_ && socket_.state() == QAbstractSocket::ConnectedState) {
+        return;
+    }
+    if (ack.cmd == CmdId::SetInterval) {
+        const int newInterval = static_cast<int>(ack.cmdPayload);
+        if (newInterval == autoIntervalMs_) {
+            return;
+        }
+        setAutoInterval(newInterval);
+        emit intervalUpdated(newInterval);
+        if (autoEnabled_ && transport_->isConnected()) {
             autoTimer_.start();
         }
     }
 }
 
-bool ClientController::writeFrame(const QByteArray &payload, bool autoMode) {
-    if (socket_.state() != QAbstractSocket::ConnectedState) {
-        emit logMessage(tr("[错误] 当前未连接服务器,无法发送数据"));
-        if (shouldReconnect_ && !reconnectTimer_.isActive()) {
-            reconnectTimer_.start();
-        }
+void ClientController::handleNotification(const QByteArray &payload) {
+    QByteArray topic;
+    QByteArray body;
+    if (!split_notify_payload(payload, &topic, &body)) {
+        log(tr("[警告] 服务器推送格式错误"));
+        return;
+    }
+    const QString topicName = QString::fromUtf8(topic);
+    if (trafficLogWanted()) {
+        log(tr("[推送] %1 | %2")
+                            .arg(topicName.isEmpty() ? tr("广播") : topicName)
+                            .arg(QString::fromUtf8(body)));
+    }
+    emit notificationReceived(topicName, body);
+}
+
+bool ClientController::writeFrame(const QByteArray &payload, bool autoMode, SendPriority priority) {
+    if (!writeRequest(buildRequestPayload(payload), priority)) {
         return false;
     }
-    const QByteArray frame = build_frame(kDefaultVersion, buildRequestPayload(payload));
-    socket_.write(frame);
-    sentCount_++;
-    updateStatistics();
-    
+    if (!trafficLogWanted()) {
+        return true;
+    }
     if (autoMode) {
-        emit logMessage(tr("[发送] 自动发送 %1 字节").arg(payload.size()));
+        log(tr("[发送] 自动发送 %1 字节").arg(payload.size()));
     } else {
-        emit logMessage(tr("[发送] 已发送 %1 字节").arg(payload.size()));
+        log(tr("[发送] 已发送 %1 字节").arg(payload.size()));
     }
     return true;
 }
 
+bool ClientController::writeRequest(const QByteArray &requestPayload, SendPriority priority) {
+    if (!transport_->isConnected()) {
+        log(tr("[错误] 当前未连接服务器,无法发送数据"));
+        if (transport_->state() == cs::common::Transport::State::Unconnected) {
+            scheduleReconnect();
+        }
+        return false;
+    }
+    CS_ALLOC_SCOPE(Dispatch);
+    if (!requestPayload.isEmpty()) {
+        const auto type = static_cast<MsgType>(requestPayload.at(0));
+        if (type == MsgType::Command || type == MsgType::Subscribe || type == MsgType::Unsubscribe ||
+            type == MsgType::Hello) {
+            priority = SendPriority::Control;
+        }
+    }
+    sendQueue_.write(transport_, priority, build_frame(frameVersion_, requestPayload));
+    sentCount_++;
+    updateStatistics();
+    return true;
+}
+
 void ClientController::updateStatistics() {
-    emit statisticsUpdated(sentCount_, receivedCount_);
+    CS_ALLOC_SCOPE(Ui);
+    if (coalesceMs_ <= 0) {
+        emit statisticsUpdated(sentCount_, receivedCount_);
+        return;
+    }
+    statsDirty_ = true;
+    scheduleUiFlush();
+}
+
+void ClientController::log(const QString &line) {
+    CS_ALLOC_SCOPE(Ui);
+    if (coalesceMs_ <= 0) {
+        emit logMessage(line);
+        return;
+    }
+    pendingLog_.append(line);
+    scheduleUiFlush();
+}
+
+bool ClientController::trafficLogWanted() {
+    if (!logTraffic_) {
+        return false;
+    }
+    if (coalesceMs_ > 0 && pendingLog_.size() >= maxLogLines_) {
+        ++droppedLog_;
+        scheduleUiFlush();
+        return false;
+    }
+    return true;
+}
+
+void ClientController::scheduleUiFlush() {
+    if (!uiTimer_.isActive()) {
+        uiTimer_.start();
+    }
+}
+
+void ClientController::flushUiUpdates() {
+    CS_ALLOC_SCOPE(Ui);
+    uiTimer_.stop();
+    if (!pendingLog_.isEmpty() || droppedLog_ > 0) {
+        emit logBatch(std::exchange(pendingLog_, {}), std::exchange(droppedLog_, 0));
+    }
+    if (statsDirty_) {
+        statsDirty_ = false;
+        emit statisticsUpdated(sentCount_, receivedCount_);
+    }
 }
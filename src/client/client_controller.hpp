@@ -1,15 +1,20 @@
 #pragma once
 
 #include <QtCore/QByteArray>
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QTimer>
-#include <QtNetwork/QAbstractSocket>
-#include <QtNetwork/QTcpSocket>
 
 #include <optional>
 
 #include "common/protocol.hpp"
+#include "common/send_queue.hpp"
+#include "common/transport.hpp"
+#include "client_stream.hpp"
+#include "reconnect_policy.hpp"
 
 class ClientController : public QObject {
     Q_OBJECT
@@ -17,6 +22,9 @@ class ClientController : public QObject {
 public:
     explicit ClientController(QObject *parent = nullptr);
 
+    // 替换底层传输并接管其所有权，需在连接前调用；测试和基准借此接入回环传输，之后不再按地址切换传输
+    void setTransport(cs::common::Transport *transport);
+    // host为"unix:<路径>"或"shm:<路径>"时改用同机传输，port忽略
     void connectToHost(const QString &host, quint16 port);
     void disconnectFromHost();
     void sendPayload(const QByteArray &payload);
@@ -24,44 +32,120 @@ public:
     void setAutoPayload(const QByteArray &payload);
     void setAutoSending(bool enabled);
 
+    // 应用层合并发送：消息累积到maxBytes或最早一条等待满maxDelayMs后，以一个批量帧发出；maxBytes<=0关闭
+    void setBatching(int maxBytes, int maxDelayMs);
+    void queuePayload(const QByteArray &payload);
+    void flushBatch();
+    // 重连等待按指数退避并全区间随机化，服务器下发RetryAfter时以其为准
+    void setReconnectBackoff(int baseMs, int maxMs);
+    // 请求帧的版本(校验方式)：kVersionCrc16、kVersionCrc32c，或仅限同机传输的kVersionUnchecked；服务器按同一版本回ACK
+    void setFrameVersion(uint8_t version);
+    // 关闭后不再为每次发送/确认输出日志，供高速率的无界面模式使用
+    void setTrafficLogging(bool enabled);
+    // 控制器运行在网络线程、界面在主线程时使用：日志与统计在intervalMs内合并为一次logBatch/statisticsUpdated，
+    // 每批最多maxLines条收发日志，超出部分只计数；intervalMs<=0时逐条发出(默认)
+    void setUpdateCoalescing(int intervalMs, int maxLines);
+    // 客户端标识：非空时每次连接建立后首先发送Hello(MsgType=0x13)，集群据此把客户端分配到固定节点。
+    // 服务器下发Redirect时立即改连目标节点；重定向目标断开后回到connectToHost()给出的初始节点
+    void setClientId(const QString &id);
+    // 订阅服务器推送主题，重连后自动重新订阅
+    void subscribe(const QString &topic);
+    void unsubscribe(const QString &topic);
+    // 在本连接上新建一条逻辑流，归控制器所有；已达kMaxStreamsPerSession时返回nullptr。流跨重连保留
+    ClientStream *openStream(cs::common::SendPriority priority = cs::common::SendPriority::Interactive);
+    // 发送队列各优先级的排队统计：订阅/命令为Control，单条发送与自动发送为Interactive，queuePayload为Bulk；可跨线程读取
+    cs::common::SendQueue::ClassStats sendQueueStats(cs::common::SendPriority priority) const;
+
 signals:
     void statusChanged(QString status);
     void logMessage(QString message);
     void responseReceived(QByteArray payload);
     void intervalUpdated(int milliseconds);
     void statisticsUpdated(int sent, int received);  // 新增:统计信号
+    void logBatch(QStringList lines, int dropped);    // 开启合并时代替logMessage
+    void notificationReceived(QString topic, QByteArray body);
     void connected();
     void disconnected();
+    // 重连目标改变：redirected为true表示跟随服务器的重定向，false表示回到初始节点
+    void endpointChanged(QString host, quint16 port, bool redirected);
 
 private slots:
     void onConnected();
     void onDisconnected();
-    void onErrorOccurred(QAbstractSocket::SocketError error);
+    void onErrorOccurred(const QString &message);
     void onReadyRead();
     void handleAutoSend();
     void handleAckTimeout();
     void attemptReconnect();
 
 private:
-    bool writeFrame(const QByteArray &payload, bool autoMode);
+    friend class ClientStream;
+
+    // 未连接时不记日志直接返回false，由流在连接建立后重发
+    bool writeStreamRequest(uint16_t streamId, const QByteArray &requestPayload, cs::common::SendPriority priority);
+    void closeStream(ClientStream *stream);
+    void routeStreamAck(const cs::protocol::AckMessage &ack);
+    bool writeFrame(const QByteArray &payload, bool autoMode, cs::common::SendPriority priority);
+    // 命令、订阅类请求不论调用方给的级别一律按Control发送
+    bool writeRequest(const QByteArray &requestPayload, cs::common::SendPriority priority);
     QByteArray buildRequestPayload(const QByteArray &content);
     void handleAckPayload(const QByteArray &payload);
+    void handleNotification(const QByteArray &payload);
+    void handleServerCommand(const QByteArray &payload);
+    void applyCommand(const cs::protocol::AckMessage &ack);
+    void followRedirect(const QString &host, quint16 port);
+    void returnHome();
+    void attachTransport(cs::common::Transport *transport);
+    void scheduleReconnect();
+    void log(const QString &line);
+    // 本条收发日志是否需要生成：关闭收发日志或本批已满时返回false(后者计入丢弃数)
+    bool trafficLogWanted();
+    void scheduleUiFlush();
+    void flushUiUpdates();
 
-    QTcpSocket socket_;
+    cs::common::Transport *transport_;
     QTimer autoTimer_;
     QTimer reconnectTimer_;
     QTimer ackTimer_;
+    QTimer batchTimer_;
+    QTimer uiTimer_;
+    ReconnectPolicy reconnectPolicy_;
     QByteArray autoPayload_;
     int autoIntervalMs_ = 3000;
     int ackTimeoutMs_ = 5000;
     bool autoEnabled_ = false;
     bool shouldReconnect_ = false;
     bool awaitingAck_ = false;
+    bool logTraffic_ = true;
+    quint16 nextMsgId_ = 1;
+    QByteArray batchPayload_;
+    int batchCount_ = 0;
+    int batchMaxBytes_ = 0;
+    QSet<QString> topics_;
+    QHash<quint16, ClientStream *> streams_;
+    quint16 nextStreamId_ = 1;
     QString host_;
+    QString endpoint_;  // 去掉传输前缀后的地址
     quint16 port_ = 0;
+    // 集群节点间互相指向(成员表尚未收敛)时，连续这么多次重定向后不再跟随，按退避回到初始节点
+    static constexpr int kMaxRedirectHops = 3;
+    QByteArray clientId_;
+    QString homeHost_;  // connectToHost()给出的初始节点
+    quint16 homePort_ = 0;
+    bool awayFromHome_ = false;  // 当前连接的是重定向目标
+    int redirectHops_ = 0;       // 收到ACK前连续跟随的重定向次数
+    cs::common::TransportKind transportKind_ = cs::common::TransportKind::Tcp;
+    bool customTransport_ = false;
     cs::protocol::ProtocolParser parser_;
+    cs::common::SendQueue sendQueue_;
+    uint8_t frameVersion_ = cs::protocol::kDefaultVersion;
     int sentCount_ = 0;      // 新增:发送计数
     int receivedCount_ = 0;  // 新增:接收计数
+    int coalesceMs_ = 0;
+    int maxLogLines_ = 0;
+    QStringList pendingLog_;  // 等待下一次合并发出的日志
+    int droppedLog_ = 0;
+    bool statsDirty_ = false;
     
     void updateStatistics();  // 新增:更新统计
 };
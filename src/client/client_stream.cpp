@@ -0,0 +1,62 @@
+#include "client_stream.hpp"
+
+#include <iterator>
+
+#include "client_controller.hpp"
+
+using namespace cs::protocol;
+
+ClientStream::ClientStream(ClientController *controller, uint16_t id, cs::common::SendPriority priority)
+    : QObject(controller),
+      controller_(controller),
+      id_(id),
+      priority_(priority),
+      credit_(kStreamWindow) {}
+
+void ClientStream::send(const QByteArray &content) {
+    if (closed_) {
+        return;
+    }
+    pending_.push_back(Message{nextMsgId_++, content});
+    pump();
+}
+
+void ClientStream::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    pending_.clear();
+    controller_->closeStream(this);
+    deleteLater();
+}
+
+void ClientStream::onAck(bool ok, int credit) {
+    if (!inFlight_.empty()) {
+        const quint16 msgId = inFlight_.front().msgId;
+        inFlight_.pop_front();
+        emit acknowledged(msgId, ok);
+    }
+    credit_ = qMin(credit_ + credit, kStreamWindow);
+    pump();
+}
+
+void ClientStream::onConnectionReset() {
+    pending_.insert(pending_.begin(), std::make_move_iterator(inFlight_.begin()),
+                    std::make_move_iterator(inFlight_.end()));
+    inFlight_.clear();
+    credit_ = kStreamWindow;
+}
+
+void ClientStream::pump() {
+    while (credit_ > 0 && !pending_.empty()) {
+        const Message &message = pending_.front();
+        if (!controller_->writeStreamRequest(
+                id_, build_request_payload(MsgType::Text, message.msgId, message.content), priority_)) {
+            return;  // 未连接，留待连接建立后由控制器再次调用
+        }
+        inFlight_.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+        --credit_;
+    }
+}
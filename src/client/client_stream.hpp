@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+
+#include <deque>
+
+#include "common/send_queue.hpp"
+
+class ClientController;
+
+// 连接上的一条逻辑流(MsgType=0x04)，由ClientController::openStream()创建并归其所有，与控制器同线程使用。
+// 每条流有独立的MsgId序列、发送优先级和kStreamWindow帧的额度：额度用尽时消息在本地排队，
+// 收到ACK归还额度后按原顺序发出，一条慢流不会占用其他流的额度。
+class ClientStream : public QObject {
+    Q_OBJECT
+
+public:
+    uint16_t id() const { return id_; }
+    cs::common::SendPriority priority() const { return priority_; }
+    int credit() const { return credit_; }
+    int queued() const { return static_cast<int>(pending_.size()); }
+    bool isClosed() const { return closed_; }
+
+    // 按文本消息编码并立即分配MsgId；未连接时留在本地队列，连接建立后发出
+    void send(const QByteArray &content);
+    // 通知服务器释放该流并在本地删除(deleteLater)，尚未发出的消息丢弃
+    void close();
+
+signals:
+    void acknowledged(quint16 msgId, bool ok);
+
+private:
+    friend class ClientController;
+
+    ClientStream(ClientController *controller, uint16_t id, cs::common::SendPriority priority);
+
+    void onAck(bool ok, int credit);
+    // 连接断开后在途的帧不会再有ACK：额度恢复为满，未确认的消息沿用原MsgId放回队首重发。
+    // 服务器可能已处理过其中一部分，因此断线前后的流消息是至少一次送达
+    void onConnectionReset();
+    void pump();
+
+    ClientController *controller_;
+    uint16_t id_;
+    cs::common::SendPriority priority_;
+    int credit_;
+    struct Message {
+        quint16 msgId;
+        QByteArray content;
+    };
+
+    quint16 nextMsgId_ = 1;
+    std::deque<Message> pending_;   // 等待额度的消息
+    std::deque<Message> inFlight_;  // 已发出未确认的消息，ACK按发送顺序到达
+    bool closed_ = false;
+};
@@ -1,7 +1,9 @@
 #include "client_window.hpp"
 
-#include <QtCore/QDateTime>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
 #include <QtWidgets/QCheckBox>
+#include <QtWidgets/QComboBox>
 #include <QtWidgets/QFormLayout>
 #include <QtWidgets/QGridLayout>
 #include <QtWidgets/QGroupBox>
@@ -9,12 +11,23 @@
 #include <QtWidgets/QHeaderView>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QLineEdit>
+#include <QtWidgets/QListView>
 #include <QtWidgets/QPlainTextEdit>
 #include <QtWidgets/QPushButton>
+#include <QtWidgets/QScrollBar>
 #include <QtWidgets/QSpinBox>
 #include <QtWidgets/QVBoxLayout>
 
-ClientWindow::ClientWindow(QWidget *parent) : QMainWindow(parent) {
+ClientWindow::ClientWindow(QWidget *parent)
+    : QMainWindow(parent),
+      networkThread_(new QThread(this)),
+      controller_(new ClientController) {
+    networkThread_->setObjectName(QStringLiteral("net"));
+    controller_->setUpdateCoalescing(kUiUpdateMs, kMaxLogLinesPerUpdate);
+    controller_->moveToThread(networkThread_);
+    connect(networkThread_, &QThread::finished, controller_, &QObject::deleteLater);
+    networkThread_->start();
+
     auto *central = new QWidget(this);
     setCentralWidget(central);
 
@@ -66,12 +79,16 @@ ClientWindow::ClientWindow(QWidget *parent) : QMainWindow(parent) {
     sentLabel_->setStyleSheet("QLabel { font-weight: bold; }");
     receivedLabel_->setStyleSheet("QLabel { font-weight: bold; color: green; }");
     
-    // 日志视图
-    logView_ = new QPlainTextEdit(central);
-    logView_->setReadOnly(true);
-    logView_->setMaximumBlockCount(1000);
+    // 日志视图：环形缓冲模型 + 等高行的虚拟化列表，只绘制可见行
+    logModel_ = new cs::common::LogModel(cs::common::LogModel::kDefaultCapacity, this);
+    logView_ = new QListView(central);
+    logView_->setModel(logModel_);
+    logView_->setUniformItemSizes(true);
+    logView_->setLayoutMode(QListView::Batched);
+    logView_->setEditTriggers(QListView::NoEditTriggers);
+    logView_->setSelectionMode(QListView::ExtendedSelection);
     logView_->setStyleSheet(
-        "QPlainTextEdit { "
+        "QListView { "
         "   background-color: #f5f5f5; "
         "   font-family: 'Consolas', 'Courier New', monospace; "
         "   font-size: 9pt; "
@@ -95,6 +112,15 @@ ClientWindow::ClientWindow(QWidget *parent) : QMainWindow(parent) {
     connLayout->addWidget(statusIndicator_, 1, 1);
     connLayout->addWidget(statusLabel_, 1, 2, 1, 3);
 
+    topicEdit_ = new QLineEdit(connGroup);
+    topicEdit_->setPlaceholderText(tr("服务器推送主题"));
+    subscribeBtn_ = new QPushButton(tr("订阅"), connGroup);
+    unsubscribeBtn_ = new QPushButton(tr("取消订阅"), connGroup);
+    connLayout->addWidget(new QLabel(tr("订阅主题:"), connGroup), 2, 0);
+    connLayout->addWidget(topicEdit_, 2, 1, 1, 2);
+    connLayout->addWidget(subscribeBtn_, 2, 3);
+    connLayout->addWidget(unsubscribeBtn_, 2, 4);
+
     // 数据发送组
     auto *payloadGroup = new QGroupBox(tr("数据发送"), central);
     auto *payloadLayout = new QVBoxLayout(payloadGroup);
@@ -121,9 +147,23 @@ ClientWindow::ClientWindow(QWidget *parent) : QMainWindow(parent) {
     statsLayout->addWidget(receivedLabel_);
     statsLayout->addStretch();
 
-    // 日志组
+    // 日志组：按级别、分类过滤并搜索内容
     auto *logGroup = new QGroupBox(tr("通信日志"), central);
     auto *logLayout = new QVBoxLayout(logGroup);
+    logLevelCombo_ = new QComboBox(logGroup);
+    logLevelCombo_->addItem(tr("全部级别"), int(cs::common::LogLevel::Debug));
+    logLevelCombo_->addItem(tr("警告及以上"), int(cs::common::LogLevel::Warn));
+    logLevelCombo_->addItem(tr("仅错误"), int(cs::common::LogLevel::Error));
+    logCategoryCombo_ = new QComboBox(logGroup);
+    logCategoryCombo_->addItem(tr("全部分类"));
+    logSearchEdit_ = new QLineEdit(logGroup);
+    logSearchEdit_->setPlaceholderText(tr("搜索日志内容"));
+    logSearchEdit_->setClearButtonEnabled(true);
+    auto *logFilterLayout = new QHBoxLayout;
+    logFilterLayout->addWidget(logLevelCombo_);
+    logFilterLayout->addWidget(logCategoryCombo_);
+    logFilterLayout->addWidget(logSearchEdit_, 1);
+    logLayout->addLayout(logFilterLayout);
     logLayout->addWidget(logView_);
 
     // 主布局
@@ -143,31 +183,71 @@ ClientWindow::ClientWindow(QWidget *parent) : QMainWindow(parent) {
     // 信号连接
     connect(connectBtn_, &QPushButton::clicked, this, &ClientWindow::handleConnectToggle);
     connect(sendBtn_, &QPushButton::clicked, this, &ClientWindow::handleSendClicked);
+    connect(subscribeBtn_, &QPushButton::clicked, this, [this]() {
+        const QString topic = topicEdit_->text().trimmed();
+        QMetaObject::invokeMethod(controller_, [controller = controller_, topic]() { controller->subscribe(topic); });
+    });
+    connect(unsubscribeBtn_, &QPushButton::clicked, this, [this]() {
+        const QString topic = topicEdit_->text().trimmed();
+        QMetaObject::invokeMethod(controller_, [controller = controller_, topic]() { controller->unsubscribe(topic); });
+    });
     connect(autoCheck_, &QCheckBox::toggled, this, &ClientWindow::handleAutoToggled);
-    connect(intervalSpin_, qOverload<int>(&QSpinBox::valueChanged), &controller_, &ClientController::setAutoInterval);
+    connect(intervalSpin_, qOverload<int>(&QSpinBox::valueChanged), controller_, &ClientController::setAutoInterval);
     connect(payloadEdit_, &QPlainTextEdit::textChanged, this, [this]() {
-        controller_.setAutoPayload(currentPayload());
+        const QByteArray payload = currentPayload();
+        QMetaObject::invokeMethod(controller_, [controller = controller_, payload]() { controller->setAutoPayload(payload); });
     });
 
-    connect(&controller_, &ClientController::statusChanged, this, &ClientWindow::handleStatusChanged);
-    connect(&controller_, &ClientController::logMessage, this, &ClientWindow::handleLog);
-    connect(&controller_, &ClientController::intervalUpdated, this, &ClientWindow::handleIntervalUpdated);
-    connect(&controller_, &ClientController::statisticsUpdated, this, &ClientWindow::handleStatisticsUpdated);
+    // 跨线程连接，均为排队调用
+    connect(controller_, &ClientController::statusChanged, this, &ClientWindow::handleStatusChanged);
+    connect(controller_, &ClientController::logMessage, this, &ClientWindow::handleLog);
+    connect(controller_, &ClientController::logBatch, this, &ClientWindow::handleLogBatch);
+    connect(controller_, &ClientController::intervalUpdated, this, &ClientWindow::handleIntervalUpdated);
+    connect(controller_, &ClientController::statisticsUpdated, this, &ClientWindow::handleStatisticsUpdated);
+
+    connect(logView_->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        followLog_ = value == logView_->verticalScrollBar()->maximum();
+    });
+    connect(logModel_, &cs::common::LogModel::rowsAppended, this, [this]() {
+        if (followLog_) {
+            logView_->scrollToBottom();
+        }
+    });
+    connect(logModel_, &cs::common::LogModel::categoryAdded, logCategoryCombo_,
+            [this](const QString &category) { logCategoryCombo_->addItem(category); });
+    connect(logLevelCombo_, qOverload<int>(&QComboBox::currentIndexChanged), this, &ClientWindow::applyLogFilter);
+    connect(logCategoryCombo_, qOverload<int>(&QComboBox::currentIndexChanged), this, &ClientWindow::applyLogFilter);
+    logFilterTimer_ = new QTimer(this);
+    logFilterTimer_->setSingleShot(true);
+    logFilterTimer_->setInterval(kLogFilterDebounceMs);
+    connect(logFilterTimer_, &QTimer::timeout, this, &ClientWindow::applyLogFilter);
+    connect(logSearchEdit_, &QLineEdit::textChanged, logFilterTimer_, qOverload<>(&QTimer::start));
     
     appendLog(tr("[系统] 客户端已就绪"));
 }
 
+ClientWindow::~ClientWindow() {
+    // 控制器随网络线程结束在该线程中销毁，连接由传输析构时关闭
+    networkThread_->quit();
+    networkThread_->wait();
+}
+
 void ClientWindow::handleConnectToggle() {
     const bool connected = (statusLabel_->text() == tr("已连接"));
     if (connected) {
-        controller_.disconnectFromHost();
+        QMetaObject::invokeMethod(controller_, &ClientController::disconnectFromHost);
     } else {
-        controller_.connectToHost(hostEdit_->text(), static_cast<quint16>(portSpin_->value()));
+        const QString host = hostEdit_->text();
+        const auto port = static_cast<quint16>(portSpin_->value());
+        QMetaObject::invokeMethod(controller_, [controller = controller_, host, port]() {
+            controller->connectToHost(host, port);
+        });
     }
 }
 
 void ClientWindow::handleSendClicked() {
-    controller_.sendPayload(currentPayload());
+    const QByteArray payload = currentPayload();
+    QMetaObject::invokeMethod(controller_, [controller = controller_, payload]() { controller->sendPayload(payload); });
 }
 
 void ClientWindow::handleStatusChanged(const QString &status) {
@@ -201,6 +281,15 @@ void ClientWindow::handleLog(const QString &message) {
     appendLog(message);
 }
 
+void ClientWindow::handleLogBatch(const QStringList &lines, int dropped) {
+    for (const QString &line : lines) {
+        appendLog(line);
+    }
+    if (dropped > 0) {
+        appendLog(tr("[日志] 收发过快，省略 %1 条收发记录").arg(dropped));
+    }
+}
+
 void ClientWindow::handleIntervalUpdated(int value) {
     intervalSpin_->blockSignals(true);
     intervalSpin_->setValue(value);
@@ -212,8 +301,11 @@ void ClientWindow::handleIntervalUpdated(int value) {
 }
 
 void ClientWindow::handleAutoToggled(bool checked) {
-    controller_.setAutoPayload(currentPayload());
-    controller_.setAutoSending(checked);
+    const QByteArray payload = currentPayload();
+    QMetaObject::invokeMethod(controller_, [controller = controller_, payload, checked]() {
+        controller->setAutoPayload(payload);
+        controller->setAutoSending(checked);
+    });
     autoCheck_->setText(checked ? tr("自动发送中...") : tr("启用自动发送"));
     
     if (checked) {
@@ -236,8 +328,16 @@ void ClientWindow::handleStatisticsUpdated(int sent, int received) {
 }
 
 void ClientWindow::appendLog(const QString &line) {
-    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    logView_->appendPlainText(QString("[%1] %2").arg(timestamp, line));
+    logModel_->appendLine(line);
+}
+
+void ClientWindow::applyLogFilter() {
+    cs::common::LogModel::Filter filter;
+    filter.minLevel = static_cast<cs::common::LogLevel>(logLevelCombo_->currentData().toInt());
+    filter.category = logCategoryCombo_->currentIndex() > 0 ? logCategoryCombo_->currentText() : QString();
+    filter.text = logSearchEdit_->text();
+    followLog_ = true;
+    logModel_->setFilter(filter);
 }
 
 QByteArray ClientWindow::currentPayload() const {
@@ -3,40 +3,60 @@
 #include <QtWidgets/QMainWindow>
 
 #include "client_controller.hpp"
+#include "common/log_model.hpp"
 
 class QCheckBox;
+class QComboBox;
 class QLabel;
 class QLineEdit;
+class QListView;
 class QPlainTextEdit;
 class QPushButton;
 class QSpinBox;
+class QThread;
+class QTimer;
 
 class ClientWindow : public QMainWindow {
     Q_OBJECT
 
 public:
     explicit ClientWindow(QWidget *parent = nullptr);
+    ~ClientWindow() override;
+
+    // 网络线程上的日志/统计最多每kUiUpdateMs送到界面一次，每次最多kMaxLogLinesPerUpdate条收发日志
+    static constexpr int kUiUpdateMs = 100;
+    static constexpr int kMaxLogLinesPerUpdate = 50;
+    // 搜索框停止输入这么久后才重建过滤结果
+    static constexpr int kLogFilterDebounceMs = 250;
 
 private slots:
     void handleConnectToggle();
     void handleSendClicked();
     void handleStatusChanged(const QString &status);
     void handleLog(const QString &message);
+    void handleLogBatch(const QStringList &lines, int dropped);
     void handleIntervalUpdated(int value);
     void handleAutoToggled(bool checked);
     void handleStatisticsUpdated(int sent, int received);
 
 private:
     void appendLog(const QString &line);
+    void applyLogFilter();
     QByteArray currentPayload() const;
 
-    ClientController controller_;
+    // 套接字、自动发送与ACK定时器都在网络线程上运行，界面卡顿不影响发送节奏与测得的延迟；
+    // 界面对控制器的调用一律经排队调用投递
+    QThread *networkThread_;
+    ClientController *controller_;
 
     QLineEdit *hostEdit_;
     QSpinBox *portSpin_;
     QPushButton *connectBtn_;
     QLabel *statusLabel_;
     QLabel *statusIndicator_;  // 新增:状态指示器
+    QLineEdit *topicEdit_;
+    QPushButton *subscribeBtn_;
+    QPushButton *unsubscribeBtn_;
     QPlainTextEdit *payloadEdit_;
     QPushButton *sendBtn_;
     QCheckBox *autoCheck_;
@@ -44,5 +64,11 @@ private:
     QLabel *serverControlled_;  // 新增:服务器控制提示
     QLabel *sentLabel_;         // 新增:发送统计
     QLabel *receivedLabel_;     // 新增:接收统计
-    QPlainTextEdit *logView_;
+    cs::common::LogModel *logModel_;
+    QListView *logView_;
+    QComboBox *logLevelCombo_;
+    QComboBox *logCategoryCombo_;
+    QLineEdit *logSearchEdit_;
+    QTimer *logFilterTimer_;
+    bool followLog_ = true;  // 视图停在底部时新日志自动滚动
 };
@@ -0,0 +1,187 @@
+#include "datagram_sender.hpp"
+
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QHostInfo>
+#include <QtNetwork/QUdpSocket>
+
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "common/protocol.hpp"
+
+using namespace cs::protocol;
+
+DatagramSender::DatagramSender(QObject *parent)
+    : QObject(parent) {
+}
+
+DatagramSender::~DatagramSender() {
+    release();
+}
+
+bool DatagramSender::open(const QString &host, quint16 port) {
+    close();
+    const QHostAddress address(host);
+    if (!address.isNull()) {
+        return openAddress(address, port);
+    }
+    // 不用阻塞的QHostInfo::fromName：发送器所在的网络线程上还有其他连接
+    lookupId_ = QHostInfo::lookupHost(host, this, [this, host, port](const QHostInfo &info) {
+        onHostResolved(info, host, port);
+    });
+    return true;
+}
+
+void DatagramSender::onHostResolved(const QHostInfo &info, const QString &host, quint16 port) {
+    if (info.lookupId() != lookupId_) {
+        return;  // 已被close()或新的open()取代
+    }
+    lookupId_ = -1;
+    if (info.error() != QHostInfo::NoError || info.addresses().isEmpty()) {
+        emit logMessage(QStringLiteral("[错误] 无法解析地址 %1: %2").arg(host, info.errorString()));
+        return;
+    }
+    openAddress(info.addresses().constFirst(), port);
+}
+
+bool DatagramSender::openAddress(const QHostAddress &address, quint16 port) {
+#ifdef Q_OS_LINUX
+    // 已连接的UDP套接字：sendmmsg无需逐条携带目标地址，内核也省去每次路由查找
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        auto *addr = reinterpret_cast<sockaddr_in6 *>(&storage);
+        addr->sin6_family = AF_INET6;
+        addr->sin6_port = htons(port);
+        const Q_IPV6ADDR raw = address.toIPv6Address();
+        std::memcpy(addr->sin6_addr.s6_addr, raw.c, 16);
+        length = sizeof(sockaddr_in6);
+    } else {
+        auto *addr = reinterpret_cast<sockaddr_in *>(&storage);
+        addr->sin_family = AF_INET;
+        addr->sin_port = htons(port);
+        addr->sin_addr.s_addr = htonl(address.toIPv4Address());
+        length = sizeof(sockaddr_in);
+    }
+    fd_ = ::socket(storage.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr *>(&storage), length) != 0) {
+        emit logMessage(QStringLiteral("[错误] UDP套接字打开失败: %1").arg(QString::fromLocal8Bit(std::strerror(errno))));
+        release();
+        return false;
+    }
+#else
+    socket_ = new QUdpSocket(this);
+    host_ = address.toString();
+    port_ = port;
+#endif
+    emit logMessage(QStringLiteral("[UDP] 发送到 %1:%2，每个数据报最多 %3 字节").arg(address.toString()).arg(port).arg(datagramBytes_));
+    emit connected();
+    return true;
+}
+
+void DatagramSender::close() {
+    flush();
+    release();
+}
+
+void DatagramSender::release() {
+    if (lookupId_ >= 0) {
+        QHostInfo::abortHostLookup(lookupId_);
+        lookupId_ = -1;
+    }
+    current_.clear();
+    ready_.clear();
+    flushScheduled_ = false;
+#ifdef Q_OS_LINUX
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#else
+    delete socket_;
+    socket_ = nullptr;
+#endif
+}
+
+void DatagramSender::setDatagramBytes(int bytes) {
+    datagramBytes_ = qBound(64, bytes, 65507);
+}
+
+void DatagramSender::queuePayload(const QByteArray &content) {
+    const QByteArray frame = build_frame(kDefaultVersion, build_request_payload(MsgType::Text, nextMsgId_++, content));
+    // 单帧超过上限时独占一个数据报，由IP层分片
+    if (!current_.isEmpty() && current_.size() + frame.size() > datagramBytes_) {
+        ready_.push_back(std::move(current_));
+        current_ = QByteArray();
+    }
+    if (current_.isEmpty()) {
+        current_.reserve(datagramBytes_);
+    }
+    current_.append(frame);
+    ++sentCount_;
+    if (!flushScheduled_) {
+        flushScheduled_ = true;
+        QTimer::singleShot(0, this, [this]() { flush(); });
+    }
+}
+
+void DatagramSender::flush() {
+    flushScheduled_ = false;
+    if (!current_.isEmpty()) {
+        ready_.push_back(std::move(current_));
+        current_ = QByteArray();
+    }
+    if (ready_.empty()) {
+        return;
+    }
+    sendDatagrams();
+    ready_.clear();
+    emit statisticsUpdated(sentCount_, 0);
+}
+
+void DatagramSender::sendDatagrams() {
+#ifdef Q_OS_LINUX
+    if (fd_ < 0) {
+        return;
+    }
+    mmsghdr messages[kSendBurst];
+    iovec iovecs[kSendBurst];
+    std::size_t offset = 0;
+    while (offset < ready_.size()) {
+        const int count = static_cast<int>(qMin<std::size_t>(kSendBurst, ready_.size() - offset));
+        for (int i = 0; i < count; ++i) {
+            QByteArray &datagram = ready_[offset + static_cast<std::size_t>(i)];
+            iovecs[i].iov_base = datagram.data();
+            iovecs[i].iov_len = static_cast<std::size_t>(datagram.size());
+            std::memset(&messages[i], 0, sizeof(mmsghdr));
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int sent = ::sendmmsg(fd_, messages, static_cast<unsigned int>(count), 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 发送缓冲满等错误直接丢弃剩余数据报，遥测不重传
+            emit logMessage(QStringLiteral("[UDP] 发送失败: %1").arg(QString::fromLocal8Bit(std::strerror(errno))));
+            return;
+        }
+        offset += static_cast<std::size_t>(qMax(1, sent));
+    }
+#else
+    if (!socket_) {
+        return;
+    }
+    const QHostAddress address(host_);
+    for (const QByteArray &datagram : ready_) {
+        socket_->writeDatagram(datagram, address, port_);
+    }
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <vector>
+
+class QHostAddress;
+class QHostInfo;
+class QUdpSocket;
+
+// UDP遥测发送：消息按TCP相同格式编码成帧，多帧拼入一个数据报(不超过datagramBytes)，
+// 没有ACK也不重传。Linux上用sendmmsg一次提交一批数据报。
+class DatagramSender : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultDatagramBytes = 1400;  // 留在常见MTU以内，避免IP分片
+    static constexpr int kSendBurst = 64;
+
+    explicit DatagramSender(QObject *parent = nullptr);
+    ~DatagramSender() override;
+
+    // host为IP时立即打开；为主机名时异步解析，打开后发出connected()，失败只记日志。
+    // 返回false表示已确定无法打开
+    bool open(const QString &host, quint16 port);
+    // 发出已排队的数据报后关闭
+    void close();
+    void setDatagramBytes(int bytes);
+
+    // 与ClientController::queuePayload相同的语义：按文本消息编码，当前事件循环轮次结束时统一发出
+    void queuePayload(const QByteArray &content);
+    void flush();
+
+signals:
+    void connected();
+    void statisticsUpdated(int sent, int received);
+    void logMessage(QString message);
+
+private:
+    bool openAddress(const QHostAddress &address, quint16 port);
+    void onHostResolved(const QHostInfo &info, const QString &host, quint16 port);
+    // 停止解析并关闭套接字，不发信号；未发出的数据报丢弃(遥测不重传)
+    void release();
+    void sendDatagrams();
+
+    int datagramBytes_ = kDefaultDatagramBytes;
+    quint16 nextMsgId_ = 1;
+    int sentCount_ = 0;
+    int lookupId_ = -1;  // 进行中的主机名解析
+    bool flushScheduled_ = false;
+    QByteArray current_;             // 正在拼装的数据报
+    std::vector<QByteArray> ready_;  // 已拼满、等待提交的数据报
+#ifdef Q_OS_LINUX
+    int fd_ = -1;
+#else
+    QUdpSocket *socket_ = nullptr;
+    QString host_;
+    quint16 port_ = 0;
+#endif
+};
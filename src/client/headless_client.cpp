@@ -0,0 +1,366 @@
+#include "headless_client.hpp"
+
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <algorithm>
+#include <utility>
+
+#include "client_controller.hpp"
+#include "datagram_sender.hpp"
+
+namespace {
+
+constexpr int kTickMs = 10;
+constexpr int kUnlimitedChunkPerConnection = 64;
+constexpr int kDrainMs = 500;
+
+}  // namespace
+
+HeadlessClient::HeadlessClient(HeadlessOptions options, QObject *parent)
+    : QObject(parent),
+      options_(std::move(options)),
+      out_(stdout) {
+    options_.connections = qMax(1, options_.connections);
+    const int threadCount = options_.threads > 0
+                                ? options_.threads
+                                : qMin(options_.connections, qMax(1, QThread::idealThreadCount()));
+    for (int i = 0; i < threadCount; ++i) {
+        auto *thread = new QThread(this);
+        thread->setObjectName(QStringLiteral("net-%1").arg(i));
+        thread->start();
+        threads_.push_back(thread);
+    }
+
+    payloadTemplate_ = QByteArray(qMax(1, options_.payloadBytes), 'x');
+
+    for (int i = 0; i < options_.connections; ++i) {
+        auto conn = std::make_unique<Connection>();
+        Connection *raw = conn.get();
+        const auto onConnected = [this, raw]() {
+            raw->connected = true;
+            if (running_) {
+                ++reconnects_;
+            }
+            const bool all = std::all_of(connections_.begin(), connections_.end(),
+                                         [](const auto &c) { return c->connected.load(); });
+            if (all && !running_) {
+                beginWorkload();
+            }
+        };
+        QThread *thread = threads_[static_cast<std::size_t>(i) % threads_.size()];
+        if (options_.datagram) {
+            auto *sender = new DatagramSender;
+            if (options_.batchBytes > 0) {
+                sender->setDatagramBytes(options_.batchBytes);  // UDP模式下batch-bytes即数据报大小
+            }
+            connect(sender, &DatagramSender::statisticsUpdated, sender, [raw](int sent, int) {
+                raw->sent = sent;
+            }, Qt::DirectConnection);
+            connect(sender, &DatagramSender::connected, this, onConnected);
+            connect(sender, &DatagramSender::logMessage, this, [this](const QString &message) {
+                out_ << message << Qt::endl;
+            });
+            sender->moveToThread(thread);
+            conn->sender = sender;
+            connections_.push_back(std::move(conn));
+            continue;
+        }
+        auto *controller = new ClientController;
+        controller->setTrafficLogging(false);
+        controller->setBatching(options_.batchBytes, options_.batchDelayMs);
+        controller->setReconnectBackoff(options_.reconnectBaseMs, options_.reconnectMaxMs);
+        controller->setFrameVersion(options_.frameVersion);
+        if (!options_.clientIdPrefix.isEmpty()) {
+            controller->setClientId(QStringLiteral("%1-%2").arg(options_.clientIdPrefix).arg(i));
+        }
+        conn->port = options_.port;
+        for (int s = 0; s < options_.streams; ++s) {
+            if (ClientStream *stream = controller->openStream()) {
+                conn->streams.push_back(stream);
+            }
+        }
+        // 统计在网络线程中直接写入原子量，主线程按周期读取，避免逐条跨线程信号
+        connect(controller, &ClientController::statisticsUpdated, controller, [raw](int sent, int received) {
+            raw->sent = sent;
+            raw->acked = received;
+        }, Qt::DirectConnection);
+        connect(controller, &ClientController::connected, this, onConnected);
+        connect(controller, &ClientController::disconnected, this, [raw]() {
+            raw->connected = false;
+        });
+        connect(controller, &ClientController::endpointChanged, controller,
+                [raw](const QString &, quint16 port, bool redirected) {
+                    raw->port = port;
+                    raw->redirects += redirected ? 1 : 0;
+                }, Qt::DirectConnection);
+        controller->moveToThread(thread);
+        conn->controller = controller;
+        connections_.push_back(std::move(conn));
+    }
+
+    tickTimer_.setTimerType(Qt::PreciseTimer);
+    tickTimer_.setInterval(kTickMs);
+    connect(&tickTimer_, &QTimer::timeout, this, &HeadlessClient::dispatchDue);
+
+    reportTimer_.setInterval(1000);
+    connect(&reportTimer_, &QTimer::timeout, this, [this]() { report(false); });
+
+    connectTimeout_.setSingleShot(true);
+    connectTimeout_.setInterval(5000);
+    connect(&connectTimeout_, &QTimer::timeout, this, [this]() {
+        if (!running_) {
+            out_ << "[警告] 部分连接未能在5秒内建立，使用已连接的连接开始测试" << Qt::endl;
+            beginWorkload();
+        }
+    });
+}
+
+HeadlessClient::~HeadlessClient() {
+    // 控制器与发送器(及其套接字、定时器)须在所属的网络线程上析构：先投递deleteLater再结束线程，
+    // QThread在事件循环退出后、线程结束前处理剩余的延迟删除
+    for (auto &conn : connections_) {
+        if (conn->controller) {
+            conn->controller->deleteLater();
+            conn->controller = nullptr;
+        }
+        if (conn->sender) {
+            conn->sender->deleteLater();
+            conn->sender = nullptr;
+        }
+    }
+    for (auto *thread : threads_) {
+        thread->quit();
+    }
+    for (auto *thread : threads_) {
+        thread->wait();
+    }
+}
+
+void HeadlessClient::start() {
+    out_ << QStringLiteral("[无界面] 目标 %1%2:%3 连接数=%3 线程数=%4 速率=%5条/秒 负载=%6字节 分发=%7")
+                .arg(options_.datagram ? QStringLiteral("udp:") : QString())
+                .arg(options_.host)
+                .arg(options_.port)
+                .arg(options_.connections)
+                .arg(threads_.size())
+                .arg(options_.messagesPerSec > 0 ? QString::number(options_.messagesPerSec) : QStringLiteral("不限"))
+                .arg(options_.payloadBytes)
+                .arg(options_.dispatch == HeadlessOptions::Dispatch::KeyHash ? QStringLiteral("按key哈希")
+                                                                            : QStringLiteral("轮询"))
+         << Qt::endl;
+    for (auto &conn : connections_) {
+        const QString host = options_.host;
+        const quint16 port = options_.port;
+        if (DatagramSender *sender = conn->sender) {
+            QMetaObject::invokeMethod(sender, [sender, host, port]() {
+                sender->open(host, port);
+            }, Qt::QueuedConnection);
+            continue;
+        }
+        ClientController *controller = conn->controller;
+        QMetaObject::invokeMethod(controller, [controller, host, port]() {
+            controller->connectToHost(host, port);
+        }, Qt::QueuedConnection);
+    }
+    connectTimeout_.start();
+}
+
+void HeadlessClient::beginWorkload() {
+    running_ = true;
+    connectTimeout_.stop();
+    clock_.start();
+    intervalClock_.start();
+    tickTimer_.start();
+    reportTimer_.start();
+    QTimer::singleShot(options_.durationSec * 1000, this, [this]() {
+        tickTimer_.stop();
+        reportTimer_.stop();
+        for (auto &conn : connections_) {
+            if (conn->sender) {
+                QMetaObject::invokeMethod(conn->sender, [sender = conn->sender]() { sender->flush(); }, Qt::QueuedConnection);
+            } else {
+                QMetaObject::invokeMethod(conn->controller, &ClientController::flushBatch, Qt::QueuedConnection);
+            }
+        }
+        // 留出时间接收最后一批ACK
+        QTimer::singleShot(kDrainMs, this, [this]() {
+            report(true);
+            for (auto &conn : connections_) {
+                if (conn->sender) {
+                    QMetaObject::invokeMethod(conn->sender, [sender = conn->sender]() { sender->close(); }, Qt::QueuedConnection);
+                } else {
+                    QMetaObject::invokeMethod(conn->controller, &ClientController::disconnectFromHost, Qt::QueuedConnection);
+                }
+            }
+            QTimer::singleShot(kDrainMs, this, &HeadlessClient::finished);
+        });
+    });
+}
+
+void HeadlessClient::dispatchDue() {
+    quint64 due = 0;
+    if (options_.messagesPerSec > 0) {
+        due = static_cast<quint64>(clock_.elapsed()) * static_cast<quint64>(options_.messagesPerSec) / 1000;
+    } else {
+        due = dispatched_ + static_cast<quint64>(connections_.size()) * kUnlimitedChunkPerConnection;
+    }
+    if (due <= dispatched_) {
+        return;
+    }
+
+    // 每条消息附带所选流的下标；未开流时恒为0且不使用
+    std::vector<QVector<QPair<int, QByteArray>>> perConnection(connections_.size());
+    for (; dispatched_ < due; ++dispatched_) {
+        const int index = pickConnection(dispatched_);
+        const auto streamCount = static_cast<quint64>(qMax<std::size_t>(1, connections_[index]->streams.size()));
+        if (options_.dispatch == HeadlessOptions::Dispatch::KeyHash) {
+            const quint64 key = dispatched_ % static_cast<quint64>(qMax(1, options_.keyCount));
+            perConnection[index].append({static_cast<int>(key % streamCount), QByteArray::number(key) + ':' + payloadTemplate_});
+        } else {
+            perConnection[index].append({static_cast<int>(dispatched_ % streamCount), payloadTemplate_});
+        }
+    }
+    // 每个连接每个周期只投递一次，减少跨线程事件数量
+    for (std::size_t i = 0; i < connections_.size(); ++i) {
+        if (perConnection[i].isEmpty()) {
+            continue;
+        }
+        if (DatagramSender *sender = connections_[i]->sender) {
+            QMetaObject::invokeMethod(sender, [sender, batch = std::move(perConnection[i])]() {
+                for (const auto &entry : batch) {
+                    sender->queuePayload(entry.second);
+                }
+            }, Qt::QueuedConnection);
+            continue;
+        }
+        ClientController *controller = connections_[i]->controller;
+        const std::vector<ClientStream *> &streams = connections_[i]->streams;
+        QMetaObject::invokeMethod(controller, [controller, streams, batch = std::move(perConnection[i])]() {
+            for (const auto &entry : batch) {
+                if (streams.empty()) {
+                    controller->queuePayload(entry.second);
+                } else {
+                    streams[static_cast<std::size_t>(entry.first)]->send(entry.second);
+                }
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+int HeadlessClient::pickConnection(quint64 sequence) {
+    const auto count = static_cast<quint64>(connections_.size());
+    if (options_.dispatch == HeadlessOptions::Dispatch::KeyHash) {
+        const quint64 key = sequence % static_cast<quint64>(qMax(1, options_.keyCount));
+        return static_cast<int>(qHash(key) % count);
+    }
+    return static_cast<int>(roundRobin_++ % count);
+}
+
+void HeadlessClient::report(bool final) {
+    const double seconds = qMax<qint64>(1, final ? clock_.elapsed() : intervalClock_.restart()) / 1000.0;
+    int totalSent = 0;
+    int totalAcked = 0;
+    int sentDelta = 0;
+    int ackedDelta = 0;
+    int connected = 0;
+    QStringList details;
+    for (std::size_t i = 0; i < connections_.size(); ++i) {
+        auto &conn = *connections_[i];
+        const int sent = conn.sent.load();
+        const int acked = conn.acked.load();
+        const int ds = final ? sent : sent - conn.lastSent;
+        const int da = final ? acked : acked - conn.lastAcked;
+        conn.lastSent = sent;
+        conn.lastAcked = acked;
+        totalSent += sent;
+        totalAcked += acked;
+        sentDelta += ds;
+        ackedDelta += da;
+        connected += conn.connected ? 1 : 0;
+        details.append(QStringLiteral("  #%1 发送 %2 帧/s 确认 %3 帧/s")
+                           .arg(i)
+                           .arg(ds / seconds, 0, 'f', 0)
+                           .arg(da / seconds, 0, 'f', 0));
+    }
+
+    const quint64 reconnectDelta = final ? reconnects_ : reconnects_ - lastReconnects_;
+    lastReconnects_ = reconnects_;
+    out_ << QStringLiteral("%1[%2s] 合计 发送 %3 帧/s 确认 %4 帧/s | 已分发 %5 条 | 累计 发送 %6 确认 %7 | 在线 %8/%9 | 重连 %10/s")
+                .arg(final ? QStringLiteral("[汇总]") : QString())
+                .arg(clock_.elapsed() / 1000.0, 0, 'f', 1)
+                .arg(sentDelta / seconds, 0, 'f', 0)
+                .arg(ackedDelta / seconds, 0, 'f', 0)
+                .arg(dispatched_)
+                .arg(totalSent)
+                .arg(totalAcked)
+                .arg(connected)
+                .arg(connections_.size())
+                .arg(reconnectDelta / seconds, 0, 'f', 1)
+         << Qt::endl;
+    if (final) {
+        reportSendQueues();
+        reportNodes();
+    }
+    // 连接较多时只在汇总中逐条输出
+    if (final || connections_.size() <= 16) {
+        for (const QString &line : std::as_const(details)) {
+            out_ << line << Qt::endl;
+        }
+    }
+}
+
+void HeadlessClient::reportNodes() {
+    if (options_.clientIdPrefix.isEmpty()) {
+        return;
+    }
+    // 结束时各连接的重连目标；重定向目标断开后连接会先回到初始端口，再被重新分配
+    QMap<int, int> perPort;
+    int redirects = 0;
+    for (const auto &conn : connections_) {
+        ++perPort[conn->port.load()];
+        redirects += conn->redirects.load();
+    }
+    QStringList parts;
+    for (auto it = perPort.cbegin(); it != perPort.cend(); ++it) {
+        parts.append(QStringLiteral("%1×%2").arg(it.key()).arg(it.value()));
+    }
+    out_ << QStringLiteral("  节点分布: %1 | 重定向 %2 次").arg(parts.join(QLatin1Char(' '))).arg(redirects) << Qt::endl;
+}
+
+void HeadlessClient::reportSendQueues() {
+    const std::pair<cs::common::SendPriority, QString> classes[] = {
+        {cs::common::SendPriority::Control, QStringLiteral("命令")},
+        {cs::common::SendPriority::Interactive, QStringLiteral("单条")},
+        {cs::common::SendPriority::Bulk, QStringLiteral("压测")},
+    };
+    QStringList parts;
+    for (const auto &[priority, name] : classes) {
+        cs::common::SendQueue::ClassStats total;
+        for (const auto &conn : connections_) {
+            if (!conn->controller) {
+                continue;
+            }
+            const auto stats = conn->controller->sendQueueStats(priority);
+            total.frames += stats.frames;
+            total.queued += stats.queued;
+            total.totalWaitNs += stats.totalWaitNs;
+            total.maxWaitNs = qMax(total.maxWaitNs, stats.maxWaitNs);
+        }
+        if (total.frames > 0) {
+            parts.append(QStringLiteral("%1 %2 条(排队 %3) 平均 %4 µs 最大 %5 µs")
+                             .arg(name)
+                             .arg(total.frames)
+                             .arg(total.queued)
+                             .arg(total.avgWaitUs(), 0, 'f', 1)
+                             .arg(total.maxWaitNs / 1000));
+        }
+    }
+    if (!parts.isEmpty()) {
+        out_ << QStringLiteral("  发送排队: ") << parts.join(QStringLiteral(" | ")) << Qt::endl;
+    }
+}
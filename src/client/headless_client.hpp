@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QTextStream>
+#include <QtCore/QTimer>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "common/protocol.hpp"
+
+class ClientController;
+class ClientStream;
+class DatagramSender;
+class QThread;
+
+struct HeadlessOptions {
+    enum class Dispatch {
+        RoundRobin,
+        KeyHash,  // 同一key固定落在同一连接上，保证该key的消息有序
+    };
+
+    QString host = QStringLiteral("127.0.0.1");
+    quint16 port = 8080;
+    int connections = 4;
+    int threads = 0;             // 0 = min(连接数, CPU核数)
+    int messagesPerSec = 1000;   // 所有连接合计，0 = 不限速
+    int payloadBytes = 32;
+    int durationSec = 10;
+    Dispatch dispatch = Dispatch::RoundRobin;
+    int keyCount = 64;
+    int batchBytes = 0;          // >0 时启用ClientController合并发送
+    int batchDelayMs = 5;
+    bool datagram = false;       // 改走UDP遥测，只发送不等待ACK
+    int reconnectBaseMs = 500;   // 重连退避起点与上限，见ReconnectPolicy
+    int reconnectMaxMs = 30000;
+    uint8_t frameVersion = cs::protocol::kDefaultVersion;  // --integrity选择的帧校验方式，仅TCP/同机连接使用
+    int streams = 0;             // >0 时每个连接开这么多条逻辑流，消息经流发送(hash模式下同一key固定同一条流)
+    QString clientIdPrefix;      // 非空时第i个连接以"前缀-i"为客户端标识，集群按它把连接分到各节点
+};
+
+// 无界面多连接客户端：N个ClientController分布在若干网络线程上，
+// 主线程按速率生成消息并分发，定期输出每连接与合计的发送/确认速率。
+class HeadlessClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit HeadlessClient(HeadlessOptions options, QObject *parent = nullptr);
+    ~HeadlessClient() override;
+
+    void start();
+
+signals:
+    void finished();
+
+private:
+    struct Connection {
+        ClientController *controller = nullptr;
+        DatagramSender *sender = nullptr;  // UDP模式下代替controller
+        std::vector<ClientStream *> streams;  // 归controller所有，只在网络线程中使用
+        std::atomic<int> sent{0};
+        std::atomic<int> acked{0};
+        std::atomic<bool> connected{false};
+        std::atomic<int> port{0};  // 当前连接的服务端口，重定向后随之改变
+        std::atomic<int> redirects{0};
+        int lastSent = 0;
+        int lastAcked = 0;
+    };
+
+    void beginWorkload();
+    void dispatchDue();
+    void report(bool final);
+    void reportSendQueues();
+    void reportNodes();
+    int pickConnection(quint64 sequence);
+
+    HeadlessOptions options_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::vector<QThread *> threads_;
+    QTimer tickTimer_;
+    QTimer reportTimer_;
+    QTimer connectTimeout_;
+    QElapsedTimer clock_;
+    QElapsedTimer intervalClock_;
+    quint64 dispatched_ = 0;
+    quint64 roundRobin_ = 0;
+    quint64 reconnects_ = 0;  // 测试开始后的重新连接次数，观察重连是否成峰
+    quint64 lastReconnects_ = 0;
+    bool running_ = false;
+    QByteArray payloadTemplate_;
+    QTextStream out_;
+};
@@ -1,9 +1,116 @@
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTextStream>
 #include <QtWidgets/QApplication>
 
+#include <cstring>
+
 #include "client_window.hpp"
+#include "common/alloc_tracker.hpp"
+#include "common/transport.hpp"
+#include "headless_client.hpp"
+
+namespace {
+
+// 分配统计构建在退出时输出各阶段汇总
+void report_allocations_on_exit(QCoreApplication &app) {
+    if (cs::common::AllocTracker::available()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+            QTextStream(stderr) << cs::common::AllocTracker::summary() << Qt::endl;
+        });
+    }
+}
+
+bool headless_requested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int run_headless(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption headlessOption(QStringLiteral("headless"), QStringLiteral("不启动界面，运行多连接压测客户端"));
+    const QCommandLineOption hostOption(QStringLiteral("host"), QStringLiteral("服务器地址(unix:<路径>、shm:<路径>为同机传输)"), QStringLiteral("host"), QStringLiteral("127.0.0.1"));
+    const QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("服务器端口"), QStringLiteral("port"), QStringLiteral("8080"));
+    const QCommandLineOption connectionsOption(QStringLiteral("connections"), QStringLiteral("连接数"), QStringLiteral("n"), QStringLiteral("4"));
+    const QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("网络线程数(0=自动)"), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("合计发送速率(条/秒，0=不限)"), QStringLiteral("n"), QStringLiteral("1000"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("每条消息字节数"), QStringLiteral("bytes"), QStringLiteral("32"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("测试时长(秒)"), QStringLiteral("sec"), QStringLiteral("10"));
+    const QCommandLineOption dispatchOption(QStringLiteral("dispatch"), QStringLiteral("分发方式: rr 或 hash"), QStringLiteral("mode"), QStringLiteral("rr"));
+    const QCommandLineOption keysOption(QStringLiteral("keys"), QStringLiteral("hash分发时的key数量"), QStringLiteral("n"), QStringLiteral("64"));
+    const QCommandLineOption batchOption(QStringLiteral("batch-bytes"), QStringLiteral("合并发送字节上限(0=关闭)"), QStringLiteral("bytes"), QStringLiteral("0"));
+    const QCommandLineOption batchDelayOption(QStringLiteral("batch-delay"), QStringLiteral("合并发送最长等待(毫秒)"), QStringLiteral("ms"), QStringLiteral("5"));
+    const QCommandLineOption udpOption(QStringLiteral("udp"), QStringLiteral("以UDP遥测方式发送(服务器需开启--udp，无ACK)"));
+    const QCommandLineOption reconnectBaseOption(QStringLiteral("reconnect-base"), QStringLiteral("重连退避起点(毫秒)"), QStringLiteral("ms"), QStringLiteral("500"));
+    const QCommandLineOption reconnectMaxOption(QStringLiteral("reconnect-max"), QStringLiteral("重连退避上限(毫秒)"), QStringLiteral("ms"), QStringLiteral("30000"));
+    const QCommandLineOption integrityOption(QStringLiteral("integrity"), QStringLiteral("帧校验: crc16、crc32c 或 none(仅unix:/shm:同机传输)"), QStringLiteral("mode"), QStringLiteral("crc16"));
+    const QCommandLineOption clientIdOption(QStringLiteral("client-id"), QStringLiteral("客户端标识前缀，第i个连接为<前缀>-i(集群按标识分配节点)"), QStringLiteral("prefix"));
+    const QCommandLineOption streamsOption(QStringLiteral("streams"), QStringLiteral("每个连接的逻辑流数量(0=不使用流)"), QStringLiteral("n"), QStringLiteral("0"));
+    parser.addOptions({headlessOption, hostOption, portOption, connectionsOption, threadsOption, rateOption,
+                       sizeOption, durationOption, dispatchOption, keysOption, batchOption, batchDelayOption, udpOption,
+                       reconnectBaseOption, reconnectMaxOption, integrityOption, streamsOption, clientIdOption});
+    parser.process(app);
+
+    HeadlessOptions options;
+    options.host = parser.value(hostOption);
+    options.port = static_cast<quint16>(parser.value(portOption).toUInt());
+    options.connections = parser.value(connectionsOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.messagesPerSec = parser.value(rateOption).toInt();
+    options.payloadBytes = parser.value(sizeOption).toInt();
+    options.durationSec = parser.value(durationOption).toInt();
+    options.dispatch = parser.value(dispatchOption) == QStringLiteral("hash") ? HeadlessOptions::Dispatch::KeyHash
+                                                                             : HeadlessOptions::Dispatch::RoundRobin;
+    options.keyCount = parser.value(keysOption).toInt();
+    options.batchBytes = parser.value(batchOption).toInt();
+    options.batchDelayMs = parser.value(batchDelayOption).toInt();
+    options.datagram = parser.isSet(udpOption);
+    options.reconnectBaseMs = parser.value(reconnectBaseOption).toInt();
+    options.reconnectMaxMs = parser.value(reconnectMaxOption).toInt();
+    const QString integrity = parser.value(integrityOption);
+    if (integrity == QStringLiteral("crc16")) {
+        options.frameVersion = cs::protocol::kVersionCrc16;
+    } else if (integrity == QStringLiteral("crc32c")) {
+        options.frameVersion = cs::protocol::kVersionCrc32c;
+    } else if (integrity == QStringLiteral("none")) {
+        // 服务器只在本机传输上接受不带校验的帧，TCP上这些帧会被全部丢弃
+        QString endpoint;
+        if (cs::common::transport_kind(options.host, &endpoint) == cs::common::TransportKind::Tcp) {
+            QTextStream(stderr) << QStringLiteral("--integrity none 只能用于 unix:/shm: 同机传输，当前主机为 %1").arg(options.host)
+                                << Qt::endl;
+            return 1;
+        }
+        options.frameVersion = cs::protocol::kVersionUnchecked;
+    } else {
+        QTextStream(stderr) << QStringLiteral("未知的 --integrity 取值：%1(可选 crc16、crc32c、none)").arg(integrity) << Qt::endl;
+        return 1;
+    }
+
+    options.clientIdPrefix = parser.value(clientIdOption);
+    options.streams = qBound(0, parser.value(streamsOption).toInt(), int(cs::protocol::kMaxStreamsPerSession));
+
+    report_allocations_on_exit(app);
+    HeadlessClient client(options);
+    QObject::connect(&client, &HeadlessClient::finished, &app, &QCoreApplication::quit);
+    client.start();
+    return app.exec();
+}
+
+}  // namespace
 
 int main(int argc, char *argv[]) {
+    if (headless_requested(argc, argv)) {
+        return run_headless(argc, argv);
+    }
     QApplication app(argc, argv);
+    report_allocations_on_exit(app);
     ClientWindow window;
     window.show();
     return app.exec();
@@ -0,0 +1,32 @@
+#include "reconnect_policy.hpp"
+
+#include <QtCore/QRandomGenerator>
+
+void ReconnectPolicy::setBackoff(int baseMs, int maxMs) {
+    baseMs_ = qMax(1, baseMs);
+    maxMs_ = qMax(baseMs_, maxMs);
+}
+
+int ReconnectPolicy::nextDelayMs() {
+    if (retryAfterMs_ >= 0) {
+        // 服务器已在其时间片内加了抖动，这里不再叠加
+        const int delay = retryAfterMs_;
+        retryAfterMs_ = -1;
+        ++attempts_;
+        return delay;
+    }
+    // 位移次数有界，避免溢出；上限之后的失败都落在[0, maxMs]
+    const int shift = qMin(attempts_, 20);
+    const qint64 ceiling = qMin<qint64>(maxMs_, qint64(baseMs_) << shift);
+    ++attempts_;
+    return static_cast<int>(QRandomGenerator::global()->bounded(ceiling + 1));
+}
+
+void ReconnectPolicy::setRetryAfter(int delayMs) {
+    retryAfterMs_ = qBound(0, delayMs, maxMs_ * 2);
+}
+
+void ReconnectPolicy::reset() {
+    attempts_ = 0;
+    retryAfterMs_ = -1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+// 重连退避：第n次失败后在[0, min(maxMs, baseMs·2^n)]内均匀取值("full jitter")，
+// 大量客户端同时掉线时各自的重连时刻会在整个区间内散开，而不是按固定间隔同步成波峰。
+// 服务器下发RetryAfter时，下一次重连改用服务器分配的时间，其后恢复指数退避。
+class ReconnectPolicy {
+public:
+    static constexpr int kDefaultBaseMs = 500;
+    static constexpr int kDefaultMaxMs = 30000;
+
+    void setBackoff(int baseMs, int maxMs);
+    int baseMs() const { return baseMs_; }
+    int maxMs() const { return maxMs_; }
+
+    // 计算下一次重连前的等待时间并推进失败次数
+    int nextDelayMs();
+    // 服务器要求至少等待delayMs，仅作用于下一次重连
+    void setRetryAfter(int delayMs);
+    // 连接成功后清零失败次数
+    void reset();
+    int attempts() const { return attempts_; }
+
+private:
+    int baseMs_ = kDefaultBaseMs;
+    int maxMs_ = kDefaultMaxMs;
+    int attempts_ = 0;
+    int retryAfterMs_ = -1;
+};
@@ -0,0 +1,96 @@
+#include "alloc_tracker.hpp"
+
+#include <QtCore/QStringList>
+
+#include <array>
+#include <atomic>
+
+namespace cs::common {
+
+namespace {
+
+// 分配钩子可能在静态初始化之前被调用，这里只使用常量初始化的对象
+struct Counters {
+    std::array<std::atomic<quint64>, kAllocTagCount> allocations{};
+    std::array<std::atomic<quint64>, kAllocTagCount> bytes{};
+    std::atomic<quint64> frames{0};
+};
+
+Counters g_counters;
+thread_local AllocTag t_tag = AllocTag::Other;
+
+}  // namespace
+
+bool AllocTracker::available() {
+#ifdef CS_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocTag AllocTracker::exchange(AllocTag tag) {
+    const AllocTag previous = t_tag;
+    t_tag = tag;
+    return previous;
+}
+
+void AllocTracker::record(std::size_t bytes) {
+    const auto index = static_cast<std::size_t>(t_tag);
+    g_counters.allocations[index].fetch_add(1, std::memory_order_relaxed);
+    g_counters.bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocTracker::addFrames(quint64 frames) {
+    g_counters.frames.fetch_add(frames, std::memory_order_relaxed);
+}
+
+quint64 AllocTracker::frames() {
+    return g_counters.frames.load(std::memory_order_relaxed);
+}
+
+AllocTracker::TagStats AllocTracker::stats(AllocTag tag) {
+    const auto index = static_cast<std::size_t>(tag);
+    return {g_counters.allocations[index].load(std::memory_order_relaxed),
+            g_counters.bytes[index].load(std::memory_order_relaxed)};
+}
+
+void AllocTracker::reset() {
+    for (int i = 0; i < kAllocTagCount; ++i) {
+        g_counters.allocations[std::size_t(i)].store(0, std::memory_order_relaxed);
+        g_counters.bytes[std::size_t(i)].store(0, std::memory_order_relaxed);
+    }
+    g_counters.frames.store(0, std::memory_order_relaxed);
+}
+
+const char *AllocTracker::tagName(AllocTag tag) {
+    switch (tag) {
+    case AllocTag::Receive: return "receive";
+    case AllocTag::Parse: return "parse";
+    case AllocTag::Dispatch: return "dispatch";
+    case AllocTag::Ack: return "ack";
+    case AllocTag::Ui: return "ui";
+    case AllocTag::Other: break;
+    }
+    return "other";
+}
+
+QString AllocTracker::summary() {
+    const quint64 frameCount = frames();
+    const double divisor = double(qMax<quint64>(1, frameCount));
+    QStringList lines;
+    lines.append(QStringLiteral("[分配统计] 帧 %1").arg(frameCount));
+    for (int i = 0; i < kAllocTagCount; ++i) {
+        const auto tag = static_cast<AllocTag>(i);
+        const TagStats s = stats(tag);
+        lines.append(QStringLiteral("  %1 %2 次 %3 字节 | 每帧 %4 次 %5 字节")
+                         .arg(QString::fromLatin1(tagName(tag)), -8)
+                         .arg(s.allocations)
+                         .arg(s.bytes)
+                         .arg(double(s.allocations) / divisor, 0, 'f', 2)
+                         .arg(double(s.bytes) / divisor, 0, 'f', 1));
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+}  // namespace cs::common
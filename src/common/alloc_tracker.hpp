@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QtCore/QString>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cs::common {
+
+// 分配归属的阶段，由CS_ALLOC_SCOPE在调用路径上标注；未标注的分配记入Other
+enum class AllocTag : uint8_t {
+    Other = 0,
+    Receive = 1,   // 从传输层读取
+    Parse = 2,     // 帧解析、拆批与payload拷贝
+    Dispatch = 3,  // 路由、提交业务线程池、客户端编码发送
+    Ack = 4,       // ACK编码、写出与客户端ACK处理
+    Ui = 5,        // 发往界面的信号参数、日志与统计刷新
+};
+
+constexpr int kAllocTagCount = 6;
+
+// 按阶段统计堆分配次数与字节数。以 -DCS_ALLOC_TRACKING=ON 构建时，alloc_interpose.cpp 接管
+// malloc系列(glibc)或全局operator new(其他平台，此时不含Qt容器的分配)，每次分配计入当前线程所在的阶段；
+// 普通构建中CS_ALLOC_SCOPE为空，以下接口只返回0。
+class AllocTracker {
+public:
+    struct TagStats {
+        quint64 allocations = 0;
+        quint64 bytes = 0;
+    };
+
+    // 是否以分配统计模式构建
+    static bool available();
+
+    static AllocTag exchange(AllocTag tag);
+    // 由分配钩子调用，不得分配内存
+    static void record(std::size_t bytes);
+
+    // 每帧平均值以此为分母：服务器按收到的请求帧，客户端按收到的应答/推送帧累加
+    static void addFrames(quint64 frames);
+    static quint64 frames();
+    static TagStats stats(AllocTag tag);
+    static void reset();
+
+    static const char *tagName(AllocTag tag);
+    // 各阶段的次数、字节数与每帧平均，多行文本
+    static QString summary();
+};
+
+// 作用域内的分配记入tag，析构时恢复外层阶段
+class AllocScope {
+public:
+    explicit AllocScope(AllocTag tag) : previous_(AllocTracker::exchange(tag)) {}
+    ~AllocScope() { AllocTracker::exchange(previous_); }
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+private:
+    AllocTag previous_;
+};
+
+}  // namespace cs::common
+
+#ifdef CS_ALLOC_TRACKING
+#define CS_ALLOC_SCOPE(tag) const ::cs::common::AllocScope cs_alloc_scope_(::cs::common::AllocTag::tag)
+#else
+#define CS_ALLOC_SCOPE(tag) static_cast<void>(0)
+#endif
@@ -0,0 +1,89 @@
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+
+namespace cs::common {
+
+BufferPool::BufferPool(std::size_t blockBytes, std::size_t maxCached)
+    : blockBytes_(blockBytes),
+      maxCached_(maxCached) {
+    free_.reserve(maxCached_);
+}
+
+BufferPool::~BufferPool() {
+    for (char *block : free_) {
+        delete[] block;
+    }
+}
+
+BufferPool &BufferPool::local() {
+    thread_local BufferPool pool;
+    return pool;
+}
+
+char *BufferPool::acquire() {
+    ++stats_.acquires;
+    char *block = nullptr;
+    if (!free_.empty()) {
+        ++stats_.hits;
+        block = free_.back();
+        free_.pop_back();
+    } else {
+        block = new char[blockBytes_];
+    }
+    ++stats_.inUse;
+    stats_.highWater = std::max(stats_.highWater, stats_.inUse);
+    stats_.cached = free_.size();
+    return block;
+}
+
+void BufferPool::release(char *block) {
+    if (!block) {
+        return;
+    }
+    --stats_.inUse;
+    if (free_.size() < maxCached_) {
+        free_.push_back(block);
+    } else {
+        delete[] block;
+    }
+    stats_.cached = free_.size();
+}
+
+BumpArena::BumpArena() {
+    spans_.reserve(kReservedSpans);
+}
+
+BumpArena::~BumpArena() {
+    reset();
+}
+
+void BumpArena::begin(BufferPool &pool) {
+    reset();
+    pool_ = &pool;
+}
+
+char *BumpArena::allocate(std::size_t bytes) {
+    if (!pool_ || bytes > pool_->blockBytes()) {
+        return nullptr;
+    }
+    if (spans_.empty() || spans_.back().size + bytes > pool_->blockBytes()) {
+        spans_.push_back(Span{pool_->acquire(), 0});
+    }
+    Span &span = spans_.back();
+    char *out = span.data + span.size;
+    span.size += bytes;
+    return out;
+}
+
+void BumpArena::reset() {
+    if (pool_) {
+        for (const Span &span : spans_) {
+            pool_->release(span.data);
+        }
+    }
+    spans_.clear();
+    pool_ = nullptr;
+}
+
+}  // namespace cs::common
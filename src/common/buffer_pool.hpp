@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cs::common {
+
+// 固定大小内存块的空闲链表池。非线程安全：每个工作线程通过local()使用自己的实例，
+// 块只能在同一次事件处理内借出并归还，会话跨线程迁移时不会把块带走。
+class BufferPool {
+public:
+    static constexpr std::size_t kDefaultBlockBytes = 16 * 1024;
+    static constexpr std::size_t kDefaultMaxCached = 64;
+
+    struct Stats {
+        uint64_t acquires = 0;
+        uint64_t hits = 0;
+        std::size_t inUse = 0;
+        std::size_t highWater = 0;  // 同时借出块数的峰值
+        std::size_t cached = 0;
+
+        double hitRate() const { return acquires == 0 ? 1.0 : double(hits) / double(acquires); }
+    };
+
+    explicit BufferPool(std::size_t blockBytes = kDefaultBlockBytes, std::size_t maxCached = kDefaultMaxCached);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    static BufferPool &local();
+
+    char *acquire();
+    void release(char *block);
+
+    std::size_t blockBytes() const { return blockBytes_; }
+    const Stats &stats() const { return stats_; }
+
+private:
+    std::size_t blockBytes_;
+    std::size_t maxCached_;
+    std::vector<char *> free_;
+    Stats stats_;
+};
+
+// 基于BufferPool的单调分配器：一批临时数据（如一次读事件产生的全部ACK帧）顺序写入，
+// 批处理结束时reset()把块归还给池。单次分配不得超过池的块大小。
+class BumpArena {
+public:
+    struct Span {
+        char *data = nullptr;
+        std::size_t size = 0;
+    };
+
+    BumpArena();
+    ~BumpArena();
+
+    BumpArena(const BumpArena &) = delete;
+    BumpArena &operator=(const BumpArena &) = delete;
+
+    void begin(BufferPool &pool);
+    char *allocate(std::size_t bytes);
+    void reset();
+
+    bool empty() const { return spans_.empty() || spans_.front().size == 0; }
+    const std::vector<Span> &spans() const { return spans_; }
+
+private:
+    static constexpr std::size_t kReservedSpans = 8;
+
+    BufferPool *pool_ = nullptr;
+    std::vector<Span> spans_;
+};
+
+}  // namespace cs::common
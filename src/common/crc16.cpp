@@ -1,5 +1,7 @@
 #include "crc16.hpp"
 
+#include <array>
+
 namespace cs::protocol {
 
 namespace {
@@ -7,20 +9,31 @@ namespace {
 constexpr uint16_t kPoly = 0x1021;
 constexpr uint16_t kInit = 0xFFFF;
 
-}  // namespace
-
-uint16_t crc16_ibm(const uint8_t *data, std::size_t size) {
-    uint16_t crc = kInit;
-    for (std::size_t idx = 0; idx < size; ++idx) {
-        const uint8_t byte = data[idx];
-        crc ^= static_cast<uint16_t>(byte) << 8;
-        for (int i = 0; i < 8; ++i) {
+// 逐字节查表，结果与逐位移位的实现完全一致
+constexpr std::array<uint16_t, 256> make_table() {
+    std::array<uint16_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        auto crc = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; ++bit) {
             const bool carry = (crc & 0x8000) != 0;
-            crc <<= 1;
+            crc = static_cast<uint16_t>(crc << 1);
             if (carry) {
                 crc ^= kPoly;
             }
         }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto kTable = make_table();
+
+}  // namespace
+
+uint16_t crc16_ibm(const uint8_t *data, std::size_t size) {
+    uint16_t crc = kInit;
+    for (std::size_t idx = 0; idx < size; ++idx) {
+        crc = static_cast<uint16_t>((crc << 8) ^ kTable[((crc >> 8) ^ data[idx]) & 0xFF]);
     }
     return crc;
 }
@@ -0,0 +1,111 @@
+#include "crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CS_CRC32C_X86 1
+#include <nmmintrin.h>
+#endif
+
+namespace cs::protocol {
+
+namespace {
+
+constexpr uint32_t kPoly = 0x82F63B78;  // 0x1EDC6F41的反射形式
+
+// 8张表的slicing-by-8，每次处理8字节
+constexpr std::array<std::array<uint32_t, 256>, 8> make_tables() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? kPoly : 0);
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (std::size_t t = 1; t < 8; ++t) {
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr auto kTables = make_tables();
+
+uint32_t update_software(uint32_t crc, const uint8_t *data, std::size_t size) {
+    while (size >= 8) {
+        uint32_t lo = 0;
+        uint32_t hi = 0;
+        std::memcpy(&lo, data, 4);
+        std::memcpy(&hi, data + 4, 4);
+        lo ^= crc;  // 小端主机：低地址字节在低位
+        crc = kTables[7][lo & 0xFF] ^ kTables[6][(lo >> 8) & 0xFF] ^ kTables[5][(lo >> 16) & 0xFF] ^
+              kTables[4][lo >> 24] ^ kTables[3][hi & 0xFF] ^ kTables[2][(hi >> 8) & 0xFF] ^
+              kTables[1][(hi >> 16) & 0xFF] ^ kTables[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ kTables[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef CS_CRC32C_X86
+__attribute__((target("sse4.2"))) uint32_t update_hardware(uint32_t crc, const uint8_t *data, std::size_t size) {
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    auto crc32 = static_cast<uint32_t>(crc64);
+    while (size-- > 0) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+    }
+    return crc32;
+}
+
+bool detect_hardware() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+using UpdateFn = uint32_t (*)(uint32_t, const uint8_t *, std::size_t);
+
+UpdateFn select_update() {
+#ifdef CS_CRC32C_X86
+    if (detect_hardware()) {
+        return update_hardware;
+    }
+#endif
+    return update_software;
+}
+
+// 首次调用时检测一次CPU特性，之后直接走选定的实现；局部静态变量的初始化是线程安全的，
+// 其他翻译单元在静态初始化阶段调用crc32c()也不依赖初始化顺序
+UpdateFn selected_update() {
+    static const UpdateFn update = select_update();
+    return update;
+}
+
+}  // namespace
+
+uint32_t crc32c(const uint8_t *data, std::size_t size) {
+    return ~selected_update()(0xFFFFFFFFu, data, size);
+}
+
+uint32_t crc32c_software(const uint8_t *data, std::size_t size) {
+    return ~update_software(0xFFFFFFFFu, data, size);
+}
+
+bool crc32c_hardware_available() {
+    return selected_update() != update_software;
+}
+
+}  // namespace cs::protocol
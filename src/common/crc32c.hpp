@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cs::protocol {
+
+// CRC32C(Castagnoli，多项式0x1EDC6F41，反射，初值与结果异或0xFFFFFFFF)。
+// x86-64上运行时检测SSE4.2，可用时使用crc32指令，否则退回查表实现；两条路径结果一致。
+uint32_t crc32c(const uint8_t *data, std::size_t size);
+// 仅查表实现，供基准对比和校验硬件路径
+uint32_t crc32c_software(const uint8_t *data, std::size_t size);
+bool crc32c_hardware_available();
+
+}  // namespace cs::protocol
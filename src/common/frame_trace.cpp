@@ -0,0 +1,198 @@
+#include "frame_trace.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::common {
+
+namespace {
+
+constexpr int kStageCount = 4;
+
+// 字段用relaxed原子量：导出线程可能与写入线程同时访问环的边界槽位，最多读到一条不完整的事件
+struct Event {
+    std::atomic<int64_t> ns{0};
+    std::atomic<uint32_t> id{0};
+    std::atomic<uint8_t> stage{0};
+};
+
+struct Ring {
+    int tid = 0;
+    QString name;
+    std::unique_ptr<Event[]> events{new Event[FrameTracer::kEventsPerThread]};
+    std::atomic<uint64_t> head{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::atomic<uint32_t> nextId{1};
+    std::atomic<int> sampleEvery{1};
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+Ring &local_ring() {
+    // 线程退出后环仍由注册表持有，导出时不会丢失该线程的事件
+    thread_local const std::shared_ptr<Ring> ring = []() {
+        auto created = std::make_shared<Ring>();
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        created->tid = static_cast<int>(reg.rings.size()) + 1;
+        const QThread *thread = QThread::currentThread();
+        created->name = thread && !thread->objectName().isEmpty() ? thread->objectName()
+                                                                 : QStringLiteral("thread-%1").arg(created->tid);
+        reg.rings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+const char *span_name(int endStage) {
+    switch (endStage) {
+    case 1:
+        return "parse";
+    case 2:
+        return "dispatch";
+    default:
+        return "ack";
+    }
+}
+
+}  // namespace
+
+std::atomic<bool> FrameTracer::enabled_{false};
+
+void FrameTracer::setEnabled(bool enabled, int sampleEvery) {
+    registry().sampleEvery.store(sampleEvery > 0 ? sampleEvery : 1, std::memory_order_relaxed);
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t FrameTracer::sample() {
+    thread_local uint32_t seen = 0;
+    if (seen++ % static_cast<uint32_t>(registry().sampleEvery.load(std::memory_order_relaxed)) != 0) {
+        return 0;
+    }
+    uint32_t id = registry().nextId.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) {
+        id = registry().nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+    return id;
+}
+
+int64_t FrameTracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void FrameTracer::write(uint32_t traceId, Stage stage, int64_t ns) {
+    Ring &ring = local_ring();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Event &event = ring.events[head & (kEventsPerThread - 1)];
+    event.ns.store(ns, std::memory_order_relaxed);
+    event.id.store(traceId, std::memory_order_relaxed);
+    event.stage.store(static_cast<uint8_t>(stage), std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void FrameTracer::clear() {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &ring : reg.rings) {
+        ring->head.store(0, std::memory_order_release);
+    }
+}
+
+int FrameTracer::exportChromeTrace(const QString &path, QString *error) {
+    const bool wasEnabled = enabled();
+    enabled_.store(false, std::memory_order_relaxed);
+
+    struct Stamps {
+        std::array<int64_t, kStageCount> ns{};
+        std::array<int, kStageCount> tid{};
+    };
+    std::unordered_map<uint32_t, Stamps> frames;
+    std::vector<std::pair<int, QString>> threads;
+    int64_t origin = INT64_MAX;
+    {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto &ring : reg.rings) {
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            const uint64_t count = head < kEventsPerThread ? head : kEventsPerThread;
+            if (count == 0) {
+                continue;
+            }
+            threads.emplace_back(ring->tid, ring->name);
+            for (uint64_t i = head - count; i < head; ++i) {
+                const Event &event = ring->events[i & (kEventsPerThread - 1)];
+                const int stage = event.stage.load(std::memory_order_relaxed);
+                const int64_t ns = event.ns.load(std::memory_order_relaxed);
+                if (stage >= kStageCount || ns == 0) {
+                    continue;
+                }
+                Stamps &stamps = frames[event.id.load(std::memory_order_relaxed)];
+                stamps.ns[static_cast<std::size_t>(stage)] = ns;
+                stamps.tid[static_cast<std::size_t>(stage)] = ring->tid;
+                origin = qMin(origin, ns);
+            }
+        }
+    }
+
+    QByteArray json("{\"traceEvents\":[\n");
+    bool first = true;
+    const auto append = [&json, &first](const QByteArray &entry) {
+        if (!first) {
+            json.append(",\n");
+        }
+        first = false;
+        json.append(entry);
+    };
+    for (const auto &[tid, name] : threads) {
+        append(QByteArrayLiteral("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":") + QByteArray::number(tid) +
+               QByteArrayLiteral(",\"args\":{\"name\":\"") + name.toUtf8() + QByteArrayLiteral("\"}}"));
+    }
+    int spans = 0;
+    for (const auto &[id, stamps] : frames) {
+        // 相邻两个时刻都存在才生成区间，区间画在结束时刻所在的线程上
+        for (int stage = 1; stage < kStageCount; ++stage) {
+            const int64_t start = stamps.ns[static_cast<std::size_t>(stage - 1)];
+            const int64_t end = stamps.ns[static_cast<std::size_t>(stage)];
+            if (start == 0 || end == 0 || end < start) {
+                continue;
+            }
+            append(QByteArrayLiteral("{\"name\":\"") + span_name(stage) +
+                   QByteArrayLiteral("\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":") +
+                   QByteArray::number(stamps.tid[static_cast<std::size_t>(stage)]) + QByteArrayLiteral(",\"ts\":") +
+                   QByteArray::number(double(start - origin) / 1000.0, 'f', 3) + QByteArrayLiteral(",\"dur\":") +
+                   QByteArray::number(double(end - start) / 1000.0, 'f', 3) + QByteArrayLiteral(",\"args\":{\"frame\":") +
+                   QByteArray::number(id) + QByteArrayLiteral("}}"));
+            ++spans;
+        }
+    }
+    json.append("\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    enabled_.store(wasEnabled, std::memory_order_relaxed);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return -1;
+    }
+    return spans;
+}
+
+}  // namespace cs::common
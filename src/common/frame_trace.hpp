@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QtCore/QString>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cs::common {
+
+// 逐帧链路追踪：在读到数据、解析完成、分派、ACK写出四个时刻打点，写入各线程自己的环形缓冲，
+// 导出为Chrome/Perfetto可直接打开的JSON。未开启时每个打点位置只有一次enabled()判断；
+// 开启后按1/N采样，未采中的帧追踪ID为0，后续打点同样只是一次判断。
+class FrameTracer {
+public:
+    enum class Stage : uint8_t {
+        Read = 0,     // 本次读事件开始
+        Parsed = 1,   // 帧解析并校验完成
+        Dispatched = 2,  // 已直接应答或投递到业务线程池
+        AckWritten = 3,  // 对应ACK写入socket
+    };
+
+    static constexpr std::size_t kEventsPerThread = 1 << 16;
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    // sampleEvery为采样间隔，1表示每帧都追踪
+    static void setEnabled(bool enabled, int sampleEvery = 1);
+
+    // 为新帧分配追踪ID；未开启或未被采样时返回0
+    static uint32_t begin() { return enabled() ? sample() : 0; }
+    static void record(uint32_t traceId, Stage stage, int64_t ns) {
+        if (traceId != 0) {
+            write(traceId, stage, ns);
+        }
+    }
+    static void record(uint32_t traceId, Stage stage) {
+        if (traceId != 0) {
+            write(traceId, stage, now());
+        }
+    }
+    static int64_t now();
+
+    // 导出全部线程缓冲中的事件，期间暂停追踪；返回写出的区间数，失败返回-1
+    static int exportChromeTrace(const QString &path, QString *error);
+    static void clear();
+
+private:
+    static uint32_t sample();
+    static void write(uint32_t traceId, Stage stage, int64_t ns);
+
+    static std::atomic<bool> enabled_;
+};
+
+}  // namespace cs::common
@@ -0,0 +1,270 @@
+#include "log_model.hpp"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QStringList>
+
+namespace cs::common {
+
+namespace {
+
+// 待插入条目合并的间隔，约为一次屏幕刷新
+constexpr int kFlushIntervalMs = 16;
+// 重建过滤结果时每次事件循环最多扫描的条目数
+constexpr quint64 kRebuildChunk = 200'000;
+
+LogLevel level_for_category(const QString &category) {
+    if (category.contains(QStringLiteral("错误")) || category.contains(QStringLiteral("失败"))) {
+        return LogLevel::Error;
+    }
+    if (category.contains(QStringLiteral("警告")) || category.contains(QStringLiteral("超时"))) {
+        return LogLevel::Warn;
+    }
+    return LogLevel::Info;
+}
+
+}  // namespace
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent),
+      capacity_(static_cast<std::size_t>(qMax(1, capacity))) {
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(kFlushIntervalMs);
+    connect(&flushTimer_, &QTimer::timeout, this, &LogModel::flushPending);
+    rebuildTimer_.setSingleShot(true);
+    rebuildTimer_.setInterval(0);
+    connect(&rebuildTimer_, &QTimer::timeout, this, &LogModel::continueRebuild);
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(visible_.size());
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() < 0 || static_cast<std::size_t>(index.row()) >= visible_.size()) {
+        return {};
+    }
+    const Entry &entry = entryAt(visible_[static_cast<std::size_t>(index.row())]);
+    const QString &category = categoryNames_[entry.category];
+    switch (role) {
+    case Qt::DisplayRole: {
+        const QString timestamp =
+            QDateTime::fromMSecsSinceEpoch(entry.timestampMs).toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz"));
+        if (category.isEmpty()) {
+            return QStringLiteral("[%1] %2").arg(timestamp, entry.message);
+        }
+        return QStringLiteral("[%1] [%2] %3").arg(timestamp, category, entry.message);
+    }
+    case LevelRole:
+        return static_cast<int>(entry.level);
+    case CategoryRole:
+        return category;
+    case SessionRole:
+        return sessionNames_[entry.session];
+    case TimestampRole:
+        return entry.timestampMs;
+    case MessageRole:
+        return entry.message;
+    default:
+        return {};
+    }
+}
+
+void LogModel::append(LogLevel level, const QString &category, const QString &session, const QString &message) {
+    Entry entry;
+    entry.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.category = internCategory(category);
+    entry.session = internSession(session);
+    entry.message = message;
+    pending_.push_back(std::move(entry));
+    if (!flushTimer_.isActive()) {
+        flushTimer_.start();
+    }
+}
+
+void LogModel::appendLine(const QString &line, const QString &session) {
+    QString category;
+    QString message = line;
+    if (line.startsWith(QLatin1Char('['))) {
+        const int close = line.indexOf(QLatin1Char(']'));
+        if (close > 0) {
+            category = line.mid(1, close - 1);
+            message = line.mid(close + 1).trimmed();
+        }
+    }
+    append(level_for_category(category), category, session, message);
+}
+
+void LogModel::setFilter(const Filter &filter) {
+    filter_ = filter;
+    filterCategory_ = -1;
+    if (!filter_.category.isEmpty()) {
+        filterCategory_ = categoryIndex_.contains(filter_.category) ? categoryIndex_.value(filter_.category) : -2;
+    }
+    flushPending();
+    beginResetModel();
+    visible_.clear();
+    endResetModel();
+    rebuildCursor_ = firstSeq_;
+    rebuilding_ = true;
+    continueRebuild();
+}
+
+void LogModel::clear() {
+    flushTimer_.stop();
+    rebuildTimer_.stop();
+    beginResetModel();
+    pending_.clear();
+    ring_.clear();
+    visible_.clear();
+    firstSeq_ = 0;
+    nextSeq_ = 0;
+    rebuilding_ = false;
+    endResetModel();
+}
+
+int LogModel::capacity() const {
+    return static_cast<int>(capacity_);
+}
+
+qint64 LogModel::totalEntries() const {
+    return static_cast<qint64>(nextSeq_ - firstSeq_);
+}
+
+QStringList LogModel::categories() const {
+    QStringList names;
+    for (const QString &name : categoryNames_) {
+        if (!name.isEmpty()) {
+            names.append(name);
+        }
+    }
+    return names;
+}
+
+quint16 LogModel::internCategory(const QString &name) {
+    const auto it = categoryIndex_.constFind(name);
+    if (it != categoryIndex_.constEnd()) {
+        return *it;
+    }
+    if (categoryNames_.size() > 0xFFFF) {
+        return 0;
+    }
+    const auto id = static_cast<quint16>(categoryNames_.size());
+    categoryNames_.push_back(name);
+    categoryIndex_.insert(name, id);
+    if (filterCategory_ == -2 && name == filter_.category) {
+        filterCategory_ = id;
+    }
+    if (!name.isEmpty()) {
+        emit categoryAdded(name);
+    }
+    return id;
+}
+
+quint16 LogModel::internSession(const QString &name) {
+    const auto it = sessionIndex_.constFind(name);
+    if (it != sessionIndex_.constEnd()) {
+        return *it;
+    }
+    // 会话ID不断产生，表满后新会话共用空ID，只影响按会话过滤
+    if (sessionNames_.size() > 0xFFFF) {
+        return sessionIndex_.value(QString());
+    }
+    const auto id = static_cast<quint16>(sessionNames_.size());
+    sessionNames_.push_back(name);
+    sessionIndex_.insert(name, id);
+    return id;
+}
+
+bool LogModel::matches(const Entry &entry) const {
+    if (entry.level < filter_.minLevel) {
+        return false;
+    }
+    if (filterCategory_ != -1 && entry.category != filterCategory_) {
+        return false;
+    }
+    if (!filter_.session.isEmpty() && !sessionNames_[entry.session].startsWith(filter_.session)) {
+        return false;
+    }
+    return filter_.text.isEmpty() || entry.message.contains(filter_.text, Qt::CaseInsensitive);
+}
+
+const LogModel::Entry &LogModel::entryAt(quint64 seq) const {
+    return ring_[static_cast<std::size_t>(seq % capacity_)];
+}
+
+void LogModel::flushPending() {
+    flushTimer_.stop();
+    if (pending_.empty()) {
+        return;
+    }
+    const quint64 batchStart = nextSeq_;
+    for (Entry &entry : pending_) {
+        if (ring_.size() < capacity_) {
+            ring_.push_back(std::move(entry));
+        } else {
+            ring_[static_cast<std::size_t>(nextSeq_ % capacity_)] = std::move(entry);
+            ++firstSeq_;
+        }
+        ++nextSeq_;
+    }
+    pending_.clear();
+
+    // 被覆盖的条目从可见行头部整体移除
+    std::size_t evicted = 0;
+    while (evicted < visible_.size() && visible_[evicted] < firstSeq_) {
+        ++evicted;
+    }
+    if (evicted > 0) {
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(evicted) - 1);
+        visible_.erase(visible_.begin(), visible_.begin() + static_cast<std::ptrdiff_t>(evicted));
+        endRemoveRows();
+    }
+    if (rebuilding_) {
+        rebuildCursor_ = qMax(rebuildCursor_, firstSeq_);
+        return;  // 新条目由重建过程扫描到
+    }
+
+    std::vector<quint64> added;
+    for (quint64 seq = qMax(batchStart, firstSeq_); seq < nextSeq_; ++seq) {
+        if (matches(entryAt(seq))) {
+            added.push_back(seq);
+        }
+    }
+    if (added.empty()) {
+        return;
+    }
+    const int first = static_cast<int>(visible_.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+    visible_.insert(visible_.end(), added.begin(), added.end());
+    endInsertRows();
+    emit rowsAppended();
+}
+
+void LogModel::continueRebuild() {
+    if (!rebuilding_) {
+        return;
+    }
+    rebuildCursor_ = qMax(rebuildCursor_, firstSeq_);
+    const quint64 end = qMin(nextSeq_, rebuildCursor_ + kRebuildChunk);
+    std::vector<quint64> added;
+    for (; rebuildCursor_ < end; ++rebuildCursor_) {
+        if (matches(entryAt(rebuildCursor_))) {
+            added.push_back(rebuildCursor_);
+        }
+    }
+    if (!added.empty()) {
+        const int first = static_cast<int>(visible_.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+        visible_.insert(visible_.end(), added.begin(), added.end());
+        endInsertRows();
+    }
+    if (rebuildCursor_ >= nextSeq_) {
+        rebuilding_ = false;
+        emit rowsAppended();
+        return;
+    }
+    rebuildTimer_.start();
+}
+
+}  // namespace cs::common
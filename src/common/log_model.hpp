@@ -0,0 +1,96 @@
+#pragma once
+
+#include "logger.hpp"
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+#include <deque>
+#include <vector>
+
+namespace cs::common {
+
+// 日志视图的数据源：固定容量的环形缓冲保存结构化日志条目，满了覆盖最旧的。
+// 追加的条目先进入待插入队列，每帧(约16ms)合并成一次beginInsertRows，界面重绘频率与日志速率无关。
+// 过滤条件变化时分块重建可见行索引，每次事件循环只扫描一部分，百万级条目也不会卡住界面。
+class LogModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultCapacity = 2'000'000;
+
+    enum Role {
+        LevelRole = Qt::UserRole + 1,
+        CategoryRole,
+        SessionRole,
+        TimestampRole,
+        MessageRole,
+    };
+
+    struct Filter {
+        LogLevel minLevel = LogLevel::Debug;
+        QString category;  // 空表示不限
+        QString session;   // 前缀匹配，空表示不限
+        QString text;      // 消息内容包含，忽略大小写
+    };
+
+    explicit LogModel(int capacity = kDefaultCapacity, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    void append(LogLevel level, const QString &category, const QString &session, const QString &message);
+    // 解析"[分类] 内容"格式的旧日志行，按分类推断级别
+    void appendLine(const QString &line, const QString &session = QString());
+
+    void setFilter(const Filter &filter);
+    const Filter &filter() const { return filter_; }
+    void clear();
+
+    int capacity() const;
+    qint64 totalEntries() const;  // 环中现存的条目数
+    QStringList categories() const;
+
+signals:
+    // 一批条目插入后发出，视图据此决定是否滚动到底部
+    void rowsAppended();
+    void categoryAdded(const QString &category);
+
+private:
+    struct Entry {
+        qint64 timestampMs = 0;
+        LogLevel level = LogLevel::Info;
+        quint16 category = 0;
+        quint16 session = 0;
+        QString message;
+    };
+
+    quint16 internCategory(const QString &name);
+    quint16 internSession(const QString &name);
+    bool matches(const Entry &entry) const;
+    const Entry &entryAt(quint64 seq) const;
+    void flushPending();
+    void continueRebuild();
+
+    std::size_t capacity_;
+    std::vector<Entry> ring_;  // 按需增长到capacity_后循环覆盖
+    quint64 firstSeq_ = 0;     // 环中最旧条目的序号
+    quint64 nextSeq_ = 0;      // 下一个条目的序号
+    std::deque<quint64> visible_;  // 通过过滤的条目序号，按时间先后
+    std::vector<Entry> pending_;
+    QTimer flushTimer_;
+    QTimer rebuildTimer_;
+    quint64 rebuildCursor_ = 0;
+    bool rebuilding_ = false;
+    Filter filter_;
+    int filterCategory_ = -1;  // filter_.category的已驻留编号，-1表示不限，-2表示不存在
+    QHash<QString, quint16> categoryIndex_;
+    std::vector<QString> categoryNames_;
+    QHash<QString, quint16> sessionIndex_;
+    std::vector<QString> sessionNames_;
+};
+
+}  // namespace cs::common
@@ -0,0 +1,243 @@
+#include "loopback_transport.hpp"
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPointer>
+
+#include <cstring>
+
+namespace cs::common {
+
+void LoopbackScheduler::post(std::function<void()> task) {
+    QMutexLocker locker(&mutex_);
+    tasks_.push_back(std::move(task));
+}
+
+bool LoopbackScheduler::runOne() {
+    std::function<void()> task;
+    {
+        QMutexLocker locker(&mutex_);
+        if (tasks_.empty()) {
+            return false;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+    }
+    task();  // 不持锁执行，任务里可以继续投递
+    return true;
+}
+
+int LoopbackScheduler::runUntilIdle(int maxTasks) {
+    int executed = 0;
+    while ((maxTasks < 0 || executed < maxTasks) && runOne()) {
+        ++executed;
+    }
+    return executed;
+}
+
+std::size_t LoopbackScheduler::pending() const {
+    QMutexLocker locker(&mutex_);
+    return tasks_.size();
+}
+
+// 两端共享的连接状态，所有字段由mutex保护
+struct LoopbackTransport::Link {
+    QMutex mutex;
+    LoopbackScheduler *scheduler = nullptr;
+    LoopbackTransport *ends[2] = {nullptr, nullptr};
+    QByteArray inbound[2];
+    qsizetype readOffset[2] = {0, 0};
+    qint64 writtenPending[2] = {0, 0};  // 尚未通过bytesWritten报告的字节数
+    bool readyPending[2] = {false, false};
+    bool disconnectNotified[2] = {false, false};
+    bool closed = false;
+};
+
+namespace {
+
+// 把通知投递到target所在的执行上下文；target在执行前销毁则丢弃
+template <typename Fn>
+void schedule(LoopbackScheduler *scheduler, LoopbackTransport *target, Fn fn) {
+    if (!target) {
+        return;
+    }
+    if (scheduler) {
+        scheduler->post([guard = QPointer<LoopbackTransport>(target), fn = std::move(fn)]() {
+            if (guard) {
+                fn(guard.data());
+            }
+        });
+        return;
+    }
+    QMetaObject::invokeMethod(target, [target, fn = std::move(fn)]() { fn(target); }, Qt::QueuedConnection);
+}
+
+}  // namespace
+
+std::pair<LoopbackTransport *, LoopbackTransport *> LoopbackTransport::createPair(LoopbackScheduler *scheduler) {
+    auto link = std::make_shared<Link>();
+    link->scheduler = scheduler;
+    auto *first = new LoopbackTransport(link, 0);
+    auto *second = new LoopbackTransport(link, 1);
+    link->ends[0] = first;
+    link->ends[1] = second;
+    return {first, second};
+}
+
+LoopbackTransport::LoopbackTransport(std::shared_ptr<Link> link, int side)
+    : link_(std::move(link)),
+      side_(side) {}
+
+LoopbackTransport::~LoopbackTransport() {
+    QMutexLocker locker(&link_->mutex);
+    link_->ends[side_] = nullptr;
+    if (!link_->closed) {
+        link_->closed = true;
+        schedule(link_->scheduler, link_->ends[1 - side_], [](LoopbackTransport *peer) { peer->notifyDisconnected(); });
+    }
+}
+
+Transport::State LoopbackTransport::state() const {
+    QMutexLocker locker(&link_->mutex);
+    return link_->closed ? State::Unconnected : State::Connected;
+}
+
+void LoopbackTransport::connectToHost(const QString &, quint16) {
+    QMutexLocker locker(&link_->mutex);
+    if (link_->closed) {
+        schedule(link_->scheduler, this, [](LoopbackTransport *self) {
+            emit self->errorOccurred(QStringLiteral("回环连接已关闭"));
+        });
+        return;
+    }
+    schedule(link_->scheduler, this, [](LoopbackTransport *self) { emit self->connected(); });
+}
+
+qint64 LoopbackTransport::read(char *data, qint64 maxSize) {
+    QMutexLocker locker(&link_->mutex);
+    QByteArray &buffer = link_->inbound[side_];
+    qsizetype &offset = link_->readOffset[side_];
+    const qint64 n = qMin<qint64>(maxSize, buffer.size() - offset);
+    if (n <= 0) {
+        return 0;
+    }
+    std::memcpy(data, buffer.constData() + offset, static_cast<std::size_t>(n));
+    offset += n;
+    if (offset == buffer.size()) {
+        buffer.resize(0);  // 保留容量，下次写入不必重新分配
+        offset = 0;
+    }
+    return n;
+}
+
+QByteArray LoopbackTransport::readAll() {
+    QMutexLocker locker(&link_->mutex);
+    QByteArray &buffer = link_->inbound[side_];
+    qsizetype &offset = link_->readOffset[side_];
+    QByteArray out = offset == 0 ? std::exchange(buffer, QByteArray()) : buffer.mid(offset);
+    buffer.resize(0);
+    offset = 0;
+    return out;
+}
+
+qint64 LoopbackTransport::write(const char *data, qint64 size) {
+    if (size <= 0) {
+        return 0;
+    }
+    QMutexLocker locker(&link_->mutex);
+    if (link_->closed) {
+        return -1;
+    }
+    const int peer = 1 - side_;
+    link_->inbound[peer].append(data, size);
+    if (!link_->readyPending[peer]) {
+        link_->readyPending[peer] = true;
+        schedule(link_->scheduler, link_->ends[peer], [](LoopbackTransport *target) { target->notifyReadyRead(); });
+    }
+    if (link_->writtenPending[side_] == 0) {
+        schedule(link_->scheduler, this, [](LoopbackTransport *self) {
+            qint64 written = 0;
+            {
+                QMutexLocker locker(&self->link_->mutex);
+                written = std::exchange(self->link_->writtenPending[self->side_], 0);
+            }
+            if (written > 0) {
+                emit self->bytesWritten(written);
+            }
+        });
+    }
+    link_->writtenPending[side_] += size;
+    return size;
+}
+
+qint64 LoopbackTransport::bytesToWrite() const {
+    return 0;
+}
+
+void LoopbackTransport::disconnectFromHost() {
+    close(false);
+}
+
+void LoopbackTransport::abort() {
+    close(true);
+}
+
+bool LoopbackTransport::waitForDisconnected(int) {
+    return state() == State::Unconnected;  // 关闭是同步完成的，不需要等待
+}
+
+QString LoopbackTransport::peerAddress() const {
+    return QStringLiteral("loopback");
+}
+
+quint16 LoopbackTransport::peerPort() const {
+    return 0;
+}
+
+QString LoopbackTransport::errorString() const {
+    return state() == State::Unconnected ? QStringLiteral("回环连接已关闭") : QString();
+}
+
+qint64 LoopbackTransport::bytesAvailable() const {
+    QMutexLocker locker(&link_->mutex);
+    return link_->inbound[side_].size() - link_->readOffset[side_];
+}
+
+void LoopbackTransport::close(bool discardInbound) {
+    QMutexLocker locker(&link_->mutex);
+    if (discardInbound) {
+        link_->inbound[side_].clear();
+        link_->readOffset[side_] = 0;
+    }
+    if (link_->closed) {
+        return;
+    }
+    link_->closed = true;
+    // 与TCP一致，主动关闭的一端和对端都会收到disconnected；对端仍可读完已收到的数据
+    for (LoopbackTransport *end : link_->ends) {
+        schedule(link_->scheduler, end, [](LoopbackTransport *target) { target->notifyDisconnected(); });
+    }
+}
+
+void LoopbackTransport::notifyReadyRead() {
+    bool hasData = false;
+    {
+        QMutexLocker locker(&link_->mutex);
+        link_->readyPending[side_] = false;
+        hasData = link_->inbound[side_].size() > link_->readOffset[side_];
+    }
+    if (hasData) {
+        emit readyRead();
+    }
+}
+
+void LoopbackTransport::notifyDisconnected() {
+    {
+        QMutexLocker locker(&link_->mutex);
+        if (std::exchange(link_->disconnectNotified[side_], true)) {
+            return;
+        }
+    }
+    emit disconnected();
+}
+
+}  // namespace cs::common
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "transport.hpp"
+
+#include <QtCore/QMutex>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace cs::common {
+
+// 确定性调度器：回环传输的通知(readyRead/bytesWritten/disconnected)不进Qt事件队列，
+// 而是按投递顺序排在这里，由测试或基准显式执行，同样的输入总是产生同样的事件顺序。
+class LoopbackScheduler {
+public:
+    void post(std::function<void()> task);
+    // 执行队首任务，队列为空时返回false
+    bool runOne();
+    // 执行到队列为空(包括执行过程中新投递的任务)，maxTasks<0不限，返回执行的任务数
+    int runUntilIdle(int maxTasks = -1);
+    std::size_t pending() const;
+
+private:
+    mutable QMutex mutex_;
+    std::deque<std::function<void()>> tasks_;
+};
+
+// 进程内回环传输：成对创建，一端写入的字节直接追加到另一端的接收缓冲，不经过内核。
+// 用于在没有网络的情况下驱动SessionWorker/ClientController，测量纯应用层每帧开销。
+// 写入不经过发送缓冲，bytesToWrite()恒为0；同一端的多次写入只触发一次readyRead。
+class LoopbackTransport : public Transport {
+    Q_OBJECT
+
+public:
+    // scheduler为空时通知通过Qt排队调用投递，两端可以位于不同线程
+    static std::pair<LoopbackTransport *, LoopbackTransport *> createPair(LoopbackScheduler *scheduler = nullptr);
+    ~LoopbackTransport() override;
+
+    State state() const override;
+    // 两端创建时已经连通，这里只补发connected信号
+    void connectToHost(const QString &host, quint16 port) override;
+    qint64 read(char *data, qint64 maxSize) override;
+    QByteArray readAll() override;
+    qint64 write(const char *data, qint64 size) override;
+    qint64 bytesToWrite() const override;
+    void disconnectFromHost() override;
+    void abort() override;
+    bool waitForDisconnected(int msecs) override;
+    QString peerAddress() const override;
+    quint16 peerPort() const override;
+    QString errorString() const override;
+    // 本端已收到尚未读取的字节数
+    qint64 bytesAvailable() const override;
+    bool isLocal() const override { return true; }
+
+private:
+    struct Link;
+
+    LoopbackTransport(std::shared_ptr<Link> link, int side);
+
+    void close(bool discardInbound);
+    void notifyReadyRead();
+    void notifyDisconnected();
+
+    std::shared_ptr<Link> link_;
+    int side_;
+};
+
+}  // namespace cs::common
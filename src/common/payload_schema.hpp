@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// 编译期payload布局描述：用成员指针列出字段顺序，生成大端序编解码。
+// 所有尺寸都是编译期常量，编码可直接写入栈缓冲区，解码只做一次长度检查加若干次定长读取。
+namespace cs::protocol::schema {
+
+namespace detail {
+
+template <typename T, bool = std::is_enum_v<T>>
+struct wire_type {
+    using type = T;
+};
+
+template <typename T>
+struct wire_type<T, true> {
+    using type = std::underlying_type_t<T>;
+};
+
+}  // namespace detail
+
+template <typename T>
+using wire_t = typename detail::wire_type<T>::type;
+
+template <typename T>
+constexpr void store_be(uint8_t *out, T value) {
+    using W = wire_t<T>;
+    static_assert(std::is_unsigned_v<W>, "wire fields must be unsigned integers or enums");
+    const auto raw = static_cast<W>(value);
+    for (std::size_t i = 0; i < sizeof(W); ++i) {
+        out[i] = static_cast<uint8_t>(raw >> (8 * (sizeof(W) - 1 - i)));
+    }
+}
+
+template <typename T>
+constexpr T load_be(const uint8_t *in) {
+    using W = wire_t<T>;
+    static_assert(std::is_unsigned_v<W>, "wire fields must be unsigned integers or enums");
+    W raw = 0;
+    for (std::size_t i = 0; i < sizeof(W); ++i) {
+        raw = static_cast<W>((static_cast<std::uint64_t>(raw) << 8) | in[i]);
+    }
+    return static_cast<T>(raw);
+}
+
+// 定长字段，Member为消息结构体的成员指针
+template <auto Member>
+struct Field;
+
+template <typename Msg, typename T, T Msg::*Member>
+struct Field<Member> {
+    using message_type = Msg;
+    using value_type = T;
+    static constexpr std::size_t kBytes = sizeof(wire_t<T>);
+
+    static constexpr void encode(const Msg &msg, uint8_t *out) { store_be<T>(out, msg.*Member); }
+    static constexpr void decode(const uint8_t *in, Msg &msg) { msg.*Member = load_be<T>(in); }
+};
+
+// 可选尾部字段：仅当前面某个定长字段FlagMember等于FlagValues之一时出现（如CmdId决定的CmdPayload）
+template <auto Member, auto FlagMember, auto... FlagValues>
+struct OptionalField : Field<Member> {
+    using typename Field<Member>::message_type;
+
+    static constexpr bool present(const message_type &msg) { return ((msg.*FlagMember == FlagValues) || ...); }
+};
+
+template <typename... Fields>
+struct Fixed {};
+
+template <typename... Fields>
+struct Optional {};
+
+template <typename Msg, typename FixedFields, typename OptionalFields = Optional<>>
+class Schema;
+
+template <typename Msg, typename... F, typename... O>
+class Schema<Msg, Fixed<F...>, Optional<O...>> {
+public:
+    static constexpr std::size_t kFixedBytes = (std::size_t{0} + ... + F::kBytes);
+    static constexpr std::size_t kMaxBytes = kFixedBytes + (std::size_t{0} + ... + O::kBytes);
+
+    static constexpr std::size_t encoded_size(const Msg &msg) {
+        return kFixedBytes + (std::size_t{0} + ... + (O::present(msg) ? O::kBytes : 0));
+    }
+
+    // out至少kMaxBytes字节，返回写入的字节数
+    static constexpr std::size_t encode(const Msg &msg, uint8_t *out) {
+        std::size_t pos = 0;
+        ((F::encode(msg, out + pos), pos += F::kBytes), ...);
+        (encode_optional<O>(msg, out, pos), ...);
+        return pos;
+    }
+
+    // 定长部分不足或标记存在的可选字段被截断时返回false；consumed为已解析的字节数，其后为变长Body
+    static constexpr bool decode(const uint8_t *in, std::size_t size, Msg *msg, std::size_t *consumed = nullptr) {
+        if (size < kFixedBytes) {
+            return false;
+        }
+        std::size_t pos = 0;
+        ((F::decode(in + pos, *msg), pos += F::kBytes), ...);
+        if (!(decode_optional<O>(in, size, pos, *msg) && ...)) {
+            return false;
+        }
+        if (consumed) {
+            *consumed = pos;
+        }
+        return true;
+    }
+
+private:
+    template <typename Field>
+    static constexpr void encode_optional(const Msg &msg, uint8_t *out, std::size_t &pos) {
+        if (Field::present(msg)) {
+            Field::encode(msg, out + pos);
+            pos += Field::kBytes;
+        }
+    }
+
+    template <typename Field>
+    static constexpr bool decode_optional(const uint8_t *in, std::size_t size, std::size_t &pos, Msg &msg) {
+        if (!Field::present(msg)) {
+            return true;
+        }
+        if (size - pos < Field::kBytes) {
+            return false;
+        }
+        Field::decode(in + pos, msg);
+        pos += Field::kBytes;
+        return true;
+    }
+};
+
+}  // namespace cs::protocol::schema
@@ -1,15 +1,19 @@
 #include "protocol.hpp"
 
 #include "crc16.hpp"
+#include "crc32c.hpp"
 
 #include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
 
 #include <cstddef>
+#include <cstring>
 namespace cs::protocol {
 
 namespace {
 
-constexpr int kFixedFrameBytes = 1 /*SOF*/ + 1 /*Version*/ + 2 /*Length*/ + 2 /*CRC*/ + 1 /*EOF*/;
+// 不含校验字段的最短帧：SOF、Version、Length、EOF
+constexpr int kFixedFrameBytes = 1 + 1 + 2 + 1;
 
 void set_error(FrameError code, const QString &reason, FrameError *outCode, QString *outReason) {
     if (outCode) {
@@ -21,22 +25,112 @@ void set_error(FrameError code, const QString &reason, FrameError *outCode, QStr
 }
 
 uint16_t read_u16(const QByteArray &bytes, int offset) {
-    const uint8_t hi = static_cast<uint8_t>(bytes.at(offset));
-    const uint8_t lo = static_cast<uint8_t>(bytes.at(offset + 1));
-    return static_cast<uint16_t>((hi << 8) | lo);
+    return schema::load_be<uint16_t>(reinterpret_cast<const uint8_t *>(bytes.constData()) + offset);
 }
 
+void append_u16(QByteArray &bytes, uint16_t value) {
+    uint8_t raw[2];
+    schema::store_be(raw, value);
+    bytes.append(reinterpret_cast<const char *>(raw), 2);
+}
+
+// 现有线格式的编译期回归检查：编码结果必须与协议文档中的字节逐一一致，解码后字段不变
+template <typename Schema, typename Msg, std::size_t N>
+constexpr bool matches_wire(const Msg &msg, const uint8_t (&wire)[N]) {
+    uint8_t out[Schema::kMaxBytes] = {};
+    if (Schema::encode(msg, out) != N || Schema::encoded_size(msg) != N) {
+        return false;
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        if (out[i] != wire[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint8_t kAckWithInterval[] = {0x00, 0x00, 0x00, 0x00, 0x01, 0x8C, 0xAB, 0xCD, 0xEF, 0x01, 0x00, 0x00, 0x03, 0xE8};
+constexpr uint8_t kCommandRetryAfter[] = {0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x07, 0xD0};
+constexpr uint8_t kAckInvalid[] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2A, 0x00};
+constexpr uint8_t kRequestHeader[] = {0x01, 0x04, 0xD2};
+constexpr uint8_t kStreamAck[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0x00, 0x07, 0x00, 0x01};
+constexpr uint8_t kStreamHeader[] = {0x04, 0x00, 0x07};
+constexpr uint8_t kCommandRedirect[] = {0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x00, 0x00, 0x23, 0x2A};
+
+constexpr bool ack_round_trip() {
+    AckMessage decoded;
+    std::size_t consumed = 0;
+    if (!AckSchema::decode(kAckWithInterval, sizeof(kAckWithInterval), &decoded, &consumed)) {
+        return false;
+    }
+    // CmdId=0x01但缺少CmdPayload必须判为截断
+    AckMessage truncated;
+    return consumed == sizeof(kAckWithInterval) && decoded.code == RespCode::Ok &&
+           decoded.timestamp == 0x000000018CABCDEFull && decoded.cmd == CmdId::SetInterval &&
+           decoded.cmdPayload == 1000 && !AckSchema::decode(kAckWithInterval, kAckPayloadMinBytes, &truncated);
+}
+
+static_assert(kAckPayloadMinBytes == 10 && kAckPayloadMaxBytes == 14, "ACK layout changed");
+static_assert(kRequestHeaderBytes == 3 && kBatchHeaderBytes == 5, "request layout changed");
+static_assert(matches_wire<AckSchema>(AckMessage{RespCode::Ok, 0x000000018CABCDEFull, CmdId::SetInterval, 1000}, kAckWithInterval));
+static_assert(matches_wire<AckSchema>(AckMessage{RespCode::Command, 1, CmdId::RetryAfter, 2000}, kCommandRetryAfter));
+static_assert(matches_wire<AckSchema>(AckMessage{RespCode::Invalid, 42, CmdId::None, 1000}, kAckInvalid));
+static_assert(matches_wire<RequestSchema>(RequestHeader{MsgType::Text, 1234}, kRequestHeader));
+static_assert(matches_wire<AckSchema>(AckMessage{RespCode::Ok, 5, CmdId::StreamAck, pack_stream_ack(7, 1)}, kStreamAck));
+static_assert(matches_wire<StreamSchema>(StreamHeader{MsgType::Stream, 7}, kStreamHeader));
+static_assert(matches_wire<AckSchema>(AckMessage{RespCode::Command, 2, CmdId::Redirect, 9002}, kCommandRedirect));
+static_assert(kRedirectHostOffset == kAckPayloadMaxBytes, "redirect host must follow the command header");
+static_assert(kStreamHeaderBytes == 3, "stream layout changed");
+static_assert(ack_round_trip());
+
 }  // namespace
 
+ProtocolParser::ProtocolParser() {
+    // 预留两帧上限的空间，稳态下append()不再触发扩容
+    buffer_.reserve(2 * (kMaxPayloadBytes + kMaxFrameOverheadBytes));
+}
+
 void ProtocolParser::append(const QByteArray &data) {
-    buffer_.append(data);
+    append(data.constData(), data.size());
+}
+
+void ProtocolParser::append(const char *data, qsizetype size) {
+    if (offset_ > 0) {
+        buffer_.remove(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+void ProtocolParser::trim(qsizetype maxCapacity) {
+    if (buffer_.capacity() <= maxCapacity) {
+        return;
+    }
+    if (offset_ > 0) {
+        buffer_.remove(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.squeeze();
 }
 
 void ProtocolParser::clear() {
-    buffer_.clear();
+    buffer_.resize(0);  // QByteArray::clear()会释放存储，丢掉构造时的预留
+    offset_ = 0;
 }
 
 std::optional<ParsedFrame> ProtocolParser::nextFrame(FrameError *error, QString *message) {
+    FrameView view;
+    if (!nextFrameView(&view, error, message)) {
+        return std::nullopt;
+    }
+    ParsedFrame parsed;
+    parsed.frame.version = view.version;
+    parsed.frame.payload = view.payloadCopy();
+    parsed.rawBytes = QByteArray(view.raw, view.rawSize);
+    return parsed;
+}
+
+bool ProtocolParser::nextFrameView(FrameView *view, FrameError *error, QString *message) {
     if (error) {
         *error = FrameError::None;
     }
@@ -45,55 +139,64 @@ std::optional<ParsedFrame> ProtocolParser::nextFrame(FrameError *error, QString
     }
 
     while (true) {
-        const int sofIndex = buffer_.indexOf(char(kSof));
+        const qsizetype sofIndex = buffer_.indexOf(char(kSof), offset_);
         if (sofIndex < 0) {
-            if (!buffer_.isEmpty()) {
-                buffer_.clear();
+            if (offset_ < buffer_.size()) {
                 set_error(FrameError::MissingSOF, QStringLiteral("SOF not found"), error, message);
             }
-            return std::nullopt;
-        }
-
-        if (sofIndex > 0) {
-            buffer_.remove(0, sofIndex);
+            // 每次读事件把缓冲消费完都会走到这里：保留容量，不能用clear()
+            buffer_.resize(0);
+            offset_ = 0;
+            return false;
         }
+        offset_ = sofIndex;
 
-        if (buffer_.size() < kFixedFrameBytes) {
-            return std::nullopt;
+        const auto *base = reinterpret_cast<const uint8_t *>(buffer_.constData()) + offset_;
+        const qsizetype available = buffer_.size() - offset_;
+        if (available < kFixedFrameBytes) {
+            return false;
         }
 
-        const uint8_t version = static_cast<uint8_t>(buffer_.at(1));
-        if (version != kDefaultVersion) {
-            buffer_.remove(0, 1);  // Skip unexpected version byte while retaining SOF search.
+        const uint8_t version = base[1];
+        const int checksumSize = checksum_bytes(version);
+        if (checksumSize < 0 || (version == kVersionUnchecked && !acceptUnchecked_)) {
+            ++offset_;  // Skip unexpected version byte while retaining SOF search.
             set_error(FrameError::UnsupportedVersion, QStringLiteral("Unsupported version %1").arg(version), error, message);
             continue;
         }
 
-        const uint16_t payloadLen = read_u16(buffer_, 2);
+        const uint16_t payloadLen = static_cast<uint16_t>((base[2] << 8) | base[3]);
         if (payloadLen > kMaxPayloadBytes) {
-            buffer_.remove(0, 1);
+            ++offset_;
             set_error(FrameError::LengthTooLarge, QStringLiteral("Payload %1 exceeds limit").arg(payloadLen), error, message);
             continue;
         }
 
-        const int frameSize = 1 + 1 + 2 + payloadLen + 2 + 1;
-        if (buffer_.size() < frameSize) {
-            return std::nullopt;
+        const int frameSize = kFixedFrameBytes + payloadLen + checksumSize;
+        if (available < frameSize) {
+            return false;
         }
 
-        const uint8_t eof = static_cast<uint8_t>(buffer_.at(frameSize - 1));
+        const uint8_t eof = base[frameSize - 1];
         if (eof != kEof) {
-            buffer_.remove(0, 1);
+            ++offset_;
             set_error(FrameError::InvalidEOF, QStringLiteral("Invalid EOF 0x%1").arg(QString::number(eof, 16)), error, message);
             continue;
         }
 
-        const QByteArray headerPlusPayload = buffer_.mid(1, 1 + 2 + payloadLen);
-        const auto crcProvided = read_u16(buffer_, 1 + 1 + 2 + payloadLen);
-        const auto *ptr = reinterpret_cast<const uint8_t *>(headerPlusPayload.constData());
-        const uint16_t crcCalculated = crc16_ibm(ptr, static_cast<std::size_t>(headerPlusPayload.size()));
+        // 校验范围与CRC16相同：Version|Length|Payload
+        const std::size_t crcOffset = 1 + 1 + 2 + payloadLen;
+        uint32_t crcProvided = 0;
+        uint32_t crcCalculated = 0;
+        if (version == kVersionCrc16) {
+            crcProvided = schema::load_be<uint16_t>(base + crcOffset);
+            crcCalculated = crc16_ibm(base + 1, 1 + 2 + payloadLen);
+        } else if (version == kVersionCrc32c) {
+            crcProvided = schema::load_be<uint32_t>(base + crcOffset);
+            crcCalculated = crc32c(base + 1, 1 + 2 + payloadLen);
+        }
         if (crcCalculated != crcProvided) {
-            buffer_.remove(0, 1);
+            ++offset_;
             set_error(FrameError::InvalidCRC,
                       QStringLiteral("CRC mismatch calc=0x%1 recv=0x%2")
                           .arg(QString::number(crcCalculated, 16))
@@ -102,35 +205,172 @@ std::optional<ParsedFrame> ProtocolParser::nextFrame(FrameError *error, QString
             continue;
         }
 
-        ParsedFrame parsed;
-        parsed.frame.version = version;
-        parsed.frame.payload = buffer_.mid(4, payloadLen);
-        parsed.rawBytes = buffer_.left(frameSize);
-        buffer_.remove(0, frameSize);
-        return parsed;
+        view->version = version;
+        view->raw = reinterpret_cast<const char *>(base);
+        view->rawSize = frameSize;
+        view->payload = view->raw + 4;
+        view->payloadSize = payloadLen;
+        offset_ += frameSize;
+        return true;
     }
 }
 
 QByteArray build_frame(uint8_t version, const QByteArray &payload) {
-    QByteArray frame;
-    const uint16_t payloadLen = static_cast<uint16_t>(payload.size());
-    const int frameSize = 1 + 1 + 2 + payloadLen + 2 + 1;
-    frame.reserve(frameSize);
-    frame.append(char(kSof));
-    QByteArray headerPayload;
-    headerPayload.append(char(version));
-    headerPayload.append(char((payloadLen >> 8) & 0xFF));
-    headerPayload.append(char(payloadLen & 0xFF));
-    headerPayload.append(payload);
-
-    const auto *ptr = reinterpret_cast<const uint8_t *>(headerPayload.constData());
-    const auto crc = crc16_ibm(ptr, static_cast<std::size_t>(headerPayload.size()));
-
-    frame.append(headerPayload);
-    frame.append(char((crc >> 8) & 0xFF));
-    frame.append(char(crc & 0xFF));
-    frame.append(char(kEof));
+    QByteArray frame(kMaxFrameOverheadBytes + payload.size(), Qt::Uninitialized);
+    frame.truncate(encode_frame(version, payload.constData(), static_cast<int>(payload.size()), frame.data()));
     return frame;
 }
 
+int encode_frame(uint8_t version, const char *payload, int size, char *out) {
+    const auto payloadLen = static_cast<uint16_t>(size);
+    auto *bytes = reinterpret_cast<uint8_t *>(out);
+    bytes[0] = kSof;
+    bytes[1] = version;
+    bytes[2] = static_cast<uint8_t>((payloadLen >> 8) & 0xFF);
+    bytes[3] = static_cast<uint8_t>(payloadLen & 0xFF);
+    if (payloadLen > 0) {
+        std::memcpy(bytes + 4, payload, payloadLen);
+    }
+    const auto checked = static_cast<std::size_t>(1 + 2 + payloadLen);
+    uint8_t *trailer = bytes + 4 + payloadLen;
+    if (version == kVersionCrc32c) {
+        schema::store_be(trailer, crc32c(bytes + 1, checked));
+        trailer += 4;
+    } else if (version != kVersionUnchecked) {
+        // 未知版本沿用CRC16布局，便于构造测试用的异常帧
+        schema::store_be(trailer, crc16_ibm(bytes + 1, checked));
+        trailer += 2;
+    }
+    *trailer++ = kEof;
+    return static_cast<int>(trailer - bytes);
+}
+
+QByteArray build_request_payload(MsgType type, uint16_t msgId, const QByteArray &body) {
+    QByteArray payload(kRequestHeaderBytes + body.size(), Qt::Uninitialized);
+    RequestSchema::encode(RequestHeader{type, msgId}, reinterpret_cast<uint8_t *>(payload.data()));
+    std::memcpy(payload.data() + kRequestHeaderBytes, body.constData(), std::size_t(body.size()));
+    return payload;
+}
+
+QByteArray build_stream_payload(uint16_t streamId, const QByteArray &innerPayload) {
+    QByteArray payload(kStreamHeaderBytes + innerPayload.size(), Qt::Uninitialized);
+    StreamSchema::encode(StreamHeader{MsgType::Stream, streamId}, reinterpret_cast<uint8_t *>(payload.data()));
+    std::memcpy(payload.data() + kStreamHeaderBytes, innerPayload.constData(), std::size_t(innerPayload.size()));
+    return payload;
+}
+
+QByteArray begin_batch_payload(uint16_t msgId) {
+    QByteArray payload;
+    payload.reserve(kMaxPayloadBytes);
+    payload.resize(kBatchHeaderBytes);
+    BatchSchema::encode(BatchHeader{MsgType::Batch, msgId, 0}, reinterpret_cast<uint8_t *>(payload.data()));
+    return payload;
+}
+
+void append_batch_entry(QByteArray &batchPayload, const QByteArray &subPayload) {
+    append_u16(batchPayload, static_cast<uint16_t>(subPayload.size()));
+    batchPayload.append(subPayload);
+    auto *header = reinterpret_cast<uint8_t *>(batchPayload.data());
+    BatchHeader batch;
+    BatchSchema::decode(header, std::size_t(batchPayload.size()), &batch);
+    ++batch.count;
+    BatchSchema::encode(batch, header);
+}
+
+bool split_batch(const QByteArray &batchPayload, QVector<QByteArray> *entries, QString *error) {
+    BatchHeader header;
+    if (!BatchSchema::decode(reinterpret_cast<const uint8_t *>(batchPayload.constData()), std::size_t(batchPayload.size()), &header) ||
+        header.type != MsgType::Batch) {
+        if (error) {
+            *error = QStringLiteral("Batch header truncated");
+        }
+        return false;
+    }
+    const uint16_t count = header.count;
+    int offset = kBatchHeaderBytes;
+    entries->clear();
+    entries->reserve(count);
+    for (uint16_t i = 0; i < count; ++i) {
+        if (offset + kBatchEntryOverhead > batchPayload.size()) {
+            if (error) {
+                *error = QStringLiteral("Batch entry %1 length missing").arg(i);
+            }
+            return false;
+        }
+        const uint16_t subLen = read_u16(batchPayload, offset);
+        offset += kBatchEntryOverhead;
+        if (subLen < kRequestHeaderBytes || offset + subLen > batchPayload.size()) {
+            if (error) {
+                *error = QStringLiteral("Batch entry %1 length %2 invalid").arg(i).arg(subLen);
+            }
+            return false;
+        }
+        if (static_cast<uint8_t>(batchPayload.at(offset)) == uint8_t(MsgType::Batch)) {
+            if (error) {
+                *error = QStringLiteral("Nested batch not allowed");
+            }
+            return false;
+        }
+        entries->append(batchPayload.mid(offset, subLen));
+        offset += subLen;
+    }
+    if (offset != batchPayload.size()) {
+        if (error) {
+            *error = QStringLiteral("Batch has %1 trailing bytes").arg(batchPayload.size() - offset);
+        }
+        return false;
+    }
+    return true;
+}
+
+QByteArray build_command_payload(CmdId cmd, uint32_t cmdPayload) {
+    AckMessage command;
+    command.code = RespCode::Command;
+    command.timestamp = static_cast<uint64_t>(QDateTime::currentMSecsSinceEpoch());
+    command.cmd = cmd;
+    command.cmdPayload = cmdPayload;
+    char payload[kAckPayloadMaxBytes];
+    const int size = encode_ack_payload(command, payload);
+    return QByteArray(payload, size);
+}
+
+QByteArray build_redirect_payload(uint16_t port, const QByteArray &host) {
+    QByteArray payload = build_command_payload(CmdId::Redirect, port);
+    payload.append(host.left(kMaxRedirectHostBytes));
+    return payload;
+}
+
+QByteArray redirect_host(const QByteArray &commandPayload) {
+    AckMessage command;
+    if (!decode_ack_payload(commandPayload.constData(), commandPayload.size(), &command) ||
+        command.cmd != CmdId::Redirect) {
+        return {};
+    }
+    return commandPayload.mid(kRedirectHostOffset);
+}
+
+QByteArray build_notify_payload(const QByteArray &topic, const QByteArray &body) {
+    const QByteArray name = topic.left(kMaxTopicBytes);
+    QByteArray payload;
+    payload.reserve(kNotifyHeaderBytes + name.size() + body.size());
+    payload.append(char(RespCode::Notify));
+    payload.append(char(name.size()));
+    payload.append(name);
+    payload.append(body);
+    return payload;
+}
+
+bool split_notify_payload(const QByteArray &payload, QByteArray *topic, QByteArray *body) {
+    if (payload.size() < kNotifyHeaderBytes || static_cast<uint8_t>(payload.at(0)) != uint8_t(RespCode::Notify)) {
+        return false;
+    }
+    const int topicLen = static_cast<uint8_t>(payload.at(1));
+    if (kNotifyHeaderBytes + topicLen > payload.size()) {
+        return false;
+    }
+    *topic = payload.mid(kNotifyHeaderBytes, topicLen);
+    *body = payload.mid(kNotifyHeaderBytes + topicLen);
+    return true;
+}
+
 }  // namespace cs::protocol
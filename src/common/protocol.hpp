@@ -2,16 +2,171 @@
 
 #include <QtCore/QByteArray>
 #include <QtCore/QString>
+#include <QtCore/QVector>
 
 #include <cstdint>
 #include <optional>
 
+#include "payload_schema.hpp"
+
 namespace cs::protocol {
 
 constexpr uint8_t kSof = 0xAA;
 constexpr uint8_t kEof = 0x55;
-constexpr uint8_t kDefaultVersion = 0x01;
+// Version决定帧尾校验字段：0x01为CRC16(2字节)，0x02为CRC32C(4字节)，0x03不带校验，仅用于可信的本机链路
+constexpr uint8_t kVersionCrc16 = 0x01;
+constexpr uint8_t kVersionCrc32c = 0x02;
+constexpr uint8_t kVersionUnchecked = 0x03;
+constexpr uint8_t kDefaultVersion = kVersionCrc16;
 constexpr uint16_t kMaxPayloadBytes = 4096;
+constexpr int kFrameOverheadBytes = 1 /*SOF*/ + 1 /*Version*/ + 2 /*Length*/ + 2 /*CRC*/ + 1 /*EOF*/;
+constexpr int kMaxFrameOverheadBytes = kFrameOverheadBytes + 2 /*CRC32C比CRC16多出的字节*/;
+
+// 该版本帧尾校验字段的字节数，未知版本返回-1
+constexpr int checksum_bytes(uint8_t version) {
+    switch (version) {
+    case kVersionCrc16:
+        return 2;
+    case kVersionCrc32c:
+        return 4;
+    case kVersionUnchecked:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+constexpr int frame_overhead_bytes(uint8_t version) {
+    return 1 /*SOF*/ + 1 /*Version*/ + 2 /*Length*/ + checksum_bytes(version) + 1 /*EOF*/;
+}
+
+// 请求payload: [MsgType(1)][MsgId(2)][Body]
+enum class MsgType : uint8_t {
+    Text = 0x01,
+    Binary = 0x02,
+    Batch = 0x03,
+    Stream = 0x04,       // 逻辑流：Body为内层请求payload，见StreamHeader
+    Command = 0x10,
+    Subscribe = 0x11,    // Body为主题名(UTF-8)
+    Unsubscribe = 0x12,
+    Hello = 0x13,        // Body为客户端标识(UTF-8)，连接建立后首先发送；集群按它选择归属节点
+};
+
+struct RequestHeader {
+    MsgType type = MsgType::Text;
+    uint16_t msgId = 0;
+};
+
+using RequestSchema = schema::Schema<RequestHeader,
+                                     schema::Fixed<schema::Field<&RequestHeader::type>,
+                                                   schema::Field<&RequestHeader::msgId>>>;
+
+constexpr int kRequestHeaderBytes = int(RequestSchema::kFixedBytes);
+// 客户端标识超出部分由服务器截断
+constexpr int kMaxClientIdBytes = 64;
+
+// 批量消息Body: [Count(2)] + Count × ([SubLen(2)][SubPayload(SubLen)])，SubPayload为完整请求payload
+struct BatchHeader {
+    MsgType type = MsgType::Batch;
+    uint16_t msgId = 0;
+    uint16_t count = 0;
+};
+
+using BatchSchema = schema::Schema<BatchHeader,
+                                   schema::Fixed<schema::Field<&BatchHeader::type>,
+                                                 schema::Field<&BatchHeader::msgId>,
+                                                 schema::Field<&BatchHeader::count>>>;
+
+constexpr int kBatchHeaderBytes = int(BatchSchema::kFixedBytes);
+constexpr int kBatchEntryOverhead = 2 /*SubLen*/;
+
+// 流帧payload: [0x04][StreamId(2)][内层请求payload]。一个连接上复用多条互相独立的逻辑流，
+// 每条流有自己的MsgId序列和发送额度；StreamId从1开始，内层payload为空表示关闭该流。
+struct StreamHeader {
+    MsgType type = MsgType::Stream;
+    uint16_t streamId = 0;
+};
+
+using StreamSchema = schema::Schema<StreamHeader,
+                                    schema::Fixed<schema::Field<&StreamHeader::type>,
+                                                  schema::Field<&StreamHeader::streamId>>>;
+
+constexpr int kStreamHeaderBytes = int(StreamSchema::kFixedBytes);
+// 每条流最多在途(已发出未确认)的帧数；每个ACK按CmdId=0x04归还额度
+constexpr int kStreamWindow = 32;
+constexpr int kMaxStreamsPerSession = 1024;
+
+QByteArray build_stream_payload(uint16_t streamId, const QByteArray &innerPayload);
+
+inline bool decode_stream_header(const char *data, qsizetype size, StreamHeader *header) {
+    return StreamSchema::decode(reinterpret_cast<const uint8_t *>(data), std::size_t(size), header) &&
+           header->type == MsgType::Stream;
+}
+
+// ACK payload: [RespCode(1)][Timestamp(8,毫秒)][CmdId(1)][CmdPayload(CmdId=0x01~0x04时4字节)]
+enum class RespCode : uint8_t {
+    Ok = 0x00,
+    Invalid = 0x01,
+    Notify = 0x80,   // 服务器主动推送，不是ACK，见build_notify_payload()
+    Command = 0x81,  // 服务器主动下发的命令，布局与ACK相同，不是ACK
+};
+
+enum class CmdId : uint8_t {
+    None = 0x00,
+    SetInterval = 0x01,
+    RetryAfter = 0x02,  // CmdPayload为毫秒数：客户端断开后至少等待这么久再重连
+    Redirect = 0x03,    // 仅作服务器命令：CmdPayload为目标端口，其后可跟目标主机名，见build_redirect_payload()
+    StreamAck = 0x04,   // 流帧的ACK，CmdPayload为[StreamId(2)][归还的额度(2)]
+};
+
+constexpr uint32_t pack_stream_ack(uint16_t streamId, uint16_t credit) {
+    return (uint32_t(streamId) << 16) | credit;
+}
+constexpr uint16_t stream_ack_id(uint32_t cmdPayload) { return uint16_t(cmdPayload >> 16); }
+constexpr uint16_t stream_ack_credit(uint32_t cmdPayload) { return uint16_t(cmdPayload & 0xFFFF); }
+
+struct AckMessage {
+    RespCode code = RespCode::Ok;
+    uint64_t timestamp = 0;
+    CmdId cmd = CmdId::None;
+    uint32_t cmdPayload = 0;
+};
+
+using AckSchema = schema::Schema<AckMessage,
+                                 schema::Fixed<schema::Field<&AckMessage::code>,
+                                               schema::Field<&AckMessage::timestamp>,
+                                               schema::Field<&AckMessage::cmd>>,
+                                 schema::Optional<schema::OptionalField<&AckMessage::cmdPayload,
+                                                                        &AckMessage::cmd, CmdId::SetInterval,
+                                                                        CmdId::RetryAfter, CmdId::Redirect,
+                                                                        CmdId::StreamAck>>>;
+
+constexpr int kAckPayloadMinBytes = int(AckSchema::kFixedBytes);
+constexpr int kAckPayloadMaxBytes = int(AckSchema::kMaxBytes);
+
+// out至少kAckPayloadMaxBytes字节，返回写入的字节数
+inline int encode_ack_payload(const AckMessage &ack, char *out) {
+    return int(AckSchema::encode(ack, reinterpret_cast<uint8_t *>(out)));
+}
+
+// 服务器主动命令帧(RespCode=0x81)的payload，时间戳取当前时刻
+QByteArray build_command_payload(CmdId cmd, uint32_t cmdPayload);
+
+// 重定向命令payload: [命令头(14)][Host(UTF-8，可为空)]。Host为空表示沿用客户端当前连接的主机，只换端口
+constexpr int kRedirectHostOffset = kAckPayloadMaxBytes;
+constexpr int kMaxRedirectHostBytes = 255;
+QByteArray build_redirect_payload(uint16_t port, const QByteArray &host);
+// 服务器命令payload中重定向目标的主机名部分，不是重定向命令时返回空
+QByteArray redirect_host(const QByteArray &commandPayload);
+
+inline bool decode_ack_payload(const char *data, qsizetype size, AckMessage *ack) {
+    return AckSchema::decode(reinterpret_cast<const uint8_t *>(data), std::size_t(size), ack);
+}
+
+// 成功时Body从data + kRequestHeaderBytes开始
+inline bool decode_request_header(const char *data, qsizetype size, RequestHeader *header) {
+    return RequestSchema::decode(reinterpret_cast<const uint8_t *>(data), std::size_t(size), header);
+}
 
 enum class FrameError {
     None = 0,
@@ -33,16 +188,59 @@ struct ParsedFrame {
     QByteArray rawBytes;
 };
 
+// 指向解析器内部缓冲区的帧视图，在下一次append()/nextFrame*()/clear()之前有效
+struct FrameView {
+    uint8_t version = kDefaultVersion;
+    const char *payload = nullptr;
+    int payloadSize = 0;
+    const char *raw = nullptr;
+    int rawSize = 0;
+
+    QByteArray payloadCopy() const { return QByteArray(payload, payloadSize); }
+};
+
 class ProtocolParser {
 public:
+    ProtocolParser();
+
     void append(const QByteArray &data);
+    void append(const char *data, qsizetype size);
     std::optional<ParsedFrame> nextFrame(FrameError *error = nullptr, QString *message = nullptr);
+    // 零拷贝版本：CRC就地校验、不复制payload，稳态下不分配内存
+    bool nextFrameView(FrameView *view, FrameError *error = nullptr, QString *message = nullptr);
+    // 丢弃缓冲的数据，保留容量；需要归还内存时用trim()
     void clear();
+    // 是否接受不带校验的0x03帧，默认拒绝(按UnsupportedVersion处理)；只应对本机传输开启
+    void setAcceptUnchecked(bool accept) { acceptUnchecked_ = accept; }
+    bool acceptUnchecked() const { return acceptUnchecked_; }
+    qsizetype bufferedBytes() const { return buffer_.size() - offset_; }
+    // 缓冲区实际占用的内存(含已消费未前移的部分与预留容量)
+    qsizetype bufferCapacity() const { return buffer_.capacity(); }
+    // 容量超过maxCapacity时前移未消费数据并释放多余容量；突发流量过后让空闲会话回到小缓冲
+    void trim(qsizetype maxCapacity);
 
 private:
     QByteArray buffer_;
+    qsizetype offset_ = 0;  // 已消费字节，延迟到append()时再整体前移
+    bool acceptUnchecked_ = false;
 };
 
+// 帧尾按version写入CRC16/CRC32C或不写校验，未知版本按CRC16布局编码
 QByteArray build_frame(uint8_t version, const QByteArray &payload);
+// 把一帧直接编码到out（至少kMaxFrameOverheadBytes + size字节），返回写入的字节数
+int encode_frame(uint8_t version, const char *payload, int size, char *out);
+
+QByteArray build_request_payload(MsgType type, uint16_t msgId, const QByteArray &body);
+// 追加一条子消息到批量payload（payload需已含批量头），并更新Count
+void append_batch_entry(QByteArray &batchPayload, const QByteArray &subPayload);
+QByteArray begin_batch_payload(uint16_t msgId);
+// 拆分批量payload，格式错误时返回false并给出原因
+bool split_batch(const QByteArray &batchPayload, QVector<QByteArray> *entries, QString *error = nullptr);
+
+// 推送payload: [0x80][TopicLen(1)][Topic(UTF-8)][Body]，空主题表示广播
+constexpr int kNotifyHeaderBytes = 1 /*RespCode*/ + 1 /*TopicLen*/;
+constexpr int kMaxTopicBytes = 255;
+QByteArray build_notify_payload(const QByteArray &topic, const QByteArray &body);
+bool split_notify_payload(const QByteArray &payload, QByteArray *topic, QByteArray *body);
 
 }  // namespace cs::protocol
@@ -0,0 +1,122 @@
+#include "send_queue.hpp"
+
+#include <limits>
+
+#include "frame_trace.hpp"
+#include "transport.hpp"
+
+namespace cs::common {
+
+SendQueue::SendQueue(qint64 highWaterBytes, qint64 bulkHighWaterBytes)
+    : highWaterBytes_(highWaterBytes),
+      bulkHighWaterBytes_(bulkHighWaterBytes) {}
+
+bool SendQueue::writable(Transport *transport, std::size_t index) const {
+    const qint64 limit = index == static_cast<std::size_t>(SendPriority::Bulk) ? qMin(bulkHighWaterBytes_, highWaterBytes_)
+                                                                                : highWaterBytes_;
+    return transport->bytesToWrite() < limit;
+}
+
+void SendQueue::write(Transport *transport, SendPriority priority, const char *data, qint64 size) {
+    if (size <= 0) {
+        return;
+    }
+    // 有任何排队的帧时新帧也要排队：同级保持顺序，低级别不能越过已排队的高级别帧
+    if (queuedBytes_ == 0 && writable(transport, static_cast<std::size_t>(priority))) {
+        transport->write(data, size);
+        account(priority, 0, false);
+        return;
+    }
+    write(transport, priority, QByteArray(data, size));
+}
+
+void SendQueue::write(Transport *transport, SendPriority priority, const QByteArray &frames) {
+    if (frames.isEmpty()) {
+        return;
+    }
+    const auto index = static_cast<std::size_t>(priority);
+    if (queuedBytes_ == 0 && writable(transport, index)) {
+        transport->write(frames);  // 隐式共享，广播帧不复制
+        account(priority, 0, false);
+        return;
+    }
+    queues_[index].push_back(Entry{frames, FrameTracer::now()});
+    queuedBytes_ += frames.size();
+    counters_[index].queuedBytes.fetch_add(frames.size(), std::memory_order_relaxed);
+    if (priority != SendPriority::Bulk) {
+        // 排队的可能只是因Bulk水位而等待的推送：命令与ACK按自己的水位立即写出，不等下一次bytesWritten
+        pump(transport);
+    }
+}
+
+int SendQueue::pump(Transport *transport) {
+    int written = 0;
+    while (queuedBytes_ > 0) {
+        for (std::size_t index = 0; index < queues_.size(); ++index) {
+            auto &queue = queues_[index];
+            if (queue.empty()) {
+                continue;
+            }
+            // 只看最高的非空级别：它写不出时更低级别的水位也不会更高
+            if (!writable(transport, index)) {
+                return written;
+            }
+            Entry entry = std::move(queue.front());
+            queue.pop_front();
+            queuedBytes_ -= entry.data.size();
+            counters_[index].queuedBytes.fetch_sub(entry.data.size(), std::memory_order_relaxed);
+            transport->write(entry.data);
+            account(static_cast<SendPriority>(index), FrameTracer::now() - entry.enqueuedNs, true);
+            ++written;
+            break;  // 每写出一条都重新从最高级别找起
+        }
+    }
+    return written;
+}
+
+void SendQueue::flush(Transport *transport) {
+    const qint64 highWater = highWaterBytes_;
+    const qint64 bulkHighWater = bulkHighWaterBytes_;
+    highWaterBytes_ = std::numeric_limits<qint64>::max();
+    bulkHighWaterBytes_ = highWaterBytes_;
+    pump(transport);
+    highWaterBytes_ = highWater;
+    bulkHighWaterBytes_ = bulkHighWater;
+}
+
+void SendQueue::clear() {
+    for (std::size_t index = 0; index < queues_.size(); ++index) {
+        queues_[index].clear();
+        counters_[index].queuedBytes.store(0, std::memory_order_relaxed);
+    }
+    queuedBytes_ = 0;
+}
+
+SendQueue::ClassStats SendQueue::stats(SendPriority priority) const {
+    const Counters &counters = counters_[static_cast<std::size_t>(priority)];
+    ClassStats stats;
+    stats.frames = counters.frames.load(std::memory_order_relaxed);
+    stats.queued = counters.queued.load(std::memory_order_relaxed);
+    stats.totalWaitNs = counters.totalWaitNs.load(std::memory_order_relaxed);
+    stats.maxWaitNs = counters.maxWaitNs.load(std::memory_order_relaxed);
+    stats.queuedBytes = counters.queuedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SendQueue::account(SendPriority priority, int64_t waitNs, bool wasQueued) {
+    Counters &counters = counters_[static_cast<std::size_t>(priority)];
+    counters.frames.fetch_add(1, std::memory_order_relaxed);
+    if (wasQueued) {
+        counters.queued.fetch_add(1, std::memory_order_relaxed);
+        counters.totalWaitNs.fetch_add(static_cast<quint64>(waitNs), std::memory_order_relaxed);
+        // 只有所属线程写入，读-比较-写即可
+        if (waitNs > counters.maxWaitNs.load(std::memory_order_relaxed)) {
+            counters.maxWaitNs.store(waitNs, std::memory_order_relaxed);
+        }
+    }
+    if (recorder_) {
+        recorder_(priority, waitNs);
+    }
+}
+
+}  // namespace cs::common
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace cs::common {
+
+class Transport;
+
+// 发送优先级，数值越小越先写出
+enum class SendPriority : uint8_t {
+    Control = 0,      // 服务器命令(限速、RetryAfter)、客户端命令/订阅
+    Interactive = 1,  // ACK、单条请求
+    Bulk = 2,         // 推送、批量/压测流量
+};
+
+constexpr int kSendPriorityCount = 3;
+
+// 逐连接的分级发送队列。传输层写缓冲低于高水位时直接写出，否则按优先级暂存整帧，
+// 等bytesWritten后由pump()按优先级写出，因此高优先级帧只在帧边界插到已排队的低优先级帧前面，
+// 已交给传输层的字节不再重排。Bulk帧使用更低的水位：传输层中排在命令与ACK前面的推送数据
+// 不超过bulkHighWaterBytes(外加一帧)。只能在连接所在线程调用；统计为原子量，可在其他线程读取。
+class SendQueue {
+public:
+    static constexpr qint64 kDefaultHighWaterBytes = 64 * 1024;
+    static constexpr qint64 kDefaultBulkHighWaterBytes = 16 * 1024;
+
+    struct ClassStats {
+        quint64 frames = 0;       // 写出的条目数(ACK合批时一批算一条)
+        quint64 queued = 0;       // 其中曾经排队等待的条目数
+        quint64 totalWaitNs = 0;  // 排队等待合计，直接写出的按0计
+        qint64 maxWaitNs = 0;
+        qint64 queuedBytes = 0;   // 当前排队中的字节
+
+        double avgWaitUs() const { return frames == 0 ? 0.0 : double(totalWaitNs) / double(frames) / 1000.0; }
+    };
+
+    using WaitRecorder = std::function<void(SendPriority priority, qint64 waitNs)>;
+
+    explicit SendQueue(qint64 highWaterBytes = kDefaultHighWaterBytes,
+                       qint64 bulkHighWaterBytes = kDefaultBulkHighWaterBytes);
+
+    // data须为一帧或若干完整帧；可以直接写出时不复制
+    void write(Transport *transport, SendPriority priority, const char *data, qint64 size);
+    void write(Transport *transport, SendPriority priority, const QByteArray &frames);
+    // 传输层写缓冲回落后调用，按优先级写出排队的帧，返回写出的条目数
+    int pump(Transport *transport);
+    // 关闭连接前调用：不管高水位，按优先级写出全部排队的帧
+    void flush(Transport *transport);
+    void clear();
+
+    bool empty() const { return queuedBytes_ == 0; }
+    qint64 queuedBytes() const { return queuedBytes_; }
+    void setHighWaterBytes(qint64 bytes) { highWaterBytes_ = bytes; }
+    void setBulkHighWaterBytes(qint64 bytes) { bulkHighWaterBytes_ = bytes; }
+    // 每个写出的条目的排队时间都会回调，服务器用它汇总各级别的等待分布
+    void setWaitRecorder(WaitRecorder recorder) { recorder_ = std::move(recorder); }
+    ClassStats stats(SendPriority priority) const;
+
+private:
+    struct Entry {
+        QByteArray data;
+        int64_t enqueuedNs = 0;
+    };
+    struct Counters {
+        std::atomic<quint64> frames{0};
+        std::atomic<quint64> queued{0};
+        std::atomic<quint64> totalWaitNs{0};
+        std::atomic<qint64> maxWaitNs{0};
+        std::atomic<qint64> queuedBytes{0};
+    };
+
+    bool writable(Transport *transport, std::size_t index) const;
+    void account(SendPriority priority, int64_t waitNs, bool wasQueued);
+
+    std::array<std::deque<Entry>, kSendPriorityCount> queues_;
+    std::array<Counters, kSendPriorityCount> counters_;
+    qint64 queuedBytes_ = 0;
+    qint64 highWaterBytes_;
+    qint64 bulkHighWaterBytes_;
+    WaitRecorder recorder_;
+};
+
+}  // namespace cs::common
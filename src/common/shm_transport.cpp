@@ -0,0 +1,631 @@
+#include "shm_transport.hpp"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+#include <QtNetwork/QLocalSocket>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace cs::common {
+
+// head/tail单调递增，按容量取模定位；两端各占独立缓存行，避免伪共享
+struct ShmRingHeader {
+    alignas(64) std::atomic<quint64> head{0};  // 消费者已读到的位置
+    alignas(64) std::atomic<quint64> tail{0};  // 生产者已写到的位置
+    alignas(64) std::atomic<quint32> consumerWaiting{1};  // 消费者已读空并等待唤醒
+    std::atomic<quint32> producerWaiting{0};              // 生产者因环满等待唤醒
+};
+
+namespace {
+
+constexpr quint32 kShmMagic = 0x43534D52;  // "CSMR"
+constexpr quint32 kShmVersion = 1;
+constexpr std::size_t kPageBytes = 4096;
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "共享内存中的原子量必须无锁");
+
+// rings[0]为客户端→服务器，rings[1]为服务器→客户端；数据区从页边界开始依次排列
+struct ShmRegion {
+    quint32 magic = kShmMagic;
+    quint32 version = kShmVersion;
+    quint32 ringBytes = 0;
+    ShmRingHeader rings[2];
+};
+
+// 握手消息，随SCM_RIGHTS一起发送；描述符顺序为memfd、服务器eventfd、客户端eventfd
+struct ShmHello {
+    quint32 magic = kShmMagic;
+    quint32 ringBytes = 0;
+};
+
+std::size_t data_offset() {
+    return (sizeof(ShmRegion) + kPageBytes - 1) / kPageBytes * kPageBytes;
+}
+
+quint32 round_ring_bytes(quint32 bytes) {
+    quint32 size = 4096;
+    while (size < bytes && size < (1u << 30)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+#ifdef Q_OS_LINUX
+QString errno_string(const char *step) {
+    return QStringLiteral("%1: %2").arg(QLatin1String(step), QString::fromLocal8Bit(std::strerror(errno)));
+}
+
+void close_fd(int &fd) {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+#endif
+
+}  // namespace
+
+ShmTransport::ShmTransport(QObject *parent) : Transport(parent) {}
+
+ShmTransport::~ShmTransport() {
+    cancelHandshake();
+    release();
+}
+
+bool ShmTransport::supported() {
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+ShmTransport *ShmTransport::accept(QLocalSocket *channel, quint32 ringBytes, QString *error) {
+#ifdef Q_OS_LINUX
+    const quint32 ring = round_ring_bytes(ringBytes);
+    const std::size_t total = data_offset() + 2 * std::size_t(ring);
+    int memfd = ::memfd_create("cs-shm-transport", MFD_CLOEXEC);
+    if (memfd < 0) {
+        if (error) {
+            *error = errno_string("memfd_create");
+        }
+        return nullptr;
+    }
+    if (::ftruncate(memfd, static_cast<off_t>(total)) != 0) {
+        if (error) {
+            *error = errno_string("ftruncate");
+        }
+        close_fd(memfd);
+        return nullptr;
+    }
+    // 先在服务器侧初始化区头，再把描述符交给客户端
+    void *base = ::mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (base == MAP_FAILED) {
+        if (error) {
+            *error = errno_string("mmap");
+        }
+        close_fd(memfd);
+        return nullptr;
+    }
+    auto *region = new (base) ShmRegion;
+    region->ringBytes = ring;
+    ::munmap(base, sizeof(ShmRegion));
+
+    int serverWake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int clientWake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (serverWake < 0 || clientWake < 0) {
+        if (error) {
+            *error = errno_string("eventfd");
+        }
+        close_fd(memfd);
+        close_fd(serverWake);
+        close_fd(clientWake);
+        return nullptr;
+    }
+
+    ShmHello hello;
+    hello.ringBytes = ring;
+    iovec iov{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * 3);
+    const int fds[3] = {memfd, serverWake, clientWake};
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    // 新接受的连接发送缓冲为空，8字节加描述符一次即可写入；写不进说明连接异常，直接失败而不在调用线程上等待
+    const int fd = static_cast<int>(channel->socketDescriptor());
+    ssize_t sent = -1;
+    do {
+        sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != static_cast<ssize_t>(sizeof(hello))) {
+        if (error) {
+            *error = errno_string("sendmsg");
+        }
+        close_fd(memfd);
+        close_fd(serverWake);
+        close_fd(clientWake);
+        return nullptr;
+    }
+
+    auto *transport = new ShmTransport;
+    if (!transport->attach(channel, memfd, ring, serverWake, clientWake, true, error)) {
+        delete transport;
+        close_fd(memfd);
+        close_fd(serverWake);
+        close_fd(clientWake);
+        return nullptr;
+    }
+    close_fd(memfd);  // 映射建立后不再需要
+    transport->peerAddress_ = QStringLiteral("shm");
+    return transport;
+#else
+    Q_UNUSED(channel);
+    Q_UNUSED(ringBytes);
+    if (error) {
+        *error = QStringLiteral("当前平台不支持共享内存传输");
+    }
+    return nullptr;
+#endif
+}
+
+bool ShmTransport::attach(QLocalSocket *channel, int memfd, quint32 ringBytes, int wakeFd, int peerWakeFd,
+                          bool serverSide, QString *error) {
+#ifdef Q_OS_LINUX
+    mappingBytes_ = data_offset() + 2 * std::size_t(ringBytes);
+    void *base = ::mmap(nullptr, mappingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (base == MAP_FAILED) {
+        if (error) {
+            *error = errno_string("mmap");
+        }
+        mappingBytes_ = 0;
+        return false;
+    }
+    auto *region = static_cast<ShmRegion *>(base);
+    if (region->magic != kShmMagic || region->version != kShmVersion || region->ringBytes != ringBytes) {
+        if (error) {
+            *error = QStringLiteral("共享内存区头不匹配");
+        }
+        ::munmap(base, mappingBytes_);
+        mappingBytes_ = 0;
+        return false;
+    }
+    mapping_ = base;
+    char *data = static_cast<char *>(base) + data_offset();
+    ShmRingHeader *toServer = &region->rings[0];
+    ShmRingHeader *toClient = &region->rings[1];
+    rx_ = serverSide ? toServer : toClient;
+    tx_ = serverSide ? toClient : toServer;
+    rxData_ = serverSide ? data : data + ringBytes;
+    txData_ = serverSide ? data + ringBytes : data;
+    ringMask_ = ringBytes - 1;
+    wakeFd_ = wakeFd;
+    peerWakeFd_ = peerWakeFd;
+
+    channel_ = channel;
+    channel_->setParent(this);
+    connect(channel_, &QLocalSocket::disconnected, this, &ShmTransport::onChannelClosed);
+    connect(channel_, &QLocalSocket::readyRead, this, [this]() { channel_->readAll(); });  // 协商后不再有数据
+
+    wakeNotifier_ = new QSocketNotifier(wakeFd_, QSocketNotifier::Read, this);
+    connect(wakeNotifier_, &QSocketNotifier::activated, this, &ShmTransport::onWake);
+    connected_ = true;
+    return true;
+#else
+    Q_UNUSED(channel);
+    Q_UNUSED(memfd);
+    Q_UNUSED(ringBytes);
+    Q_UNUSED(wakeFd);
+    Q_UNUSED(peerWakeFd);
+    Q_UNUSED(serverSide);
+    if (error) {
+        *error = QStringLiteral("当前平台不支持共享内存传输");
+    }
+    return false;
+#endif
+}
+
+void ShmTransport::release() {
+#ifdef Q_OS_LINUX
+    delete wakeNotifier_;
+    wakeNotifier_ = nullptr;
+    if (mapping_) {
+        ::munmap(mapping_, mappingBytes_);
+        mapping_ = nullptr;
+    }
+    rx_ = tx_ = nullptr;
+    close_fd(wakeFd_);
+    close_fd(peerWakeFd_);
+#endif
+    connected_ = false;
+    closeWhenFlushed_ = false;
+}
+
+int ShmTransport::takeHandshakeFd() {
+    // 先于描述符关闭或转交停用通知器；可能正处于它的activated信号中，延后删除
+    if (handshakeNotifier_) {
+        handshakeNotifier_->setEnabled(false);
+        handshakeNotifier_->deleteLater();
+        handshakeNotifier_ = nullptr;
+    }
+    if (handshakeTimer_) {
+        handshakeTimer_->stop();
+    }
+    return std::exchange(handshakeFd_, -1);
+}
+
+void ShmTransport::cancelHandshake() {
+#ifdef Q_OS_LINUX
+    int fd = takeHandshakeFd();
+    close_fd(fd);
+#endif
+}
+
+Transport::State ShmTransport::state() const {
+    if (connected_) {
+        return closeWhenFlushed_ ? State::Closing : State::Connected;
+    }
+    return handshakeFd_ >= 0 ? State::Connecting : State::Unconnected;
+}
+
+void ShmTransport::connectToHost(const QString &host, quint16) {
+#ifdef Q_OS_LINUX
+    cancelHandshake();
+    release();
+    if (channel_) {
+        channel_->abort();
+        channel_->deleteLater();
+        channel_ = nullptr;
+    }
+    outbox_.clear();
+    error_.clear();
+
+    // 与QLocalServer一致：非绝对路径位于临时目录下
+    const QString fullPath = host.startsWith(QLatin1Char('/')) ? host : QDir::tempPath() + QLatin1Char('/') + host;
+    const QByteArray nativePath = QFile::encodeName(fullPath);
+    sockaddr_un addr{};
+    if (nativePath.size() >= static_cast<int>(sizeof(addr.sun_path))) {
+        fail(QStringLiteral("路径过长: %1").arg(host));
+        return;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, nativePath.constData(), static_cast<std::size_t>(nativePath.size()));
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fail(errno_string("socket"));
+        return;
+    }
+    // 非阻塞的本地connect立即完成，服务器积压队列已满时返回EAGAIN，按失败处理
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        fail(errno_string("connect"));
+        close_fd(fd);
+        return;
+    }
+
+    handshakeFd_ = fd;
+    handshakeHost_ = host;
+    handshakeNotifier_ = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(handshakeNotifier_, &QSocketNotifier::activated, this, &ShmTransport::onHandshakeReadable);
+    if (!handshakeTimer_) {
+        handshakeTimer_ = new QTimer(this);
+        handshakeTimer_->setSingleShot(true);
+        connect(handshakeTimer_, &QTimer::timeout, this, &ShmTransport::onHandshakeTimeout);
+    }
+    handshakeTimer_->start(kHandshakeTimeoutMs);
+#else
+    Q_UNUSED(host);
+    fail(QStringLiteral("当前平台不支持共享内存传输"));
+#endif
+}
+
+void ShmTransport::onHandshakeReadable() {
+#ifdef Q_OS_LINUX
+    ShmHello hello;
+    iovec iov{&hello, sizeof(hello)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t received = ::recvmsg(handshakeFd_, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;  // 尚无完整消息，等下一次可读
+    }
+    const int savedErrno = errno;
+    int fd = takeHandshakeFd();
+
+    int fds[3] = {-1, -1, -1};
+    int count = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); received >= 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        const std::size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const auto *data = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+        for (std::size_t i = 0; i < n; ++i) {
+            if (count < 3) {
+                fds[count++] = data[i];
+            } else {
+                ::close(data[i]);
+            }
+        }
+    }
+    const auto closeAll = [&fds, &fd]() {
+        for (int &f : fds) {
+            close_fd(f);
+        }
+        close_fd(fd);
+    };
+    if (received != static_cast<ssize_t>(sizeof(hello)) || count != 3 || hello.magic != kShmMagic) {
+        errno = savedErrno;
+        fail(received < 0 ? errno_string("recvmsg") : QStringLiteral("共享内存协商消息无效"));
+        closeAll();
+        return;
+    }
+
+    auto *channel = new QLocalSocket;
+    if (!channel->setSocketDescriptor(fd)) {
+        fail(channel->errorString());
+        delete channel;
+        closeAll();
+        return;
+    }
+    fd = -1;  // 已由channel接管
+    QString error;
+    if (!attach(channel, fds[0], hello.ringBytes, fds[2], fds[1], false, &error)) {
+        fail(error);
+        delete channel;
+        closeAll();
+        return;
+    }
+    close_fd(fds[0]);
+    peerAddress_ = QStringLiteral("shm:%1").arg(handshakeHost_);
+    emit connected();
+#endif
+}
+
+void ShmTransport::onHandshakeTimeout() {
+    if (handshakeFd_ < 0) {
+        return;
+    }
+    cancelHandshake();
+    fail(QStringLiteral("等待共享内存协商超时"));
+}
+
+qint64 ShmTransport::read(char *data, qint64 maxSize) {
+    if (!rx_) {
+        return -1;
+    }
+    const quint64 head = rx_->head.load(std::memory_order_relaxed);
+    const quint64 tail = rx_->tail.load(std::memory_order_acquire);
+    const qint64 n = qMin<qint64>(maxSize, static_cast<qint64>(tail - head));
+    if (n <= 0) {
+        parkReader();
+        return 0;
+    }
+    const std::size_t offset = static_cast<std::size_t>(head & ringMask_);
+    const std::size_t first = qMin<std::size_t>(static_cast<std::size_t>(n), ringMask_ + 1 - offset);
+    std::memcpy(data, rxData_ + offset, first);
+    std::memcpy(data + first, rxData_, static_cast<std::size_t>(n) - first);
+    rx_->head.store(head + static_cast<quint64>(n), std::memory_order_release);
+    // 与生产者的producerWaiting置位构成Dekker式配对，保证不漏唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (rx_->producerWaiting.exchange(0, std::memory_order_relaxed) != 0) {
+        signalPeer();
+    }
+    return n;
+}
+
+qint64 ShmTransport::write(const char *data, qint64 size) {
+    if (!connected_ || closeWhenFlushed_) {
+        return -1;
+    }
+    if (size <= 0) {
+        return 0;
+    }
+    if (!outbox_.isEmpty()) {
+        outbox_.append(data, size);  // 前面还有积压，保持顺序
+        return size;
+    }
+    const qint64 n = pushRing(data, size);
+    if (n > 0) {
+        scheduleBytesWritten(n);
+    }
+    if (n < size) {
+        outbox_.append(data + n, size - n);
+        parkWriter();
+    }
+    return size;
+}
+
+qint64 ShmTransport::bytesToWrite() const {
+    return outbox_.size();
+}
+
+void ShmTransport::disconnectFromHost() {
+    if (handshakeFd_ >= 0) {
+        cancelHandshake();
+        return;
+    }
+    if (connected_ && !outbox_.isEmpty()) {
+        closeWhenFlushed_ = true;  // flushOutbox()写完后关闭
+        flushOutbox();
+        return;
+    }
+    if (channel_) {
+        channel_->disconnectFromServer();  // 触发onChannelClosed
+    }
+}
+
+void ShmTransport::abort() {
+    cancelHandshake();
+    outbox_.clear();
+    if (channel_) {
+        channel_->abort();
+    }
+    onChannelClosed();
+}
+
+bool ShmTransport::waitForDisconnected(int msecs) {
+    if (channel_ && channel_->state() != QLocalSocket::UnconnectedState) {
+        return channel_->waitForDisconnected(msecs);
+    }
+    return true;
+}
+
+QString ShmTransport::peerAddress() const {
+    return peerAddress_;
+}
+
+quint16 ShmTransport::peerPort() const {
+    return 0;
+}
+
+QString ShmTransport::errorString() const {
+    return error_;
+}
+
+qint64 ShmTransport::pushRing(const char *data, qint64 size) {
+    const quint64 tail = tx_->tail.load(std::memory_order_relaxed);
+    const quint64 head = tx_->head.load(std::memory_order_acquire);
+    const qint64 space = static_cast<qint64>(ringMask_ + 1 - (tail - head));
+    const qint64 n = qMin(size, space);
+    if (n <= 0) {
+        return 0;
+    }
+    const std::size_t offset = static_cast<std::size_t>(tail & ringMask_);
+    const std::size_t first = qMin<std::size_t>(static_cast<std::size_t>(n), ringMask_ + 1 - offset);
+    std::memcpy(txData_ + offset, data, first);
+    std::memcpy(txData_, data + first, static_cast<std::size_t>(n) - first);
+    tx_->tail.store(tail + static_cast<quint64>(n), std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (tx_->consumerWaiting.exchange(0, std::memory_order_relaxed) != 0) {
+        signalPeer();  // 对端已读空在等待，唤醒一次；对端忙时不产生系统调用
+    }
+    return n;
+}
+
+void ShmTransport::flushOutbox() {
+    if (outbox_.isEmpty() || !tx_) {
+        return;
+    }
+    const qint64 n = pushRing(outbox_.constData(), outbox_.size());
+    if (n > 0) {
+        outbox_.remove(0, n);
+        scheduleBytesWritten(n);
+    }
+    if (!outbox_.isEmpty()) {
+        parkWriter();
+    } else if (closeWhenFlushed_ && channel_) {
+        channel_->disconnectFromServer();  // 触发onChannelClosed
+    }
+}
+
+void ShmTransport::parkReader() {
+    rx_->consumerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // 置位前生产者可能刚写入且看到的是未等待，自己补发一次readyRead
+    if (rx_->tail.load(std::memory_order_acquire) != rx_->head.load(std::memory_order_relaxed)) {
+        scheduleReadyRead();
+    }
+}
+
+void ShmTransport::parkWriter() {
+    tx_->producerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const quint64 used = tx_->tail.load(std::memory_order_relaxed) - tx_->head.load(std::memory_order_acquire);
+    if (used <= ringMask_) {
+        // 置位前消费者已经腾出空间，不会再唤醒本端
+        QMetaObject::invokeMethod(this, [this]() { flushOutbox(); }, Qt::QueuedConnection);
+    }
+}
+
+void ShmTransport::signalPeer() {
+#ifdef Q_OS_LINUX
+    const quint64 one = 1;
+    if (peerWakeFd_ >= 0) {
+        [[maybe_unused]] const ssize_t rc = ::write(peerWakeFd_, &one, sizeof(one));
+    }
+#endif
+}
+
+void ShmTransport::scheduleReadyRead() {
+    if (readyScheduled_) {
+        return;
+    }
+    readyScheduled_ = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        readyScheduled_ = false;
+        if (rx_ && rx_->tail.load(std::memory_order_acquire) != rx_->head.load(std::memory_order_relaxed)) {
+            emit readyRead();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void ShmTransport::scheduleBytesWritten(qint64 bytes) {
+    const bool scheduled = unreportedWritten_ > 0;
+    unreportedWritten_ += bytes;
+    if (scheduled) {
+        return;
+    }
+    // 与QTcpSocket一致，bytesWritten在事件循环中异步发出，同一轮的多次写入合并为一次
+    QMetaObject::invokeMethod(this, [this]() {
+        const qint64 written = std::exchange(unreportedWritten_, 0);
+        if (written > 0) {
+            emit bytesWritten(written);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void ShmTransport::onWake() {
+#ifdef Q_OS_LINUX
+    quint64 count = 0;
+    [[maybe_unused]] const ssize_t rc = ::read(wakeFd_, &count, sizeof(count));
+#endif
+    flushOutbox();
+    if (rx_ && rx_->tail.load(std::memory_order_acquire) != rx_->head.load(std::memory_order_relaxed)) {
+        emit readyRead();
+    }
+}
+
+void ShmTransport::onChannelClosed() {
+    if (!connected_) {
+        return;
+    }
+    connected_ = false;
+    closeWhenFlushed_ = false;
+    if (wakeNotifier_) {
+        wakeNotifier_->setEnabled(false);
+    }
+    emit disconnected();
+}
+
+void ShmTransport::fail(const QString &message) {
+    error_ = message;
+    QMetaObject::invokeMethod(this, [this, message]() { emit errorOccurred(message); }, Qt::QueuedConnection);
+}
+
+}  // namespace cs::common
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "transport.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+class QLocalSocket;
+class QSocketNotifier;
+class QTimer;
+
+namespace cs::common {
+
+struct ShmRingHeader;
+
+// 同机共享内存传输：memfd映射出两个单生产者单消费者字节环(每个方向一个)，
+// 对端只在本端空闲等待时才经eventfd唤醒，连续收发不产生系统调用。
+// 共享内存与eventfd通过本地套接字(SCM_RIGHTS)协商，该套接字保持连接用于感知对端退出。
+// 仅Linux可用；环中传输的仍是ProtocolParser解析的完整帧字节流。
+class ShmTransport : public Transport {
+    Q_OBJECT
+
+public:
+    static constexpr quint32 kDefaultRingBytes = 1u << 20;
+    static constexpr int kHandshakeTimeoutMs = 3000;
+
+    explicit ShmTransport(QObject *parent = nullptr);
+    ~ShmTransport() override;
+
+    static bool supported();
+    // 服务器侧：在协商端点接受的连接上创建共享内存区，把描述符发给客户端。
+    // 只做一次非阻塞发送(新连接的发送缓冲必然放得下)，不在调用线程上等待。
+    // 成功时接管channel并返回新传输，失败返回nullptr且不改动channel
+    static ShmTransport *accept(QLocalSocket *channel, quint32 ringBytes, QString *error);
+
+    State state() const override;
+    // 客户端侧：host为服务器的协商端点路径，port忽略。握手在事件循环中完成：
+    // 成功发出connected()，失败或超过kHandshakeTimeoutMs发出errorOccurred()
+    void connectToHost(const QString &host, quint16 port) override;
+    qint64 read(char *data, qint64 maxSize) override;
+    qint64 write(const char *data, qint64 size) override;
+    // 只统计因环满暂存在本端的字节，已进入环的视为已发出
+    qint64 bytesToWrite() const override;
+    bool isLocal() const override { return true; }
+    // 先把环满时暂存的数据写完，再关闭协商通道
+    void disconnectFromHost() override;
+    void abort() override;
+    bool waitForDisconnected(int msecs) override;
+    QString peerAddress() const override;
+    quint16 peerPort() const override;
+    QString errorString() const override;
+
+private:
+    bool attach(QLocalSocket *channel, int memfd, quint32 ringBytes, int wakeFd, int peerWakeFd, bool serverSide,
+                QString *error);
+    void release();
+    void onHandshakeReadable();
+    void onHandshakeTimeout();
+    // 停止等待握手并交出协商套接字，调用方负责关闭或转交
+    int takeHandshakeFd();
+    void cancelHandshake();
+    qint64 pushRing(const char *data, qint64 size);
+    void flushOutbox();
+    void parkReader();
+    void parkWriter();
+    void signalPeer();
+    void scheduleReadyRead();
+    void scheduleBytesWritten(qint64 bytes);
+    void onWake();
+    void onChannelClosed();
+    void fail(const QString &message);
+
+    QLocalSocket *channel_ = nullptr;
+    QSocketNotifier *wakeNotifier_ = nullptr;
+    QSocketNotifier *handshakeNotifier_ = nullptr;
+    QTimer *handshakeTimer_ = nullptr;
+    int handshakeFd_ = -1;  // 客户端等待握手消息的套接字，握手完成后交给channel_
+    QString handshakeHost_;
+    void *mapping_ = nullptr;
+    std::size_t mappingBytes_ = 0;
+    ShmRingHeader *rx_ = nullptr;
+    ShmRingHeader *tx_ = nullptr;
+    char *rxData_ = nullptr;
+    char *txData_ = nullptr;
+    quint64 ringMask_ = 0;
+    int wakeFd_ = -1;      // 本端等待的eventfd
+    int peerWakeFd_ = -1;  // 唤醒对端的eventfd
+    QByteArray outbox_;    // 环满时暂存的待写数据，按顺序在环有空间后写入
+    qint64 unreportedWritten_ = 0;
+    bool readyScheduled_ = false;
+    bool connected_ = false;
+    bool closeWhenFlushed_ = false;  // 已请求断开，outbox_写完后关闭协商通道
+    QString peerAddress_;
+    QString error_;
+};
+
+}  // namespace cs::common
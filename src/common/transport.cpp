@@ -0,0 +1,227 @@
+#include "transport.hpp"
+
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpSocket>
+
+#include "shm_transport.hpp"
+
+namespace cs::common {
+
+void Transport::connectToHost(const QString &host, quint16 port) {
+    emit errorOccurred(QStringLiteral("该传输不支持连接 %1:%2").arg(host).arg(port));
+}
+
+QByteArray Transport::readAll() {
+    QByteArray out;
+    char chunk[16 * 1024];
+    qint64 n = 0;
+    while ((n = read(chunk, sizeof(chunk))) > 0) {
+        out.append(chunk, n);
+    }
+    return out;
+}
+
+qint64 Transport::write(const QByteArray &data) {
+    return write(data.constData(), data.size());
+}
+
+// socket作为子对象，随传输对象一起迁移线程和销毁
+TcpTransport::TcpTransport(QTcpSocket *socket, QObject *parent)
+    : Transport(parent),
+      socket_(socket ? socket : new QTcpSocket) {
+    socket_->setParent(this);
+    connect(socket_, &QTcpSocket::connected, this, &Transport::connected);
+    connect(socket_, &QTcpSocket::readyRead, this, &Transport::readyRead);
+    connect(socket_, &QTcpSocket::bytesWritten, this, &Transport::bytesWritten);
+    connect(socket_, &QTcpSocket::disconnected, this, &Transport::disconnected);
+    connect(socket_, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        emit errorOccurred(socket_->errorString());
+    });
+}
+
+Transport::State TcpTransport::state() const {
+    switch (socket_->state()) {
+    case QAbstractSocket::ConnectedState:
+        return State::Connected;
+    case QAbstractSocket::HostLookupState:
+    case QAbstractSocket::ConnectingState:
+        return State::Connecting;
+    case QAbstractSocket::ClosingState:
+        return State::Closing;
+    default:
+        return State::Unconnected;
+    }
+}
+
+void TcpTransport::connectToHost(const QString &host, quint16 port) {
+    socket_->connectToHost(host, port);
+}
+
+qint64 TcpTransport::read(char *data, qint64 maxSize) {
+    return socket_->read(data, maxSize);
+}
+
+QByteArray TcpTransport::readAll() {
+    return socket_->readAll();
+}
+
+qint64 TcpTransport::write(const char *data, qint64 size) {
+    return socket_->write(data, size);
+}
+
+qint64 TcpTransport::write(const QByteArray &data) {
+    return socket_->write(data);  // 共享帧数据，Qt写缓冲区直接引用而不复制
+}
+
+qint64 TcpTransport::bytesToWrite() const {
+    return socket_->bytesToWrite();
+}
+
+qint64 TcpTransport::bytesAvailable() const {
+    return socket_->bytesAvailable();
+}
+
+void TcpTransport::setReadBufferSize(qint64 size) {
+    socket_->setReadBufferSize(size);
+}
+
+void TcpTransport::disconnectFromHost() {
+    socket_->disconnectFromHost();
+}
+
+void TcpTransport::abort() {
+    socket_->abort();
+}
+
+bool TcpTransport::waitForDisconnected(int msecs) {
+    return socket_->waitForDisconnected(msecs);
+}
+
+QString TcpTransport::peerAddress() const {
+    return socket_->peerAddress().toString();
+}
+
+quint16 TcpTransport::peerPort() const {
+    return socket_->peerPort();
+}
+
+QString TcpTransport::errorString() const {
+    return socket_->errorString();
+}
+
+LocalTransport::LocalTransport(QLocalSocket *socket, QObject *parent)
+    : Transport(parent),
+      socket_(socket ? socket : new QLocalSocket) {
+    socket_->setParent(this);
+    connect(socket_, &QLocalSocket::connected, this, &Transport::connected);
+    connect(socket_, &QLocalSocket::readyRead, this, &Transport::readyRead);
+    connect(socket_, &QLocalSocket::bytesWritten, this, &Transport::bytesWritten);
+    connect(socket_, &QLocalSocket::disconnected, this, &Transport::disconnected);
+    connect(socket_, &QLocalSocket::errorOccurred, this, [this](QLocalSocket::LocalSocketError) {
+        emit errorOccurred(socket_->errorString());
+    });
+}
+
+Transport::State LocalTransport::state() const {
+    switch (socket_->state()) {
+    case QLocalSocket::ConnectedState:
+        return State::Connected;
+    case QLocalSocket::ConnectingState:
+        return State::Connecting;
+    case QLocalSocket::ClosingState:
+        return State::Closing;
+    default:
+        return State::Unconnected;
+    }
+}
+
+void LocalTransport::connectToHost(const QString &host, quint16) {
+    socket_->connectToServer(host);
+}
+
+qint64 LocalTransport::read(char *data, qint64 maxSize) {
+    return socket_->read(data, maxSize);
+}
+
+QByteArray LocalTransport::readAll() {
+    return socket_->readAll();
+}
+
+qint64 LocalTransport::write(const char *data, qint64 size) {
+    return socket_->write(data, size);
+}
+
+qint64 LocalTransport::write(const QByteArray &data) {
+    return socket_->write(data);
+}
+
+qint64 LocalTransport::bytesToWrite() const {
+    return socket_->bytesToWrite();
+}
+
+qint64 LocalTransport::bytesAvailable() const {
+    return socket_->bytesAvailable();
+}
+
+void LocalTransport::setReadBufferSize(qint64 size) {
+    socket_->setReadBufferSize(size);
+}
+
+void LocalTransport::disconnectFromHost() {
+    socket_->disconnectFromServer();
+}
+
+void LocalTransport::abort() {
+    socket_->abort();
+}
+
+bool LocalTransport::waitForDisconnected(int msecs) {
+    return socket_->waitForDisconnected(msecs);
+}
+
+QString LocalTransport::peerAddress() const {
+    // 服务器侧接受的连接没有服务器名
+    const QString name = socket_->fullServerName();
+    return name.isEmpty() ? QStringLiteral("unix") : QStringLiteral("unix:%1").arg(name);
+}
+
+quint16 LocalTransport::peerPort() const {
+    return 0;
+}
+
+QString LocalTransport::errorString() const {
+    return socket_->errorString();
+}
+
+TransportKind transport_kind(const QString &host, QString *endpoint) {
+    const auto strip = [&host, endpoint](int prefix) {
+        if (endpoint) {
+            *endpoint = host.mid(prefix);
+        }
+    };
+    if (host.startsWith(QLatin1String("unix:"))) {
+        strip(5);
+        return TransportKind::Local;
+    }
+    if (host.startsWith(QLatin1String("shm:"))) {
+        strip(4);
+        return TransportKind::SharedMemory;
+    }
+    strip(0);
+    return TransportKind::Tcp;
+}
+
+Transport *create_transport(TransportKind kind) {
+    switch (kind) {
+    case TransportKind::Local:
+        return new LocalTransport;
+    case TransportKind::SharedMemory:
+        return new ShmTransport;
+    case TransportKind::Tcp:
+        break;
+    }
+    return new TcpTransport;
+}
+
+}  // namespace cs::common
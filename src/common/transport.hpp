@@ -0,0 +1,132 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+class QLocalSocket;
+class QTcpSocket;
+
+namespace cs::common {
+
+// 会话与客户端所依赖的字节流传输接口。语义与QTcpSocket一致：数据到达发readyRead，
+// 写入立即返回并在写出后发bytesWritten，对端关闭发disconnected。
+// 实现必须与使用者在同一线程，迁移线程时随使用者一起moveToThread()。
+class Transport : public QObject {
+    Q_OBJECT
+
+public:
+    enum class State {
+        Unconnected,
+        Connecting,
+        Connected,
+        Closing,
+    };
+
+    using QObject::QObject;
+
+    virtual State state() const = 0;
+    bool isConnected() const { return state() == State::Connected; }
+
+    // 客户端发起连接，完成后发connected；不支持主动连接的实现发errorOccurred
+    virtual void connectToHost(const QString &host, quint16 port);
+    virtual qint64 read(char *data, qint64 maxSize) = 0;
+    virtual QByteArray readAll();
+    virtual qint64 write(const char *data, qint64 size) = 0;
+    // 默认转为指针写入；能利用隐式共享避免拷贝的实现可以重写
+    virtual qint64 write(const QByteArray &data);
+    virtual qint64 bytesToWrite() const = 0;
+    // 已收到、尚未被read()取走的字节数，用于内存统计；无独立接收缓冲的实现返回0
+    virtual qint64 bytesAvailable() const { return 0; }
+    // 限制接收缓冲大小(字节，0为不限)，缓冲满后停止从内核读取，由TCP流控反压对端；不支持的实现忽略
+    virtual void setReadBufferSize(qint64 size) { Q_UNUSED(size); }
+    // 对端是否必然在本机(Unix域套接字、共享内存、进程内)；只有本机链路才允许不带校验的帧
+    virtual bool isLocal() const { return false; }
+    // 写完缓冲后关闭
+    virtual void disconnectFromHost() = 0;
+    // 丢弃缓冲立即关闭
+    virtual void abort() = 0;
+    virtual bool waitForDisconnected(int msecs) = 0;
+
+    virtual QString peerAddress() const = 0;
+    virtual quint16 peerPort() const = 0;
+    virtual QString errorString() const = 0;
+
+signals:
+    void connected();
+    void readyRead();
+    void bytesWritten(qint64 bytes);
+    void disconnected();
+    void errorOccurred(const QString &message);
+};
+
+// 基于QTcpSocket的实现，接管socket的所有权
+class TcpTransport : public Transport {
+    Q_OBJECT
+
+public:
+    explicit TcpTransport(QTcpSocket *socket = nullptr, QObject *parent = nullptr);
+
+    QTcpSocket *socket() const { return socket_; }
+
+    State state() const override;
+    void connectToHost(const QString &host, quint16 port) override;
+    qint64 read(char *data, qint64 maxSize) override;
+    QByteArray readAll() override;
+    qint64 write(const char *data, qint64 size) override;
+    qint64 write(const QByteArray &data) override;
+    qint64 bytesToWrite() const override;
+    qint64 bytesAvailable() const override;
+    void setReadBufferSize(qint64 size) override;
+    void disconnectFromHost() override;
+    void abort() override;
+    bool waitForDisconnected(int msecs) override;
+    QString peerAddress() const override;
+    quint16 peerPort() const override;
+    QString errorString() const override;
+
+private:
+    QTcpSocket *socket_;
+};
+
+// 基于QLocalSocket的实现(Unix域套接字/Windows命名管道)，connectToHost()的host为服务器路径，port忽略
+class LocalTransport : public Transport {
+    Q_OBJECT
+
+public:
+    explicit LocalTransport(QLocalSocket *socket = nullptr, QObject *parent = nullptr);
+
+    QLocalSocket *socket() const { return socket_; }
+
+    State state() const override;
+    void connectToHost(const QString &host, quint16 port) override;
+    qint64 read(char *data, qint64 maxSize) override;
+    QByteArray readAll() override;
+    qint64 write(const char *data, qint64 size) override;
+    qint64 write(const QByteArray &data) override;
+    qint64 bytesToWrite() const override;
+    qint64 bytesAvailable() const override;
+    void setReadBufferSize(qint64 size) override;
+    bool isLocal() const override { return true; }
+    void disconnectFromHost() override;
+    void abort() override;
+    bool waitForDisconnected(int msecs) override;
+    QString peerAddress() const override;
+    quint16 peerPort() const override;
+    QString errorString() const override;
+
+private:
+    QLocalSocket *socket_;
+};
+
+// 客户端按地址前缀选择传输："unix:<路径>"为Unix域套接字，"shm:<路径>"为共享内存环，其余按TCP主机名处理
+enum class TransportKind {
+    Tcp,
+    Local,
+    SharedMemory,
+};
+
+TransportKind transport_kind(const QString &host, QString *endpoint);
+Transport *create_transport(TransportKind kind);
+
+}  // namespace cs::common
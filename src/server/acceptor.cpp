@@ -0,0 +1,151 @@
+#include "acceptor.hpp"
+
+#include <QtCore/QUuid>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpSocket>
+
+#ifdef Q_OS_UNIX
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "admission_control.hpp"
+
+Acceptor::Acceptor(int index, std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent)
+    : QObject(parent),
+      index_(index),
+      runtimeConfig_(std::move(runtime)) {}
+
+Acceptor::~Acceptor() = default;
+
+bool Acceptor::reusePortSupported() {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+qintptr Acceptor::openReusePortSocket(quint16 port, quint16 *boundPort, QString *error) {
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    const auto fail = [error](int fd, const char *step) -> qintptr {
+        if (error) {
+            *error = QStringLiteral("%1: %2").arg(QLatin1String(step), QString::fromLocal8Bit(std::strerror(errno)));
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return -1;
+    };
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return fail(fd, "socket");
+    }
+    const int enable = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0) {
+        return fail(fd, "SO_REUSEADDR");
+    }
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+        return fail(fd, "SO_REUSEPORT");
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        return fail(fd, "bind");
+    }
+    if (::listen(fd, SOMAXCONN) != 0) {
+        return fail(fd, "listen");
+    }
+
+    if (boundPort) {
+        socklen_t len = sizeof(addr);
+        if (::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0) {
+            *boundPort = ntohs(addr.sin_port);
+        }
+    }
+    return fd;
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(boundPort);
+    if (error) {
+        *error = QStringLiteral("当前平台不支持SO_REUSEPORT");
+    }
+    return -1;
+#endif
+}
+
+void Acceptor::closeSocket(qintptr descriptor) {
+#ifdef Q_OS_UNIX
+    if (descriptor >= 0) {
+        ::close(static_cast<int>(descriptor));
+    }
+#else
+    Q_UNUSED(descriptor);
+#endif
+}
+
+void Acceptor::adopt(qintptr descriptor) {
+    // 必须在Acceptor所在线程创建QTcpServer，保证其套接字通知器归属本线程
+    if (!server_) {
+        server_ = new QTcpServer(this);
+        connect(server_, &QTcpServer::newConnection, this, &Acceptor::handleNewConnection);
+    }
+    if (!server_->setSocketDescriptor(descriptor)) {
+        emit logMessage(QStringLiteral("接收线程 #%1 接管监听套接字失败：%2").arg(index_).arg(server_->errorString()));
+    }
+}
+
+void Acceptor::shutdown() {
+    if (server_) {
+        server_->close();
+    }
+    // stop()会触发finished→deleteLater，先拷贝一份避免迭代中修改
+    const auto workers = workers_;
+    for (auto *worker : workers) {
+        worker->stop();
+    }
+    shuttingDown_ = true;
+    if (workers_.isEmpty()) {
+        emit drained();
+    }
+}
+
+void Acceptor::handleNewConnection() {
+    while (server_->hasPendingConnections()) {
+        auto *socket = server_->nextPendingConnection();
+        if (!socket) {
+            continue;
+        }
+        const auto admission = runtimeConfig_->admission;
+        if (admission && !admission->tryAdmit()) {
+            admission->reject(new cs::common::TcpTransport(socket, this));
+            continue;
+        }
+        const QString address = socket->peerAddress().toString();
+        const quint16 peerPort = socket->peerPort();
+        const QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        auto *worker = new SessionWorker(socket, id, runtimeConfig_);
+        if (admission) {
+            connect(worker, &QObject::destroyed, [admission]() { admission->release(); });
+        }
+        // 生命周期在发布前接好：sessionAccepted尚在界面线程队列中时shutdown()就可能停止该会话，
+        // 此时只有这里的连接能让它销毁、归还准入名额并从workers_移除
+        connect(worker, &SessionWorker::finished, worker, &QObject::deleteLater);
+        workers_.insert(worker);
+        connect(worker, &QObject::destroyed, this, [this, worker]() {
+            workers_.remove(worker);
+            if (shuttingDown_ && workers_.isEmpty()) {
+                emit drained();
+            }
+        });
+        emit sessionAccepted(QPointer<SessionWorker>(worker), id, address, peerPort);
+    }
+}
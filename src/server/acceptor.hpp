@@ -0,0 +1,49 @@
+#pragma once
+
+#include "server_runtime.hpp"
+#include "session_worker.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtNetwork/QTcpServer>
+
+#include <memory>
+
+// 分片接收器：每个Acceptor运行在独立线程，持有一个SO_REUSEPORT监听套接字，
+// 接入的会话留在本线程的事件循环中处理。
+class Acceptor : public QObject {
+    Q_OBJECT
+
+public:
+    Acceptor(int index, std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent = nullptr);
+    ~Acceptor() override;
+
+    static bool reusePortSupported();
+    // 在调用线程创建、绑定并监听一个SO_REUSEPORT套接字，失败返回-1
+    static qintptr openReusePortSocket(quint16 port, quint16 *boundPort, QString *error);
+    static void closeSocket(qintptr descriptor);
+
+    int index() const { return index_; }
+
+public slots:
+    void adopt(qintptr descriptor);
+    // 关闭监听并停止本线程上的全部会话；会话全部销毁后发出drained()
+    void shutdown();
+
+signals:
+    void drained();
+    // 排队送达界面线程前会话可能已被shutdown()停止并销毁，接收方须检查worker是否仍有效
+    void sessionAccepted(QPointer<SessionWorker> worker, QString id, QString address, quint16 port);
+    void logMessage(QString text);
+
+private slots:
+    void handleNewConnection();
+
+private:
+    int index_;
+    QTcpServer *server_ = nullptr;
+    std::shared_ptr<ServerRuntimeConfig> runtimeConfig_;
+    QSet<SessionWorker *> workers_;
+    bool shuttingDown_ = false;
+};
@@ -0,0 +1,74 @@
+#include "admission_control.hpp"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QRandomGenerator>
+
+#include "common/protocol.hpp"
+#include "common/transport.hpp"
+
+using namespace cs::protocol;
+
+void AdmissionControl::setLimit(int maxSessions) {
+    limit_.store(qMax(0, maxSessions), std::memory_order_relaxed);
+}
+
+int AdmissionControl::limit() const {
+    return limit_.load(std::memory_order_relaxed);
+}
+
+void AdmissionControl::setAdmitRate(int perSec) {
+    admitPerSec_.store(qMax(1, perSec), std::memory_order_relaxed);
+}
+
+int AdmissionControl::admitRate() const {
+    return admitPerSec_.load(std::memory_order_relaxed);
+}
+
+bool AdmissionControl::tryAdmit() {
+    const int limit = limit_.load(std::memory_order_relaxed);
+    int current = active_.load(std::memory_order_relaxed);
+    do {
+        if (limit > 0 && current >= limit) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!active_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+    return true;
+}
+
+void AdmissionControl::release() {
+    active_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int AdmissionControl::active() const {
+    return active_.load(std::memory_order_relaxed);
+}
+
+quint64 AdmissionControl::rejected() const {
+    return rejected_.load(std::memory_order_relaxed);
+}
+
+quint32 AdmissionControl::nextRetryAfterMs() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 gapMs = qMax<qint64>(1, 1000 / admitPerSec_.load(std::memory_order_relaxed));
+    qint64 slot = nextSlotMs_.load(std::memory_order_relaxed);
+    qint64 start = 0;
+    do {
+        start = qMax(slot, now);
+        if (start + gapMs - now > kMaxRetryAfterMs) {
+            // 时间片已排满整个窗口，其余客户端在窗口内均匀随机，不再推迟
+            return QRandomGenerator::global()->bounded(static_cast<quint32>(kMaxRetryAfterMs));
+        }
+    } while (!nextSlotMs_.compare_exchange_weak(slot, start + gapMs, std::memory_order_relaxed));
+    const qint64 jitter = QRandomGenerator::global()->bounded(static_cast<quint32>(gapMs));
+    return static_cast<quint32>(start - now + jitter);
+}
+
+void AdmissionControl::reject(cs::common::Transport *transport) {
+    QObject::connect(transport, &cs::common::Transport::disconnected, transport, &QObject::deleteLater);
+    transport->write(build_frame(kDefaultVersion, build_command_payload(CmdId::RetryAfter, nextRetryAfterMs())));
+    transport->disconnectFromHost();
+    if (transport->state() == cs::common::Transport::State::Unconnected) {
+        transport->deleteLater();
+    }
+}
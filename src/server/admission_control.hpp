@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+
+namespace cs::common {
+class Transport;
+}  // namespace cs::common
+
+// 会话准入：限制同时在线的会话数，并为被拒绝或被停机断开的客户端分配错开的重连时间。
+// 重连时间按admitPerSec排成等间隔的时间片，每个客户端拿到下一个空闲时间片(片内再随机偏移)，
+// 这样大量客户端同时掉线时，重连会被摊平到一段时间内而不是同时涌回。各方法可从任意线程调用。
+class AdmissionControl {
+public:
+    static constexpr int kDefaultAdmitPerSec = 500;
+    static constexpr int kMaxRetryAfterMs = 30000;
+
+    // maxSessions<=0表示不限制
+    void setLimit(int maxSessions);
+    int limit() const;
+    void setAdmitRate(int perSec);
+    int admitRate() const;
+
+    // 未达上限时占用一个名额并返回true；每个成功的tryAdmit()对应一次release()
+    bool tryAdmit();
+    void release();
+    int active() const;
+    quint64 rejected() const;
+
+    // 分配下一个重连时间片，返回距现在的毫秒数(不超过kMaxRetryAfterMs)
+    quint32 nextRetryAfterMs();
+    // 拒绝未准入的连接：发送RetryAfter命令后关闭，传输在断开后自行释放
+    void reject(cs::common::Transport *transport);
+
+private:
+    std::atomic<int> limit_{0};
+    std::atomic<int> admitPerSec_{kDefaultAdmitPerSec};
+    std::atomic<int> active_{0};
+    std::atomic<quint64> rejected_{0};
+    std::atomic<qint64> nextSlotMs_{0};
+};
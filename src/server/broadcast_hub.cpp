@@ -0,0 +1,144 @@
+#include "broadcast_hub.hpp"
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QReadLocker>
+#include <QtCore/QWriteLocker>
+
+#include <algorithm>
+
+#include "common/protocol.hpp"
+
+using namespace cs::protocol;
+
+bool BroadcastHub::Inbox::pop(QByteArray *frame) {
+    QMutexLocker locker(&mutex_);
+    if (frames_.empty()) {
+        armed_ = false;
+        return false;
+    }
+    *frame = std::move(frames_.front());
+    frames_.pop_front();
+    return true;
+}
+
+bool BroadcastHub::Inbox::push(const QByteArray &frame, std::size_t capacity, bool *dropped) {
+    QMutexLocker locker(&mutex_);
+    if (!receiver_) {
+        return false;
+    }
+    *dropped = frames_.size() >= capacity;
+    if (*dropped) {
+        frames_.pop_front();  // 慢会话只保留最新的消息，不拖慢发布方
+    }
+    frames_.push_back(frame);
+    if (!armed_) {
+        armed_ = true;
+        // 在锁内投递：close()持有同一把锁，保证receiver此时仍然存活
+        QMetaObject::invokeMethod(receiver_, notify_, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void BroadcastHub::Inbox::close() {
+    QMutexLocker locker(&mutex_);
+    receiver_ = nullptr;
+    notify_ = nullptr;
+    frames_.clear();
+}
+
+BroadcastHub::BroadcastHub(std::size_t inboxFrames) : inboxFrames_(qMax<std::size_t>(1, inboxFrames)) {}
+
+std::shared_ptr<BroadcastHub::Inbox> BroadcastHub::attach(QObject *receiver, std::function<void()> notify) {
+    auto inbox = std::make_shared<Inbox>();
+    inbox->receiver_ = receiver;
+    inbox->notify_ = std::move(notify);
+    QWriteLocker locker(&lock_);
+    all_.insert(inbox.get());
+    return inbox;
+}
+
+void BroadcastHub::detach(const std::shared_ptr<Inbox> &inbox) {
+    if (!inbox) {
+        return;
+    }
+    inbox->close();
+    QWriteLocker locker(&lock_);
+    for (const QString &topic : inbox->topics_) {
+        auto it = topics_.find(topic);
+        if (it != topics_.end()) {
+            it->erase(inbox.get());
+            if (it->empty()) {
+                topics_.erase(it);
+            }
+        }
+    }
+    inbox->topics_.clear();
+    all_.erase(inbox.get());
+}
+
+void BroadcastHub::subscribe(const std::shared_ptr<Inbox> &inbox, const QString &topic) {
+    if (!inbox || topic.isEmpty()) {
+        return;
+    }
+    QWriteLocker locker(&lock_);
+    if (all_.find(inbox.get()) == all_.end()) {
+        return;
+    }
+    if (topics_[topic].insert(inbox.get()).second) {
+        inbox->topics_.push_back(topic);
+    }
+}
+
+void BroadcastHub::unsubscribe(const std::shared_ptr<Inbox> &inbox, const QString &topic) {
+    if (!inbox) {
+        return;
+    }
+    QWriteLocker locker(&lock_);
+    auto it = topics_.find(topic);
+    if (it == topics_.end() || it->erase(inbox.get()) == 0) {
+        return;
+    }
+    if (it->empty()) {
+        topics_.erase(it);
+    }
+    auto &own = inbox->topics_;
+    own.erase(std::remove(own.begin(), own.end(), topic), own.end());
+}
+
+int BroadcastHub::publish(const QString &topic, const QByteArray &body) {
+    // 只编码一次，所有收件箱共享这一帧
+    const QByteArray frame = build_frame(kDefaultVersion, build_notify_payload(topic.toUtf8(), body));
+    published_.fetch_add(1, std::memory_order_relaxed);
+    QReadLocker locker(&lock_);
+    if (topic.isEmpty()) {
+        return fanOut(frame, all_);
+    }
+    const auto it = topics_.constFind(topic);
+    return it == topics_.constEnd() ? 0 : fanOut(frame, *it);
+}
+
+int BroadcastHub::fanOut(const QByteArray &frame, const std::unordered_set<Inbox *> &targets) {
+    int delivered = 0;
+    quint64 dropped = 0;
+    for (Inbox *inbox : targets) {
+        bool full = false;
+        if (inbox->push(frame, inboxFrames_, &full)) {
+            ++delivered;
+            dropped += full ? 1 : 0;
+        }
+    }
+    delivered_.fetch_add(static_cast<quint64>(delivered), std::memory_order_relaxed);
+    dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    return delivered;
+}
+
+BroadcastHub::Stats BroadcastHub::stats() const {
+    Stats stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    QReadLocker locker(&lock_);
+    stats.sessions = static_cast<int>(all_.size());
+    stats.topics = static_cast<int>(topics_.size());
+    return stats;
+}
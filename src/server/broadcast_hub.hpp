@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QString>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+// 广播与主题订阅。消息只编码一次成完整帧，QByteArray的隐式共享使各会话写队列持有同一块内存，
+// 不做逐会话拷贝也不重算CRC。每个会话一个有界收件箱，会话线程按socket积压情况取出写入。
+class BroadcastHub {
+public:
+    static constexpr std::size_t kDefaultInboxFrames = 256;
+
+    struct Stats {
+        quint64 published = 0;
+        quint64 delivered = 0;  // 进入会话收件箱的帧数
+        quint64 dropped = 0;    // 收件箱已满时丢弃的最旧帧数
+        int sessions = 0;
+        int topics = 0;
+    };
+
+    class Inbox;
+
+    explicit BroadcastHub(std::size_t inboxFrames = kDefaultInboxFrames);
+
+    // notify在有新帧可取时通过receiver的事件循环调用；receiver销毁前须调用detach()
+    std::shared_ptr<Inbox> attach(QObject *receiver, std::function<void()> notify);
+    void detach(const std::shared_ptr<Inbox> &inbox);
+    void subscribe(const std::shared_ptr<Inbox> &inbox, const QString &topic);
+    void unsubscribe(const std::shared_ptr<Inbox> &inbox, const QString &topic);
+
+    // topic为空时发送给所有会话，返回接收的会话数
+    int publish(const QString &topic, const QByteArray &body);
+    Stats stats() const;
+
+private:
+    int fanOut(const QByteArray &frame, const std::unordered_set<Inbox *> &targets);
+
+    std::size_t inboxFrames_;
+    mutable QReadWriteLock lock_;
+    std::unordered_set<Inbox *> all_;  // 会话持有收件箱，销毁前detach()
+    QHash<QString, std::unordered_set<Inbox *>> topics_;
+    std::atomic<quint64> published_{0};
+    std::atomic<quint64> delivered_{0};
+    std::atomic<quint64> dropped_{0};
+};
+
+class BroadcastHub::Inbox {
+public:
+    // 取出一帧；队列为空时解除通知标记，下一次push会重新通知
+    bool pop(QByteArray *frame);
+
+private:
+    friend class BroadcastHub;
+
+    bool push(const QByteArray &frame, std::size_t capacity, bool *dropped);
+    void close();
+
+    QMutex mutex_;
+    std::deque<QByteArray> frames_;
+    bool armed_ = false;  // 已发出通知或会话正因积压等待写出
+    QObject *receiver_ = nullptr;
+    std::function<void()> notify_;
+    std::vector<QString> topics_;
+};
@@ -0,0 +1,372 @@
+#include "cluster_membership.hpp"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QMessageAuthenticationCode>
+#include <QtNetwork/QNetworkDatagram>
+#include <QtNetwork/QUdpSocket>
+
+#include <algorithm>
+
+#include "cluster_ring.hpp"
+
+namespace {
+
+constexpr char kMagic[] = {'C', 'S', 'C', 'L'};
+constexpr uint8_t kVersion = 2;
+constexpr uint8_t kFlagLeaving = 0x01;
+constexpr int kHeaderBytes = 4 /*Magic*/ + 1 /*Version*/ + 1 /*Flags*/ + 1 /*Count*/;
+constexpr int kMacBytes = 32;  // HMAC-SHA256
+
+struct Entry {
+    QString node;
+    quint16 clusterPort = 0;
+    QHostAddress address;  // 发送方自己那一项为空
+};
+
+// "IP:端口"，IPv6写作"[addr]:port"。不接受主机名：解析会阻塞界面线程，且种子地址是信任的依据
+bool parse_peer(const QString &peer, QHostAddress *address, quint16 *port) {
+    const int colon = peer.lastIndexOf(QLatin1Char(':'));
+    bool ok = false;
+    const uint value = colon > 0 ? peer.mid(colon + 1).toUInt(&ok) : 0;
+    if (!ok || value == 0 || value > 65535) {
+        return false;
+    }
+    QString host = peer.left(colon);
+    if (host.startsWith(QLatin1Char('[')) && host.endsWith(QLatin1Char(']'))) {
+        host = host.mid(1, host.size() - 2);
+    }
+    if (!address->setAddress(host)) {
+        return false;
+    }
+    *port = quint16(value);
+    return true;
+}
+
+QByteArray sign(const QByteArray &data, const QByteArray &secret) {
+    return QMessageAuthenticationCode::hash(data, secret, QCryptographicHash::Sha256);
+}
+
+// 逐字节比较全部内容，耗时与第一个不同字节的位置无关
+bool constant_time_equal(const char *a, const char *b, int size) {
+    unsigned char diff = 0;
+    for (int i = 0; i < size; ++i) {
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+// 节点名中的主机是否就是address；主机为空(客户端沿用当前连接的主机)时不会把客户端引向别处，视为一致
+bool node_host_matches(const QString &node, const QHostAddress &address) {
+    QByteArray host;
+    quint16 port = 0;
+    if (!HashRing::splitNode(node.toStdString(), &host, &port)) {
+        return false;
+    }
+    if (host.isEmpty()) {
+        return true;
+    }
+    if (host.startsWith('[') && host.endsWith(']')) {
+        host = host.mid(1, host.size() - 2);
+    }
+    QHostAddress advertised;
+    return advertised.setAddress(QString::fromLatin1(host)) &&
+           advertised.isEqual(address, QHostAddress::TolerantConversion);
+}
+
+}  // namespace
+
+ClusterMembership::ClusterMembership(std::shared_ptr<ClusterRouter> router, QObject *parent)
+    : QObject(parent),
+      router_(std::move(router)),
+      heartbeatTimer_(this) {
+    heartbeatTimer_.setInterval(kHeartbeatMs);
+    connect(&heartbeatTimer_, &QTimer::timeout, this, &ClusterMembership::heartbeat);
+}
+
+ClusterMembership::~ClusterMembership() {
+    leave();
+}
+
+bool ClusterMembership::start(const ClusterSettings &settings, const QString &node, QString *error) {
+    leave();
+    if (settings.secret.isEmpty()) {
+        if (error) {
+            *error = QStringLiteral("未设置集群密钥");
+        }
+        return false;
+    }
+    seeds_.clear();
+    for (const QString &peer : settings.peers) {
+        Endpoint endpoint;
+        if (!parse_peer(peer.trimmed(), &endpoint.address, &endpoint.port)) {
+            if (error) {
+                *error = QStringLiteral("集群节点 %1 不是\"IP:端口\"").arg(peer);
+            }
+            return false;
+        }
+        seeds_.push_back(endpoint);
+    }
+    secret_ = settings.secret;
+    socket_ = new QUdpSocket(this);
+    if (!socket_->bind(settings.bindAddress, settings.port)) {
+        if (error) {
+            *error = socket_->errorString();
+        }
+        delete socket_;
+        socket_ = nullptr;
+        return false;
+    }
+    connect(socket_, &QUdpSocket::readyRead, this, &ClusterMembership::onReadable);
+    self_ = node;
+    members_.clear();
+    tombstones_.clear();
+    router_->setSelf(self_.toStdString());
+    rebuildRing(true);
+    heartbeatTimer_.start();
+    heartbeat();  // 立即宣告加入，不等第一个周期
+    return true;
+}
+
+void ClusterMembership::leave() {
+    if (!socket_) {
+        return;
+    }
+    heartbeatTimer_.stop();
+    // UDP可能丢包，离开通知连发两次；仍然丢失时其他节点按超时移除
+    const QByteArray farewell = encodeHeartbeat(true);
+    sendToAll(farewell);
+    sendToAll(farewell);
+    socket_->close();
+    socket_->deleteLater();
+    socket_ = nullptr;
+    rebuildRing(false);
+    members_.clear();
+}
+
+bool ClusterMembership::isRunning() const {
+    return socket_ != nullptr;
+}
+
+quint16 ClusterMembership::clusterPort() const {
+    return socket_ ? socket_->localPort() : 0;
+}
+
+std::vector<ClusterMembership::Member> ClusterMembership::members() const {
+    std::vector<Member> result;
+    if (!socket_) {
+        return result;
+    }
+    Member self;
+    self.node = self_;
+    self.address = socket_->localAddress();
+    self.clusterPort = socket_->localPort();
+    self.lastSeenMs = QDateTime::currentMSecsSinceEpoch();
+    self.self = true;
+    result.push_back(self);
+    for (const Member &member : members_) {
+        result.push_back(member);
+    }
+    std::sort(result.begin(), result.end(), [](const Member &a, const Member &b) { return a.node < b.node; });
+    return result;
+}
+
+void ClusterMembership::heartbeat() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList expired;
+    for (const Member &member : std::as_const(members_)) {
+        if (now - member.lastSeenMs > kNodeTimeoutMs) {
+            expired.append(member.node);
+        }
+    }
+    for (const QString &node : std::as_const(expired)) {
+        removeMember(node, now);
+        emit logMessage(QStringLiteral("集群节点 %1 心跳超时，已移出").arg(node));
+    }
+    for (auto it = tombstones_.begin(); it != tombstones_.end();) {
+        it = it.value() <= now ? tombstones_.erase(it) : std::next(it);
+    }
+    if (rejected_ > reportedRejected_) {
+        emit logMessage(QStringLiteral("丢弃 %1 个未通过签名或地址校验的集群数据报").arg(rejected_ - reportedRejected_));
+        reportedRejected_ = rejected_;
+    }
+    sendToAll(encodeHeartbeat(false));
+    if (!expired.isEmpty()) {
+        rebuildRing(true);
+    }
+}
+
+void ClusterMembership::onReadable() {
+    while (socket_ && socket_->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = socket_->receiveDatagram();
+        handleDatagram(datagram.data(), datagram.senderAddress(), quint16(datagram.senderPort()));
+    }
+}
+
+bool ClusterMembership::isSeed(const QHostAddress &address, quint16 port) const {
+    return std::any_of(seeds_.begin(), seeds_.end(), [&address, port](const Endpoint &seed) {
+        return seed.port == port && seed.address.isEqual(address, QHostAddress::TolerantConversion);
+    });
+}
+
+void ClusterMembership::handleDatagram(const QByteArray &signedData, const QHostAddress &sender, quint16 senderPort) {
+    if (signedData.size() < kHeaderBytes + kMacBytes) {
+        ++rejected_;
+        return;
+    }
+    const QByteArray data = signedData.left(signedData.size() - kMacBytes);
+    if (!constant_time_equal(sign(data, secret_).constData(), signedData.constData() + data.size(), kMacBytes)) {
+        ++rejected_;
+        return;
+    }
+    if (!data.startsWith(QByteArray::fromRawData(kMagic, sizeof(kMagic))) || uint8_t(data.at(4)) != kVersion) {
+        return;
+    }
+    const uint8_t flags = uint8_t(data.at(5));
+    const int count = uint8_t(data.at(6));
+    std::vector<Entry> entries;
+    int offset = kHeaderBytes;
+    // 格式不符的数据报整个丢弃，不采纳其中任何一项
+    for (int i = 0; i < count; ++i) {
+        if (offset + 1 > data.size()) {
+            return;
+        }
+        const int nodeLen = uint8_t(data.at(offset++));
+        if (offset + nodeLen + 3 > data.size()) {
+            return;
+        }
+        Entry entry;
+        entry.node = QString::fromUtf8(data.constData() + offset, nodeLen);
+        offset += nodeLen;
+        entry.clusterPort = quint16((uint8_t(data.at(offset)) << 8) | uint8_t(data.at(offset + 1)));
+        offset += 2;
+        const int addrLen = uint8_t(data.at(offset++));
+        if (offset + addrLen > data.size()) {
+            return;
+        }
+        if (addrLen > 0) {
+            entry.address.setAddress(QString::fromLatin1(data.constData() + offset, addrLen));
+        }
+        offset += addrLen;
+        entries.push_back(entry);
+    }
+    if (entries.empty() || entries.front().node.isEmpty() || entries.front().node == self_) {
+        return;
+    }
+    // 种子由本节点配置，可以声明主机名；其余节点的节点名只能指向它自己的地址
+    const bool trusted = isSeed(sender, senderPort);
+    if (!trusted && !node_host_matches(entries.front().node, sender)) {
+        ++rejected_;
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const Entry &origin = entries.front();
+    bool changed = false;
+    if (flags & kFlagLeaving) {
+        if (members_.contains(origin.node)) {
+            removeMember(origin.node, now);
+            emit logMessage(QStringLiteral("集群节点 %1 已离开").arg(origin.node));
+            rebuildRing(true);
+        }
+        return;
+    }
+    tombstones_.remove(origin.node);  // 直接收到心跳：节点已重启或恢复
+    auto it = members_.find(origin.node);
+    if (it == members_.end()) {
+        it = members_.insert(origin.node, Member{origin.node, sender, origin.clusterPort, now, false});
+        changed = true;
+        emit logMessage(QStringLiteral("集群节点 %1 加入").arg(origin.node));
+    }
+    it->address = sender;
+    it->clusterPort = origin.clusterPort;
+    it->lastSeenMs = now;
+
+    // 流言只用来发现新节点；已知节点的存活只以它自己的心跳为准
+    for (std::size_t i = 1; i < entries.size(); ++i) {
+        const Entry &entry = entries[i];
+        if (entry.node.isEmpty() || entry.node == self_ || entry.address.isNull() || members_.contains(entry.node) ||
+            tombstones_.contains(entry.node)) {
+            continue;
+        }
+        if (!trusted && !node_host_matches(entry.node, entry.address)) {
+            ++rejected_;
+            continue;
+        }
+        members_.insert(entry.node, Member{entry.node, entry.address, entry.clusterPort, now, false});
+        changed = true;
+        emit logMessage(QStringLiteral("经 %1 得知集群节点 %2").arg(origin.node, entry.node));
+    }
+    if (changed) {
+        rebuildRing(true);
+    }
+}
+
+void ClusterMembership::removeMember(const QString &node, qint64 nowMs) {
+    members_.remove(node);
+    tombstones_.insert(node, nowMs + kTombstoneMs);
+}
+
+void ClusterMembership::rebuildRing(bool includeSelf) {
+    std::vector<std::string> nodes;
+    nodes.reserve(std::size_t(members_.size()) + 1);
+    if (includeSelf) {
+        nodes.push_back(self_.toStdString());
+    }
+    for (const Member &member : std::as_const(members_)) {
+        nodes.push_back(member.node.toStdString());
+    }
+    const int count = int(nodes.size());
+    router_->update(std::make_shared<const HashRing>(std::move(nodes)));
+    if (includeSelf) {
+        emit ringChanged(count);
+    }
+}
+
+QByteArray ClusterMembership::encodeHeartbeat(bool leaving) const {
+    QByteArray datagram;
+    datagram.append(kMagic, sizeof(kMagic));
+    datagram.append(char(kVersion));
+    datagram.append(char(leaving ? kFlagLeaving : 0));
+    datagram.append(char(0));  // Count，写完各项后回填
+    int count = 0;
+    const auto append = [&datagram, &count](const QString &node, quint16 clusterPort, const QByteArray &address) {
+        const QByteArray name = node.toUtf8().left(255);
+        datagram.append(char(name.size()));
+        datagram.append(name);
+        datagram.append(char(clusterPort >> 8));
+        datagram.append(char(clusterPort & 0xFF));
+        datagram.append(char(address.size()));
+        datagram.append(address);
+        ++count;
+    };
+    append(self_, socket_ ? socket_->localPort() : 0, QByteArray());
+    if (!leaving) {
+        for (const Member &member : std::as_const(members_)) {
+            if (count >= kMaxEntries) {
+                break;
+            }
+            append(member.node, member.clusterPort, member.address.toString().toLatin1());
+        }
+    }
+    datagram[6] = char(count);
+    datagram.append(sign(datagram, secret_));
+    return datagram;
+}
+
+void ClusterMembership::sendToAll(const QByteArray &datagram) {
+    if (!socket_) {
+        return;
+    }
+    std::vector<Endpoint> targets = seeds_;
+    for (const Member &member : std::as_const(members_)) {
+        const bool known = std::any_of(targets.begin(), targets.end(), [&member](const Endpoint &endpoint) {
+            return endpoint.port == member.clusterPort && endpoint.address.isEqual(member.address);
+        });
+        if (!known) {
+            targets.push_back({member.address, member.clusterPort});
+        }
+    }
+    for (const Endpoint &target : targets) {
+        socket_->writeDatagram(datagram, target.address, target.port);
+    }
+}
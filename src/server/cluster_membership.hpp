@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+
+#include <memory>
+#include <vector>
+
+class ClusterRouter;
+class QUdpSocket;
+
+// 加入集群的参数，由命令行传入
+struct ClusterSettings {
+    quint16 port = 0;                          // 集群UDP端口
+    QHostAddress bindAddress = QHostAddress::Any;
+    QStringList peers;                         // 种子节点集群端口的"IP:端口"
+    QString advertiseHost;                     // 重定向给客户端的本节点主机，空表示沿用客户端当前连接的主机
+    QByteArray secret;                         // 各节点共享的密钥，用于数据报认证，不能为空
+};
+
+// 集群成员表：每个节点在自己的UDP集群端口上每kHeartbeatMs向种子节点与已知成员发送心跳，
+// 心跳附带本节点已知的存活成员(流言)，新节点只要认识任意一个种子就会被全体发现。
+// kNodeTimeoutMs内没有直接收到心跳的成员视为离开；正常停止的节点发出离开通知，其余节点立即移除它。
+// 成员集合变化时重建HashRing交给ClusterRouter，并发出ringChanged。对象在Listener所在线程使用。
+//
+// 心跳数据报: [Magic "CSCL"(4)][Version(1)][Flags(1)][Count(1)] +
+//             Count × ([NodeLen(1)][Node][ClusterPort(2)][AddrLen(1)][Addr]) + [HMAC-SHA256(32)]
+// 第一项为发送方自己(AddrLen=0，接收方使用数据报来源地址)；Flags的bit0表示发送方正在离开。
+// 节点名即客户端会被重定向到的地址，伪造一个数据报就能把客户端引到任意主机，因此：
+// 每个数据报以共享密钥签名，签名不符的整个丢弃；节点名中的主机必须是IP且与该节点的集群地址一致
+// (自己那一项比对数据报来源，流言项比对其中的Addr)，来自种子节点的数据报不受此限，可以声明主机名。
+class ClusterMembership : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kHeartbeatMs = 500;
+    static constexpr int kNodeTimeoutMs = 2000;
+    // 离开或超时的节点在这段时间内不会因其他节点的流言重新加入，直接收到它的心跳除外
+    static constexpr int kTombstoneMs = 2 * kNodeTimeoutMs;
+    static constexpr int kMaxEntries = 255;
+
+    struct Member {
+        QString node;            // 服务地址"主机:端口"，即环上的节点名
+        QHostAddress address;    // 集群端口所在的地址
+        quint16 clusterPort = 0;
+        qint64 lastSeenMs = 0;   // 最近一次直接收到心跳的时刻，只经流言得知时为加入时刻
+        bool self = false;
+    };
+
+    explicit ClusterMembership(std::shared_ptr<ClusterRouter> router, QObject *parent = nullptr);
+    ~ClusterMembership() override;
+
+    // node为本节点的服务地址；settings.peers可以只给其他节点中的一部分
+    bool start(const ClusterSettings &settings, const QString &node, QString *error);
+    // 通知其他节点并停止心跳；本地环改为只含其余成员，停机排空的会话据此被重定向
+    void leave();
+    bool isRunning() const;
+    quint16 clusterPort() const;
+    QString node() const { return self_; }
+    // 含本节点，按节点名排序
+    std::vector<Member> members() const;
+
+signals:
+    void ringChanged(int nodes);
+    void logMessage(QString text);
+
+private slots:
+    void onReadable();
+    void heartbeat();
+
+private:
+    struct Endpoint {
+        QHostAddress address;
+        quint16 port = 0;
+    };
+
+    QByteArray encodeHeartbeat(bool leaving) const;
+    void handleDatagram(const QByteArray &data, const QHostAddress &sender, quint16 senderPort);
+    bool isSeed(const QHostAddress &address, quint16 port) const;
+    void removeMember(const QString &node, qint64 nowMs);
+    void rebuildRing(bool includeSelf);
+    void sendToAll(const QByteArray &datagram);
+
+    std::shared_ptr<ClusterRouter> router_;
+    QUdpSocket *socket_ = nullptr;
+    QTimer heartbeatTimer_;
+    QString self_;
+    QByteArray secret_;
+    std::vector<Endpoint> seeds_;
+    quint64 rejected_ = 0;  // 签名或地址校验失败的数据报
+    quint64 reportedRejected_ = 0;
+    QHash<QString, Member> members_;     // 不含本节点
+    QHash<QString, qint64> tombstones_;  // 节点名 -> 可再次经流言加入的时刻
+};
@@ -0,0 +1,117 @@
+#include "cluster_ring.hpp"
+
+#include <QtCore/QMutexLocker>
+
+#include <algorithm>
+
+namespace {
+
+// splitmix64的终混函数：FNV-1a的低位分布较差，混合后再放到环上
+quint64 mix(quint64 x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+}  // namespace
+
+HashRing::HashRing(std::vector<std::string> nodes) : nodes_(std::move(nodes)) {
+    std::sort(nodes_.begin(), nodes_.end());
+    nodes_.erase(std::unique(nodes_.begin(), nodes_.end()), nodes_.end());
+    points_.reserve(nodes_.size() * kVirtualNodes);
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        const quint64 base = hash(nodes_[i]);
+        for (int v = 0; v < kVirtualNodes; ++v) {
+            points_.emplace_back(mix(base + 0x9e3779b97f4a7c15ULL * quint64(v + 1)), int(i));
+        }
+    }
+    std::sort(points_.begin(), points_.end());
+}
+
+int HashRing::ownerIndex(std::string_view key) const {
+    if (points_.empty()) {
+        return -1;
+    }
+    const quint64 h = hash(key);
+    auto it = std::lower_bound(points_.begin(), points_.end(), h,
+                               [](const std::pair<quint64, int> &point, quint64 value) { return point.first < value; });
+    if (it == points_.end()) {
+        it = points_.begin();  // 越过最大点后回到环首
+    }
+    return it->second;
+}
+
+const std::string *HashRing::owner(std::string_view key) const {
+    const int index = ownerIndex(key);
+    return index < 0 ? nullptr : &nodes_[std::size_t(index)];
+}
+
+quint64 HashRing::hash(std::string_view bytes) {
+    quint64 h = 0xcbf29ce484222325ULL;
+    for (const char c : bytes) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+bool HashRing::splitNode(std::string_view node, QByteArray *host, quint16 *port) {
+    const std::size_t colon = node.rfind(':');
+    if (colon == std::string_view::npos || colon + 1 == node.size()) {
+        return false;
+    }
+    quint32 value = 0;
+    for (const char c : node.substr(colon + 1)) {
+        if (c < '0' || c > '9' || value > 65535) {
+            return false;
+        }
+        value = value * 10 + quint32(c - '0');
+    }
+    if (value == 0 || value > 65535) {
+        return false;
+    }
+    *host = QByteArray(node.data(), qsizetype(colon));
+    *port = quint16(value);
+    return true;
+}
+
+void ClusterRouter::setSelf(std::string node) {
+    QMutexLocker locker(&mutex_);
+    self_ = std::move(node);
+}
+
+std::string ClusterRouter::self() const {
+    QMutexLocker locker(&mutex_);
+    return self_;
+}
+
+void ClusterRouter::update(std::shared_ptr<const HashRing> ring) {
+    QMutexLocker locker(&mutex_);
+    ring_ = std::move(ring);
+}
+
+std::shared_ptr<const HashRing> ClusterRouter::ring() const {
+    QMutexLocker locker(&mutex_);
+    return ring_;
+}
+
+std::optional<std::string> ClusterRouter::redirectTarget(std::string_view clientId) const {
+    std::shared_ptr<const HashRing> ring;
+    std::string self;
+    {
+        QMutexLocker locker(&mutex_);
+        ring = ring_;
+        self = self_;
+    }
+    if (!ring || clientId.empty()) {
+        return std::nullopt;
+    }
+    const std::string *owner = ring->owner(clientId);
+    if (!owner || *owner == self) {
+        return std::nullopt;
+    }
+    return *owner;
+}
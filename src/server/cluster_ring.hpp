@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 一致性哈希环：每个节点在环上放kVirtualNodes个虚拟点，键顺时针落到的第一个点即归属节点。
+// 增删一个节点只会改变约1/N的键的归属。节点名为服务地址"主机:端口"(主机可为空，表示与客户端当前
+// 连接的主机相同)；哈希为固定的FNV-1a+splitmix，各节点进程独立计算也得到同一个环。构造后只读。
+class HashRing {
+public:
+    static constexpr int kVirtualNodes = 128;
+
+    HashRing() = default;
+    // 节点名去重并排序
+    explicit HashRing(std::vector<std::string> nodes);
+
+    bool empty() const { return nodes_.empty(); }
+    const std::vector<std::string> &nodes() const { return nodes_; }
+    // key归属节点在nodes()中的下标，空环返回-1
+    int ownerIndex(std::string_view key) const;
+    const std::string *owner(std::string_view key) const;
+
+    static quint64 hash(std::string_view bytes);
+    // 把"主机:端口"拆开，端口不合法时返回false
+    static bool splitNode(std::string_view node, QByteArray *host, quint16 *port);
+
+private:
+    std::vector<std::pair<quint64, int>> points_;  // 按哈希值升序
+    std::vector<std::string> nodes_;
+};
+
+// 会话线程查询客户端归属的入口，所有会话共享(见ServerRuntimeConfig::cluster)。
+// 环由ClusterMembership在成员变化时整体替换，查询只在取环时短暂加锁。
+class ClusterRouter {
+public:
+    void setSelf(std::string node);
+    std::string self() const;
+    // ring为空指针表示退出集群，此后所有客户端都留在本节点
+    void update(std::shared_ptr<const HashRing> ring);
+    std::shared_ptr<const HashRing> ring() const;
+
+    // clientId归其他节点所有时返回该节点名；未组成集群、归属本节点或环为空时返回nullopt
+    std::optional<std::string> redirectTarget(std::string_view clientId) const;
+
+    void countRedirect() { redirects_.fetch_add(1, std::memory_order_relaxed); }
+    quint64 redirects() const { return redirects_.load(std::memory_order_relaxed); }
+
+private:
+    mutable QMutex mutex_;
+    std::string self_;
+    std::shared_ptr<const HashRing> ring_;
+    std::atomic<quint64> redirects_{0};
+};
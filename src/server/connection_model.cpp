@@ -38,6 +38,12 @@ QVariant ConnectionModel::data(const QModelIndex &index, int role) const {
                 return row.lastActive.toString(Qt::ISODate);
             case Interval:
                 return row.intervalMs;
+            case PoolHitRate:
+                return QStringLiteral("%1%").arg(row.poolHitRate * 100.0, 0, 'f', 1);
+            case PoolHighWater:
+                return row.poolHighWater;
+            case Memory:
+                return QStringLiteral("%1 KB").arg(row.memoryBytes / 1024.0, 0, 'f', 1);
             default:
                 return {};
         }
@@ -60,6 +66,12 @@ QVariant ConnectionModel::headerData(int section, Qt::Orientation orientation, i
                 return QStringLiteral("最近活动(UTC)");
             case Interval:
                 return QStringLiteral("发送间隔(ms)");
+            case PoolHitRate:
+                return QStringLiteral("池命中率");
+            case PoolHighWater:
+                return QStringLiteral("池高水位");
+            case Memory:
+                return QStringLiteral("缓冲内存");
             default:
                 return {};
         }
@@ -92,6 +104,16 @@ void ConnectionModel::markDisconnected(const QString &id) {
     emit dataChanged(top, bottom);
 }
 
+void ConnectionModel::setInterval(const QString &id, int intervalMs) {
+    const int idx = findRow(id);
+    if (idx == -1) {
+        return;
+    }
+    rows_[idx].intervalMs = intervalMs;
+    const QModelIndex cell = index(idx, Interval);
+    emit dataChanged(cell, cell);
+}
+
 int ConnectionModel::findRow(const QString &id) const {
     for (int i = 0; i < rows_.size(); ++i) {
         if (rows_.at(i).id == id) {
@@ -11,6 +11,9 @@ struct ConnectionRow {
     QString status;
     QDateTime lastActive;
     int intervalMs = 0;
+    double poolHitRate = 1.0;  // 所在工作线程缓冲池的命中率
+    int poolHighWater = 0;
+    qint64 memoryBytes = 0;  // 会话缓冲合计，见SessionMetrics::memoryBytes()
 };
 
 class ConnectionModel : public QAbstractTableModel {
@@ -24,6 +27,9 @@ public:
         Status,
         LastActive,
         Interval,
+        PoolHitRate,
+        PoolHighWater,
+        Memory,
         ColumnCount
     };
 
@@ -36,6 +42,7 @@ public:
 
     void upsert(const ConnectionRow &row);
     void markDisconnected(const QString &id);
+    void setInterval(const QString &id, int intervalMs);
 
 private:
     int findRow(const QString &id) const;
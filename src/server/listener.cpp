@@ -1,29 +1,84 @@
 #include "listener.hpp"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QDeadlineTimer>
 #include <QtCore/QStringList>
 #include <QtCore/QUuid>
 #include <QtCore/QVariant>
 #include <QtCore/QThread>
 #include <QtNetwork/QHostAddress>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpSocket>
 
+#include <algorithm>
+
+#include "acceptor.hpp"
+#include "cluster_ring.hpp"
+#include "common/shm_transport.hpp"
+#include "metrics_endpoint.hpp"
 #include "session_worker.hpp"
+#include "socket_handoff.hpp"
 
 Listener::Listener(QObject *parent)
     : QObject(parent),
       server_(new QTcpServer(this)),
       runtimeConfig_(std::make_shared<ServerRuntimeConfig>()) {
+    runtimeConfig_->dispatcher = std::make_shared<MessageDispatcher>();
+    runtimeConfig_->broadcast = std::make_shared<BroadcastHub>();
+    runtimeConfig_->counters = std::make_shared<ServerCounters>();
+    runtimeConfig_->admission = std::make_shared<AdmissionControl>();
+    runtimeConfig_->cluster = std::make_shared<ClusterRouter>();
+    registerDefaultHandlers();
+    rateController_ = new RateController(runtimeConfig_, this);
+    connect(rateController_, &RateController::loadSampled, this, &Listener::loadSampled);
+    connect(rateController_, &RateController::intervalChanged, this, &Listener::pushSessionInterval);
+    connect(rateController_, &RateController::intervalChanged, this, &Listener::sessionIntervalChanged);
     connect(server_, &QTcpServer::newConnection, this, &Listener::handleNewConnection);
+    scheduler_ = new SessionScheduler(this);
+    connect(scheduler_, &SessionScheduler::logMessage, this, &Listener::logMessage);
+
+    timelineTimer_.setTimerType(Qt::PreciseTimer);
+    timelineTimer_.setInterval(1000);
+    connect(&timelineTimer_, &QTimer::timeout, this, &Listener::sampleTimeline);
+    timelineClock_.start();
+    timelineTimer_.start();
+    drainTimer_.setSingleShot(true);
+    connect(&drainTimer_, &QTimer::timeout, this, &Listener::finishDrain);
 }
 
 Listener::~Listener() {
     stop();
+    // 事件循环已不再运行，不能等removeSession()：直接按截止时间等待各线程退出。
+    // 届时仍在运行的线程脱离本对象，避免销毁运行中的QThread
+    drainTimer_.stop();
+    for (auto &[id, thread] : threads_) {
+        retireThread(thread);
+    }
+    threads_.clear();
+    scheduler_->shutdown(drainDeadline_);
+    for (const QPointer<QThread> &thread : retiringThreads_) {
+        if (thread && !thread->wait(drainDeadline_)) {
+            thread->setParent(nullptr);
+        }
+    }
 }
 
 bool Listener::start(quint16 port) {
+    if (draining_) {
+        emit logMessage(QStringLiteral("上次停止的会话仍在关闭，请稍后再启动"));
+        return false;
+    }
     if (server_->isListening()) {
         server_->close();
     }
+    shutdownAcceptors();
+    if (acceptorCount_ > 1) {
+        if (Acceptor::reusePortSupported()) {
+            return startSharded(port);
+        }
+        emit logMessage(QStringLiteral("当前平台不支持SO_REUSEPORT，退回单线程监听"));
+    }
     if (!server_->listen(QHostAddress::Any, port)) {
         emit logMessage(QStringLiteral("监听失败：%1").arg(server_->errorString()));
         return false;
@@ -32,38 +87,591 @@ bool Listener::start(quint16 port) {
     return true;
 }
 
-void Listener::stop() {
-    // 先记录所有会话ID
-    QStringList sessionIds;
+void Listener::setSessionThreads(int threads) {
+    sessionThreads_ = qMax(0, threads);
+}
+
+int Listener::sessionThreads() const {
+    return sessionThreads_;
+}
+
+void Listener::setSessionRebalancing(bool enabled) {
+    scheduler_->setRebalancing(enabled);
+}
+
+SessionScheduler::Stats Listener::sessionSchedulerStats() const {
+    return scheduler_->stats();
+}
+
+void Listener::setAdmissionLimit(int maxSessions) {
+    runtimeConfig_->admission->setLimit(maxSessions);
+}
+
+void Listener::setAdmitRate(int perSec) {
+    runtimeConfig_->admission->setAdmitRate(perSec);
+}
+
+const AdmissionControl &Listener::admission() const {
+    return *runtimeConfig_->admission;
+}
+
+void Listener::setSessionLimits(const SessionLimits &limits) {
+    runtimeConfig_->sessionReadBufferBytes = qMax<qint64>(0, limits.readBufferBytes);
+    runtimeConfig_->sessionWriteBufferBytes = qMax<qint64>(0, limits.writeBufferBytes);
+    runtimeConfig_->sessionParserBytes = qMax<qint64>(0, limits.parserBytes);
+    sessionStackBytes_ = qMax<qint64>(0, limits.stackBytes);
+}
+
+SessionLimits Listener::sessionLimits() const {
+    SessionLimits limits;
+    limits.readBufferBytes = runtimeConfig_->sessionReadBufferBytes.load();
+    limits.writeBufferBytes = runtimeConfig_->sessionWriteBufferBytes.load();
+    limits.parserBytes = runtimeConfig_->sessionParserBytes.load();
+    limits.stackBytes = sessionStackBytes_;
+    return limits;
+}
+
+void Listener::setMemoryBudget(qint64 bytes) {
+    memoryBudgetBytes_ = qMax<qint64>(0, bytes);
+}
+
+Listener::MemoryStats Listener::memoryStats() const {
+    MemoryStats stats;
+    stats.sessions = static_cast<int>(sessionMetrics_.size());
+    stats.budgetBytes = memoryBudgetBytes_;
+    stats.shed = shedSessions_;
+    stats.stackBytes = sessionStackBytes_ * static_cast<qint64>(threads_.size() + std::size_t(scheduler_->threadCount()));
+    for (const auto &[id, metrics] : sessionMetrics_) {
+        const qint64 bytes = metrics->memoryBytes();
+        stats.totalBytes += bytes;
+        stats.maxSessionBytes = qMax(stats.maxSessionBytes, bytes);
+        stats.readPaused += metrics->readPaused.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    return stats;
+}
+
+void Listener::enforceMemoryBudget() {
+    if (memoryBudgetBytes_ <= 0) {
+        return;
+    }
+    std::vector<std::pair<qint64, QString>> usage;
+    usage.reserve(sessionMetrics_.size());
+    qint64 total = 0;
+    for (const auto &[id, metrics] : sessionMetrics_) {
+        // 上次已断开的会话正在关闭，其缓冲即将释放；再算一次会多断开无辜的会话
+        if (shedding_.count(id)) {
+            continue;
+        }
+        const qint64 bytes = metrics->memoryBytes();
+        total += bytes;
+        usage.emplace_back(bytes, id);
+    }
+    if (total <= memoryBudgetBytes_) {
+        return;
+    }
+    // 从占用最多的会话开始断开，留出10%余量，避免在预算边缘每秒都断开一个
+    std::sort(usage.begin(), usage.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    const qint64 target = memoryBudgetBytes_ * 9 / 10;
+    for (const auto &[bytes, id] : usage) {
+        if (total <= target) {
+            break;
+        }
+        auto it = sessions_.find(id);
+        if (it == sessions_.end() || !it->second) {
+            continue;
+        }
+        QMetaObject::invokeMethod(it->second, "stop", Qt::QueuedConnection);
+        shedding_.insert(id);
+        total -= bytes;
+        ++shedSessions_;
+        emit logMessage(QStringLiteral("内存超出预算，断开会话 %1 (占用 %2 KB)").arg(id).arg(bytes / 1024));
+    }
+}
+
+void Listener::registerHandler(cs::protocol::MsgType type, MessageHandler handler) {
+    runtimeConfig_->dispatcher->registerHandler(type, std::move(handler));
+}
+
+void Listener::setHandlerThreads(int threads) {
+    runtimeConfig_->dispatcher->setThreadCount(threads);
+}
+
+std::vector<MessageDispatcher::TypeStats> Listener::handlerStats() const {
+    return runtimeConfig_->dispatcher->stats();
+}
+
+int Listener::publish(const QString &topic, const QByteArray &body) {
+    return runtimeConfig_->broadcast->publish(topic, body);
+}
+
+BroadcastHub::Stats Listener::broadcastStats() const {
+    return runtimeConfig_->broadcast->stats();
+}
+
+std::vector<MetricsTimeline::Sample> Listener::timeline() const {
+    return timeline_.snapshot();
+}
+
+int Listener::timelineCapacity() const {
+    return timeline_.capacity();
+}
+
+LatencyHistogram::Counts Listener::sendQueueWait(cs::common::SendPriority priority) const {
+    return runtimeConfig_->counters->sendQueueWait[static_cast<std::size_t>(priority)].counts();
+}
+
+void Listener::sampleTimeline() {
+    // 以实际经过的时间折算每秒速率，定时器迟到时数据仍然准确
+    const qint64 elapsedMs = timelineClock_.restart();
+    timeline_.sample(*runtimeConfig_->counters, static_cast<int>(sessions_.size()),
+                     QDateTime::currentMSecsSinceEpoch(), elapsedMs);
+    if (runtimeConfig_->analytics) {
+        const auto types = runtimeConfig_->analytics->typeStats();
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            typeRates_[i] = double(types[i].frames - lastTypeFrames_[i]) * 1000.0 / double(qMax<qint64>(1, elapsedMs));
+            lastTypeFrames_[i] = types[i].frames;
+        }
+    }
+    enforceMemoryBudget();
+}
+
+bool Listener::enableAnalytics() {
+    if (runtimeConfig_->analytics) {
+        return true;
+    }
+    if (isListening() || !sessions_.empty() || udpReceiver_) {
+        emit logMessage(QStringLiteral("载荷统计须在启动服务之前开启"));
+        return false;
+    }
+    runtimeConfig_->analytics = std::make_shared<PayloadAnalytics>();
+    return true;
+}
+
+bool Listener::analyticsEnabled() const {
+    return runtimeConfig_->analytics != nullptr;
+}
+
+Listener::AnalyticsReport Listener::analytics(int top) const {
+    AnalyticsReport report;
+    if (!runtimeConfig_->analytics) {
+        return report;
+    }
+    const PayloadAnalytics::Snapshot snapshot = runtimeConfig_->analytics->snapshot();
+    report.distinctPayloads = snapshot.distinctPayloads();
+    report.totalFrames = snapshot.totalFrames();
+    for (std::size_t i = 0; i < snapshot.types.size(); ++i) {
+        const PayloadAnalytics::TypeStats &type = snapshot.types[i];
+        if (type.frames == 0) {
+            continue;
+        }
+        report.types.push_back({type.type, type.frames, type.bytes, typeRates_[i], type.sizeQuantile(0.50),
+                                type.sizeQuantile(0.99)});
+    }
+
+    const auto rank = [&snapshot, top](std::vector<AnalyticsReport::Talker> talkers) {
+        const auto count = std::min<std::size_t>(std::size_t(qMax(0, top)), talkers.size());
+        std::partial_sort(talkers.begin(), talkers.begin() + std::ptrdiff_t(count), talkers.end(),
+                          [](const auto &a, const auto &b) { return a.frames > b.frames; });
+        talkers.resize(count);
+        return talkers;
+    };
+    std::vector<AnalyticsReport::Talker> sessions;
+    for (const AnalyticsCandidate &candidate : sessionCandidates_) {
+        sessions.push_back({candidate.label, snapshot.estimateFrames(candidate.key), snapshot.estimateBytes(candidate.key)});
+    }
+    std::vector<AnalyticsReport::Talker> addresses;
+    for (const AnalyticsCandidate &candidate : addressCandidates_) {
+        addresses.push_back({candidate.label, snapshot.estimateFrames(candidate.key), snapshot.estimateBytes(candidate.key)});
+    }
+    // UDP来源没有会话，按"udp:地址:端口"参与会话排行，见UdpReceiver::handleDatagram()
+    for (const auto &source : udpSources()) {
+        const QString label = QStringLiteral("udp:%1:%2").arg(source.address).arg(source.port);
+        const quint64 key = PayloadAnalytics::sessionKey(label.toStdString());
+        sessions.push_back({label, snapshot.estimateFrames(key), snapshot.estimateBytes(key)});
+    }
+    report.topSessions = rank(std::move(sessions));
+    report.topAddresses = rank(std::move(addresses));
+    return report;
+}
+
+void Listener::addAnalyticsCandidate(std::deque<AnalyticsCandidate> *candidates, QString label, quint64 key) {
+    for (const AnalyticsCandidate &candidate : *candidates) {
+        if (candidate.key == key) {
+            return;
+        }
+    }
+    candidates->push_back({std::move(label), key});
+    if (int(candidates->size()) > kAnalyticsCandidates) {
+        candidates->pop_front();
+    }
+}
+
+bool Listener::startMetrics(quint16 port, const QHostAddress &address) {
+    if (!metricsEndpoint_) {
+        metricsEndpoint_ = new MetricsEndpoint([this]() { return renderMetrics(); }, this);
+    }
+    if (!analyticsEnabled() && !isListening() && sessions_.empty() && !udpReceiver_) {
+        enableAnalytics();
+    }
+    QString error;
+    if (!metricsEndpoint_->listen(address, port, &error)) {
+        emit logMessage(QStringLiteral("指标端点监听失败：%1").arg(error));
+        return false;
+    }
+    emit logMessage(QStringLiteral("指标端点 http://%1:%2/metrics%3")
+                        .arg(address.toString())
+                        .arg(metricsEndpoint_->port())
+                        .arg(analyticsEnabled() ? QString() : QStringLiteral("(未开启载荷统计，不输出载荷指标)")));
+    return true;
+}
+
+void Listener::stopMetrics() {
+    if (metricsEndpoint_) {
+        metricsEndpoint_->close();
+    }
+}
+
+quint16 Listener::metricsPort() const {
+    return metricsEndpoint_ ? metricsEndpoint_->port() : 0;
+}
+
+QByteArray Listener::renderMetrics() const {
+    const ServerCounters &counters = *runtimeConfig_->counters;
+    QByteArray out;
+    const auto metric = [&out](const char *name, const char *type, const char *help) {
+        out += QByteArrayLiteral("# HELP ") + name + ' ' + help + QByteArrayLiteral("\n# TYPE ") + name + ' ' + type + '\n';
+    };
+    const auto sample = [&out](const char *name, const QByteArray &labels, double value) {
+        out += name;
+        if (!labels.isEmpty()) {
+            out += '{' + labels + '}';
+        }
+        out += ' ' + QByteArray::number(value, 'g', 15) + '\n';
+    };
+    // 标签值需转义反斜杠、双引号与换行
+    const auto label = [](const QString &value) {
+        QByteArray escaped = value.toUtf8();
+        escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+        return escaped;
+    };
+
+    metric("cs_frames_received_total", "counter", "Frames received on all transports");
+    sample("cs_frames_received_total", {}, double(counters.framesIn.load(std::memory_order_relaxed)));
+    metric("cs_bytes_received_total", "counter", "Bytes received on all transports");
+    sample("cs_bytes_received_total", {}, double(counters.bytesIn.load(std::memory_order_relaxed)));
+    metric("cs_frame_errors_total", "counter", "Invalid frames");
+    sample("cs_frame_errors_total", {}, double(counters.errors.load(std::memory_order_relaxed)));
+    metric("cs_acks_total", "counter", "ACKs written");
+    sample("cs_acks_total", {}, double(counters.acks.load(std::memory_order_relaxed)));
+    metric("cs_sessions", "gauge", "Open sessions");
+    sample("cs_sessions", {}, double(sessions_.size()));
+    metric("cs_cluster_nodes", "gauge", "Cluster members including this node, 0 when not clustered");
+    sample("cs_cluster_nodes", {}, double(clusterMembers().size()));
+    metric("cs_cluster_redirects_total", "counter", "Clients redirected to their owning node");
+    sample("cs_cluster_redirects_total", {}, double(clusterRedirects()));
+    const SessionScheduler::Stats scheduler = scheduler_->stats();
+    metric("cs_session_thread_busy_ratio", "gauge", "Estimated load of each session pool thread, fraction of one core");
+    for (std::size_t i = 0; i < scheduler.threads.size(); ++i) {
+        sample("cs_session_thread_busy_ratio", "thread=\"" + QByteArray::number(qulonglong(i)) + '"',
+               scheduler.threads[i].busy);
+    }
+    metric("cs_session_migrations_total", "counter", "Sessions moved between session pool threads");
+    sample("cs_session_migrations_total", {}, double(scheduler.migrations));
+    metric("cs_ack_latency_microseconds", "summary", "Request read to ACK written since start");
+    const LatencyHistogram::Counts latency = counters.ackLatency.counts();
+    for (const double q : {0.5, 0.9, 0.99}) {
+        sample("cs_ack_latency_microseconds", "quantile=\"" + QByteArray::number(q) + '"',
+               LatencyHistogram::quantileUs(latency, q));
+    }
+
+    if (!analyticsEnabled()) {
+        return out;
+    }
+    const AnalyticsReport report = analytics(10);
+    const auto typeLabel = [](uint8_t type) -> QByteArray {
+        return type == 0 ? QByteArrayLiteral("type=\"other\"")
+                         : "type=\"0x" + QByteArray::number(type, 16).rightJustified(2, '0') + '"';
+    };
+    metric("cs_payload_frames_total", "counter", "Request payloads by MsgType");
+    for (const auto &type : report.types) {
+        sample("cs_payload_frames_total", typeLabel(type.type), double(type.frames));
+    }
+    metric("cs_payload_bytes_total", "counter", "Request payload bytes by MsgType");
+    for (const auto &type : report.types) {
+        sample("cs_payload_bytes_total", typeLabel(type.type), double(type.bytes));
+    }
+    metric("cs_payload_frames_per_second", "gauge", "Request payload rate by MsgType over the last second");
+    for (const auto &type : report.types) {
+        sample("cs_payload_frames_per_second", typeLabel(type.type), type.framesPerSec);
+    }
+    metric("cs_payload_size_bytes", "summary", "Request payload size upper bound by MsgType");
+    for (const auto &type : report.types) {
+        sample("cs_payload_size_bytes", typeLabel(type.type) + ",quantile=\"0.5\"", double(type.p50Bytes));
+        sample("cs_payload_size_bytes", typeLabel(type.type) + ",quantile=\"0.99\"", double(type.p99Bytes));
+    }
+    metric("cs_payload_distinct_estimate", "gauge", "Distinct payload contents (HyperLogLog, MsgId excluded)");
+    sample("cs_payload_distinct_estimate", {}, report.distinctPayloads);
+    metric("cs_top_session_frames", "gauge", "Heaviest sessions by frames (count-min estimate)");
+    for (const auto &talker : report.topSessions) {
+        sample("cs_top_session_frames", "session=\"" + label(talker.label) + '"', double(talker.frames));
+    }
+    metric("cs_top_address_frames", "gauge", "Heaviest peer addresses by frames (count-min estimate)");
+    for (const auto &talker : report.topAddresses) {
+        sample("cs_top_address_frames", "address=\"" + label(talker.label) + '"', double(talker.frames));
+    }
+    return out;
+}
+
+bool Listener::startCluster(const ClusterSettings &settings) {
+    if (!isListening()) {
+        emit logMessage(QStringLiteral("加入集群失败：服务尚未监听"));
+        return false;
+    }
+    if (!cluster_) {
+        cluster_ = new ClusterMembership(runtimeConfig_->cluster, this);
+        connect(cluster_, &ClusterMembership::logMessage, this, &Listener::logMessage);
+        connect(cluster_, &ClusterMembership::ringChanged, this, &Listener::rebalanceSessions);
+    }
+    const QString node = QStringLiteral("%1:%2").arg(settings.advertiseHost).arg(port());
+    QString error;
+    if (!cluster_->start(settings, node, &error)) {
+        emit logMessage(QStringLiteral("加入集群失败：%1").arg(error));
+        return false;
+    }
+    emit logMessage(QStringLiteral("集群节点 %1，成员端口 %2，种子 %3")
+                        .arg(node)
+                        .arg(cluster_->clusterPort())
+                        .arg(settings.peers.isEmpty() ? QStringLiteral("-") : settings.peers.join(QLatin1Char(','))));
+    return true;
+}
+
+void Listener::leaveCluster() {
+    if (cluster_ && cluster_->isRunning()) {
+        cluster_->leave();
+        emit logMessage(QStringLiteral("已离开集群"));
+    }
+}
+
+std::vector<ClusterMembership::Member> Listener::clusterMembers() const {
+    return cluster_ ? cluster_->members() : std::vector<ClusterMembership::Member>();
+}
+
+quint64 Listener::clusterRedirects() const {
+    return runtimeConfig_->cluster->redirects();
+}
+
+void Listener::rebalanceSessions(int nodes) {
+    // 一致性哈希下只有约1/N的客户端换了归属，由各会话在自己的线程中判断，其余会话不受影响
+    emit logMessage(QStringLiteral("集群成员变为 %1 个节点，检查 %2 个会话的归属").arg(nodes).arg(sessions_.size()));
     for (auto &[id, worker] : sessions_) {
-        sessionIds.append(id);
         if (worker) {
+            QMetaObject::invokeMethod(worker, &SessionWorker::rebalance, Qt::QueuedConnection);
+        }
+    }
+}
+
+void Listener::pushSessionInterval(const QString &id, int intervalMs) {
+    // 直接投递到会话所在线程；会话在投递前销毁时事件随之丢弃
+    auto it = sessions_.find(id);
+    if (it != sessions_.end() && it->second) {
+        SessionWorker *worker = it->second;
+        QMetaObject::invokeMethod(worker, [worker, intervalMs]() { worker->pushInterval(intervalMs); },
+                                  Qt::QueuedConnection);
+    }
+}
+
+void Listener::registerDefaultHandlers() {
+    using cs::protocol::MsgType;
+    using cs::protocol::RespCode;
+    // 文本与二进制消息只做接收确认，实际业务通过registerHandler()替换
+    const auto accept = [](const HandlerRequest &) { return HandlerResult{}; };
+    registerHandler(MsgType::Text, accept);
+    registerHandler(MsgType::Binary, accept);
+    // 命令消息必须带命令内容
+    registerHandler(MsgType::Command, [](const HandlerRequest &request) {
+        return HandlerResult{request.body().isEmpty() ? RespCode::Invalid : RespCode::Ok};
+    });
+}
+
+void Listener::stop() {
+    leaveCluster();
+    drain(kDefaultDrainMs);
+}
+
+void Listener::drain(int deadlineMs) {
+    if (draining_) {
+        return;
+    }
+    drainDeadline_ = QDeadlineTimer(deadlineMs);
+    runtimeConfig_->drainDeadlineMs = drainDeadline_.deadline();
+
+    // 先停止接收新连接
+    if (server_->isListening()) {
+        server_->close();
+    }
+    stopLocal();
+    stopUdp();
+
+    // 所有会话同时开始关闭：独立线程上的会话各自在本线程执行stop()并退出事件循环，
+    // 接收线程上的会话由shutdownAcceptors()统一处理；两者共享同一截止时间。
+    // 不在本线程等待：会话结束后经removeSession()移除，全部移除或到达截止时间时由finishDrain()收尾
+    for (auto &[id, worker] : sessions_) {
+        rateController_->removeSession(id);
+        if (worker && (threads_.count(id) || scheduler_->contains(id))) {
             QMetaObject::invokeMethod(worker, "stop", Qt::QueuedConnection);
         }
     }
-    
+    shutdownAcceptors();
+
+    draining_ = true;
+    if (sessions_.empty()) {
+        finishDrain();
+        return;
+    }
+    drainTimer_.start(qMax(0, deadlineMs));
+}
+
+void Listener::finishDrain() {
+    drainTimer_.stop();
+    draining_ = false;
+    // 到截止时间仍未结束的会话不再等待：其线程结束后自行释放，迟到的finished由removeSession()忽略
+    if (!sessions_.empty()) {
+        emit logMessage(QStringLiteral("%1 个会话未在截止时间内关闭").arg(sessions_.size()));
+    }
+    QStringList sessionIds;
+    for (auto &[id, worker] : sessions_) {
+        sessionIds.append(id);
+    }
+    for (auto &[id, thread] : threads_) {
+        retireThread(thread);
+    }
+    // 池内线程在处理完已投递的事件后退出，不在本线程等待
+    scheduler_->stop();
+
     // 清理会话和线程
     sessions_.clear();
+    sessionMetrics_.clear();
+    shedding_.clear();
     threads_.clear();
-    
-    // 关闭服务器
-    if (server_->isListening()) {
-        server_->close();
-    }
-    
+    runtimeConfig_->drainDeadlineMs = 0;
+
     // 通知所有连接已关闭（关键！）
     for (const QString &id : sessionIds) {
         emit connectionClosed(id);
     }
-    
+
     emit stopped();
+    if (handoffPending_) {
+        handoffPending_ = false;
+        emit handedOff();
+    }
+}
+
+void Listener::retireThread(QThread *thread) {
+    retiringThreads_.erase(std::remove(retiringThreads_.begin(), retiringThreads_.end(), nullptr),
+                           retiringThreads_.end());
+    if (thread) {
+        retiringThreads_.emplace_back(thread);
+    }
+}
+
+bool Listener::startLocal(const QString &path) {
+    stopLocal();
+    localServer_ = new QLocalServer(this);
+    QLocalServer::removeServer(path);  // 清理上次异常退出留下的套接字文件
+    if (!localServer_->listen(path)) {
+        emit logMessage(QStringLiteral("本地监听失败：%1").arg(localServer_->errorString()));
+        stopLocal();
+        return false;
+    }
+    connect(localServer_, &QLocalServer::newConnection, this, &Listener::handleNewLocalConnection);
+    emit logMessage(QStringLiteral("Unix域套接字监听于 %1").arg(localServer_->fullServerName()));
+
+    if (cs::common::ShmTransport::supported()) {
+        const QString shmPath = path + QStringLiteral(".shm");
+        shmServer_ = new QLocalServer(this);
+        QLocalServer::removeServer(shmPath);
+        if (shmServer_->listen(shmPath)) {
+            connect(shmServer_, &QLocalServer::newConnection, this, &Listener::handleNewShmConnection);
+            emit logMessage(QStringLiteral("共享内存协商端点 %1").arg(shmServer_->fullServerName()));
+        } else {
+            emit logMessage(QStringLiteral("共享内存协商端点监听失败：%1").arg(shmServer_->errorString()));
+            delete shmServer_;
+            shmServer_ = nullptr;
+        }
+    }
+    return true;
+}
+
+void Listener::stopLocal() {
+    for (QLocalServer **server : {&localServer_, &shmServer_}) {
+        if (*server) {
+            (*server)->close();
+            (*server)->deleteLater();
+            *server = nullptr;
+        }
+    }
+}
+
+QString Listener::localPath() const {
+    return localServer_ ? localServer_->fullServerName() : QString();
+}
+
+bool Listener::startUdp(quint16 port) {
+    stopUdp();
+    udpThread_ = new QThread(this);
+    udpThread_->setObjectName(QStringLiteral("udp"));
+    udpReceiver_ = new UdpReceiver(runtimeConfig_);
+    udpReceiver_->moveToThread(udpThread_);
+    udpThread_->start();
+    bool ok = false;
+    QString error;
+    // 套接字通知器必须在接收线程中创建
+    QMetaObject::invokeMethod(udpReceiver_, [this, port, &ok, &error]() {
+        ok = udpReceiver_->open(port, &error);
+    }, Qt::BlockingQueuedConnection);
+    if (!ok) {
+        emit logMessage(QStringLiteral("UDP监听失败：%1").arg(error));
+        stopUdp();
+        return false;
+    }
+    emit logMessage(QStringLiteral("UDP遥测监听于端口 %1").arg(udpReceiver_->port()));
+    return true;
+}
+
+void Listener::stopUdp() {
+    if (!udpThread_) {
+        return;
+    }
+    QMetaObject::invokeMethod(udpReceiver_, &UdpReceiver::close, Qt::BlockingQueuedConnection);
+    udpThread_->quit();
+    udpThread_->wait();
+    delete udpReceiver_;
+    delete udpThread_;
+    udpReceiver_ = nullptr;
+    udpThread_ = nullptr;
+}
+
+quint16 Listener::udpPort() const {
+    return udpReceiver_ ? udpReceiver_->port() : 0;
+}
+
+std::vector<UdpReceiver::SourceStats> Listener::udpSources() const {
+    return udpReceiver_ ? udpReceiver_->sources() : std::vector<UdpReceiver::SourceStats>();
+}
+
+quint64 Listener::udpEvictedSources() const {
+    return udpReceiver_ ? udpReceiver_->evictedSources() : 0;
 }
 
 bool Listener::isListening() const {
-    return server_ && server_->isListening();
+    return !acceptors_.empty() || (server_ && server_->isListening());
 }
 
 quint16 Listener::port() const {
+    if (!acceptors_.empty()) {
+        return shardedPort_;
+    }
     return server_ ? server_->serverPort() : 0;
 }
 
@@ -81,6 +689,164 @@ std::optional<int> Listener::forcedInterval() const {
     return runtimeConfig_->forcedIntervalMs.load();
 }
 
+void Listener::setAdaptiveInterval(std::optional<int> minIntervalMs) {
+    if (minIntervalMs) {
+        auto settings = rateController_->settings();
+        settings.minIntervalMs = *minIntervalMs;
+        rateController_->setSettings(settings);
+    }
+    rateController_->setEnabled(minIntervalMs.has_value());
+}
+
+std::optional<int> Listener::adaptiveInterval() const {
+    if (!rateController_->isEnabled()) {
+        return std::nullopt;
+    }
+    return rateController_->settings().minIntervalMs;
+}
+
+void Listener::setAcceptorCount(int count) {
+    acceptorCount_ = qMax(1, count);
+}
+
+int Listener::acceptorCount() const {
+    return acceptorCount_;
+}
+
+bool Listener::enableHandoff(const QString &path, int drainMs) {
+    if (!SocketHandoff::supported()) {
+        emit logMessage(QStringLiteral("当前平台不支持热重启套接字交接"));
+        return false;
+    }
+    if (!handoff_) {
+        handoff_ = new SocketHandoff(this);
+        connect(handoff_, &SocketHandoff::successorConnected, this, &Listener::handleSuccessorConnected);
+    }
+    handoffDrainMs_ = drainMs;
+    QString error;
+    if (!handoff_->listen(path, &error)) {
+        emit logMessage(QStringLiteral("热重启通道监听失败：%1").arg(error));
+        return false;
+    }
+    emit logMessage(QStringLiteral("热重启通道已就绪：%1").arg(handoff_->path()));
+    return true;
+}
+
+bool Listener::takeOver(const QString &path, int timeoutMs) {
+    QString error;
+    const auto descriptors = SocketHandoff::receive(path, timeoutMs, &error);
+    if (descriptors.empty()) {
+        emit logMessage(QStringLiteral("接管监听套接字失败：%1").arg(error));
+        return false;
+    }
+    if (!error.isEmpty()) {
+        emit logMessage(QStringLiteral("接管监听套接字警告：%1").arg(error));
+    }
+
+    if (server_->isListening()) {
+        server_->close();
+    }
+    shutdownAcceptors();
+    const quint16 boundPort = SocketHandoff::localPort(descriptors.front());
+    if (descriptors.size() == 1) {
+        if (!server_->setSocketDescriptor(descriptors.front())) {
+            emit logMessage(QStringLiteral("接管监听套接字失败：%1").arg(server_->errorString()));
+            return false;
+        }
+    } else {
+        // 旧进程为分片监听时，接管其全部SO_REUSEPORT套接字以保留各自的连接队列
+        acceptorCount_ = static_cast<int>(descriptors.size());
+        startAcceptors(descriptors, boundPort);
+    }
+    emit logMessage(QStringLiteral("已从旧进程接管 %1 个监听套接字").arg(descriptors.size()));
+    emit listening(boundPort);
+    return true;
+}
+
+void Listener::handleSuccessorConnected() {
+    QString error;
+    if (!handoff_->transfer(listeningDescriptors(), &error)) {
+        emit logMessage(QStringLiteral("交接监听套接字失败：%1").arg(error));
+        return;
+    }
+    // 新进程已持有监听套接字的副本，本进程关闭自己的副本不会拒绝任何新连接
+    emit logMessage(QStringLiteral("监听套接字已交给新进程，开始排空现有会话"));
+    handoffPending_ = true;
+    drain(handoffDrainMs_);
+}
+
+std::vector<qintptr> Listener::listeningDescriptors() const {
+    if (!acceptorDescriptors_.empty()) {
+        return acceptorDescriptors_;
+    }
+    if (server_->isListening()) {
+        return {server_->socketDescriptor()};
+    }
+    return {};
+}
+
+bool Listener::startSharded(quint16 port) {
+    // 所有套接字在本线程同步创建，端口冲突等错误可以立即返回；
+    // 端口为0时以第一个套接字实际绑定的端口为准。
+    std::vector<qintptr> descriptors;
+    quint16 boundPort = port;
+    for (int i = 0; i < acceptorCount_; ++i) {
+        QString error;
+        const qintptr fd = Acceptor::openReusePortSocket(boundPort, &boundPort, &error);
+        if (fd < 0) {
+            for (const qintptr opened : descriptors) {
+                Acceptor::closeSocket(opened);
+            }
+            emit logMessage(QStringLiteral("监听失败：%1").arg(error));
+            return false;
+        }
+        descriptors.push_back(fd);
+    }
+    startAcceptors(descriptors, boundPort);
+    emit logMessage(QStringLiteral("已启用 %1 个接收线程(SO_REUSEPORT)").arg(acceptorCount_));
+    emit listening(boundPort);
+    return true;
+}
+
+void Listener::startAcceptors(const std::vector<qintptr> &descriptors, quint16 port) {
+    for (std::size_t i = 0; i < descriptors.size(); ++i) {
+        auto *thread = new QThread(this);
+        thread->setObjectName(QStringLiteral("acceptor-%1").arg(i));
+        auto *acceptor = new Acceptor(static_cast<int>(i), runtimeConfig_);
+        acceptor->moveToThread(thread);
+        connect(acceptor, &Acceptor::sessionAccepted, this,
+                [this](const QPointer<SessionWorker> &worker, const QString &id, const QString &address, quint16 peerPort) {
+                    registerSession(worker, nullptr, id, address, peerPort);
+                });
+        connect(acceptor, &Acceptor::logMessage, this, &Listener::logMessage);
+        thread->start();
+        const qintptr descriptor = descriptors[i];
+        QMetaObject::invokeMethod(acceptor, [acceptor, descriptor]() { acceptor->adopt(descriptor); }, Qt::QueuedConnection);
+        acceptors_.push_back(acceptor);
+        acceptorThreads_.push_back(thread);
+    }
+    acceptorDescriptors_ = descriptors;
+    shardedPort_ = port;
+}
+
+void Listener::shutdownAcceptors() {
+    // 各接收线程同时关闭监听并停止其本地会话(单个会话的等待受drainDeadlineMs约束)，
+    // 会话全部销毁后线程退出并释放自己与接收器，不在本线程等待
+    for (std::size_t i = 0; i < acceptors_.size(); ++i) {
+        Acceptor *acceptor = acceptors_[i];
+        QThread *thread = acceptorThreads_[i];
+        connect(acceptor, &Acceptor::drained, thread, &QThread::quit, Qt::DirectConnection);
+        connect(thread, &QThread::finished, acceptor, &QObject::deleteLater);
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        retireThread(thread);
+        QMetaObject::invokeMethod(acceptor, &Acceptor::shutdown, Qt::QueuedConnection);
+    }
+    acceptors_.clear();
+    acceptorThreads_.clear();
+    acceptorDescriptors_.clear();
+    shardedPort_ = 0;
+}
+
 void Listener::handleNewConnection() {
     while (server_->hasPendingConnections()) {
         auto socket = server_->nextPendingConnection();
@@ -89,48 +855,137 @@ void Listener::handleNewConnection() {
         }
         const QString address = socket->peerAddress().toString();
         const quint16 peerPort = socket->peerPort();
-        socket->setParent(nullptr);
-        const QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
-        auto *thread = new QThread(this);
-        auto *worker = new SessionWorker(socket, id, runtimeConfig_);
-        worker->moveToThread(thread);
-        socket->moveToThread(thread);
+        startSession(new cs::common::TcpTransport(socket), address, peerPort);
+    }
+}
+
+void Listener::handleNewLocalConnection() {
+    while (localServer_->hasPendingConnections()) {
+        auto *socket = localServer_->nextPendingConnection();
+        if (!socket) {
+            continue;
+        }
+        startSession(new cs::common::LocalTransport(socket), QStringLiteral("unix"), 0);
+    }
+}
 
+void Listener::handleNewShmConnection() {
+    while (shmServer_->hasPendingConnections()) {
+        auto *socket = shmServer_->nextPendingConnection();
+        if (!socket) {
+            continue;
+        }
+        QString error;
+        auto *transport = cs::common::ShmTransport::accept(socket, cs::common::ShmTransport::kDefaultRingBytes, &error);
+        if (!transport) {
+            emit logMessage(QStringLiteral("共享内存协商失败：%1").arg(error));
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+        startSession(transport, QStringLiteral("shm"), 0);
+    }
+}
+
+void Listener::startSession(cs::common::Transport *transport, const QString &address, quint16 peerPort) {
+    const auto admission = runtimeConfig_->admission;
+    if (!admission->tryAdmit()) {
+        transport->setParent(this);
+        admission->reject(transport);
+        return;
+    }
+    const QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    auto *worker = new SessionWorker(transport, id, runtimeConfig_);
+    connect(worker, &QObject::destroyed, [admission]() { admission->release(); });
+    connect(worker, &SessionWorker::finished, worker, &QObject::deleteLater);
+    if (sessionThreads_ > 0) {
+        // 线程池在第一个会话到来时启动，之后由调度器按负载分配和迁移
+        scheduler_->start(sessionThreads_, sessionStackBytes_);
+        scheduler_->place(worker, id, worker->metrics());
+        registerSession(worker, nullptr, id, address, peerPort);
+        return;
+    }
+    auto *thread = new QThread(this);
+    if (sessionStackBytes_ > 0) {
+        thread->setStackSize(static_cast<uint>(sessionStackBytes_));
+    }
+    worker->moveToThread(thread);  // 传输已成为会话的子对象，随之一起迁移
+    registerSession(worker, thread, id, address, peerPort);
+}
+
+void Listener::registerSession(const QPointer<SessionWorker> &worker, QThread *thread, const QString &id,
+                               const QString &address, quint16 peerPort) {
+    // thread为空表示会话驻留在接收线程或会话线程池中，由所在线程的事件循环驱动。
+    // 接收线程上的会话经排队信号到达，此前可能已被Acceptor::shutdown()停止并销毁
+    if (!worker) {
+        return;
+    }
+    connect(worker, &SessionWorker::finished, this, [this](const QString &connectionId) {
+        removeSession(connectionId);
+    });
+    connect(worker, &SessionWorker::connectionUpdated, this, &Listener::connectionUpdated);
+    const auto metrics = worker->metrics();
+    connect(worker, &SessionWorker::frameReceived, this, [this, metrics](const QString &connectionId, const QByteArray &payload) {
+        metrics->pendingSignalBytes.fetch_sub(payload.size(), std::memory_order_relaxed);
+        emit frameReceived(connectionId, payload);
+    });
+    connect(worker, &SessionWorker::invalidPacket, this, &Listener::invalidPacket);
+    // 先接好finished再检查：此后结束的会话经removeSession()移除；此前已结束的不再登记也不再start()，
+    // 其销毁由所在线程的finished→deleteLater负责
+    if (worker->isFinished()) {
+        return;
+    }
+
+    sessions_.emplace(id, worker);
+    sessionMetrics_.emplace(id, metrics);
+    if (analyticsEnabled()) {
+        // 与SessionWorker计算草图键使用同一组字符串
+        addAnalyticsCandidate(&sessionCandidates_, QStringLiteral("%1 %2:%3").arg(id.left(8), address).arg(peerPort),
+                              PayloadAnalytics::sessionKey(id.toStdString()));
+        addAnalyticsCandidate(&addressCandidates_, address, PayloadAnalytics::addressKey(address.toStdString()));
+    }
+    rateController_->addSession(id, metrics);
+    if (thread) {
         connect(thread, &QThread::started, worker, &SessionWorker::start);
-        connect(worker, &SessionWorker::finished, this, [this](const QString &connectionId) {
-            removeSession(connectionId);
-        });
-        connect(worker, &SessionWorker::finished, worker, &QObject::deleteLater);
-        connect(worker, &SessionWorker::connectionUpdated, this, &Listener::connectionUpdated);
-        connect(worker, &SessionWorker::frameReceived, this, &Listener::frameReceived);
-        connect(worker, &SessionWorker::invalidPacket, this, &Listener::invalidPacket);
         connect(thread, &QThread::finished, thread, &QObject::deleteLater);
-
-        sessions_.emplace(id, worker);
+        // 会话对象销毁即结束其线程；直接连接，避免依赖界面线程的事件循环
+        connect(worker, &QObject::destroyed, thread, &QThread::quit, Qt::DirectConnection);
         threads_.emplace(id, thread);
         thread->start();
-
-        ConnectionRow row;
-        row.id = id;
-        row.address = address;
-        row.port = peerPort;
-        row.status = QStringLiteral("已连接");
-        row.lastActive = QDateTime::currentDateTimeUtc();
-        row.intervalMs = runtimeConfig_->forcedIntervalMs.load();
-        emit connectionUpdated(row);
-        emit logMessage(QStringLiteral("新的客户端接入 %1:%2").arg(row.address).arg(row.port));
+    } else {
+        QMetaObject::invokeMethod(worker.data(), "start", Qt::QueuedConnection);
     }
+
+    ConnectionRow row;
+    row.id = id;
+    row.address = address;
+    row.port = peerPort;
+    row.status = QStringLiteral("已连接");
+    row.lastActive = QDateTime::currentDateTimeUtc();
+    row.intervalMs = runtimeConfig_->forcedIntervalMs.load();
+    emit connectionUpdated(row);
+    emit logMessage(QStringLiteral("新的客户端接入 %1:%2").arg(row.address).arg(row.port));
 }
 
 void Listener::removeSession(const QString &id) {
+    // 排空超时后会话表已清空并通知过关闭，迟到的finished不再重复处理
+    if (sessions_.erase(id) == 0) {
+        return;
+    }
     auto itThread = threads_.find(id);
     if (itThread != threads_.end()) {
+        // 不在界面线程上等待：线程结束后通过finished→deleteLater自行释放
         if (itThread->second) {
             itThread->second->quit();
-            itThread->second->wait(1000);
         }
         threads_.erase(itThread);
     }
-    sessions_.erase(id);
+    sessionMetrics_.erase(id);
+    shedding_.erase(id);
+    scheduler_->remove(id);
+    rateController_->removeSession(id);
     emit connectionClosed(id);
+    if (draining_ && sessions_.empty()) {
+        finishDrain();
+    }
 }
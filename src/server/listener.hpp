@@ -1,34 +1,184 @@
 #pragma once
 
+#include "admission_control.hpp"
+#include "broadcast_hub.hpp"
+#include "cluster_membership.hpp"
 #include "connection_model.hpp"
+#include "message_dispatcher.hpp"
+#include "payload_analytics.hpp"
+#include "rate_controller.hpp"
 #include "server_runtime.hpp"
+#include "server_stats.hpp"
+#include "session_metrics.hpp"
+#include "session_scheduler.hpp"
+#include "udp_receiver.hpp"
+#include "common/transport.hpp"
 
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
+#include <QtCore/QTimer>
 #include <QtNetwork/QHostAddress>
 #include <QtNetwork/QTcpServer>
 
+#include <array>
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+class Acceptor;
+class MetricsEndpoint;
+class QLocalServer;
+class QThread;
 class SessionWorker;
+class SocketHandoff;
+
+// 单会话资源上限，0表示不限/使用系统默认值
+struct SessionLimits {
+    qint64 readBufferBytes = 0;   // 传输接收缓冲(QTcpSocket::setReadBufferSize)
+    qint64 writeBufferBytes = 0;  // 写缓冲超过该值时暂停读取该会话
+    qint64 parserBytes = 64 * 1024;  // 解析器空闲时保留的缓冲容量
+    qint64 stackBytes = 0;        // 会话线程栈大小(QThread::setStackSize)
+};
 
 class Listener : public QObject {
     Q_OBJECT
 
 public:
+    struct MemoryStats {
+        int sessions = 0;
+        qint64 totalBytes = 0;       // 各会话缓冲合计
+        qint64 maxSessionBytes = 0;
+        qint64 budgetBytes = 0;
+        qint64 stackBytes = 0;       // 会话线程栈预留合计，0表示使用系统默认值未计入
+        int readPaused = 0;
+        quint64 shed = 0;            // 因超出全局预算被断开的会话累计
+    };
+
+    // 由PayloadAnalytics合并出的载荷统计；帧数/字节数为count-min估计值，只会偏大
+    struct AnalyticsReport {
+        struct Talker {
+            QString label;
+            quint64 frames = 0;
+            quint64 bytes = 0;
+        };
+        struct TypeRow {
+            uint8_t type = 0;  // 0表示其他类型
+            quint64 frames = 0;
+            quint64 bytes = 0;
+            double framesPerSec = 0.0;  // 最近一秒
+            quint64 p50Bytes = 0;
+            quint64 p99Bytes = 0;
+        };
+        std::vector<Talker> topSessions;   // 按帧数降序
+        std::vector<Talker> topAddresses;
+        std::vector<TypeRow> types;        // 只含出现过的类型
+        double distinctPayloads = 0.0;     // 去掉MsgId后不同内容数的HyperLogLog估计
+        quint64 totalFrames = 0;
+    };
+
+    // 热点排行从最近接入的这么多个会话/地址中挑选，草图本身不保存键
+    static constexpr int kAnalyticsCandidates = 1024;
+
     explicit Listener(QObject *parent = nullptr);
     ~Listener() override;
 
+    static constexpr int kDefaultDrainMs = 1000;
+
     bool start(quint16 port);
     void stop();
+    // 停止监听并并行关闭所有会话，不阻塞调用线程；全部会话关闭或经过deadlineMs后发出stopped()
+    void drain(int deadlineMs);
+    bool isDraining() const { return draining_; }
     bool isListening() const;
     quint16 port() const;
 
     void setForcedInterval(std::optional<int> intervalMs);
     std::optional<int> forcedInterval() const;
+    // 按服务器负载逐会话调整发送间隔，minIntervalMs为允许的最短间隔；nullopt表示关闭
+    void setAdaptiveInterval(std::optional<int> minIntervalMs);
+    std::optional<int> adaptiveInterval() const;
+
+    // 接收线程数，>1时使用SO_REUSEPORT分片监听，需在start()前设置
+    void setAcceptorCount(int count);
+    int acceptorCount() const;
+
+    // 会话线程池的线程数，0表示每个会话一个线程(默认)；需在start()前设置。
+    // 线程池只承载Listener自己接入的会话(单线程监听、Unix域套接字、共享内存)，分片接收的会话仍留在接收线程
+    void setSessionThreads(int threads);
+    int sessionThreads() const;
+    // 按会话开销在池内线程间迁移会话，默认开启
+    void setSessionRebalancing(bool enabled);
+    SessionScheduler::Stats sessionSchedulerStats() const;
+
+    // 在线会话上限，0为不限；超限的连接收到RetryAfter命令后被关闭，重连时间按admitPerSec错开
+    void setAdmissionLimit(int maxSessions);
+    void setAdmitRate(int perSec);
+    const AdmissionControl &admission() const;
+
+    // 新会话生效；已有会话保留建立时的上限
+    void setSessionLimits(const SessionLimits &limits);
+    SessionLimits sessionLimits() const;
+    // 全部会话缓冲合计的预算(字节，0为不限)；每秒检查一次，超出时从占用最多的会话开始断开，直到回落到预算的90%
+    void setMemoryBudget(qint64 bytes);
+    MemoryStats memoryStats() const;
+
+    // 同机客户端：在path上监听Unix域套接字，path.shm上协商共享内存环传输；独立于TCP监听启动，stop()/drain()时一并关闭
+    bool startLocal(const QString &path);
+    void stopLocal();
+    QString localPath() const;
+
+    // UDP遥测：在port上接收不需要ACK的帧，独立线程批量收包；stop()/drain()时一并关闭
+    bool startUdp(quint16 port);
+    void stopUdp();
+    quint16 udpPort() const;
+    std::vector<UdpReceiver::SourceStats> udpSources() const;
+    quint64 udpEvictedSources() const;
+
+    // 热重启：旧进程在path上等待接替者并交出监听套接字；新进程从path接管
+    bool enableHandoff(const QString &path, int drainMs);
+    bool takeOver(const QString &path, int timeoutMs);
+
+    // 业务处理器在计算线程池中执行，需在start()前注册；threads为0时使用CPU核数
+    void registerHandler(cs::protocol::MsgType type, MessageHandler handler);
+    void setHandlerThreads(int threads);
+    std::vector<MessageDispatcher::TypeStats> handlerStats() const;
+
+    // 向订阅了topic的会话推送body，topic为空时推送给所有会话；返回接收的会话数
+    int publish(const QString &topic, const QByteArray &body);
+    BroadcastHub::Stats broadcastStats() const;
+
+    // 最近若干秒的每秒聚合数据（吞吐、错误、会话数、ACK延迟分位数），按时间先后排列
+    std::vector<MetricsTimeline::Sample> timeline() const;
+    int timelineCapacity() const;
+    // 各发送优先级自启动以来的排队时间分布，直接写出的帧按0计入
+    LatencyHistogram::Counts sendQueueWait(cs::common::SendPriority priority) const;
+    // 未开启载荷统计时返回空报告
+    AnalyticsReport analytics(int top = 5) const;
+    // 开启载荷统计(PayloadAnalytics，约550KB)。会话线程不加锁地读取该指针，只能在监听与UDP接收开始前开启
+    bool enableAnalytics();
+    bool analyticsEnabled() const;
+
+    // 在address:port上提供 GET /metrics(Prometheus文本格式)；独立于服务监听，stop()/drain()不关闭。
+    // 默认只绑定本机回环；尚未监听时顺带开启载荷统计
+    bool startMetrics(quint16 port, const QHostAddress &address = QHostAddress(QHostAddress::LocalHost));
+    void stopMetrics();
+    quint16 metricsPort() const;
+    QByteArray renderMetrics() const;
+
+    // 加入集群：在settings.port上与种子节点交换成员表，需在监听之后调用。
+    // 本节点在环上的名字为"advertiseHost:服务端口"，advertiseHost为空表示客户端沿用当前连接的主机重连；
+    // 发送了标识(MsgType=0x13)的客户端若归其他节点，收到Redirect命令后改连该节点。成员变化时重新检查现有会话。
+    bool startCluster(const ClusterSettings &settings);
+    // 通知其他节点本节点离开；stop()会先调用它，使排空的会话被重定向到各自新的归属节点
+    void leaveCluster();
+    std::vector<ClusterMembership::Member> clusterMembers() const;
+    quint64 clusterRedirects() const;
 
 signals:
     void listening(quint16 port);
@@ -38,15 +188,77 @@ signals:
     void frameReceived(const QString &id, QByteArray payload);
     void invalidPacket(const QString &id, QString reason);
     void logMessage(QString text);
+    void handedOff();
+    void loadSampled(const RateController::LoadSample &sample);
+    void sessionIntervalChanged(const QString &id, int intervalMs);
 
 private slots:
     void handleNewConnection();
+    void handleNewLocalConnection();
+    void handleNewShmConnection();
+    void handleSuccessorConnected();
 
 private:
+    bool startSharded(quint16 port);
+    void startAcceptors(const std::vector<qintptr> &descriptors, quint16 port);
+    void shutdownAcceptors();
+    std::vector<qintptr> listeningDescriptors() const;
+    // 为新连接创建独立线程上的会话
+    void startSession(cs::common::Transport *transport, const QString &address, quint16 peerPort);
+    // 调用方须已把finished接到deleteLater；已结束或已销毁的会话不登记
+    void registerSession(const QPointer<SessionWorker> &worker, QThread *thread, const QString &id,
+                         const QString &address, quint16 peerPort);
     void removeSession(const QString &id);
+    void finishDrain();
+    // 线程结束后自行释放；析构时仍在运行的线程须先等待，见~Listener()
+    void retireThread(QThread *thread);
+    void registerDefaultHandlers();
+    void sampleTimeline();
+    void enforceMemoryBudget();
+    void rebalanceSessions(int nodes);
+    void pushSessionInterval(const QString &id, int intervalMs);
+
+    struct AnalyticsCandidate {
+        QString label;
+        quint64 key = 0;
+    };
+    static void addAnalyticsCandidate(std::deque<AnalyticsCandidate> *candidates, QString label, quint64 key);
 
     QTcpServer *server_ = nullptr;
+    QLocalServer *localServer_ = nullptr;
+    QLocalServer *shmServer_ = nullptr;
+    UdpReceiver *udpReceiver_ = nullptr;
+    QThread *udpThread_ = nullptr;
+    int acceptorCount_ = 1;
+    quint16 shardedPort_ = 0;
+    std::vector<Acceptor *> acceptors_;
+    std::vector<QThread *> acceptorThreads_;
+    std::vector<qintptr> acceptorDescriptors_;
+    SocketHandoff *handoff_ = nullptr;
+    int handoffDrainMs_ = kDefaultDrainMs;
+    bool handoffPending_ = false;  // 排空结束后发出handedOff()
+    bool draining_ = false;
+    QDeadlineTimer drainDeadline_;
+    QTimer drainTimer_;
+    std::vector<QPointer<QThread>> retiringThreads_;
     std::unordered_map<QString, SessionWorker *> sessions_;
     std::unordered_map<QString, QThread *> threads_;
+    int sessionThreads_ = 0;
+    SessionScheduler *scheduler_ = nullptr;
+    std::unordered_map<QString, std::shared_ptr<SessionMetrics>> sessionMetrics_;
+    qint64 sessionStackBytes_ = 0;
+    qint64 memoryBudgetBytes_ = 0;
+    quint64 shedSessions_ = 0;
+    std::unordered_set<QString> shedding_;  // 已因预算断开、尚未结束的会话，不再计入占用也不重复断开
     std::shared_ptr<ServerRuntimeConfig> runtimeConfig_;
+    RateController *rateController_ = nullptr;
+    MetricsTimeline timeline_;
+    QTimer timelineTimer_;
+    QElapsedTimer timelineClock_;
+    std::deque<AnalyticsCandidate> sessionCandidates_;
+    std::deque<AnalyticsCandidate> addressCandidates_;
+    std::array<quint64, PayloadAnalytics::kTypeSlots> lastTypeFrames_{};
+    std::array<double, PayloadAnalytics::kTypeSlots> typeRates_{};
+    MetricsEndpoint *metricsEndpoint_ = nullptr;
+    ClusterMembership *cluster_ = nullptr;
 };
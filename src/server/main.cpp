@@ -1,10 +1,146 @@
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QTextStream>
 #include <QtWidgets/QApplication>
 
+#include "common/alloc_tracker.hpp"
+#include "common/frame_trace.hpp"
 #include "server_window.hpp"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("监听端口"), QStringLiteral("port"), QStringLiteral("8080"));
+    const QCommandLineOption listenOption(QStringLiteral("listen"), QStringLiteral("启动后立即开始监听"));
+    const QCommandLineOption acceptorsOption(QStringLiteral("acceptors"), QStringLiteral("SO_REUSEPORT接收线程数"), QStringLiteral("count"), QStringLiteral("1"));
+    const QCommandLineOption takeoverOption(QStringLiteral("takeover"), QStringLiteral("从旧进程的交接通道接管监听套接字"), QStringLiteral("path"));
+    const QCommandLineOption handoffOption(QStringLiteral("handoff"), QStringLiteral("在该路径上等待新进程接管(热重启)"), QStringLiteral("path"));
+    const QCommandLineOption drainOption(QStringLiteral("drain-ms"), QStringLiteral("交接后排空会话的总截止时间(毫秒)"), QStringLiteral("ms"), QStringLiteral("10000"));
+    const QCommandLineOption localOption(QStringLiteral("local"), QStringLiteral("同时在该路径监听Unix域套接字(路径.shm为共享内存协商端点)"), QStringLiteral("path"));
+    const QCommandLineOption udpOption(QStringLiteral("udp"), QStringLiteral("同时在该端口接收UDP遥测帧(不回ACK)"), QStringLiteral("port"));
+    const QCommandLineOption handlerThreadsOption(QStringLiteral("handler-threads"), QStringLiteral("业务处理线程数(0=CPU核数)"), QStringLiteral("count"), QStringLiteral("0"));
+    const QCommandLineOption sessionThreadsOption(QStringLiteral("session-threads"), QStringLiteral("会话线程池的线程数(0=每个会话一个线程)"), QStringLiteral("count"), QStringLiteral("0"));
+    const QCommandLineOption noRebalanceOption(QStringLiteral("no-rebalance"), QStringLiteral("会话线程池不按负载在线程间迁移会话"));
+    const QCommandLineOption maxSessionsOption(QStringLiteral("max-sessions"), QStringLiteral("在线会话上限，超出时下发RetryAfter并断开(0=不限)"), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption admitRateOption(QStringLiteral("admit-rate"), QStringLiteral("被拒绝或停机断开的客户端每秒错开重连的数量"), QStringLiteral("n"), QStringLiteral("500"));
+    const QCommandLineOption readBufferOption(QStringLiteral("read-buffer-kb"), QStringLiteral("单会话接收缓冲上限(KB，0=不限)"), QStringLiteral("kb"), QStringLiteral("0"));
+    const QCommandLineOption writeBufferOption(QStringLiteral("write-buffer-kb"), QStringLiteral("单会话写缓冲超过该值时暂停读取(KB，0=不限)"), QStringLiteral("kb"), QStringLiteral("0"));
+    const QCommandLineOption stackOption(QStringLiteral("session-stack-kb"), QStringLiteral("会话线程栈大小(KB，0=系统默认)"), QStringLiteral("kb"), QStringLiteral("0"));
+    const QCommandLineOption memoryBudgetOption(QStringLiteral("memory-budget-mb"), QStringLiteral("全部会话缓冲的内存预算，超出时断开占用最多的会话(MB，0=不限)"), QStringLiteral("mb"), QStringLiteral("0"));
+    const QCommandLineOption metricsOption(QStringLiteral("metrics-port"), QStringLiteral("在该端口提供HTTP指标端点 GET /metrics(Prometheus文本格式)"), QStringLiteral("port"));
+    const QCommandLineOption metricsBindOption(QStringLiteral("metrics-bind"), QStringLiteral("指标端点绑定的本机地址(默认只允许本机访问)"), QStringLiteral("address"), QStringLiteral("127.0.0.1"));
+    const QCommandLineOption analyticsOption(QStringLiteral("analytics"), QStringLiteral("统计载荷类型分布与热点会话(开启--metrics-port时自动开启)"));
+    const QCommandLineOption clusterPortOption(QStringLiteral("cluster-port"), QStringLiteral("加入集群：在该UDP端口与其他节点交换成员表"), QStringLiteral("port"));
+    const QCommandLineOption clusterBindOption(QStringLiteral("cluster-bind"), QStringLiteral("集群UDP端口绑定的本机地址"), QStringLiteral("address"), QStringLiteral("0.0.0.0"));
+    const QCommandLineOption clusterSecretOption(QStringLiteral("cluster-secret"), QStringLiteral("各节点共享的集群密钥，用于认证成员数据报(加入集群时必需)"), QStringLiteral("secret"));
+    const QCommandLineOption peersOption(QStringLiteral("peers"), QStringLiteral("其他节点的集群端口，逗号分隔的 IP:端口"), QStringLiteral("list"));
+    const QCommandLineOption advertiseOption(QStringLiteral("advertise-host"), QStringLiteral("重定向给客户端的本节点主机名(默认空：客户端沿用当前连接的主机)"), QStringLiteral("host"));
+    const QCommandLineOption traceOption(QStringLiteral("trace"), QStringLiteral("开启逐帧追踪，退出时导出Chrome trace JSON到该文件"), QStringLiteral("file"));
+    const QCommandLineOption traceSampleOption(QStringLiteral("trace-sample"), QStringLiteral("追踪采样间隔(每N帧追踪1帧)"), QStringLiteral("n"), QStringLiteral("1"));
+    parser.addOption(portOption);
+    parser.addOption(listenOption);
+    parser.addOption(acceptorsOption);
+    parser.addOption(takeoverOption);
+    parser.addOption(handoffOption);
+    parser.addOption(drainOption);
+    parser.addOption(localOption);
+    parser.addOption(udpOption);
+    parser.addOption(handlerThreadsOption);
+    parser.addOption(sessionThreadsOption);
+    parser.addOption(noRebalanceOption);
+    parser.addOption(maxSessionsOption);
+    parser.addOption(admitRateOption);
+    parser.addOption(readBufferOption);
+    parser.addOption(writeBufferOption);
+    parser.addOption(stackOption);
+    parser.addOption(memoryBudgetOption);
+    parser.addOption(metricsOption);
+    parser.addOption(metricsBindOption);
+    parser.addOption(analyticsOption);
+    parser.addOption(clusterPortOption);
+    parser.addOption(clusterBindOption);
+    parser.addOption(clusterSecretOption);
+    parser.addOption(peersOption);
+    parser.addOption(advertiseOption);
+    parser.addOption(traceOption);
+    parser.addOption(traceSampleOption);
+    parser.process(app);
+
+    if (parser.isSet(traceOption)) {
+        using cs::common::FrameTracer;
+        FrameTracer::setEnabled(true, parser.value(traceSampleOption).toInt());
+        const QString tracePath = parser.value(traceOption);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]() {
+            QString error;
+            const int spans = FrameTracer::exportChromeTrace(tracePath, &error);
+            QTextStream err(stderr);
+            if (spans < 0) {
+                err << QStringLiteral("导出追踪失败：%1").arg(error) << Qt::endl;
+            } else {
+                err << QStringLiteral("已导出 %1 个追踪区间到 %2").arg(spans).arg(tracePath) << Qt::endl;
+            }
+        });
+    }
+
+    if (cs::common::AllocTracker::available()) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+            QTextStream(stderr) << cs::common::AllocTracker::summary() << Qt::endl;
+        });
+    }
+
     ServerWindow window;
+    window.setAcceptorCount(parser.value(acceptorsOption).toInt());
+    window.setHandlerThreads(parser.value(handlerThreadsOption).toInt());
+    window.setSessionThreads(parser.value(sessionThreadsOption).toInt(), !parser.isSet(noRebalanceOption));
+    window.setAdmission(parser.value(maxSessionsOption).toInt(), parser.value(admitRateOption).toInt());
+    SessionLimits limits;
+    limits.readBufferBytes = parser.value(readBufferOption).toLongLong() * 1024;
+    limits.writeBufferBytes = parser.value(writeBufferOption).toLongLong() * 1024;
+    limits.stackBytes = parser.value(stackOption).toLongLong() * 1024;
+    window.setSessionLimits(limits, parser.value(memoryBudgetOption).toLongLong() * 1024 * 1024);
+    QHostAddress metricsAddress;
+    if (parser.isSet(metricsOption) && !metricsAddress.setAddress(parser.value(metricsBindOption))) {
+        QTextStream(stderr) << QStringLiteral("无效的指标端点绑定地址：%1").arg(parser.value(metricsBindOption)) << Qt::endl;
+        return 1;
+    }
+    // 会话线程不加锁地读取统计对象，必须在开始监听之前创建
+    if (parser.isSet(analyticsOption) || parser.isSet(metricsOption)) {
+        window.enableAnalytics();
+    }
+    if (parser.isSet(takeoverOption)) {
+        // 接管失败时退回普通监听，保证服务可用
+        if (!window.takeOver(parser.value(takeoverOption))) {
+            window.startServer(static_cast<quint16>(parser.value(portOption).toUInt()));
+        }
+    } else if (parser.isSet(listenOption)) {
+        window.startServer(static_cast<quint16>(parser.value(portOption).toUInt()));
+    }
+    if (parser.isSet(localOption)) {
+        window.startLocal(parser.value(localOption));
+    }
+    if (parser.isSet(udpOption)) {
+        window.startUdp(static_cast<quint16>(parser.value(udpOption).toUInt()));
+    }
+    if (parser.isSet(metricsOption)) {
+        window.startMetrics(static_cast<quint16>(parser.value(metricsOption).toUInt()), metricsAddress);
+    }
+    if (parser.isSet(clusterPortOption)) {
+        ClusterSettings cluster;
+        cluster.port = static_cast<quint16>(parser.value(clusterPortOption).toUInt());
+        cluster.peers = parser.value(peersOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        cluster.advertiseHost = parser.value(advertiseOption);
+        cluster.secret = parser.value(clusterSecretOption).toUtf8();
+        if (!cluster.bindAddress.setAddress(parser.value(clusterBindOption))) {
+            QTextStream(stderr) << QStringLiteral("无效的集群绑定地址：%1").arg(parser.value(clusterBindOption)) << Qt::endl;
+            return 1;
+        }
+        window.startCluster(cluster);
+    }
+    // 必须在接管完成之后再开放交接通道，旧进程此时已释放该路径
+    if (parser.isSet(handoffOption)) {
+        window.enableHandoff(parser.value(handoffOption), parser.value(drainOption).toInt());
+    }
     window.show();
     return app.exec();
 }
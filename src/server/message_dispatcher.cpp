@@ -0,0 +1,162 @@
+#include "message_dispatcher.hpp"
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+
+#include <chrono>
+
+using namespace cs::protocol;
+
+namespace {
+
+// 单次调度最多连续处理的任务数，超过后先把已有结果投递回去
+constexpr int kResultsPerDelivery = 64;
+
+qint64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void update_max(std::atomic<qint64> &target, qint64 value) {
+    qint64 current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void update_max(std::atomic<int> &target, int value) {
+    int current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void post_results(QObject *receiver, const MessageDispatcher::Delivery &delivery, QVector<RespCode> &results) {
+    if (results.isEmpty()) {
+        return;
+    }
+    if (receiver) {
+        QMetaObject::invokeMethod(receiver, [delivery, batch = std::move(results)]() {
+            delivery(batch);
+        }, Qt::QueuedConnection);
+    }
+    results = QVector<RespCode>();
+}
+
+}  // namespace
+
+void MessageDispatcher::SessionQueue::close() {
+    QMutexLocker locker(&mutex_);
+    // 已入队的任务仍会执行完（保持队列深度统计一致），结果直接丢弃
+    receiver_ = nullptr;
+    delivery_ = nullptr;
+}
+
+MessageDispatcher::MessageDispatcher(int threads) {
+    setThreadCount(threads);
+}
+
+MessageDispatcher::~MessageDispatcher() {
+    pool_.waitForDone();
+}
+
+void MessageDispatcher::registerHandler(MsgType type, MessageHandler handler) {
+    handlers_[static_cast<uint8_t>(type)] = std::move(handler);
+}
+
+bool MessageDispatcher::hasHandler(uint8_t type) const {
+    return static_cast<bool>(handlers_[type]);
+}
+
+void MessageDispatcher::setThreadCount(int threads) {
+    pool_.setMaxThreadCount(threads > 0 ? threads : qMax(1, QThread::idealThreadCount()));
+}
+
+int MessageDispatcher::threadCount() const {
+    return pool_.maxThreadCount();
+}
+
+std::shared_ptr<MessageDispatcher::SessionQueue> MessageDispatcher::openSession(QObject *receiver, Delivery delivery) {
+    auto queue = std::make_shared<SessionQueue>();
+    queue->receiver_ = receiver;
+    queue->delivery_ = std::move(delivery);
+    return queue;
+}
+
+void MessageDispatcher::submit(const std::shared_ptr<SessionQueue> &queue, std::vector<HandlerRequest> requests,
+                               RespCode code) {
+    for (const auto &request : requests) {
+        auto &counters = counters_[static_cast<uint8_t>(request.header.type)];
+        update_max(counters.maxQueueDepth, counters.queueDepth.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+    QMutexLocker locker(&queue->mutex_);
+    queue->jobs_.push_back(SessionQueue::Job{std::move(requests), code, now_ns()});
+    if (queue->scheduled_) {
+        return;  // 该会话已有任务在线程池中执行，由它顺序处理
+    }
+    queue->scheduled_ = true;
+    pool_.start([this, queue]() { drain(queue); });
+}
+
+void MessageDispatcher::drain(const std::shared_ptr<SessionQueue> &queue) {
+    QVector<RespCode> results;
+    while (true) {
+        SessionQueue::Job job;
+        {
+            QMutexLocker locker(&queue->mutex_);
+            if (queue->jobs_.empty() || results.size() >= kResultsPerDelivery) {
+                // 在锁内投递并清除调度标记，保证下一轮调度的结果不会先于本轮到达
+                post_results(queue->receiver_, queue->delivery_, results);
+                if (queue->jobs_.empty()) {
+                    queue->scheduled_ = false;
+                    return;
+                }
+            }
+            job = std::move(queue->jobs_.front());
+            queue->jobs_.pop_front();
+        }
+        results.append(run(job.requests, job.code, job.enqueuedNs));
+    }
+}
+
+RespCode MessageDispatcher::run(const std::vector<HandlerRequest> &requests, RespCode code, qint64 enqueuedNs) {
+    for (const auto &request : requests) {
+        const auto type = static_cast<uint8_t>(request.header.type);
+        auto &counters = counters_[type];
+        const qint64 startNs = now_ns();
+        counters.waitNs.fetch_add(startNs - enqueuedNs, std::memory_order_relaxed);
+        if (const auto &handler = handlers_[type]) {
+            if (handler(request).code != RespCode::Ok) {
+                code = RespCode::Invalid;
+            }
+        }
+        const qint64 elapsedNs = now_ns() - startNs;
+        counters.handlerNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+        update_max(counters.maxHandlerNs, elapsedNs);
+        counters.handled.fetch_add(1, std::memory_order_relaxed);
+        counters.queueDepth.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return code;
+}
+
+std::vector<MessageDispatcher::TypeStats> MessageDispatcher::stats() const {
+    std::vector<TypeStats> out;
+    for (std::size_t type = 0; type < counters_.size(); ++type) {
+        const auto &counters = counters_[type];
+        const quint64 handled = counters.handled.load(std::memory_order_relaxed);
+        const int depth = counters.queueDepth.load(std::memory_order_relaxed);
+        if (handled == 0 && depth == 0) {
+            continue;
+        }
+        TypeStats stats;
+        stats.type = static_cast<uint8_t>(type);
+        stats.handled = handled;
+        stats.queueDepth = depth;
+        stats.maxQueueDepth = counters.maxQueueDepth.load(std::memory_order_relaxed);
+        if (handled > 0) {
+            stats.avgWaitUs = counters.waitNs.load(std::memory_order_relaxed) / 1000.0 / double(handled);
+            stats.avgHandlerUs = counters.handlerNs.load(std::memory_order_relaxed) / 1000.0 / double(handled);
+        }
+        stats.maxHandlerUs = counters.maxHandlerNs.load(std::memory_order_relaxed) / 1000;
+        out.push_back(stats);
+    }
+    return out;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "common/protocol.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct HandlerRequest {
+    QString connectionId;
+    cs::protocol::RequestHeader header;
+    QByteArray payload;  // 完整请求payload，与界面显示共享同一份数据
+
+    QByteArrayView body() const { return QByteArrayView(payload).sliced(cs::protocol::kRequestHeaderBytes); }
+};
+
+struct HandlerResult {
+    cs::protocol::RespCode code = cs::protocol::RespCode::Ok;
+};
+
+// 业务处理函数，在计算线程池中执行，不得访问socket或界面对象
+using MessageHandler = std::function<HandlerResult(const HandlerRequest &request)>;
+
+// 按MsgType注册的业务处理器表。处理在独立线程池中执行，socket读写不会被慢处理器阻塞；
+// 每个会话一个串行队列，同一会话的消息按到达顺序处理并按顺序返回结果。
+class MessageDispatcher {
+public:
+    struct TypeStats {
+        uint8_t type = 0;
+        quint64 handled = 0;
+        int queueDepth = 0;
+        int maxQueueDepth = 0;
+        double avgWaitUs = 0.0;     // 入队到开始处理
+        double avgHandlerUs = 0.0;  // 处理器自身耗时
+        qint64 maxHandlerUs = 0;
+    };
+
+    // 结果按提交顺序成批投递回会话所在线程
+    using Delivery = std::function<void(const QVector<cs::protocol::RespCode> &results)>;
+
+    class SessionQueue;
+
+    explicit MessageDispatcher(int threads = 0);
+    ~MessageDispatcher();
+
+    MessageDispatcher(const MessageDispatcher &) = delete;
+    MessageDispatcher &operator=(const MessageDispatcher &) = delete;
+
+    // 需在会话开始前注册
+    void registerHandler(cs::protocol::MsgType type, MessageHandler handler);
+    bool hasHandler(uint8_t type) const;
+    void setThreadCount(int threads);
+    int threadCount() const;
+
+    // receiver销毁前须调用SessionQueue::close()
+    std::shared_ptr<SessionQueue> openSession(QObject *receiver, Delivery delivery);
+    // 一次提交对应一个结果；批量消息的多条子消息作为一次提交，任一失败则结果为Invalid。
+    // code为预置结果：无需处理器的应答也可以借此排在该会话未完成的任务之后
+    void submit(const std::shared_ptr<SessionQueue> &queue, std::vector<HandlerRequest> requests,
+                cs::protocol::RespCode code = cs::protocol::RespCode::Ok);
+
+    std::vector<TypeStats> stats() const;
+
+private:
+    struct TypeCounters {
+        std::atomic<quint64> handled{0};
+        std::atomic<int> queueDepth{0};
+        std::atomic<int> maxQueueDepth{0};
+        std::atomic<qint64> waitNs{0};
+        std::atomic<qint64> handlerNs{0};
+        std::atomic<qint64> maxHandlerNs{0};
+    };
+
+    void drain(const std::shared_ptr<SessionQueue> &queue);
+    cs::protocol::RespCode run(const std::vector<HandlerRequest> &requests, cs::protocol::RespCode code, qint64 enqueuedNs);
+
+    std::array<MessageHandler, 256> handlers_;
+    std::array<TypeCounters, 256> counters_;
+    QThreadPool pool_;
+};
+
+class MessageDispatcher::SessionQueue {
+public:
+    void close();
+
+private:
+    friend class MessageDispatcher;
+
+    struct Job {
+        std::vector<HandlerRequest> requests;
+        cs::protocol::RespCode code = cs::protocol::RespCode::Ok;
+        qint64 enqueuedNs = 0;
+    };
+
+    QMutex mutex_;
+    std::deque<Job> jobs_;
+    bool scheduled_ = false;
+    QObject *receiver_ = nullptr;
+    MessageDispatcher::Delivery delivery_;
+};
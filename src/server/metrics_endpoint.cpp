@@ -0,0 +1,71 @@
+#include "metrics_endpoint.hpp"
+
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+namespace {
+
+QByteArray http_response(const QByteArray &status, const QByteArray &contentType, const QByteArray &body) {
+    return QByteArrayLiteral("HTTP/1.1 ") + status + QByteArrayLiteral("\r\nContent-Type: ") + contentType +
+           QByteArrayLiteral("\r\nContent-Length: ") + QByteArray::number(body.size()) +
+           QByteArrayLiteral("\r\nConnection: close\r\n\r\n") + body;
+}
+
+}  // namespace
+
+MetricsEndpoint::MetricsEndpoint(std::function<QByteArray()> render, QObject *parent)
+    : QObject(parent), render_(std::move(render)), server_(new QTcpServer(this)) {
+    connect(server_, &QTcpServer::newConnection, this, &MetricsEndpoint::handleNewConnection);
+}
+
+bool MetricsEndpoint::listen(const QHostAddress &address, quint16 port, QString *error) {
+    close();
+    if (!server_->listen(address, port)) {
+        if (error) {
+            *error = server_->errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void MetricsEndpoint::close() {
+    server_->close();
+}
+
+quint16 MetricsEndpoint::port() const {
+    return server_->isListening() ? server_->serverPort() : 0;
+}
+
+void MetricsEndpoint::handleNewConnection() {
+    while (QTcpSocket *socket = server_->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(kRequestTimeoutMs, socket, &QTcpSocket::abort);
+    }
+}
+
+void MetricsEndpoint::handleReadyRead(QTcpSocket *socket) {
+    const QByteArray head = socket->peek(kMaxRequestBytes);
+    if (!head.contains("\r\n\r\n")) {
+        if (head.size() >= kMaxRequestBytes) {
+            socket->abort();
+        }
+        return;
+    }
+    // 只应答一次，之后到达的数据不再处理
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+    const QList<QByteArray> requestLine = head.left(head.indexOf("\r\n")).split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray path = requestLine.value(1);
+    if (method != "GET") {
+        socket->write(http_response("405 Method Not Allowed", "text/plain; charset=utf-8", "only GET\n"));
+    } else if (path == "/metrics" || path.startsWith("/metrics?")) {
+        socket->write(http_response("200 OK", "text/plain; version=0.0.4; charset=utf-8", render_()));
+    } else {
+        socket->write(http_response("404 Not Found", "text/plain; charset=utf-8", "see /metrics\n"));
+    }
+    socket->disconnectFromHost();
+}
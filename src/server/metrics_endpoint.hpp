@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <functional>
+
+class QHostAddress;
+class QTcpServer;
+class QTcpSocket;
+
+// 只读的HTTP指标端点：对 GET /metrics 返回Prometheus文本格式，内容由render在本对象所在线程生成。
+// 每个请求读完请求头即应答并关闭连接，不支持keep-alive；5秒内未发完请求头的连接直接断开。
+class MetricsEndpoint : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsEndpoint(std::function<QByteArray()> render, QObject *parent = nullptr);
+
+    bool listen(const QHostAddress &address, quint16 port, QString *error);
+    void close();
+    quint16 port() const;
+
+private:
+    static constexpr int kMaxRequestBytes = 8 * 1024;
+    static constexpr int kRequestTimeoutMs = 5000;
+
+    void handleNewConnection();
+    void handleReadyRead(QTcpSocket *socket);
+
+    std::function<QByteArray()> render_;
+    QTcpServer *server_;
+};
@@ -0,0 +1,204 @@
+#include "payload_analytics.hpp"
+
+#include <QtCore/QtAlgorithms>
+
+#include <cmath>
+#include <functional>
+
+#include "common/protocol.hpp"
+
+using cs::protocol::MsgType;
+
+namespace {
+
+constexpr quint64 kSessionSeed = 0x5e55104e00000000ULL;
+constexpr quint64 kAddressSeed = 0xadd2e55000000000ULL;
+
+// splitmix64的终混函数，从一个64位哈希派生各行草图的独立下标
+quint64 mix(quint64 x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+std::size_t sketch_index(quint64 key, int row) {
+    const quint64 h = mix(key + 0x9e3779b97f4a7c15ULL * quint64(row + 1));
+    return std::size_t(row) * PayloadAnalytics::kSketchWidth + std::size_t(h % PayloadAnalytics::kSketchWidth);
+}
+
+quint64 hash_bytes(std::string_view bytes) {
+    return mix(static_cast<quint64>(std::hash<std::string_view>{}(bytes)));
+}
+
+int type_slot(uint8_t type) {
+    switch (MsgType(type)) {
+    case MsgType::Text: return 0;
+    case MsgType::Binary: return 1;
+    case MsgType::Batch: return 2;
+    case MsgType::Stream: return 3;
+    case MsgType::Command: return 4;
+    case MsgType::Subscribe: return 5;
+    case MsgType::Unsubscribe: return 6;
+    default: return 7;
+    }
+}
+
+int size_bucket(std::size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    const int log2 = 63 - qCountLeadingZeroBits(quint64(size));
+    return qMin(PayloadAnalytics::kSizeBuckets - 1, log2 + 1);
+}
+
+quint64 estimate(const std::vector<quint64> &sketch, quint64 key) {
+    quint64 best = ~quint64(0);
+    for (int row = 0; row < PayloadAnalytics::kSketchDepth; ++row) {
+        best = qMin(best, sketch[sketch_index(key, row)]);
+    }
+    return best;
+}
+
+}  // namespace
+
+quint64 PayloadAnalytics::TypeStats::sizeQuantile(double q) const {
+    quint64 total = 0;
+    for (const quint64 c : sizes) {
+        total += c;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<quint64>(q * double(total - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < kSizeBuckets; ++i) {
+        seen += sizes[std::size_t(i)];
+        if (seen >= rank) {
+            return i == 0 ? 0 : (quint64(1) << i) - 1;
+        }
+    }
+    return (quint64(1) << (kSizeBuckets - 1)) - 1;
+}
+
+quint64 PayloadAnalytics::Snapshot::estimateFrames(quint64 key) const {
+    return estimate(frames, key);
+}
+
+quint64 PayloadAnalytics::Snapshot::estimateBytes(quint64 key) const {
+    return estimate(bytes, key);
+}
+
+double PayloadAnalytics::Snapshot::distinctPayloads() const {
+    constexpr double m = kHllRegisters;
+    constexpr double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double sum = 0.0;
+    int zeros = 0;
+    for (const uint8_t r : registers) {
+        sum += std::ldexp(1.0, -int(r));
+        zeros += r == 0 ? 1 : 0;
+    }
+    const double raw = alpha * m * m / sum;
+    // 小基数时改用线性计数，误差明显更小
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / double(zeros));
+    }
+    return raw;
+}
+
+quint64 PayloadAnalytics::Snapshot::totalFrames() const {
+    quint64 total = 0;
+    for (const auto &type : types) {
+        total += type.frames;
+    }
+    return total;
+}
+
+PayloadAnalytics::PayloadAnalytics() : stripes_(kStripes) {}
+
+quint64 PayloadAnalytics::sessionKey(std::string_view id) {
+    return hash_bytes(id) ^ kSessionSeed;
+}
+
+quint64 PayloadAnalytics::addressKey(std::string_view address) {
+    return hash_bytes(address) ^ kAddressSeed;
+}
+
+int PayloadAnalytics::stripeFor(quint64 sessionKey) {
+    return int(mix(sessionKey) % kStripes);
+}
+
+uint8_t PayloadAnalytics::slotType(int slot) {
+    static constexpr uint8_t kTypes[kTypeSlots] = {
+        uint8_t(MsgType::Text),    uint8_t(MsgType::Binary),    uint8_t(MsgType::Batch),       uint8_t(MsgType::Stream),
+        uint8_t(MsgType::Command), uint8_t(MsgType::Subscribe), uint8_t(MsgType::Unsubscribe), 0,
+    };
+    return kTypes[slot];
+}
+
+void PayloadAnalytics::record(int stripe, quint64 sessionKey, quint64 addressKey, const char *payload, std::size_t size) {
+    Stripe &s = stripes_[std::size_t(stripe)];
+    for (int row = 0; row < kSketchDepth; ++row) {
+        const std::size_t sessionIndex = sketch_index(sessionKey, row);
+        const std::size_t addressIndex = sketch_index(addressKey, row);
+        s.frames[sessionIndex].fetch_add(1, std::memory_order_relaxed);
+        s.bytes[sessionIndex].fetch_add(size, std::memory_order_relaxed);
+        s.frames[addressIndex].fetch_add(1, std::memory_order_relaxed);
+        s.bytes[addressIndex].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    // 内容去重不看MsgId：同一内容重复发送只计一次
+    const uint8_t type = size > 0 ? uint8_t(payload[0]) : 0;
+    const std::size_t header = std::size_t(cs::protocol::kRequestHeaderBytes);
+    const std::string_view content = size >= header ? std::string_view(payload + header, size - header)
+                                                    : std::string_view(payload, size);
+    const quint64 h = hash_bytes(content) ^ mix(type);
+    const auto index = std::size_t(h >> (64 - kHllBits));
+    const auto rank = uint8_t(qMin(64 - kHllBits, qCountLeadingZeroBits(h << kHllBits)) + 1);
+    std::atomic<uint8_t> &reg = s.registers[index];
+    uint8_t current = reg.load(std::memory_order_relaxed);
+    while (current < rank && !reg.compare_exchange_weak(current, rank, std::memory_order_relaxed)) {
+    }
+
+    const int slot = type_slot(type);
+    s.typeFrames[std::size_t(slot)].fetch_add(1, std::memory_order_relaxed);
+    s.typeBytes[std::size_t(slot)].fetch_add(size, std::memory_order_relaxed);
+    s.typeSizes[std::size_t(slot * kSizeBuckets + size_bucket(size))].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::array<PayloadAnalytics::TypeStats, PayloadAnalytics::kTypeSlots> PayloadAnalytics::typeStats() const {
+    std::array<TypeStats, kTypeSlots> out{};
+    for (int slot = 0; slot < kTypeSlots; ++slot) {
+        out[std::size_t(slot)].type = slotType(slot);
+    }
+    for (const Stripe &s : stripes_) {
+        for (int slot = 0; slot < kTypeSlots; ++slot) {
+            TypeStats &t = out[std::size_t(slot)];
+            t.frames += s.typeFrames[std::size_t(slot)].load(std::memory_order_relaxed);
+            t.bytes += s.typeBytes[std::size_t(slot)].load(std::memory_order_relaxed);
+            for (int b = 0; b < kSizeBuckets; ++b) {
+                t.sizes[std::size_t(b)] += s.typeSizes[std::size_t(slot * kSizeBuckets + b)].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return out;
+}
+
+PayloadAnalytics::Snapshot PayloadAnalytics::snapshot() const {
+    Snapshot out;
+    out.frames.assign(std::size_t(kSketchDepth * kSketchWidth), 0);
+    out.bytes.assign(std::size_t(kSketchDepth * kSketchWidth), 0);
+    for (const Stripe &s : stripes_) {
+        for (std::size_t i = 0; i < out.frames.size(); ++i) {
+            out.frames[i] += s.frames[i].load(std::memory_order_relaxed);
+            out.bytes[i] += s.bytes[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < out.registers.size(); ++i) {
+            out.registers[i] = qMax(out.registers[i], s.registers[i].load(std::memory_order_relaxed));
+        }
+    }
+    out.types = typeStats();
+    return out;
+}
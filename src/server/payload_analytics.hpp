@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// 请求payload的流式统计，内存固定(与会话数、消息数无关)：
+//   - count-min草图按会话/来源地址累计帧数与字节数，用于找出发送最多的会话和地址；
+//   - HyperLogLog估算不同内容(去掉MsgId后)的数量；
+//   - 每种MsgType的帧数、字节数与按2的幂分桶的大小分布。
+// 写入方是各会话线程，按会话固定落在kStripes个分片之一，全部计数为relaxed原子量；
+// 读取方合并各分片(草图按位相加、HLL寄存器取最大)，写入与合并都不加锁。
+class PayloadAnalytics {
+public:
+    static constexpr int kStripes = 8;
+    static constexpr int kSketchDepth = 4;
+    static constexpr int kSketchWidth = 1024;   // 误差上界约为总量的 e/1024 ≈ 0.27%
+    static constexpr int kHllBits = 12;         // 4096个寄存器，标准误差约1.6%
+    static constexpr int kHllRegisters = 1 << kHllBits;
+    static constexpr int kSizeBuckets = 17;     // 0字节、[1,2)、[2,4)…[32K,64K)
+    static constexpr int kTypeSlots = 8;        // 文本、二进制、批量、逻辑流、命令、订阅、取消订阅、其他
+
+    struct TypeStats {
+        uint8_t type = 0;  // 其他类型的槽位为0
+        quint64 frames = 0;
+        quint64 bytes = 0;
+        std::array<quint64, kSizeBuckets> sizes{};
+
+        // 按大小分桶估算分位数(取桶上界)，单位字节；无样本时返回0
+        quint64 sizeQuantile(double q) const;
+    };
+
+    // 各分片合并后的只读副本，可在任意线程上查询
+    struct Snapshot {
+        std::vector<quint64> frames;  // kSketchDepth × kSketchWidth
+        std::vector<quint64> bytes;
+        std::array<uint8_t, kHllRegisters> registers{};
+        std::array<TypeStats, kTypeSlots> types{};
+
+        quint64 estimateFrames(quint64 key) const;
+        quint64 estimateBytes(quint64 key) const;
+        double distinctPayloads() const;
+        quint64 totalFrames() const;
+    };
+
+    PayloadAnalytics();
+
+    // 草图的键：会话与地址使用不同前缀，二者共用同一组草图
+    static quint64 sessionKey(std::string_view id);
+    static quint64 addressKey(std::string_view address);
+    static int stripeFor(quint64 sessionKey);
+
+    // 会话线程调用；payload为完整请求payload(MsgType + MsgId + Body)
+    void record(int stripe, quint64 sessionKey, quint64 addressKey, const char *payload, std::size_t size);
+
+    Snapshot snapshot() const;
+    // 只合并按类型的计数，供每秒采样计算速率，不复制草图
+    std::array<TypeStats, kTypeSlots> typeStats() const;
+
+    static uint8_t slotType(int slot);
+
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<quint64>, kSketchDepth * kSketchWidth> frames{};
+        std::array<std::atomic<quint64>, kSketchDepth * kSketchWidth> bytes{};
+        std::array<std::atomic<uint8_t>, kHllRegisters> registers{};
+        std::array<std::atomic<quint64>, kTypeSlots> typeFrames{};
+        std::array<std::atomic<quint64>, kTypeSlots> typeBytes{};
+        std::array<std::atomic<quint64>, kTypeSlots * kSizeBuckets> typeSizes{};
+    };
+
+    std::vector<Stripe> stripes_;
+};
@@ -0,0 +1,170 @@
+#include "rate_controller.hpp"
+
+#include <QtCore/QThread>
+
+#include <cmath>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "message_dispatcher.hpp"
+
+namespace {
+
+// 进程累计CPU时间(用户态+内核态)，毫秒
+qint64 process_cpu_ms() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return -1;
+    }
+    const auto to100ns = [](const FILETIME &ft) {
+        return (static_cast<qint64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    return (to100ns(kernel) + to100ns(user)) / 10000;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return (static_cast<qint64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#endif
+}
+
+}  // namespace
+
+RateController::RateController(std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent)
+    : QObject(parent),
+      runtimeConfig_(std::move(runtime)) {
+    timer_.setTimerType(Qt::PreciseTimer);
+    timer_.setInterval(settings_.tickMs);
+    connect(&timer_, &QTimer::timeout, this, &RateController::tick);
+    clock_.start();
+}
+
+void RateController::setEnabled(bool enabled) {
+    if (enabled_ == enabled) {
+        return;
+    }
+    enabled_ = enabled;
+    runtimeConfig_->adaptiveInterval = enabled;
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        it->targetRate = 0.0;
+        it->pushedMs = 0;
+        it->metrics->targetIntervalMs = 0;
+        it->lastFrames = it->metrics->framesIn.load(std::memory_order_relaxed);
+    }
+    // 未启用时不采样；重新启用时从当前时刻起算，停止期间不计作循环延迟、CPU与速率
+    if (enabled_) {
+        lastTickMs_ = clock_.elapsed();
+        sampleCpu(0);
+        timer_.start();
+    } else {
+        timer_.stop();
+    }
+}
+
+bool RateController::isEnabled() const {
+    return enabled_;
+}
+
+void RateController::setSettings(const Settings &settings) {
+    settings_ = settings;
+    timer_.setInterval(settings_.tickMs);
+}
+
+RateController::Settings RateController::settings() const {
+    return settings_;
+}
+
+void RateController::addSession(const QString &id, std::shared_ptr<SessionMetrics> metrics) {
+    Tracked session;
+    session.lastFrames = metrics->framesIn.load(std::memory_order_relaxed);
+    session.metrics = std::move(metrics);
+    sessions_.insert(id, std::move(session));
+}
+
+void RateController::removeSession(const QString &id) {
+    sessions_.remove(id);
+}
+
+double RateController::sampleCpu(qint64 wallMs) {
+    const qint64 cpuMs = process_cpu_ms();
+    double cpu = 0.0;
+    if (cpuMs >= 0 && lastCpuMs_ >= 0 && wallMs > 0) {
+        cpu = double(cpuMs - lastCpuMs_) / double(wallMs) / double(qMax(1, QThread::idealThreadCount()));
+    }
+    lastCpuMs_ = cpuMs;
+    return cpu;
+}
+
+void RateController::tick() {
+    const qint64 now = clock_.elapsed();
+    const qint64 wallMs = now - lastTickMs_;
+    lastTickMs_ = now;
+    if (wallMs <= 0) {
+        return;
+    }
+
+    LoadSample sample;
+    // 定时器的迟到时间即界面线程事件循环的排队延迟
+    sample.loopLagMs = qMax<double>(0.0, double(wallMs - settings_.tickMs));
+    if (runtimeConfig_->dispatcher) {
+        for (const auto &stats : runtimeConfig_->dispatcher->stats()) {
+            sample.queueDepth += stats.queueDepth;
+        }
+    }
+    sample.cpu = sampleCpu(wallMs);
+    sample.load = qMax(sample.loopLagMs / settings_.lagBudgetMs,
+                       qMax(double(sample.queueDepth) / settings_.queueBudget, sample.cpu / settings_.cpuBudget));
+
+    const double seconds = wallMs / 1000.0;
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        const quint64 frames = it->metrics->framesIn.load(std::memory_order_relaxed);
+        it->rate = double(frames - it->lastFrames) / seconds;
+        it->lastFrames = frames;
+        sample.totalRate += it->rate;
+    }
+    sample.sessions = static_cast<int>(sessions_.size());
+
+    if (enabled_ && !sessions_.isEmpty()) {
+        const double ceilingRate = 1000.0 / qMax(1, settings_.minIntervalMs);
+        const double floorRate = 1000.0 / qMax(1, settings_.maxIntervalMs);
+        const double fairRate = sample.totalRate / sessions_.size();
+        const bool overloaded = sample.load > 1.0;
+        for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+            Tracked &session = *it;
+            if (session.targetRate <= 0.0) {
+                session.targetRate = ceilingRate;
+            }
+            if (overloaded) {
+                // 只压低贡献了主要负载的会话，低速会话保持不变
+                if (session.rate >= fairRate * 0.5) {
+                    session.targetRate *= settings_.decreaseFactor;
+                }
+            } else if (sample.load < settings_.recoverBelow) {
+                session.targetRate += settings_.increasePerTick;
+            }
+            session.targetRate = qBound(floorRate, session.targetRate, ceilingRate);
+            const int intervalMs = static_cast<int>(std::lround(1000.0 / session.targetRate));
+            if (session.pushedMs == 0 ||
+                std::abs(intervalMs - session.pushedMs) >= session.pushedMs * settings_.pushThreshold) {
+                push(it.key(), session, intervalMs);
+            }
+        }
+    }
+
+    sample.pushes = pushes_;
+    emit loadSampled(sample);
+}
+
+void RateController::push(const QString &id, Tracked &session, int intervalMs) {
+    session.pushedMs = intervalMs;
+    session.metrics->targetIntervalMs = intervalMs;
+    ++pushes_;
+    emit intervalChanged(id, intervalMs);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "server_runtime.hpp"
+#include "session_metrics.hpp"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <memory>
+
+// 负载感知的发送间隔控制：周期采样事件循环延迟、业务队列深度与进程CPU，
+// 按AIMD在速率域上为每个会话计算目标间隔（过载时乘性降低高于平均水平的会话速率，
+// 负载回落后加性恢复），目标变化时发出intervalChanged，由Listener交给会话立即下发CmdId=0x01，
+// 而不是等待下一次ACK。未启用时定时器停止，不做任何采样。
+class RateController : public QObject {
+    Q_OBJECT
+
+public:
+    struct Settings {
+        int tickMs = 500;
+        int minIntervalMs = 500;  // 负载再低也不快于该间隔
+        int maxIntervalMs = 60000;
+        double increasePerTick = 0.2;  // 未过载时每周期增加的速率(条/秒)
+        double decreaseFactor = 0.5;   // 过载时速率乘以该系数
+        double recoverBelow = 0.7;     // 负载低于该值才开始加性恢复
+        int lagBudgetMs = 50;
+        int queueBudget = 2000;
+        double cpuBudget = 0.85;
+        double pushThreshold = 0.05;   // 目标变化超过5%才下发，避免抖动
+    };
+
+    struct LoadSample {
+        double loopLagMs = 0.0;
+        int queueDepth = 0;
+        double cpu = 0.0;   // 进程CPU占用(0~1，按核数归一)，平台不支持时为0
+        double load = 0.0;  // 各项相对预算的最大值，>1视为过载
+        double totalRate = 0.0;
+        int sessions = 0;
+        quint64 pushes = 0;
+    };
+
+    explicit RateController(std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent = nullptr);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    void setSettings(const Settings &settings);
+    Settings settings() const;
+
+    void addSession(const QString &id, std::shared_ptr<SessionMetrics> metrics);
+    void removeSession(const QString &id);
+
+signals:
+    void loadSampled(const RateController::LoadSample &sample);
+    void intervalChanged(const QString &id, int intervalMs);
+
+private slots:
+    void tick();
+
+private:
+    struct Tracked {
+        std::shared_ptr<SessionMetrics> metrics;
+        quint64 lastFrames = 0;
+        double rate = 0.0;
+        double targetRate = 0.0;
+        int pushedMs = 0;
+    };
+
+    double sampleCpu(qint64 wallMs);
+    void push(const QString &id, Tracked &session, int intervalMs);
+
+    std::shared_ptr<ServerRuntimeConfig> runtimeConfig_;
+    Settings settings_;
+    QTimer timer_;
+    QElapsedTimer clock_;
+    qint64 lastTickMs_ = 0;
+    qint64 lastCpuMs_ = -1;
+    bool enabled_ = false;
+    quint64 pushes_ = 0;
+    QHash<QString, Tracked> sessions_;
+};
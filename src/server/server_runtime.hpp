@@ -1,8 +1,38 @@
 #pragma once
 
+#include <QtCore/QtGlobal>
+
 #include <atomic>
+#include <memory>
+
+class AdmissionControl;
+class BroadcastHub;
+class ClusterRouter;
+class MessageDispatcher;
+class PayloadAnalytics;
+struct ServerCounters;
 
 struct ServerRuntimeConfig {
     std::atomic<bool> intervalControl{false};
     std::atomic<int> forcedIntervalMs{3000};
+    // 开启后由RateController按负载逐会话调整间隔，ACK携带各会话自己的目标值
+    std::atomic<bool> adaptiveInterval{false};
+    // 停机截止时间(QDeadlineTimer::deadline()毫秒值)，0表示使用会话默认的1秒等待
+    std::atomic<qint64> drainDeadlineMs{0};
+    // 按MsgType分发的业务处理器，所有会话共享同一个计算线程池
+    std::shared_ptr<MessageDispatcher> dispatcher;
+    // 广播/主题订阅，推送帧编码一次后共享给所有接收会话
+    std::shared_ptr<BroadcastHub> broadcast;
+    // 全服务器累计计数，Listener每秒采样一次写入时间序列
+    std::shared_ptr<ServerCounters> counters;
+    // 请求payload的流式统计(热点会话/地址、内容去重、按类型的速率与大小分布)，为空时不统计
+    std::shared_ptr<PayloadAnalytics> analytics;
+    // 在线会话上限与重连时间片分配，所有接入路径共享
+    std::shared_ptr<AdmissionControl> admission;
+    // 集群中客户端标识(MsgType=0x13)的归属节点，未组成集群时所有客户端都留在本节点
+    std::shared_ptr<ClusterRouter> cluster;
+    // 单会话缓冲上限(字节，0为不限)：传输接收缓冲、写缓冲(超出后暂停读取)、解析器空闲时保留的容量
+    std::atomic<qint64> sessionReadBufferBytes{0};
+    std::atomic<qint64> sessionWriteBufferBytes{0};
+    std::atomic<qint64> sessionParserBytes{64 * 1024};
 };
@@ -0,0 +1,106 @@
+#include "server_stats.hpp"
+
+#include <QtCore/QtAlgorithms>
+
+namespace {
+
+int bucket_of(quint64 us) {
+    if (us < 4) {
+        return static_cast<int>(us);
+    }
+    const int octave = 63 - qCountLeadingZeroBits(us);  // >= 2
+    const int sub = static_cast<int>((us >> (octave - 2)) & 3);
+    return qMin(LatencyHistogram::kBuckets - 1, 4 + (octave - 2) * 4 + sub);
+}
+
+}  // namespace
+
+void LatencyHistogram::record(qint64 ns) {
+    const quint64 us = ns > 0 ? static_cast<quint64>(ns) / 1000 : 0;
+    buckets_[static_cast<std::size_t>(bucket_of(us))].fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Counts LatencyHistogram::counts() const {
+    Counts out{};
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        out[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+quint64 LatencyHistogram::bucketUpperUs(int bucket) {
+    if (bucket < 4) {
+        return static_cast<quint64>(bucket) + 1;
+    }
+    const int octave = (bucket - 4) / 4 + 2;
+    const int sub = (bucket - 4) % 4;
+    return (quint64(4 + sub + 1)) << (octave - 2);
+}
+
+double LatencyHistogram::quantileUs(const Counts &counts, double q) {
+    quint64 total = 0;
+    for (const quint64 c : counts) {
+        total += c;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    const auto rank = static_cast<quint64>(q * double(total - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts[static_cast<std::size_t>(i)];
+        if (seen >= rank) {
+            return double(bucketUpperUs(i));
+        }
+    }
+    return double(bucketUpperUs(kBuckets - 1));
+}
+
+MetricsTimeline::MetricsTimeline(int capacity) : ring_(static_cast<std::size_t>(qMax(1, capacity))) {}
+
+void MetricsTimeline::sample(const ServerCounters &counters, int sessions, qint64 timestampMs, qint64 elapsedMs) {
+    const quint64 frames = counters.framesIn.load(std::memory_order_relaxed);
+    const quint64 bytes = counters.bytesIn.load(std::memory_order_relaxed);
+    const quint64 errors = counters.errors.load(std::memory_order_relaxed);
+    const quint64 acks = counters.acks.load(std::memory_order_relaxed);
+    const LatencyHistogram::Counts latency = counters.ackLatency.counts();
+
+    const double seconds = qMax<qint64>(1, elapsedMs) / 1000.0;
+    LatencyHistogram::Counts delta{};
+    for (std::size_t i = 0; i < delta.size(); ++i) {
+        delta[i] = latency[i] - lastLatency_[i];
+    }
+
+    Sample &s = ring_[static_cast<std::size_t>(head_)];
+    s.timestampMs = timestampMs;
+    s.framesPerSec = double(frames - lastFrames_) / seconds;
+    s.bytesPerSec = double(bytes - lastBytes_) / seconds;
+    s.errorsPerSec = double(errors - lastErrors_) / seconds;
+    s.acksPerSec = double(acks - lastAcks_) / seconds;
+    s.sessions = sessions;
+    s.p50Us = LatencyHistogram::quantileUs(delta, 0.50);
+    s.p90Us = LatencyHistogram::quantileUs(delta, 0.90);
+    s.p99Us = LatencyHistogram::quantileUs(delta, 0.99);
+
+    head_ = (head_ + 1) % static_cast<int>(ring_.size());
+    size_ = qMin(size_ + 1, static_cast<int>(ring_.size()));
+    lastFrames_ = frames;
+    lastBytes_ = bytes;
+    lastErrors_ = errors;
+    lastAcks_ = acks;
+    lastLatency_ = latency;
+}
+
+std::vector<MetricsTimeline::Sample> MetricsTimeline::snapshot() const {
+    std::vector<Sample> out;
+    out.reserve(static_cast<std::size_t>(size_));
+    const int capacity = static_cast<int>(ring_.size());
+    for (int i = 0; i < size_; ++i) {
+        out.push_back(ring_[static_cast<std::size_t>((head_ - size_ + i + capacity) % capacity)]);
+    }
+    return out;
+}
+
+int MetricsTimeline::capacity() const {
+    return static_cast<int>(ring_.size());
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "common/send_queue.hpp"
+
+// ACK延迟直方图：对数分桶(每倍程4个子桶，128个桶覆盖0~2^33µs，约2.4小时，更大的值计入最后一个桶)，
+// 会话线程无锁记录。
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 128;
+    using Counts = std::array<quint64, kBuckets>;
+
+    void record(qint64 ns);
+    Counts counts() const;
+
+    // 按分桶计数估算分位数(取桶上界)，单位微秒；无样本时返回0
+    static double quantileUs(const Counts &counts, double q);
+    static quint64 bucketUpperUs(int bucket);
+
+private:
+    std::array<std::atomic<quint64>, kBuckets> buckets_{};
+};
+
+// 全服务器的累计计数，所有会话共享；由MetricsTimeline按秒取差值
+struct ServerCounters {
+    std::atomic<quint64> framesIn{0};
+    std::atomic<quint64> bytesIn{0};
+    std::atomic<quint64> errors{0};
+    std::atomic<quint64> acks{0};
+    LatencyHistogram ackLatency;  // 读到请求到写出对应ACK
+    // 各发送优先级在会话发送队列中的排队时间，按cs::common::SendPriority下标；不含已交给传输层、
+    // 排在前面的数据(Bulk水位，默认至多约16KB)的发送时间，见SendQueue
+    std::array<LatencyHistogram, cs::common::kSendPriorityCount> sendQueueWait;
+};
+
+// 每秒一个点的固定容量环形时间序列。界面按固定频率读取已聚合的数据，不依赖逐帧信号。
+class MetricsTimeline {
+public:
+    static constexpr int kDefaultSeconds = 300;
+
+    struct Sample {
+        qint64 timestampMs = 0;
+        double framesPerSec = 0.0;
+        double bytesPerSec = 0.0;
+        double errorsPerSec = 0.0;
+        double acksPerSec = 0.0;
+        int sessions = 0;
+        double p50Us = 0.0;
+        double p90Us = 0.0;
+        double p99Us = 0.0;
+    };
+
+    explicit MetricsTimeline(int capacity = kDefaultSeconds);
+
+    // 以counters自上次采样以来的增量追加一个点，elapsedMs为两次采样的实际间隔
+    void sample(const ServerCounters &counters, int sessions, qint64 timestampMs, qint64 elapsedMs);
+    // 按时间先后返回环中的全部点
+    std::vector<Sample> snapshot() const;
+    int capacity() const;
+
+private:
+    std::vector<Sample> ring_;
+    int head_ = 0;  // 下一个写入位置
+    int size_ = 0;
+    quint64 lastFrames_ = 0;
+    quint64 lastBytes_ = 0;
+    quint64 lastErrors_ = 0;
+    quint64 lastAcks_ = 0;
+    LatencyHistogram::Counts lastLatency_{};
+};
@@ -1,18 +1,31 @@
 #include "server_window.hpp"
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
 #include <QtWidgets/QCheckBox>
+#include <QtWidgets/QComboBox>
 #include <QtWidgets/QFormLayout>
 #include <QtWidgets/QGridLayout>
 #include <QtWidgets/QGroupBox>
+#include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QHeaderView>
 #include <QtWidgets/QLabel>
-#include <QtWidgets/QPlainTextEdit>
+#include <QtWidgets/QLineEdit>
+#include <QtWidgets/QListView>
+#include <QtWidgets/QScrollBar>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QSpinBox>
 #include <QtWidgets/QTableView>
 #include <QtWidgets/QVBoxLayout>
 
+#include <algorithm>
+#include <utility>
+
+#include "common/alloc_tracker.hpp"
+#include "common/protocol.hpp"
+
 namespace {
 
 struct PayloadSummary {
@@ -23,10 +36,11 @@ struct PayloadSummary {
 
 PayloadSummary summarizePayload(const QByteArray &payload) {
     PayloadSummary summary;
-    if (payload.size() >= 3) {
-        summary.type = static_cast<quint8>(payload.at(0));
-        summary.msgId = (static_cast<quint8>(payload.at(1)) << 8) | static_cast<quint8>(payload.at(2));
-        summary.content = payload.mid(3);
+    cs::protocol::RequestHeader header;
+    if (cs::protocol::decode_request_header(payload.constData(), payload.size(), &header)) {
+        summary.type = static_cast<quint8>(header.type);
+        summary.msgId = header.msgId;
+        summary.content = payload.mid(cs::protocol::kRequestHeaderBytes);
     } else {
         summary.content = payload;
     }
@@ -78,18 +92,59 @@ ServerWindow::ServerWindow(QWidget *parent)
         "QTableView::item:selected { background-color: #0078d7; color: white; }"
     );
 
-    // 日志视图 - 改进显示
-    logView_ = new QPlainTextEdit(central);
-    logView_->setReadOnly(true);
-    logView_->setMaximumBlockCount(1000);
+    // 日志视图：环形缓冲模型 + 等高行的虚拟化列表，只绘制可见行
+    logModel_ = new cs::common::LogModel(cs::common::LogModel::kDefaultCapacity, this);
+    logView_ = new QListView(central);
+    logView_->setModel(logModel_);
+    logView_->setUniformItemSizes(true);
+    logView_->setLayoutMode(QListView::Batched);
+    logView_->setEditTriggers(QListView::NoEditTriggers);
+    logView_->setSelectionMode(QListView::ExtendedSelection);
     logView_->setMinimumHeight(150);
     logView_->setStyleSheet(
-        "QPlainTextEdit { "
+        "QListView { "
         "   background-color: #f5f5f5; "
         "   font-family: 'Consolas', 'Courier New', monospace; "
         "   font-size: 9pt; "
         "}"
     );
+    connect(logView_->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        followLog_ = value == logView_->verticalScrollBar()->maximum();
+    });
+    connect(logModel_, &cs::common::LogModel::rowsAppended, this, [this]() {
+        if (followLog_) {
+            logView_->scrollToBottom();
+        }
+    });
+
+    // 日志过滤：级别、分类、会话ID前缀与内容搜索
+    logLevelCombo_ = new QComboBox(central);
+    logLevelCombo_->addItem(tr("全部级别"), int(cs::common::LogLevel::Debug));
+    logLevelCombo_->addItem(tr("警告及以上"), int(cs::common::LogLevel::Warn));
+    logLevelCombo_->addItem(tr("仅错误"), int(cs::common::LogLevel::Error));
+    logCategoryCombo_ = new QComboBox(central);
+    logCategoryCombo_->addItem(tr("全部分类"));
+    connect(logModel_, &cs::common::LogModel::categoryAdded, logCategoryCombo_,
+            [this](const QString &category) { logCategoryCombo_->addItem(category); });
+    logSessionEdit_ = new QLineEdit(central);
+    logSessionEdit_->setPlaceholderText(tr("会话ID前缀"));
+    logSearchEdit_ = new QLineEdit(central);
+    logSearchEdit_->setPlaceholderText(tr("搜索日志内容"));
+    logSearchEdit_->setClearButtonEnabled(true);
+    auto *logFilterLayout = new QHBoxLayout;
+    logFilterLayout->addWidget(new QLabel(tr("运行日志:"), central));
+    logFilterLayout->addWidget(logLevelCombo_);
+    logFilterLayout->addWidget(logCategoryCombo_);
+    logFilterLayout->addWidget(logSessionEdit_);
+    logFilterLayout->addWidget(logSearchEdit_, 1);
+    connect(logLevelCombo_, qOverload<int>(&QComboBox::currentIndexChanged), this, &ServerWindow::applyLogFilter);
+    connect(logCategoryCombo_, qOverload<int>(&QComboBox::currentIndexChanged), this, &ServerWindow::applyLogFilter);
+    logFilterTimer_ = new QTimer(this);
+    logFilterTimer_->setSingleShot(true);
+    logFilterTimer_->setInterval(kLogFilterDebounceMs);
+    connect(logFilterTimer_, &QTimer::timeout, this, &ServerWindow::applyLogFilter);
+    connect(logSessionEdit_, &QLineEdit::textChanged, logFilterTimer_, qOverload<>(&QTimer::start));
+    connect(logSearchEdit_, &QLineEdit::textChanged, logFilterTimer_, qOverload<>(&QTimer::start));
 
     // 端口设置
     portSpin_ = new QSpinBox(central);
@@ -97,6 +152,12 @@ ServerWindow::ServerWindow(QWidget *parent)
     portSpin_->setValue(8080);
     portSpin_->setMinimumWidth(120);
 
+    acceptorSpin_ = new QSpinBox(central);
+    acceptorSpin_->setRange(1, 64);
+    acceptorSpin_->setValue(1);
+    acceptorSpin_->setMinimumWidth(120);
+    acceptorSpin_->setToolTip(tr("大于1时使用SO_REUSEPORT在同一端口开启多个接收线程,会话留在各自线程处理"));
+
     startBtn_ = new QPushButton(tr("启动服务器"), central);
     startBtn_->setMinimumWidth(120);
     startBtn_->setStyleSheet("QPushButton { font-weight: bold; padding: 8px; }");
@@ -117,6 +178,10 @@ ServerWindow::ServerWindow(QWidget *parent)
     intervalSpin_->setEnabled(false);
     intervalSpin_->setMinimumWidth(120);
 
+    adaptiveCheck_ = new QCheckBox(tr("按负载自适应调节(AIMD)"), central);
+    adaptiveCheck_->setToolTip(tr("根据事件循环延迟、业务队列深度和CPU占用逐个连接调整间隔,目标间隔作为最短间隔"));
+    loadLabel_ = new QLabel(tr("负载: -"), central);
+
     // 控制面板组 - 改进布局
     auto *controlGroup = new QGroupBox(tr("服务器控制面板"), central);
     auto *controlLayout = new QGridLayout(controlGroup);
@@ -130,6 +195,10 @@ ServerWindow::ServerWindow(QWidget *parent)
     controlLayout->addWidget(statusLabel, 1, 0);
     controlLayout->addWidget(statusIndicator_, 1, 1);
     controlLayout->addWidget(statusLabel_, 1, 2, 1, 2);
+
+    auto *acceptorLabel = new QLabel(tr("接收线程数:"), controlGroup);
+    controlLayout->addWidget(acceptorLabel, 2, 0);
+    controlLayout->addWidget(acceptorSpin_, 2, 1);
     controlLayout->setColumnStretch(3, 1);
 
     // 间隔控制组 - 改进布局
@@ -138,32 +207,103 @@ ServerWindow::ServerWindow(QWidget *parent)
     intervalLayout->addWidget(intervalCheck_, 0, 0, 1, 2);
     intervalLayout->addWidget(new QLabel(tr("目标间隔:"), intervalGroup), 1, 0);
     intervalLayout->addWidget(intervalSpin_, 1, 1);
+    intervalLayout->addWidget(adaptiveCheck_, 2, 0, 1, 2);
+    intervalLayout->addWidget(loadLabel_, 2, 2);
     intervalLayout->setColumnStretch(2, 1);
 
+    // 消息推送：主题为空时推送给所有连接
+    auto *publishGroup = new QGroupBox(tr("消息推送"), central);
+    auto *publishLayout = new QGridLayout(publishGroup);
+    topicEdit_ = new QLineEdit(publishGroup);
+    topicEdit_->setPlaceholderText(tr("留空表示广播给所有连接"));
+    broadcastEdit_ = new QLineEdit(publishGroup);
+    broadcastEdit_->setPlaceholderText(tr("推送内容"));
+    publishBtn_ = new QPushButton(tr("推送"), publishGroup);
+    publishLayout->addWidget(new QLabel(tr("主题:"), publishGroup), 0, 0);
+    publishLayout->addWidget(topicEdit_, 0, 1);
+    publishLayout->addWidget(new QLabel(tr("内容:"), publishGroup), 0, 2);
+    publishLayout->addWidget(broadcastEdit_, 0, 3);
+    publishLayout->addWidget(publishBtn_, 0, 4);
+    publishLayout->setColumnStretch(3, 1);
+    connect(publishBtn_, &QPushButton::clicked, this, &ServerWindow::handlePublish);
+    connect(broadcastEdit_, &QLineEdit::returnPressed, this, &ServerWindow::handlePublish);
+
+    // 业务处理统计：按MsgType显示处理量、队列深度与耗时
+    auto *handlerGroup = new QGroupBox(tr("业务处理统计"), central);
+    auto *handlerLayout = new QVBoxLayout(handlerGroup);
+    handlerStatsLabel_ = new QLabel(tr("暂无数据"), handlerGroup);
+    handlerStatsLabel_->setStyleSheet("QLabel { font-family: 'Consolas', 'Courier New', monospace; font-size: 9pt; }");
+    handlerLayout->addWidget(handlerStatsLabel_);
+    udpStatsLabel_ = new QLabel(handlerGroup);
+    udpStatsLabel_->setStyleSheet(handlerStatsLabel_->styleSheet());
+    udpStatsLabel_->hide();  // 开启UDP遥测后显示
+    handlerLayout->addWidget(udpStatsLabel_);
+    analyticsLabel_ = new QLabel(handlerGroup);
+    analyticsLabel_->setStyleSheet(handlerStatsLabel_->styleSheet());
+    analyticsLabel_->hide();  // 收到第一条请求后显示
+    handlerLayout->addWidget(analyticsLabel_);
+    clusterLabel_ = new QLabel(handlerGroup);
+    clusterLabel_->setStyleSheet(handlerStatsLabel_->styleSheet());
+    clusterLabel_->hide();  // 加入集群后显示
+    handlerLayout->addWidget(clusterLabel_);
+    sessionPoolLabel_ = new QLabel(handlerGroup);
+    sessionPoolLabel_->setStyleSheet(handlerStatsLabel_->styleSheet());
+    sessionPoolLabel_->hide();  // 会话线程池启动后显示
+    handlerLayout->addWidget(sessionPoolLabel_);
+
+    // 运行趋势：读取Listener每秒聚合好的时间序列，界面刷新与收包频率无关
+    auto *chartGroup = new QGroupBox(tr("运行趋势(最近%1秒)").arg(listener_->timelineCapacity()), central);
+    auto *chartLayout = new QHBoxLayout(chartGroup);
+    throughputChart_ = new TimeSeriesChart(tr("吞吐"), tr("帧/秒"), chartGroup);
+    trafficChart_ = new TimeSeriesChart(tr("流量与错误"), tr("/秒"), chartGroup);
+    latencyChart_ = new TimeSeriesChart(tr("ACK延迟"), tr("µs"), chartGroup);
+    chartLayout->addWidget(throughputChart_);
+    chartLayout->addWidget(trafficChart_);
+    chartLayout->addWidget(latencyChart_);
+
+    statsTimer_ = new QTimer(this);
+    statsTimer_->setInterval(1000);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshHandlerStats);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshUdpStats);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshAnalytics);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshCluster);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshSessionPool);
+    connect(statsTimer_, &QTimer::timeout, this, &ServerWindow::refreshCharts);
+    statsTimer_->start();
+
     // 主布局
     auto *layout = new QVBoxLayout;
     layout->addWidget(controlGroup);
     layout->addWidget(intervalGroup);
+    layout->addWidget(publishGroup);
+    layout->addWidget(handlerGroup);
+    layout->addWidget(chartGroup);
     layout->addWidget(new QLabel(tr("活动连接列表:"), central));
     layout->addWidget(connectionView_, 2);
-    layout->addWidget(new QLabel(tr("运行日志:"), central));
+    layout->addLayout(logFilterLayout);
     layout->addWidget(logView_, 3);
     layout->setSpacing(10);
     layout->setContentsMargins(10, 10, 10, 10);
     central->setLayout(layout);
 
     setWindowTitle(tr("C/S 服务器监控系统"));
-    resize(1000, 700);
+    resize(1100, 860);
 
     connect(startBtn_, &QPushButton::clicked, this, &ServerWindow::handleStartStop);
     connect(intervalCheck_, &QCheckBox::toggled, this, &ServerWindow::updateIntervalSettings);
     connect(intervalSpin_, qOverload<int>(&QSpinBox::valueChanged), this, &ServerWindow::updateIntervalSettings);
+    connect(adaptiveCheck_, &QCheckBox::toggled, this, [this](bool checked) {
+        intervalSpin_->setEnabled(checked || intervalCheck_->isChecked());
+        updateIntervalSettings();
+    });
 
     connect(listener_, &Listener::connectionUpdated, this, &ServerWindow::handleConnectionUpdated);
     connect(listener_, &Listener::connectionClosed, this, &ServerWindow::handleConnectionClosed);
     connect(listener_, &Listener::frameReceived, this, &ServerWindow::handleFrameReceived);
     connect(listener_, &Listener::invalidPacket, this, &ServerWindow::handleInvalidPacket);
     connect(listener_, &Listener::logMessage, this, &ServerWindow::handleLogMessage);
+    connect(listener_, &Listener::loadSampled, this, &ServerWindow::handleLoadSampled);
+    connect(listener_, &Listener::sessionIntervalChanged, model_, &ConnectionModel::setInterval);
     connect(listener_, &Listener::listening, this, [this](quint16 port) {
         appendLog(tr("[系统] 服务器已启动,监听端口: %1").arg(port));
         refreshUiState();
@@ -172,27 +312,315 @@ ServerWindow::ServerWindow(QWidget *parent)
         appendLog(tr("[系统] 服务器已停止"));
         refreshUiState();
     });
+    connect(listener_, &Listener::handedOff, this, [this]() {
+        appendLog(tr("[系统] 已完成热重启交接,本进程退出"));
+        QCoreApplication::quit();
+    });
     
     connect(intervalCheck_, &QCheckBox::toggled, [this](bool checked) {
-        intervalSpin_->setEnabled(checked);
+        intervalSpin_->setEnabled(checked || adaptiveCheck_->isChecked());
         updateIntervalSettings();
     });
 
     appendLog(tr("[系统] 服务器监控系统已就绪"));
 }
 
+void ServerWindow::setAcceptorCount(int count) {
+    acceptorSpin_->setValue(count);
+}
+
+void ServerWindow::setHandlerThreads(int threads) {
+    listener_->setHandlerThreads(threads);
+}
+
+void ServerWindow::setSessionThreads(int threads, bool rebalance) {
+    listener_->setSessionThreads(threads);
+    listener_->setSessionRebalancing(rebalance);
+}
+
+void ServerWindow::setAdmission(int maxSessions, int admitPerSec) {
+    listener_->setAdmissionLimit(maxSessions);
+    listener_->setAdmitRate(admitPerSec);
+}
+
+void ServerWindow::setSessionLimits(const SessionLimits &limits, qint64 memoryBudgetBytes) {
+    listener_->setSessionLimits(limits);
+    listener_->setMemoryBudget(memoryBudgetBytes);
+}
+
+void ServerWindow::refreshHandlerStats() {
+    const auto stats = listener_->handlerStats();
+    if (stats.empty()) {
+        return;
+    }
+    QStringList lines;
+    for (const auto &entry : stats) {
+        lines.append(tr("类型0x%1 | 已处理 %2 | 队列 %3 (峰值 %4) | 平均等待 %5 µs | 平均处理 %6 µs (最大 %7 µs)")
+                         .arg(QString::number(entry.type, 16).rightJustified(2, QLatin1Char('0')))
+                         .arg(entry.handled)
+                         .arg(entry.queueDepth)
+                         .arg(entry.maxQueueDepth)
+                         .arg(entry.avgWaitUs, 0, 'f', 1)
+                         .arg(entry.avgHandlerUs, 0, 'f', 1)
+                         .arg(entry.maxHandlerUs));
+    }
+    const AdmissionControl &admission = listener_->admission();
+    if (admission.limit() > 0 || admission.rejected() > 0) {
+        lines.append(tr("准入 | 在线 %1 / 上限 %2 | 已拒绝 %3 | 重连速率 %4/秒")
+                         .arg(admission.active())
+                         .arg(admission.limit() > 0 ? QString::number(admission.limit()) : tr("不限"))
+                         .arg(admission.rejected())
+                         .arg(admission.admitRate()));
+    }
+    const Listener::MemoryStats memory = listener_->memoryStats();
+    if (memory.sessions > 0 || memory.shed > 0) {
+        constexpr double kMiB = 1024.0 * 1024.0;
+        lines.append(tr("内存 | 会话缓冲 %1 MB / 预算 %2 | 平均 %3 KB 最大 %4 KB | 暂停读取 %5 | 已驱逐 %6%7")
+                         .arg(memory.totalBytes / kMiB, 0, 'f', 2)
+                         .arg(memory.budgetBytes > 0 ? QStringLiteral("%1 MB").arg(memory.budgetBytes / kMiB, 0, 'f', 0) : tr("不限"))
+                         .arg(memory.sessions > 0 ? memory.totalBytes / 1024.0 / memory.sessions : 0.0, 0, 'f', 1)
+                         .arg(memory.maxSessionBytes / 1024.0, 0, 'f', 1)
+                         .arg(memory.readPaused)
+                         .arg(memory.shed)
+                         .arg(memory.stackBytes > 0 ? tr(" | 线程栈预留 %1 MB").arg(memory.stackBytes / kMiB, 0, 'f', 1) : QString()));
+    }
+    QStringList queueWaits;
+    const std::pair<cs::common::SendPriority, QString> classes[] = {
+        {cs::common::SendPriority::Control, tr("命令")},
+        {cs::common::SendPriority::Interactive, tr("ACK")},
+        {cs::common::SendPriority::Bulk, tr("推送")},
+    };
+    for (const auto &[priority, name] : classes) {
+        const auto counts = listener_->sendQueueWait(priority);
+        if (std::any_of(counts.begin(), counts.end(), [](quint64 n) { return n > 0; })) {
+            queueWaits.append(tr("%1 p50 %2 µs / p99 %3 µs")
+                                  .arg(name)
+                                  .arg(LatencyHistogram::quantileUs(counts, 0.50), 0, 'f', 1)
+                                  .arg(LatencyHistogram::quantileUs(counts, 0.99), 0, 'f', 1));
+        }
+    }
+    if (!queueWaits.isEmpty()) {
+        lines.append(tr("发送排队 | %1").arg(queueWaits.join(QStringLiteral(" | "))));
+    }
+    using cs::common::AllocTracker;
+    if (AllocTracker::available() && AllocTracker::frames() > 0) {
+        const double frames = double(AllocTracker::frames());
+        QStringList allocs;
+        for (int i = 0; i < cs::common::kAllocTagCount; ++i) {
+            const auto tag = static_cast<cs::common::AllocTag>(i);
+            allocs.append(QStringLiteral("%1 %2").arg(QString::fromLatin1(AllocTracker::tagName(tag)))
+                              .arg(double(AllocTracker::stats(tag).allocations) / frames, 0, 'f', 2));
+        }
+        lines.append(tr("每帧分配 | %1").arg(allocs.join(QStringLiteral(" | "))));
+    }
+    handlerStatsLabel_->setText(lines.join(QLatin1Char('\n')));
+}
+
+void ServerWindow::refreshUdpStats() {
+    if (listener_->udpPort() == 0) {
+        udpStatsLabel_->hide();
+        return;
+    }
+    const auto sources = listener_->udpSources();
+    quint64 frames = 0;
+    quint64 lost = 0;
+    quint64 invalid = 0;
+    const UdpReceiver::SourceStats *worst = nullptr;
+    for (const auto &source : sources) {
+        frames += source.frames;
+        lost += source.lost;
+        invalid += source.invalid;
+        if (!worst || source.lossRate() > worst->lossRate()) {
+            worst = &source;
+        }
+    }
+    QString text = tr("UDP:%1 | 来源 %2 | 帧 %3 | 丢失 %4 (%5%) | 无效 %6")
+                       .arg(listener_->udpPort())
+                       .arg(sources.size())
+                       .arg(frames)
+                       .arg(lost)
+                       .arg(frames + lost == 0 ? 0.0 : 100.0 * double(lost) / double(frames + lost), 0, 'f', 2)
+                       .arg(invalid);
+    if (worst && worst->lost > 0) {
+        text += tr(" | 丢包最多 %1:%2 (%3%)").arg(worst->address).arg(worst->port).arg(100.0 * worst->lossRate(), 0, 'f', 2);
+    }
+    if (const quint64 evicted = listener_->udpEvictedSources(); evicted > 0) {
+        text += tr(" | 淘汰来源 %1").arg(evicted);
+    }
+    udpStatsLabel_->setText(text);
+    udpStatsLabel_->show();
+}
+
+void ServerWindow::refreshAnalytics() {
+    const Listener::AnalyticsReport report = listener_->analytics(3);
+    if (report.totalFrames == 0) {
+        analyticsLabel_->hide();
+        return;
+    }
+    QStringList types;
+    for (const auto &type : report.types) {
+        types.append(tr("%1 %2/秒 (%3%) 大小p50 %4 p99 %5")
+                         .arg(type.type == 0 ? tr("其他")
+                                             : QStringLiteral("0x%1").arg(QString::number(type.type, 16).rightJustified(2, QLatin1Char('0'))))
+                         .arg(type.framesPerSec, 0, 'f', 0)
+                         .arg(100.0 * double(type.frames) / double(report.totalFrames), 0, 'f', 1)
+                         .arg(type.p50Bytes)
+                         .arg(type.p99Bytes));
+    }
+    const auto talkers = [](const std::vector<Listener::AnalyticsReport::Talker> &list) {
+        QStringList parts;
+        for (const auto &talker : list) {
+            parts.append(QStringLiteral("%1 ≈%2帧/%3 KB").arg(talker.label).arg(talker.frames).arg(talker.bytes / 1024.0, 0, 'f', 1));
+        }
+        return parts.isEmpty() ? QStringLiteral("-") : parts.join(QStringLiteral(", "));
+    };
+    QStringList lines;
+    lines.append(tr("载荷 | 共 %1 条 | 不同内容≈%2 | %3")
+                     .arg(report.totalFrames)
+                     .arg(report.distinctPayloads, 0, 'f', 0)
+                     .arg(types.join(QStringLiteral(" | "))));
+    lines.append(tr("热点会话 | %1").arg(talkers(report.topSessions)));
+    lines.append(tr("热点地址 | %1").arg(talkers(report.topAddresses)));
+    analyticsLabel_->setText(lines.join(QLatin1Char('\n')));
+    analyticsLabel_->show();
+}
+
+void ServerWindow::refreshCluster() {
+    const auto members = listener_->clusterMembers();
+    if (members.empty()) {
+        clusterLabel_->hide();
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList nodes;
+    for (const auto &member : members) {
+        nodes.append(member.self ? tr("%1(本节点)").arg(member.node)
+                                 : tr("%1 %2ms前").arg(member.node).arg(now - member.lastSeenMs));
+    }
+    clusterLabel_->setText(tr("集群 | %1 个节点 | 已重定向 %2 | %3")
+                               .arg(members.size())
+                               .arg(listener_->clusterRedirects())
+                               .arg(nodes.join(QStringLiteral(", "))));
+    clusterLabel_->show();
+}
+
+void ServerWindow::refreshSessionPool() {
+    const auto stats = listener_->sessionSchedulerStats();
+    if (stats.threads.empty()) {
+        sessionPoolLabel_->hide();
+        return;
+    }
+    QStringList threads;
+    for (std::size_t i = 0; i < stats.threads.size(); ++i) {
+        const auto &thread = stats.threads[i];
+        threads.append(tr("#%1 %2会话 %3%").arg(i).arg(thread.sessions).arg(thread.busy * 100.0, 0, 'f', 0));
+    }
+    sessionPoolLabel_->setText(tr("会话线程 | %1 | 已迁移 %2 | %3")
+                                   .arg(stats.rebalancing ? tr("按负载迁移") : tr("不迁移"))
+                                   .arg(stats.migrations)
+                                   .arg(threads.join(QStringLiteral(", "))));
+    sessionPoolLabel_->show();
+}
+
+void ServerWindow::refreshCharts() {
+    const auto samples = listener_->timeline();
+    const int capacity = listener_->timelineCapacity();
+    QVector<double> frames, acks, kbytes, errors, sessions, p50, p99;
+    for (const auto &sample : samples) {
+        frames.append(sample.framesPerSec);
+        acks.append(sample.acksPerSec);
+        kbytes.append(sample.bytesPerSec / 1024.0);
+        errors.append(sample.errorsPerSec);
+        sessions.append(sample.sessions);
+        p50.append(sample.p50Us);
+        p99.append(sample.p99Us);
+    }
+    throughputChart_->setSeries({{tr("接收"), QColor(0x00, 0x78, 0xd7), frames},
+                                 {tr("ACK"), QColor(0x10, 0x7c, 0x10), acks},
+                                 {tr("连接"), QColor(0x88, 0x88, 0x88), sessions}},
+                                capacity);
+    trafficChart_->setSeries({{tr("KB"), QColor(0x00, 0x78, 0xd7), kbytes},
+                              {tr("错误"), QColor(0xd1, 0x34, 0x38), errors}},
+                             capacity);
+    latencyChart_->setSeries({{tr("p50"), QColor(0x10, 0x7c, 0x10), p50},
+                              {tr("p99"), QColor(0xca, 0x50, 0x10), p99}},
+                             capacity);
+}
+
+void ServerWindow::handlePublish() {
+    const QString topic = topicEdit_->text().trimmed();
+    const int recipients = listener_->publish(topic, broadcastEdit_->text().toUtf8());
+    const auto stats = listener_->broadcastStats();
+    appendLog(tr("[推送] %1 → %2 个连接 | 累计推送 %3 次, 入队 %4 帧, 因积压丢弃 %5 帧")
+                  .arg(topic.isEmpty() ? tr("广播") : tr("主题 %1").arg(topic))
+                  .arg(recipients)
+                  .arg(stats.published)
+                  .arg(stats.delivered)
+                  .arg(stats.dropped));
+}
+
+void ServerWindow::startServer(quint16 port) {
+    portSpin_->setValue(port);
+    if (!listener_->isListening()) {
+        handleStartStop();
+    }
+}
+
+bool ServerWindow::takeOver(const QString &path) {
+    const bool ok = listener_->takeOver(path, 5000);
+    if (ok) {
+        portSpin_->setValue(listener_->port());
+        acceptorSpin_->setValue(listener_->acceptorCount());
+    } else {
+        appendLog(tr("[错误] 热重启接管失败"));
+    }
+    refreshUiState();
+    return ok;
+}
+
+void ServerWindow::enableHandoff(const QString &path, int drainMs) {
+    listener_->enableHandoff(path, drainMs);
+}
+
+void ServerWindow::startLocal(const QString &path) {
+    listener_->startLocal(path);
+}
+
+void ServerWindow::startUdp(quint16 port) {
+    listener_->startUdp(port);
+}
+
+void ServerWindow::enableAnalytics() {
+    listener_->enableAnalytics();
+}
+
+void ServerWindow::startMetrics(quint16 port, const QHostAddress &address) {
+    listener_->startMetrics(port, address);
+}
+
+void ServerWindow::startCluster(const ClusterSettings &settings) {
+    cluster_ = settings;
+    if (listener_->isListening()) {
+        listener_->startCluster(settings);
+    }
+}
+
 void ServerWindow::handleStartStop() {
     if (listener_->isListening()) {
         listener_->stop();
     } else {
+        listener_->setAcceptorCount(acceptorSpin_->value());
         if (!listener_->start(static_cast<quint16>(portSpin_->value()))) {
             appendLog(tr("[错误] 启动监听失败,请检查端口是否被占用"));
+        } else if (cluster_) {
+            listener_->startCluster(*cluster_);
         }
     }
     refreshUiState();
 }
 
 void ServerWindow::handleConnectionUpdated(const ConnectionRow &row) {
+    CS_ALLOC_SCOPE(Ui);
     model_->upsert(row);
 }
 
@@ -201,6 +629,7 @@ void ServerWindow::handleConnectionClosed(const QString &id) {
 }
 
 void ServerWindow::handleFrameReceived(const QString &id, const QByteArray &payload) {
+    CS_ALLOC_SCOPE(Ui);
     const auto summary = summarizePayload(payload);
     appendLog(tr("[数据] 客户端 %1 | 帧长:%2字节 | 类型:0x%3 | 序号:%4 | 内容长度:%5 | HEX=%6 | 文本=%7")
                   .arg(id.left(8))
@@ -209,18 +638,39 @@ void ServerWindow::handleFrameReceived(const QString &id, const QByteArray &payl
                   .arg(summary.msgId)
                   .arg(summary.content.size())
                   .arg(hexPreview(summary.content, 32))
-                  .arg(textPreview(summary.content, 32)));
+                  .arg(textPreview(summary.content, 32)),
+              id);
 }
 
 void ServerWindow::handleInvalidPacket(const QString &id, const QString &reason) {
-    appendLog(tr("[错误] 客户端 %1 发送非法数据包: %2").arg(id.left(8), reason));
+    appendLog(tr("[错误] 客户端 %1 发送非法数据包: %2").arg(id.left(8), reason), id);
 }
 
 void ServerWindow::handleLogMessage(const QString &text) {
     appendLog(text);
 }
 
+void ServerWindow::handleLoadSampled(const RateController::LoadSample &sample) {
+    loadLabel_->setText(tr("负载 %1 | 循环延迟 %2 ms | 队列 %3 | CPU %4% | 总速率 %5 条/秒 | 已下发 %6 次")
+                            .arg(sample.load, 0, 'f', 2)
+                            .arg(sample.loopLagMs, 0, 'f', 0)
+                            .arg(sample.queueDepth)
+                            .arg(sample.cpu * 100.0, 0, 'f', 0)
+                            .arg(sample.totalRate, 0, 'f', 1)
+                            .arg(sample.pushes));
+}
+
 void ServerWindow::updateIntervalSettings() {
+    // 自适应模式下目标间隔作为最短间隔
+    const bool adaptive = adaptiveCheck_->isChecked();
+    if (adaptive != listener_->adaptiveInterval().has_value()) {
+        appendLog(adaptive ? tr("[配置] 已启用自适应间隔调节(AIMD), 最短间隔: %1 毫秒").arg(intervalSpin_->value())
+                           : tr("[配置] 已禁用自适应间隔调节"));
+    }
+    listener_->setAdaptiveInterval(adaptive ? std::optional<int>(intervalSpin_->value()) : std::nullopt);
+    if (!adaptive) {
+        loadLabel_->setText(tr("负载: - (未启用自适应调节，不采样)"));
+    }
     if (intervalCheck_->isChecked()) {
         listener_->setForcedInterval(intervalSpin_->value());
         appendLog(tr("[配置] 已启用强制间隔控制: %1 毫秒").arg(intervalSpin_->value()));
@@ -230,17 +680,28 @@ void ServerWindow::updateIntervalSettings() {
     }
 }
 
-void ServerWindow::appendLog(const QString &line) {
-    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    logView_->appendPlainText(QString("[%1] %2").arg(timestamp, line));
+void ServerWindow::appendLog(const QString &line, const QString &session) {
+    logModel_->appendLine(line, session);
+}
+
+void ServerWindow::applyLogFilter() {
+    cs::common::LogModel::Filter filter;
+    filter.minLevel = static_cast<cs::common::LogLevel>(logLevelCombo_->currentData().toInt());
+    filter.category = logCategoryCombo_->currentIndex() > 0 ? logCategoryCombo_->currentText() : QString();
+    filter.session = logSessionEdit_->text().trimmed();
+    filter.text = logSearchEdit_->text();
+    followLog_ = true;
+    logModel_->setFilter(filter);
 }
 
 void ServerWindow::refreshUiState() {
     const bool running = listener_->isListening();
     startBtn_->setText(running ? tr("停止服务器") : tr("启动服务器"));
+    startBtn_->setEnabled(!listener_->isDraining());  // 排空结束发出stopped()后恢复
     statusLabel_->setText(running ? tr("运行中") : tr("未运行"));
     statusIndicator_->setStyleSheet(running ? 
         "QLabel { color: green; font-size: 16pt; font-weight: bold; }" :
         "QLabel { color: red; font-size: 16pt; font-weight: bold; }");
     portSpin_->setEnabled(!running);
+    acceptorSpin_->setEnabled(!running);
 }
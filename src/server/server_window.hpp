@@ -4,14 +4,19 @@
 
 #include <optional>
 
+#include "common/log_model.hpp"
 #include "connection_model.hpp"
 #include "listener.hpp"
+#include "time_series_chart.hpp"
 
 class QCheckBox;
-class QPlainTextEdit;
+class QComboBox;
+class QListView;
+class QLineEdit;
 class QPushButton;
 class QSpinBox;
 class QTableView;
+class QTimer;
 class QLabel;
 
 class ServerWindow : public QMainWindow {
@@ -20,6 +25,25 @@ class ServerWindow : public QMainWindow {
 public:
     explicit ServerWindow(QWidget *parent = nullptr);
 
+    // 会话与搜索框停止输入这么久后才重建过滤结果
+    static constexpr int kLogFilterDebounceMs = 250;
+
+    void setAcceptorCount(int count);
+    void setHandlerThreads(int threads);
+    void setSessionThreads(int threads, bool rebalance);
+    void setAdmission(int maxSessions, int admitPerSec);
+    void setSessionLimits(const SessionLimits &limits, qint64 memoryBudgetBytes);
+    void startServer(quint16 port);
+    bool takeOver(const QString &path);
+    void enableHandoff(const QString &path, int drainMs);
+    void startLocal(const QString &path);
+    void startUdp(quint16 port);
+    // 须在启动服务之前调用，见Listener::enableAnalytics()
+    void enableAnalytics();
+    void startMetrics(quint16 port, const QHostAddress &address);
+    // 记下集群参数，监听中立即加入；之后每次启动服务器都重新加入
+    void startCluster(const ClusterSettings &settings);
+
 private slots:
     void handleStartStop();
     void handleConnectionUpdated(const ConnectionRow &row);
@@ -28,19 +52,51 @@ private slots:
     void handleInvalidPacket(const QString &id, const QString &reason);
     void handleLogMessage(const QString &text);
     void updateIntervalSettings();
+    void handlePublish();
+    void handleLoadSampled(const RateController::LoadSample &sample);
 
 private:
-    void appendLog(const QString &line);
+    void appendLog(const QString &line, const QString &session = QString());
+    void applyLogFilter();
     void refreshUiState();
+    void refreshHandlerStats();
+    void refreshUdpStats();
+    void refreshAnalytics();
+    void refreshCluster();
+    void refreshSessionPool();
+    void refreshCharts();
 
     Listener *listener_;
     ConnectionModel *model_;
     QTableView *connectionView_;
-    QPlainTextEdit *logView_;
+    cs::common::LogModel *logModel_;
+    QListView *logView_;
+    QComboBox *logLevelCombo_;
+    QComboBox *logCategoryCombo_;
+    QLineEdit *logSessionEdit_;
+    QLineEdit *logSearchEdit_;
+    QTimer *logFilterTimer_;
+    bool followLog_ = true;  // 视图停在底部时新日志自动滚动
     QSpinBox *portSpin_;
+    QSpinBox *acceptorSpin_;
     QPushButton *startBtn_;
     QLabel *statusLabel_;
     QLabel *statusIndicator_;  // 新增:状态指示器
     QCheckBox *intervalCheck_;
     QSpinBox *intervalSpin_;
+    QCheckBox *adaptiveCheck_;
+    QLabel *loadLabel_;
+    QLineEdit *topicEdit_;
+    QLineEdit *broadcastEdit_;
+    QPushButton *publishBtn_;
+    QLabel *handlerStatsLabel_;
+    QLabel *udpStatsLabel_;
+    QLabel *analyticsLabel_;
+    QLabel *clusterLabel_;
+    QLabel *sessionPoolLabel_;
+    QTimer *statsTimer_;
+    TimeSeriesChart *throughputChart_;
+    TimeSeriesChart *trafficChart_;
+    TimeSeriesChart *latencyChart_;
+    std::optional<ClusterSettings> cluster_;  // 未设置表示不加入集群
 };
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+
+// 会话线程写、界面线程读的逐会话计数。Listener持有shared_ptr，会话销毁后仍可安全读取。
+struct SessionMetrics {
+    std::atomic<quint64> framesIn{0};
+    std::atomic<quint64> bytesIn{0};
+    // 自适应限速给该会话的目标发送间隔(毫秒)，0表示未设置
+    std::atomic<int> targetIntervalMs{0};
+    // 会话线程处理该会话读事件、业务结果与推送的累计耗时(纳秒)，SessionScheduler据此估计会话开销
+    std::atomic<quint64> busyNs{0};
+
+    // 会话持有的缓冲字节，会话线程在每次读写事件后刷新
+    std::atomic<qint64> parserBytes{0};          // ProtocolParser缓冲区容量
+    std::atomic<qint64> readBufferBytes{0};      // 传输层已收未读
+    std::atomic<qint64> writeBufferBytes{0};     // 传输层待写出(含未读走的ACK/推送)
+    std::atomic<qint64> pendingHandlerBytes{0};  // 已提交业务线程池、结果尚未返回的请求
+    std::atomic<qint64> pendingSignalBytes{0};   // frameReceived已发出、界面线程尚未处理的payload
+    std::atomic<bool> readPaused{false};         // 写缓冲超过上限而暂停读取
+
+    qint64 memoryBytes() const {
+        return parserBytes.load(std::memory_order_relaxed) + readBufferBytes.load(std::memory_order_relaxed) +
+               writeBufferBytes.load(std::memory_order_relaxed) + pendingHandlerBytes.load(std::memory_order_relaxed) +
+               pendingSignalBytes.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,245 @@
+#include "session_scheduler.hpp"
+
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <cmath>
+
+#include "session_worker.hpp"
+
+namespace {
+
+// 负载相差不到5%个核视为相同，新会话放到会话较少的线程上
+constexpr double kPlacementTolerance = 0.05;
+
+}  // namespace
+
+SessionScheduler::SessionScheduler(QObject *parent)
+    : QObject(parent) {
+    timer_.setInterval(settings_.tickMs);
+    connect(&timer_, &QTimer::timeout, this, &SessionScheduler::tick);
+}
+
+SessionScheduler::~SessionScheduler() {
+    if (isRunning() || !stopping_.empty()) {
+        shutdown(QDeadlineTimer(1000));
+    }
+}
+
+void SessionScheduler::start(int threads, qint64 stackBytes) {
+    if (isRunning() || threads <= 0) {
+        return;
+    }
+    for (int i = 0; i < threads; ++i) {
+        auto *thread = new QThread;
+        thread->setObjectName(QStringLiteral("session-%1").arg(i));
+        if (stackBytes > 0) {
+            thread->setStackSize(static_cast<uint>(stackBytes));
+        }
+        auto *anchor = new QObject;
+        anchor->moveToThread(thread);
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        thread->start();
+        threads_.push_back(Worker{thread, anchor});
+    }
+    migrations_ = 0;
+    clock_.start();
+    lastTickMs_ = 0;
+    timer_.start();
+}
+
+void SessionScheduler::stop() {
+    timer_.stop();
+    sessions_.clear();
+    // 退出请求排在已投递的事件之后执行；deleteLater在线程结束时处理
+    for (Worker &worker : threads_) {
+        QObject *anchor = worker.anchor;
+        QMetaObject::invokeMethod(anchor, [anchor]() {
+            anchor->deleteLater();
+            QThread::currentThread()->quit();
+        }, Qt::QueuedConnection);
+        stopping_.emplace_back(worker.thread);
+    }
+    threads_.clear();
+}
+
+int SessionScheduler::shutdown(const QDeadlineTimer &deadline) {
+    stop();
+    int lingering = 0;
+    for (const QPointer<QThread> &thread : stopping_) {
+        if (thread && !thread->wait(deadline)) {
+            ++lingering;
+        }
+    }
+    stopping_.clear();
+    return lingering;
+}
+
+void SessionScheduler::setRebalancing(bool enabled) {
+    rebalancing_ = enabled;
+}
+
+void SessionScheduler::setSettings(const Settings &settings) {
+    settings_ = settings;
+    timer_.setInterval(settings_.tickMs);
+}
+
+QThread *SessionScheduler::place(SessionWorker *worker, const QString &id, std::shared_ptr<SessionMetrics> metrics) {
+    if (threads_.empty()) {
+        return nullptr;
+    }
+    const auto best = std::min_element(threads_.begin(), threads_.end(), [](const Worker &a, const Worker &b) {
+        if (std::abs(a.busy - b.busy) > kPlacementTolerance) {
+            return a.busy < b.busy;
+        }
+        return a.sessions < b.sessions;
+    });
+    worker->moveToThread(best->thread);
+    connect(worker, &SessionWorker::migrated, this, &SessionScheduler::confirmMigration);
+    ++best->sessions;
+    Tracked tracked;
+    tracked.worker = worker;
+    tracked.lastBusyNs = metrics->busyNs.load(std::memory_order_relaxed);
+    tracked.metrics = std::move(metrics);
+    tracked.thread = static_cast<int>(best - threads_.begin());
+    sessions_.insert(id, std::move(tracked));
+    return best->thread;
+}
+
+void SessionScheduler::remove(const QString &id) {
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+        return;
+    }
+    Worker &worker = threads_[static_cast<std::size_t>(it->thread)];
+    --worker.sessions;
+    worker.busy = qMax(0.0, worker.busy - it->cost);
+    sessions_.erase(it);
+}
+
+SessionScheduler::Stats SessionScheduler::stats() const {
+    Stats stats;
+    stats.migrations = migrations_;
+    stats.rebalancing = rebalancing_;
+    for (const Worker &worker : threads_) {
+        stats.threads.push_back({worker.sessions, worker.busy, worker.stolen});
+    }
+    return stats;
+}
+
+void SessionScheduler::tick() {
+    const qint64 nowMs = clock_.elapsed();
+    const double elapsedNs = double(qMax<qint64>(1, nowMs - lastTickMs_)) * 1e6;
+    lastTickMs_ = nowMs;
+    for (Worker &worker : threads_) {
+        worker.busy = 0.0;
+    }
+    std::vector<Candidate> candidates;
+    std::vector<QString> ids;
+    candidates.reserve(std::size_t(sessions_.size()));
+    ids.reserve(std::size_t(sessions_.size()));
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        Tracked &session = it.value();
+        const quint64 busyNs = session.metrics->busyNs.load(std::memory_order_relaxed);
+        // 取相邻两个周期的平均，单个周期的突发不足以触发迁移
+        session.cost = 0.5 * session.cost + 0.5 * double(busyNs - session.lastBusyNs) / elapsedNs;
+        session.lastBusyNs = busyNs;
+        threads_[std::size_t(session.thread)].busy += session.cost;
+        const bool cooled = session.movedAtMs < 0 || nowMs - session.movedAtMs >= settings_.cooldownMs;
+        candidates.push_back({session.thread, session.cost, cooled && session.migratingTo < 0});
+        ids.push_back(it.key());
+    }
+    if (!rebalancing_ || threads_.size() < 2) {
+        return;
+    }
+    std::vector<double> loads;
+    loads.reserve(threads_.size());
+    for (const Worker &worker : threads_) {
+        loads.push_back(worker.busy);
+    }
+    for (const auto &[index, to] : plan(std::move(loads), candidates, settings_)) {
+        auto it = sessions_.find(ids[index]);
+        it->movedAtMs = nowMs;
+        migrate(it.value(), to);
+    }
+}
+
+void SessionScheduler::migrate(Tracked &session, int to) {
+    QObject *anchor = threads_[std::size_t(session.thread)].anchor;
+    QThread *thread = threads_[std::size_t(to)].thread;
+    // 会话可能已结束、正等待本线程处理finished而尚未从表中移除，不能在这里解引用。
+    // 改由源线程检查：会话只会在自己所在的线程上销毁，在那里判断存活没有竞争。
+    // 会话移动与否都经migrated()回到本线程确认，此前不改动计数；会话已销毁时由remove()清理
+    QMetaObject::invokeMethod(anchor, [worker = session.worker, thread]() {
+        if (worker && worker->thread() == QThread::currentThread()) {
+            worker->migrateTo(thread);
+        }
+    }, Qt::QueuedConnection);
+    session.migratingTo = to;
+}
+
+void SessionScheduler::confirmMigration(const QString &id, bool moved) {
+    auto it = sessions_.find(id);
+    if (it == sessions_.end() || it->migratingTo < 0) {
+        return;
+    }
+    const int to = it->migratingTo;
+    it->migratingTo = -1;
+    if (!moved || std::size_t(to) >= threads_.size()) {
+        return;
+    }
+    Worker &from = threads_[std::size_t(it->thread)];
+    Worker &target = threads_[std::size_t(to)];
+    emit logMessage(QStringLiteral("会话 %1 (开销 %2%) 由线程 #%3 (%4%) 迁至 #%5 (%6%)")
+                        .arg(id.left(8))
+                        .arg(it->cost * 100.0, 0, 'f', 1)
+                        .arg(it->thread)
+                        .arg(from.busy * 100.0, 0, 'f', 1)
+                        .arg(to)
+                        .arg(target.busy * 100.0, 0, 'f', 1));
+    --from.sessions;
+    from.busy = qMax(0.0, from.busy - it->cost);
+    ++target.sessions;
+    target.busy += it->cost;
+    ++target.stolen;
+    ++migrations_;
+    it->thread = to;
+}
+
+std::vector<std::pair<std::size_t, int>> SessionScheduler::plan(std::vector<double> loads,
+                                                                const std::vector<Candidate> &candidates,
+                                                                const Settings &settings) {
+    std::vector<std::pair<std::size_t, int>> moves;
+    std::vector<bool> taken(candidates.size(), false);
+    for (int step = 0; step < settings.maxMovesPerTick && loads.size() >= 2; ++step) {
+        const auto [coldest, hottest] = std::minmax_element(loads.begin(), loads.end());
+        const int hot = static_cast<int>(hottest - loads.begin());
+        const int cold = static_cast<int>(coldest - loads.begin());
+        const double gap = *hottest - *coldest;
+        if (hot == cold || *hottest < settings.minBusy || *hottest <= *coldest * settings.imbalance) {
+            break;
+        }
+        std::size_t best = candidates.size();
+        double bestDistance = 0.0;
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            const Candidate &candidate = candidates[i];
+            if (taken[i] || !candidate.movable || candidate.thread != hot || candidate.cost <= 0.0 ||
+                candidate.cost >= gap) {
+                continue;
+            }
+            const double distance = std::abs(candidate.cost - gap / 2.0);
+            if (best == candidates.size() || distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        if (best == candidates.size()) {
+            break;
+        }
+        taken[best] = true;
+        loads[std::size_t(hot)] -= candidates[best].cost;
+        loads[std::size_t(cold)] += candidates[best].cost;
+        moves.emplace_back(best, cold);
+    }
+    return moves;
+}
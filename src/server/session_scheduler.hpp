@@ -0,0 +1,123 @@
+#pragma once
+
+#include "session_metrics.hpp"
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+class QThread;
+class SessionWorker;
+
+// 会话线程池：固定数量的线程各自运行事件循环，新会话放到当前负载最低的线程上。
+// 每个周期按SessionMetrics::busyNs的增量估计各会话的开销(占一个核的比例)，线程负载为其上会话之和；
+// 最忙线程明显高于最闲线程时，由最闲线程从最忙线程"窃取"开销合适的会话。迁移在会话自己的线程中、
+// 两次事件之间完成(见SessionWorker::migrateTo())，传输、解析器状态与待写数据随会话对象一起移动；
+// 会话经SessionWorker::migrated()确认后才更新各线程的计数。对象在Listener所在线程使用。
+class SessionScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    struct Settings {
+        int tickMs = 1000;
+        double imbalance = 1.5;   // 最忙线程负载超过最闲线程的该倍数才迁移
+        double minBusy = 0.2;     // 最忙线程负载低于该值(占一个核的比例)时不迁移
+        int maxMovesPerTick = 2;
+        int cooldownMs = 5000;    // 同一会话两次迁移的最短间隔，避免在线程间来回搬动
+    };
+
+    struct ThreadLoad {
+        int sessions = 0;
+        double busy = 0.0;        // 最近一个周期的负载估计
+        quint64 stolen = 0;       // 累计从其他线程迁入的会话
+    };
+
+    struct Stats {
+        std::vector<ThreadLoad> threads;
+        quint64 migrations = 0;
+        bool rebalancing = false;
+    };
+
+    // 一次规划中的候选会话：所在线程、开销与是否已过冷却期
+    struct Candidate {
+        int thread = 0;
+        double cost = 0.0;
+        bool movable = true;
+    };
+
+    explicit SessionScheduler(QObject *parent = nullptr);
+    ~SessionScheduler() override;
+
+    // 启动threads个线程，stackBytes为0时使用系统默认栈大小；已在运行时不做任何事
+    void start(int threads, qint64 stackBytes);
+    // 停止迁移并让各线程在处理完已投递的事件后退出，不等待；线程结束后自行释放
+    void stop();
+    // stop()并等待此前停止的全部线程，返回截止时仍未退出的线程数
+    int shutdown(const QDeadlineTimer &deadline);
+    bool isRunning() const { return !threads_.empty(); }
+    int threadCount() const { return static_cast<int>(threads_.size()); }
+
+    void setRebalancing(bool enabled);
+    bool rebalancing() const { return rebalancing_; }
+    void setSettings(const Settings &settings);
+    Settings settings() const { return settings_; }
+
+    // 把刚创建、尚未start()的会话移到负载最低的线程上并开始跟踪，须在会话所在线程(即本线程)调用
+    QThread *place(SessionWorker *worker, const QString &id, std::shared_ptr<SessionMetrics> metrics);
+    void remove(const QString &id);
+    bool contains(const QString &id) const { return sessions_.contains(id); }
+    Stats stats() const;
+
+    // 迁移规划：loads为各线程负载，返回(候选下标, 目标线程)。每一步从当前最忙线程中挑选开销小于
+    // 两线程差距、且最接近差距一半的会话移到最闲线程，直到差距不再超过阈值或达到次数上限。
+    // 比差距还大的会话不动：移过去只是换一个线程过载。
+    static std::vector<std::pair<std::size_t, int>> plan(std::vector<double> loads,
+                                                         const std::vector<Candidate> &candidates,
+                                                         const Settings &settings);
+
+signals:
+    void logMessage(QString text);
+
+private slots:
+    void tick();
+    void confirmMigration(const QString &id, bool moved);
+
+private:
+    struct Worker {
+        QThread *thread = nullptr;
+        QObject *anchor = nullptr;  // 驻留在该线程的空对象，用于向线程投递调用
+        int sessions = 0;
+        double busy = 0.0;
+        quint64 stolen = 0;
+    };
+
+    struct Tracked {
+        QPointer<SessionWorker> worker;  // 只在会话所在线程上检查，见migrate()
+        std::shared_ptr<SessionMetrics> metrics;
+        int thread = 0;
+        quint64 lastBusyNs = 0;
+        double cost = 0.0;        // 平滑后的开销，占一个核的比例
+        qint64 movedAtMs = -1;    // 上次迁移的时刻(clock_)，-1表示未迁移过
+        int migratingTo = -1;     // 已请求迁移、尚未确认的目标线程
+    };
+
+    void migrate(Tracked &session, int to);
+
+    Settings settings_;
+    QTimer timer_;
+    QElapsedTimer clock_;
+    qint64 lastTickMs_ = 0;
+    bool rebalancing_ = true;
+    quint64 migrations_ = 0;
+    std::vector<Worker> threads_;
+    std::vector<QPointer<QThread>> stopping_;  // 已请求退出的线程，shutdown()时等待
+    QHash<QString, Tracked> sessions_;
+};
@@ -1,64 +1,168 @@
 #include "session_worker.hpp"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QDeadlineTimer>
 #include <QtCore/QThread>
+#include <QtCore/QTimer>
 
+#include "admission_control.hpp"
+#include "cluster_ring.hpp"
+#include "common/alloc_tracker.hpp"
 #include "common/protocol.hpp"
+#include "payload_analytics.hpp"
+#include "server_stats.hpp"
 
+using cs::common::FrameTracer;
+using cs::common::Transport;
 using namespace cs::protocol;
 
-SessionWorker::SessionWorker(QTcpSocket *socket, QString connectionId,
+namespace {
+
+// 把一次事件处理的耗时累加到SessionMetrics::busyNs，供SessionScheduler估计会话开销
+class BusyScope {
+public:
+    explicit BusyScope(SessionMetrics &metrics) : metrics_(metrics), startNs_(FrameTracer::now()) {}
+    ~BusyScope() {
+        metrics_.busyNs.fetch_add(static_cast<quint64>(FrameTracer::now() - startNs_), std::memory_order_relaxed);
+    }
+
+private:
+    SessionMetrics &metrics_;
+    const qint64 startNs_;
+};
+
+}  // namespace
+
+SessionWorker::SessionWorker(cs::common::Transport *transport, QString connectionId,
                              std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent)
     : QObject(parent),
-      socket_(socket),
+      transport_(transport),
       connectionId_(std::move(connectionId)),
       runtimeConfig_(std::move(runtime)),
+      metrics_(std::make_shared<SessionMetrics>()),
       parser_(std::make_unique<ProtocolParser>()) {
     currentRow_.id = connectionId_;
-    if (socket_) {
-        currentRow_.address = socket_->peerAddress().toString();
-        currentRow_.port = socket_->peerPort();
+    if (transport_) {
+        transport_->setParent(this);
+        currentRow_.address = transport_->peerAddress();
+        currentRow_.port = transport_->peerPort();
         currentRow_.status = QStringLiteral("已连接");
         currentRow_.lastActive = QDateTime::currentDateTimeUtc();
         currentRow_.intervalMs = runtimeConfig_->forcedIntervalMs.load();
     }
+    analyticsSession_ = PayloadAnalytics::sessionKey(connectionId_.toStdString());
+    analyticsAddress_ = PayloadAnalytics::addressKey(currentRow_.address.toStdString());
+    analyticsStripe_ = PayloadAnalytics::stripeFor(analyticsSession_);
+    if (runtimeConfig_->dispatcher) {
+        handlerQueue_ = runtimeConfig_->dispatcher->openSession(this, [this](const QVector<RespCode> &results) {
+            onHandlerResults(results);
+        });
+    }
+    if (runtimeConfig_->broadcast) {
+        broadcastInbox_ = runtimeConfig_->broadcast->attach(this, [this]() { drainBroadcast(); });
+    }
 }
 
-SessionWorker::~SessionWorker() = default;
+SessionWorker::SessionWorker(QTcpSocket *socket, QString connectionId,
+                             std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent)
+    : SessionWorker(socket ? new cs::common::TcpTransport(socket) : nullptr, std::move(connectionId), std::move(runtime),
+                    parent) {}
+
+SessionWorker::~SessionWorker() {
+    if (handlerQueue_) {
+        handlerQueue_->close();
+    }
+    for (auto &[streamId, stream] : streams_) {
+        if (stream.handlerQueue) {
+            stream.handlerQueue->close();
+        }
+    }
+    if (runtimeConfig_->broadcast) {
+        runtimeConfig_->broadcast->detach(broadcastInbox_);
+    }
+}
 
 void SessionWorker::start() {
-    if (!socket_) {
+    if (!transport_) {
         emit finished(connectionId_);
         return;
     }
-    connect(socket_.data(), &QTcpSocket::readyRead, this, &SessionWorker::onReadyRead);
-    connect(socket_.data(), &QTcpSocket::disconnected, this, &SessionWorker::onDisconnected);
+    // 不带校验的帧只在本机链路上接受，网络连接上按不支持的版本丢弃
+    parser_->setAcceptUnchecked(transport_->isLocal());
+    connect(transport_, &Transport::readyRead, this, &SessionWorker::onReadyRead);
+    connect(transport_, &Transport::disconnected, this, &SessionWorker::onDisconnected);
+    if (auto counters = runtimeConfig_->counters) {
+        sendQueue_.setWaitRecorder([counters](cs::common::SendPriority priority, qint64 waitNs) {
+            counters->sendQueueWait[static_cast<std::size_t>(priority)].record(waitNs);
+        });
+    }
+    connect(transport_, &Transport::bytesWritten, this, [this]() {
+        sendQueue_.pump(transport_);
+        if (broadcastBlocked_) {
+            drainBroadcast();
+        }
+        // 写缓冲回落到上限一半以下时恢复读取，避免在上限附近反复切换
+        if (metrics_->readPaused.load(std::memory_order_relaxed) &&
+            outboundBytes() < runtimeConfig_->sessionWriteBufferBytes.load(std::memory_order_relaxed) / 2) {
+            metrics_->readPaused.store(false, std::memory_order_relaxed);
+            transport_->setReadBufferSize(readBufferBytes_);
+            onReadyRead();
+            return;
+        }
+        updateMemory();
+    });
+    readBufferBytes_ = runtimeConfig_->sessionReadBufferBytes.load();
+    if (readBufferBytes_ > 0) {
+        transport_->setReadBufferSize(readBufferBytes_);
+    }
     emit connectionUpdated(currentRow_);
 }
 
 void SessionWorker::stop() {
-    if (finished_) {
+    if (finished_ || stopping_) {
         return;  // 已经处理过了
     }
+    stopping_ = true;
     
-    if (socket_) {
+    if (transport_) {
         // 先断开readyRead信号，避免在关闭过程中继续处理数据
-        disconnect(socket_.data(), &QTcpSocket::readyRead, this, &SessionWorker::onReadyRead);
+        disconnect(transport_, &Transport::readyRead, this, &SessionWorker::onReadyRead);
         
         // 优雅地关闭连接，让客户端能检测到断开
-        if (socket_->state() == QAbstractSocket::ConnectedState) {
-            socket_->disconnectFromHost();
-            // 等待disconnected信号触发或超时
-            if (socket_->state() != QAbstractSocket::UnconnectedState) {
-                socket_->waitForDisconnected(1000);
+        if (transport_->isConnected()) {
+            // 整体停机时：集群中的客户端直接交给新的归属节点；其余告知错开重连的时间，避免同时涌向重启后的服务器
+            if (runtimeConfig_->drainDeadlineMs.load() > 0 && !redirected_ && !redirectIfForeign() &&
+                runtimeConfig_->admission) {
+                sendQueue_.write(transport_, cs::common::SendPriority::Control,
+                                 build_frame(replyVersion_, build_command_payload(
+                                     CmdId::RetryAfter, runtimeConfig_->admission->nextRetryAfterMs())));
+            }
+            sendQueue_.flush(transport_);
+            transport_->disconnectFromHost();
+            // 等待disconnected信号(由onDisconnected()结束会话)或超时；整体停机时受共享截止时间约束。
+            // 不用waitForDisconnected()：同一线程上的其他会话会被逐个阻塞
+            if (transport_->state() != Transport::State::Unconnected) {
+                int waitMs = 1000;
+                if (const qint64 deadlineMs = runtimeConfig_->drainDeadlineMs.load(); deadlineMs > 0) {
+                    QDeadlineTimer deadline;
+                    deadline.setDeadline(deadlineMs);
+                    waitMs = static_cast<int>(qMin<qint64>(waitMs, deadline.remainingTime()));
+                }
+                if (waitMs > 0) {
+                    QTimer::singleShot(waitMs, this, &SessionWorker::finishStop);
+                    return;
+                }
             }
-        }
-        
-        // 如果还未断开，强制关闭
-        if (socket_->state() != QAbstractSocket::UnconnectedState) {
-            socket_->abort();
         }
     }
+    finishStop();
+}
+
+void SessionWorker::finishStop() {
+    // 如果还未断开，强制关闭
+    if (transport_ && transport_->state() != Transport::State::Unconnected) {
+        transport_->abort();
+    }
     
     // 如果onDisconnected还没触发finished，这里触发
     if (!finished_) {
@@ -70,29 +174,395 @@ void SessionWorker::stop() {
     }
 }
 
+void SessionWorker::migrateTo(QThread *thread) {
+    // 读事件与业务结果都在各自的事件内处理完毕：ACK已进入发送队列，解析器中只剩不完整的帧，
+    // 这些状态连同传输(子对象)和已投递给本会话的事件随moveToThread()一起转到新线程
+    const bool moved = !finished_ && !stopping_ && thread && thread != QThread::currentThread() &&
+                       runtimeConfig_->drainDeadlineMs.load() == 0;
+    if (moved) {
+        moveToThread(thread);
+    }
+    // 此时已在新线程名下，信号按排队方式送回调度器所在线程
+    emit migrated(connectionId_, moved);
+}
+
+void SessionWorker::rebalance() {
+    if (finished_ || redirected_ || !transport_ || !transport_->isConnected()) {
+        return;
+    }
+    if (redirectIfForeign()) {
+        closeAfterRedirect();
+    }
+}
+
+void SessionWorker::closeAfterRedirect() {
+    if (!transport_ || !transport_->isConnected()) {
+        return;
+    }
+    sendQueue_.flush(transport_);
+    transport_->disconnectFromHost();
+}
+
+void SessionWorker::pushInterval(int intervalMs) {
+    if (!transport_ || !transport_->isConnected() || stopping_ || redirected_) {
+        return;
+    }
+    sendQueue_.write(transport_, cs::common::SendPriority::Control,
+                     build_frame(replyVersion_, build_command_payload(CmdId::SetInterval, uint32_t(intervalMs))));
+    // 会话可能在下一次读事件前一直空闲，界面上的间隔随下发立即更新
+    if (currentRow_.intervalMs != intervalMs) {
+        currentRow_.intervalMs = intervalMs;
+        CS_ALLOC_SCOPE(Ui);
+        emit connectionUpdated(currentRow_);
+    }
+}
+
+bool SessionWorker::redirectIfForeign() {
+    if (clientId_.empty() || !transport_ || transport_->isLocal() || !runtimeConfig_->cluster) {
+        return false;
+    }
+    const auto target = runtimeConfig_->cluster->redirectTarget(clientId_);
+    QByteArray host;
+    quint16 port = 0;
+    if (!target || !HashRing::splitNode(*target, &host, &port)) {
+        return false;
+    }
+    sendQueue_.write(transport_, cs::common::SendPriority::Control,
+                     build_frame(replyVersion_, build_redirect_payload(port, host)));
+    runtimeConfig_->cluster->countRedirect();
+    redirected_ = true;
+    currentRow_.status = QStringLiteral("重定向至 %1").arg(QString::fromStdString(*target));
+    currentRow_.lastActive = QDateTime::currentDateTimeUtc();
+    emit connectionUpdated(currentRow_);
+    return true;
+}
+
 void SessionWorker::onReadyRead() {
-    if (!socket_) {
+    if (!transport_ || stopping_) {
         return;
     }
-    parser_->append(socket_->readAll());
-    while (true) {
-        FrameError error = FrameError::None;
-        QString reason;
-        const auto frame = parser_->nextFrame(&error, &reason);
-        if (!frame.has_value()) {
-            if (error != FrameError::None) {
-                emit invalidPacket(connectionId_, reason);
+    // 对端不读ACK时写缓冲会无限增长：超过上限后暂停读取，等写缓冲回落再继续，由TCP流控反压对端。
+    // 只是不处理还不够：接收缓冲不限时传输会继续把内核中的数据读进内存，内核接收窗口永远不满。
+    // 暂停期间把接收缓冲压到很小，传输随即停止读取，反压才传到对端
+    const qint64 writeCap = runtimeConfig_->sessionWriteBufferBytes.load(std::memory_order_relaxed);
+    if (writeCap > 0 && outboundBytes() >= writeCap) {
+        if (!metrics_->readPaused.exchange(true, std::memory_order_relaxed)) {
+            transport_->setReadBufferSize(readBufferBytes_ > 0 ? qMin(readBufferBytes_, kPausedReadBufferBytes)
+                                                               : kPausedReadBufferBytes);
+        }
+        updateMemory();
+        return;
+    }
+    CS_ALLOC_SCOPE(Receive);
+    const BusyScope busy(*metrics_);
+    readNs_ = FrameTracer::now();
+    // 从线程本地池借一个块读取，避免readAll()每次分配新的QByteArray
+    auto &pool = cs::common::BufferPool::local();
+    char *block = pool.acquire();
+    const auto blockBytes = static_cast<qint64>(pool.blockBytes());
+
+    ackArena_.begin(pool);
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    FrameView view;
+    qint64 n = 0;
+    // 每读一块就解析一次，解析器中最多只剩一个不完整的帧加一块数据，而不是整个接收缓冲
+    while ((n = transport_->read(block, blockBytes)) > 0) {
+        parser_->append(block, n);
+        while (true) {
+            CS_ALLOC_SCOPE(Parse);  // 拆批、payload拷贝也计入解析；路由与ACK在各自函数内另行标注
+            FrameError error = FrameError::None;
+            QString reason;
+            if (!parser_->nextFrameView(&view, &error, &reason)) {
+                if (error != FrameError::None) {
+                    reportInvalid(reason);
+                }
+                break;
+            }
+            ++frames;
+            bytes += static_cast<quint64>(view.rawSize);
+            replyVersion_ = view.version;
+            const uint32_t traceId = FrameTracer::begin();
+            FrameTracer::record(traceId, FrameTracer::Stage::Read, readNs_);
+            FrameTracer::record(traceId, FrameTracer::Stage::Parsed);
+            if (view.payloadSize > 0 && static_cast<uint8_t>(view.payload[0]) == uint8_t(MsgType::Batch)) {
+                handleBatch(QByteArray::fromRawData(view.payload, view.payloadSize), traceId);
+                continue;
             }
-            break;
+            if (view.payloadSize > 0 && static_cast<uint8_t>(view.payload[0]) == uint8_t(MsgType::Stream)) {
+                handleStream(QByteArray::fromRawData(view.payload, view.payloadSize), traceId);
+                continue;
+            }
+            // 跨线程投递给界面与业务处理器必须持有独立数据，这是接收路径上唯一保留的拷贝，两者共享
+            const QByteArray payload = view.payloadCopy();
+            emitFrameReceived(payload);
+            std::vector<HandlerRequest> requests;
+            routePayload(payload, &requests);
+            dispatch(std::move(requests), RespCode::Ok, traceId);
         }
+    }
+    pool.release(block);
+    flushAcks();
+    parser_->trim(qMax<qint64>(runtimeConfig_->sessionParserBytes.load(std::memory_order_relaxed),
+                               kMaxFrameOverheadBytes + kMaxPayloadBytes));
+    updateMemory();
+
+    if (frames > 0) {
+        cs::common::AllocTracker::addFrames(frames);
+        metrics_->framesIn.fetch_add(frames, std::memory_order_relaxed);
+        metrics_->bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        if (runtimeConfig_->counters) {
+            runtimeConfig_->counters->framesIn.fetch_add(frames, std::memory_order_relaxed);
+            runtimeConfig_->counters->bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        const auto &stats = pool.stats();
         currentRow_.lastActive = QDateTime::currentDateTimeUtc();
-        currentRow_.status = QStringLiteral("活跃");
-        emit connectionUpdated(currentRow_);
-        emit frameReceived(connectionId_, frame->frame.payload);
-        sendAck(true);
+        if (redirected_) {
+            // 保留"重定向至"状态直到断开
+        } else if (streams_.empty()) {
+            currentRow_.status = QStringLiteral("活跃");
+        } else {
+            currentRow_.status = streamOutOfOrder_ == 0
+                                     ? QStringLiteral("活跃 (%1条流)").arg(streams_.size())
+                                     : QStringLiteral("活跃 (%1条流, 乱序%2)").arg(streams_.size()).arg(streamOutOfOrder_);
+        }
+        currentRow_.poolHitRate = stats.hitRate();
+        currentRow_.poolHighWater = static_cast<int>(stats.highWater);
+        currentRow_.memoryBytes = metrics_->memoryBytes();
+        CS_ALLOC_SCOPE(Ui);
+        emit connectionUpdated(currentRow_);  // 每次读事件只通知一次
+    }
+}
+
+void SessionWorker::emitFrameReceived(const QByteArray &payload) {
+    CS_ALLOC_SCOPE(Ui);
+    // 每条逻辑请求(含批量与逻辑流拆出的子消息)都经过这里，统计与界面看到的一致
+    if (runtimeConfig_->analytics) {
+        runtimeConfig_->analytics->record(analyticsStripe_, analyticsSession_, analyticsAddress_, payload.constData(),
+                                          std::size_t(payload.size()));
+    }
+    // 界面线程处理该信号后扣回，见Listener::registerSession()
+    metrics_->pendingSignalBytes.fetch_add(payload.size(), std::memory_order_relaxed);
+    emit frameReceived(connectionId_, payload);
+}
+
+void SessionWorker::updateMemory() {
+    metrics_->parserBytes.store(parser_->bufferCapacity(), std::memory_order_relaxed);
+    metrics_->readBufferBytes.store(transport_ ? transport_->bytesAvailable() : 0, std::memory_order_relaxed);
+    metrics_->writeBufferBytes.store(outboundBytes(), std::memory_order_relaxed);
+    metrics_->pendingHandlerBytes.store(pendingHandlerBytes_, std::memory_order_relaxed);
+}
+
+void SessionWorker::handleBatch(const QByteArray &payload, uint32_t traceId, uint16_t streamId) {
+    QVector<QByteArray> entries;
+    QString reason;
+    if (!split_batch(payload, &entries, &reason)) {
+        reportInvalid(reason);
+        dispatch({}, RespCode::Invalid, traceId, streamId);
+        return;
+    }
+    std::vector<HandlerRequest> requests;
+    for (const QByteArray &entry : std::as_const(entries)) {
+        emitFrameReceived(entry);
+        routePayload(entry, &requests);
+    }
+    dispatch(std::move(requests), RespCode::Ok, traceId, streamId);  // 整批只回一个ACK
+}
+
+void SessionWorker::handleStream(const QByteArray &payload, uint32_t traceId) {
+    StreamHeader header;
+    if (!decode_stream_header(payload.constData(), payload.size(), &header) || header.streamId == 0) {
+        reportInvalid(QStringLiteral("Stream header invalid"));
+        dispatch({}, RespCode::Invalid, traceId);
+        return;
+    }
+    const uint16_t streamId = header.streamId;
+    // 交给界面与业务线程池的内层payload需要独立的数据
+    const QByteArray inner = payload.mid(kStreamHeaderBytes);
+    auto it = streams_.find(streamId);
+    if (inner.isEmpty()) {
+        // 关闭流；仍回一个ACK保持一帧一ACK，排在该流未完成的任务之后，归还额度为0
+        if (it != streams_.end()) {
+            it->second.closing = true;
+        }
+        dispatch({}, RespCode::Ok, traceId, streamId);
+        if (it != streams_.end() && it->second.pendingJobs.empty()) {
+            eraseStream(it);
+        }
+        return;
+    }
+    if (it == streams_.end()) {
+        if (int(streams_.size()) >= kMaxStreamsPerSession) {
+            reportInvalid(QStringLiteral("Too many streams (limit %1)").arg(kMaxStreamsPerSession));
+            dispatch({}, RespCode::Invalid, traceId, streamId);
+            return;
+        }
+        it = streams_.emplace(streamId, StreamState{}).first;
+        if (runtimeConfig_->dispatcher) {
+            it->second.handlerQueue = runtimeConfig_->dispatcher->openSession(
+                this, [this, streamId](const QVector<RespCode> &results) { onStreamResults(streamId, results); });
+        }
+    }
+    StreamState &stream = it->second;
+    stream.closing = false;  // 关闭帧尚未应答完时复用同一流号
+    // 每帧都会得到一个归还额度的ACK，因此违规帧也计入在途
+    if (++stream.inFlight > kStreamWindow) {
+        reportInvalid(QStringLiteral("Stream %1 exceeded credit %2").arg(streamId).arg(kStreamWindow));
+        dispatch({}, RespCode::Invalid, traceId, streamId);
+        return;
+    }
+    RequestHeader request;
+    if (!decode_request_header(inner.constData(), inner.size(), &request) || request.type == MsgType::Stream) {
+        reportInvalid(QStringLiteral("Stream %1 payload invalid").arg(streamId));
+        dispatch({}, RespCode::Invalid, traceId, streamId);
+        return;
+    }
+    if (stream.seen && request.msgId != uint16_t(stream.lastMsgId + 1)) {
+        ++streamOutOfOrder_;
+    }
+    stream.seen = true;
+    stream.lastMsgId = request.msgId;
+    if (request.type == MsgType::Batch) {
+        handleBatch(inner, traceId, streamId);
+        return;
+    }
+    emitFrameReceived(inner);
+    std::vector<HandlerRequest> requests;
+    routePayload(inner, &requests);
+    dispatch(std::move(requests), RespCode::Ok, traceId, streamId);
+}
+
+void SessionWorker::routePayload(const QByteArray &payload, std::vector<HandlerRequest> *requests) {
+    CS_ALLOC_SCOPE(Dispatch);
+    RequestHeader header;
+    if (!decode_request_header(payload.constData(), payload.size(), &header)) {
+        return;
+    }
+    // 订阅变更直接在会话线程处理，不经过业务线程池
+    if (header.type == MsgType::Subscribe || header.type == MsgType::Unsubscribe) {
+        const QString topic = QString::fromUtf8(payload.constData() + kRequestHeaderBytes,
+                                                payload.size() - kRequestHeaderBytes);
+        if (runtimeConfig_->broadcast && broadcastInbox_) {
+            if (header.type == MsgType::Subscribe) {
+                runtimeConfig_->broadcast->subscribe(broadcastInbox_, topic);
+            } else {
+                runtimeConfig_->broadcast->unsubscribe(broadcastInbox_, topic);
+            }
+        }
+        return;
+    }
+    // 客户端标识同样在会话线程处理：归属其他节点时，重定向命令以Control级别先于本帧的ACK写出
+    if (header.type == MsgType::Hello) {
+        clientId_.assign(payload.constData() + kRequestHeaderBytes,
+                         std::size_t(qMin<qsizetype>(payload.size() - kRequestHeaderBytes, kMaxClientIdBytes)));
+        if (!redirected_ && redirectIfForeign()) {
+            QMetaObject::invokeMethod(this, &SessionWorker::closeAfterRedirect, Qt::QueuedConnection);
+        }
+        return;
+    }
+    if (runtimeConfig_->dispatcher && runtimeConfig_->dispatcher->hasHandler(uint8_t(header.type))) {
+        requests->push_back(HandlerRequest{connectionId_, header, payload});
+    }
+}
+
+void SessionWorker::dispatch(std::vector<HandlerRequest> requests, RespCode code, uint32_t traceId,
+                             uint16_t streamId) {
+    CS_ALLOC_SCOPE(Dispatch);
+    FrameTracer::record(traceId, FrameTracer::Stage::Dispatched);
+    // 流帧排在所属流自己的队列里，其余帧排在会话队列里；ACK只在各自队列内保序
+    StreamState *stream = nullptr;
+    if (streamId != 0) {
+        if (auto it = streams_.find(streamId); it != streams_.end() && it->second.handlerQueue) {
+            stream = &it->second;
+        }
+    }
+    std::deque<PendingAck> &pendingJobs = stream ? stream->pendingJobs : pendingJobs_;
+    // 没有需要处理的内容且同一队列前面没有未完成的任务时直接应答，否则排队以保证ACK顺序
+    if (requests.empty() && pendingJobs.empty()) {
+        sendAck(code == RespCode::Ok, readNs_, traceId, streamId);
+        return;
+    }
+    qint64 requestBytes = 0;
+    for (const HandlerRequest &request : requests) {
+        requestBytes += request.payload.size();
+    }
+    pendingHandlerBytes_ += requestBytes;
+    pendingJobs.push_back(PendingAck{readNs_, traceId, requestBytes, streamId});
+    runtimeConfig_->dispatcher->submit(stream ? stream->handlerQueue : handlerQueue_, std::move(requests), code);
+}
+
+void SessionWorker::onHandlerResults(const QVector<RespCode> &results) {
+    const BusyScope busy(*metrics_);
+    ackArena_.begin(cs::common::BufferPool::local());
+    for (const RespCode code : results) {
+        const PendingAck pending = pendingJobs_.front();
+        pendingJobs_.pop_front();
+        pendingHandlerBytes_ -= pending.requestBytes;
+        sendAck(code == RespCode::Ok, pending.receivedNs, pending.traceId, pending.streamId);
+    }
+    flushAcks();
+    updateMemory();
+}
+
+void SessionWorker::onStreamResults(uint16_t streamId, const QVector<RespCode> &results) {
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+    const BusyScope busy(*metrics_);
+    ackArena_.begin(cs::common::BufferPool::local());
+    for (const RespCode code : results) {
+        const PendingAck pending = it->second.pendingJobs.front();
+        it->second.pendingJobs.pop_front();
+        pendingHandlerBytes_ -= pending.requestBytes;
+        sendAck(code == RespCode::Ok, pending.receivedNs, pending.traceId, streamId);
+    }
+    flushAcks();
+    if (it->second.closing && it->second.pendingJobs.empty()) {
+        eraseStream(it);
+    }
+    updateMemory();
+}
+
+void SessionWorker::eraseStream(StreamMap::iterator it) {
+    // 关闭后队列里不会再有结果送回
+    if (it->second.handlerQueue) {
+        it->second.handlerQueue->close();
+    }
+    streams_.erase(it);
+}
+
+void SessionWorker::drainBroadcast() {
+    if (!broadcastInbox_) {
+        return;
+    }
+    if (!transport_ || !transport_->isConnected()) {
+        QByteArray discarded;
+        while (broadcastInbox_->pop(&discarded)) {
+        }
+        return;
+    }
+    const BusyScope busy(*metrics_);
+    // 积压超过高水位时停止取帧，剩余帧留在收件箱(满了丢最旧的)，等bytesWritten再继续
+    QByteArray frame;
+    broadcastBlocked_ = false;
+    while (true) {
+        if (outboundBytes() >= kBroadcastHighWaterBytes) {
+            broadcastBlocked_ = true;
+            return;
+        }
+        if (!broadcastInbox_->pop(&frame)) {
+            return;
+        }
+        // 共享帧数据，发送队列与Qt写缓冲区都直接引用而不复制
+        sendQueue_.write(transport_, cs::common::SendPriority::Bulk, frame);
     }
 }
 
+qint64 SessionWorker::outboundBytes() const {
+    return transport_ ? transport_->bytesToWrite() + sendQueue_.queuedBytes() : 0;
+}
+
 void SessionWorker::onDisconnected() {
     if (finished_) {
         return;  // 已经处理过了
@@ -104,30 +574,82 @@ void SessionWorker::onDisconnected() {
     emit finished(connectionId_);
 }
 
-void SessionWorker::sendAck(bool success) {
-    if (!socket_) {
+void SessionWorker::reportInvalid(const QString &reason) {
+    if (runtimeConfig_->counters) {
+        runtimeConfig_->counters->errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    emit invalidPacket(connectionId_, reason);
+}
+
+void SessionWorker::sendAck(bool success, qint64 receivedNs, uint32_t traceId, uint16_t streamId) {
+    if (!transport_) {
         return;
     }
-    const QByteArray payload = buildAckPayload(success);
-    const QByteArray frame = build_frame(kDefaultVersion, payload);
-    socket_->write(frame);
+    CS_ALLOC_SCOPE(Ack);
+    if (runtimeConfig_->counters) {
+        runtimeConfig_->counters->acks.fetch_add(1, std::memory_order_relaxed);
+        runtimeConfig_->counters->ackLatency.record(FrameTracer::now() - receivedNs);
+    }
+    char payload[kAckPayloadMaxBytes];
+    const int size = encodeAckPayload(success, streamId, payload);
+    if (char *out = ackArena_.allocate(static_cast<std::size_t>(frame_overhead_bytes(replyVersion_) + size))) {
+        encode_frame(replyVersion_, payload, size, out);
+        if (traceId != 0) {
+            tracedAcks_.push_back(traceId);
+        }
+        return;
+    }
+    // 不在读事件内（arena未就绪）时直接写出
+    char frame[kMaxFrameOverheadBytes + kAckPayloadMaxBytes];
+    sendQueue_.write(transport_, cs::common::SendPriority::Interactive, frame,
+                     encode_frame(replyVersion_, payload, size, frame));
+    FrameTracer::record(traceId, FrameTracer::Stage::AckWritten);
 }
 
-QByteArray SessionWorker::buildAckPayload(bool success) {
-    QByteArray payload;
-    payload.append(char(success ? 0x00 : 0x01));
-    const quint64 timestamp = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
-    for (int i = 7; i >= 0; --i) {
-        payload.append(char((timestamp >> (i * 8)) & 0xFF));
+void SessionWorker::flushAcks() {
+    CS_ALLOC_SCOPE(Ack);
+    if (transport_) {
+        for (const auto &span : ackArena_.spans()) {
+            sendQueue_.write(transport_, cs::common::SendPriority::Interactive, span.data,
+                             static_cast<qint64>(span.size));
+        }
     }
-    bool includeInterval = runtimeConfig_->intervalControl.load();
-    payload.append(char(includeInterval ? 0x01 : 0x00));
-    if (includeInterval) {
-        const quint32 interval = static_cast<quint32>(runtimeConfig_->forcedIntervalMs.load());
-        currentRow_.intervalMs = interval;
-        for (int i = 3; i >= 0; --i) {
-            payload.append(char((interval >> (i * 8)) & 0xFF));
+    ackArena_.reset();
+    if (!tracedAcks_.empty()) {
+        const qint64 writtenNs = FrameTracer::now();
+        for (const uint32_t traceId : tracedAcks_) {
+            FrameTracer::record(traceId, FrameTracer::Stage::AckWritten, writtenNs);
+        }
+        tracedAcks_.clear();
+    }
+}
+
+int SessionWorker::encodeAckPayload(bool success, uint16_t streamId, char *out) {
+    AckMessage ack;
+    ack.code = success ? RespCode::Ok : RespCode::Invalid;
+    ack.timestamp = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+    if (streamId != 0) {
+        // 流帧的ACK只携带流信息：归还一帧额度(流已关闭时为0)；限速间隔经非流帧的ACK或服务器命令下发
+        uint16_t credit = 0;
+        if (auto it = streams_.find(streamId); it != streams_.end() && !it->second.closing && it->second.inFlight > 0) {
+            --it->second.inFlight;
+            credit = 1;
         }
+        ack.cmd = CmdId::StreamAck;
+        ack.cmdPayload = pack_stream_ack(streamId, credit);
+        return encode_ack_payload(ack, out);
+    }
+    int interval = 0;
+    if (runtimeConfig_->adaptiveInterval.load()) {
+        interval = metrics_->targetIntervalMs.load(std::memory_order_relaxed);
+    }
+    if (interval == 0 && runtimeConfig_->intervalControl.load()) {
+        interval = runtimeConfig_->forcedIntervalMs.load();
+    }
+    if (interval > 0) {
+        ack.cmd = CmdId::SetInterval;
+        ack.cmdPayload = static_cast<quint32>(interval);
+        currentRow_.intervalMs = interval;
     }
-    return payload;
+    return encode_ack_payload(ack, out);
 }
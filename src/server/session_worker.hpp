@@ -1,15 +1,28 @@
 #pragma once
 
+#include "common/buffer_pool.hpp"
+#include "common/frame_trace.hpp"
+#include "common/send_queue.hpp"
+#include "common/transport.hpp"
+#include "broadcast_hub.hpp"
 #include "connection_model.hpp"
+#include "message_dispatcher.hpp"
 #include "server_runtime.hpp"
+#include "session_metrics.hpp"
 
 #include <QtCore/QByteArray>
 #include <QtCore/QObject>
-#include <QtCore/QScopedPointer>
 #include <QtCore/QUuid>
-#include <QtNetwork/QTcpSocket>
 
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class QTcpSocket;
+class QThread;
 
 namespace cs::protocol {
 class ProtocolParser;
@@ -20,31 +33,112 @@ class SessionWorker : public QObject {
     Q_OBJECT
 
 public:
+    // 接管transport的所有权，transport成为会话的子对象，随会话一起moveToThread()
+    SessionWorker(cs::common::Transport *transport, QString connectionId, std::shared_ptr<ServerRuntimeConfig> runtime,
+                  QObject *parent = nullptr);
     SessionWorker(QTcpSocket *socket, QString connectionId, std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent = nullptr);
     ~SessionWorker() override;
 
+    std::shared_ptr<SessionMetrics> metrics() const { return metrics_; }
+    // 已发出finished()；可从其他线程读取
+    bool isFinished() const { return finished_.load(std::memory_order_acquire); }
+    // 在会话当前线程的两次事件之间调用(由SessionScheduler投递)，把会话连同传输移到thread；
+    // 已结束、正在关闭或整体停机时不迁移。结果由migrated()报告
+    void migrateTo(QThread *thread);
+
 public slots:
     void start();
+    // 发出待写数据后断开，不阻塞所在线程(线程上可能还有其他会话)：收到disconnected或等待超时后发出finished()
     void stop();
+    // 集群成员变化后由Listener调用：客户端已归其他节点时下发重定向命令并断开
+    void rebalance();
+    // RateController的目标间隔变化时由Listener投递：立即以Control级别下发SetInterval命令，
+    // 不经过广播收件箱(满时丢最旧的帧)，也不排在已排队的推送之后
+    void pushInterval(int intervalMs);
 
 signals:
     void connectionUpdated(ConnectionRow row);
     void frameReceived(QString connectionId, QByteArray payload);
     void invalidPacket(QString connectionId, QString reason);
     void finished(QString connectionId);
+    void migrated(QString connectionId, bool moved);
 
 private slots:
     void onReadyRead();
     void onDisconnected();
+    void closeAfterRedirect();
+    // stop()等待断开超时：强制关闭并结束会话
+    void finishStop();
 
 private:
-    void sendAck(bool success);
-    QByteArray buildAckPayload(bool success);
+    static constexpr qint64 kBroadcastHighWaterBytes = 256 * 1024;
+    // 因写缓冲超限暂停读取期间的接收缓冲上限
+    static constexpr qint64 kPausedReadBufferBytes = 4 * 1024;
 
-    QScopedPointer<QTcpSocket> socket_;
+    // streamId为0表示不属于任何逻辑流
+    void handleBatch(const QByteArray &payload, uint32_t traceId, uint16_t streamId = 0);
+    void handleStream(const QByteArray &payload, uint32_t traceId);
+    void routePayload(const QByteArray &payload, std::vector<HandlerRequest> *requests);
+    void drainBroadcast();
+    void dispatch(std::vector<HandlerRequest> requests, cs::protocol::RespCode code, uint32_t traceId,
+                  uint16_t streamId = 0);
+    void onHandlerResults(const QVector<cs::protocol::RespCode> &results);
+    void onStreamResults(uint16_t streamId, const QVector<cs::protocol::RespCode> &results);
+    void emitFrameReceived(const QByteArray &payload);
+    void updateMemory();
+    void reportInvalid(const QString &reason);
+    // 客户端标识归其他节点时写出Redirect命令并返回true；本地传输与未发送标识的客户端不参与集群分配
+    bool redirectIfForeign();
+    void sendAck(bool success, qint64 receivedNs, uint32_t traceId, uint16_t streamId);
+    void flushAcks();
+    int encodeAckPayload(bool success, uint16_t streamId, char *out);
+    // 传输层待写与发送队列中排队的字节合计
+    qint64 outboundBytes() const;
+
+    cs::common::Transport *transport_;
     QString connectionId_;
+    // PayloadAnalytics的草图键与分片，构造时按会话ID和对端地址算好
+    quint64 analyticsSession_ = 0;
+    quint64 analyticsAddress_ = 0;
+    int analyticsStripe_ = 0;
     std::shared_ptr<ServerRuntimeConfig> runtimeConfig_;
+    std::shared_ptr<SessionMetrics> metrics_;
     std::unique_ptr<cs::protocol::ProtocolParser> parser_;
+    qint64 readBufferBytes_ = 0;  // 建立时的接收缓冲上限(0为不限)，恢复读取时还原
+    uint8_t replyVersion_ = cs::protocol::kDefaultVersion;  // ACK沿用客户端最近一帧的版本(校验方式)
+    std::shared_ptr<MessageDispatcher::SessionQueue> handlerQueue_;
+    struct PendingAck {
+        qint64 receivedNs = 0;
+        uint32_t traceId = 0;
+        qint64 requestBytes = 0;
+        uint16_t streamId = 0;
+    };
+    // 逻辑流的会话侧状态，首帧到达时建立，收到空的流帧且该流的任务全部应答后删除
+    struct StreamState {
+        int inFlight = 0;         // 已收到尚未ACK的帧，超过kStreamWindow视为客户端违反额度
+        uint16_t lastMsgId = 0;
+        bool seen = false;
+        bool closing = false;     // 已收到关闭帧，等待pendingJobs清空
+        // 每条流单独排队：ACK只在流内保序，慢流不会挡住其他流与非流帧的ACK
+        std::shared_ptr<MessageDispatcher::SessionQueue> handlerQueue;
+        std::deque<PendingAck> pendingJobs;
+    };
+    using StreamMap = std::unordered_map<uint16_t, StreamState>;
+    void eraseStream(StreamMap::iterator it);
+
+    StreamMap streams_;
+    quint64 streamOutOfOrder_ = 0;  // 各流内MsgId不连续的累计次数
+    std::deque<PendingAck> pendingJobs_;  // 不属于流、已提交给线程池但结果尚未送回的任务，记录各自的读取时刻
+    qint64 pendingHandlerBytes_ = 0;      // pendingJobs_与各流pendingJobs中请求payload的合计字节
+    qint64 readNs_ = 0;  // 当前读事件开始的时刻，用于统计ACK延迟
+    std::shared_ptr<BroadcastHub::Inbox> broadcastInbox_;
+    bool broadcastBlocked_ = false;  // 因写缓冲积压暂停取广播帧
+    cs::common::SendQueue sendQueue_;  // 服务器命令 > ACK > 推送，见cs::common::SendPriority
+    cs::common::BumpArena ackArena_;  // 一次读事件内产生的ACK帧，处理完后一次性写出
+    std::vector<uint32_t> tracedAcks_;  // arena中被采样追踪的ACK，写出后打点
+    std::string clientId_;  // 客户端Hello中的标识，为空表示未声明
+    bool redirected_ = false;  // 已下发重定向，等待断开
     ConnectionRow currentRow_;
-    bool finished_ = false;  // 防止重复触发finished信号
+    bool stopping_ = false;  // stop()已开始，等待断开
+    std::atomic<bool> finished_{false};  // 防止重复触发finished信号，见isFinished()
 };
@@ -0,0 +1,251 @@
+#include "socket_handoff.hpp"
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#ifdef Q_OS_UNIX
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_UNIX
+QString errno_string(const char *step) {
+    return QStringLiteral("%1: %2").arg(QLatin1String(step), QString::fromLocal8Bit(std::strerror(errno)));
+}
+
+bool wait_fd(int fd, short events, const QDeadlineTimer &deadline) {
+    pollfd pfd{fd, events, 0};
+    while (true) {
+        const int rc = ::poll(&pfd, 1, static_cast<int>(deadline.remainingTime()));
+        if (rc > 0) {
+            return true;
+        }
+        if (rc == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+#endif
+
+}  // namespace
+
+SocketHandoff::SocketHandoff(QObject *parent) : QObject(parent) {}
+
+SocketHandoff::~SocketHandoff() {
+    close();
+}
+
+bool SocketHandoff::supported() {
+#ifdef Q_OS_UNIX
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<qintptr> SocketHandoff::receive(const QString &path, int timeoutMs, QString *error) {
+    std::vector<qintptr> descriptors;
+#ifdef Q_OS_UNIX
+    const QDeadlineTimer deadline(timeoutMs);
+    // 与QLocalServer一致：非绝对路径位于临时目录下
+    const QString fullPath = path.startsWith(QLatin1Char('/')) ? path : QDir::tempPath() + QLatin1Char('/') + path;
+    const QByteArray nativePath = QFile::encodeName(fullPath);
+    sockaddr_un addr{};
+    if (nativePath.size() >= static_cast<int>(sizeof(addr.sun_path))) {
+        if (error) {
+            *error = QStringLiteral("路径过长: %1").arg(path);
+        }
+        return descriptors;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, nativePath.constData(), static_cast<std::size_t>(nativePath.size()));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        if (error) {
+            *error = errno_string("socket");
+        }
+        return descriptors;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        if (error) {
+            *error = errno_string("connect");
+        }
+        ::close(fd);
+        return descriptors;
+    }
+
+    if (!wait_fd(fd, POLLIN, deadline)) {
+        if (error) {
+            *error = QStringLiteral("等待旧进程发送监听套接字超时");
+        }
+        ::close(fd);
+        return descriptors;
+    }
+
+    char count = 0;
+    iovec iov{&count, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxDescriptors)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+        if (error) {
+            *error = errno_string("recvmsg");
+        }
+        ::close(fd);
+        return descriptors;
+    }
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        const std::size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const auto *fds = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+        for (std::size_t i = 0; i < n; ++i) {
+            descriptors.push_back(fds[i]);
+        }
+    }
+
+    // 等待旧进程关闭握手通道，确保其已释放path后再由本进程复用
+    char eof = 0;
+    while (wait_fd(fd, POLLIN, deadline) && ::read(fd, &eof, 1) > 0) {
+    }
+    ::close(fd);
+
+    if (descriptors.size() != static_cast<std::size_t>(static_cast<unsigned char>(count)) && error) {
+        *error = QStringLiteral("期望 %1 个描述符，实际收到 %2 个").arg(int(static_cast<unsigned char>(count))).arg(descriptors.size());
+    }
+#else
+    Q_UNUSED(path);
+    Q_UNUSED(timeoutMs);
+    if (error) {
+        *error = QStringLiteral("当前平台不支持套接字交接");
+    }
+#endif
+    return descriptors;
+}
+
+quint16 SocketHandoff::localPort(qintptr descriptor) {
+#ifdef Q_OS_UNIX
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (::getsockname(static_cast<int>(descriptor), reinterpret_cast<sockaddr *>(&addr), &len) == 0) {
+        return ntohs(addr.sin_port);
+    }
+#else
+    Q_UNUSED(descriptor);
+#endif
+    return 0;
+}
+
+bool SocketHandoff::listen(const QString &path, QString *error) {
+    close();
+    server_ = new QLocalServer(this);
+    QLocalServer::removeServer(path);
+    if (!server_->listen(path)) {
+        if (error) {
+            *error = server_->errorString();
+        }
+        delete server_;
+        server_ = nullptr;
+        return false;
+    }
+    connect(server_, &QLocalServer::newConnection, this, &SocketHandoff::handleNewConnection);
+    return true;
+}
+
+void SocketHandoff::close() {
+    if (successor_) {
+        successor_->abort();
+        successor_->deleteLater();
+        successor_ = nullptr;
+    }
+    if (server_) {
+        server_->close();
+        server_->deleteLater();
+        server_ = nullptr;
+    }
+}
+
+bool SocketHandoff::isListening() const {
+    return server_ && server_->isListening();
+}
+
+QString SocketHandoff::path() const {
+    return server_ ? server_->fullServerName() : QString();
+}
+
+void SocketHandoff::handleNewConnection() {
+    auto *socket = server_->nextPendingConnection();
+    if (!socket) {
+        return;
+    }
+    if (successor_) {
+        socket->abort();
+        socket->deleteLater();
+        return;  // 同一时间只接受一个接替者
+    }
+    successor_ = socket;
+    emit successorConnected();
+}
+
+bool SocketHandoff::transfer(const std::vector<qintptr> &descriptors, QString *error) {
+#ifdef Q_OS_UNIX
+    if (!successor_ || descriptors.empty() || descriptors.size() > static_cast<std::size_t>(kMaxDescriptors)) {
+        if (error) {
+            *error = QStringLiteral("没有可交接的接替进程或监听套接字");
+        }
+        return false;
+    }
+    const int channel = static_cast<int>(successor_->socketDescriptor());
+    char count = static_cast<char>(descriptors.size());
+    iovec iov{&count, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxDescriptors)] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * descriptors.size());
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * descriptors.size());
+    auto *fds = reinterpret_cast<int *>(CMSG_DATA(cmsg));
+    for (std::size_t i = 0; i < descriptors.size(); ++i) {
+        fds[i] = static_cast<int>(descriptors[i]);
+    }
+
+    const QDeadlineTimer deadline(1000);
+    ssize_t sent = -1;
+    do {
+        sent = ::sendmsg(channel, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && (errno == EINTR || (errno == EAGAIN && wait_fd(channel, POLLOUT, deadline))));
+    const bool ok = sent == 1;
+    if (!ok && error) {
+        *error = errno_string("sendmsg");
+    }
+    // 先撤销path再断开通道，接替者看到EOF时即可安全复用该path
+    close();
+    return ok;
+#else
+    Q_UNUSED(descriptors);
+    if (error) {
+        *error = QStringLiteral("当前平台不支持套接字交接");
+    }
+    return false;
+#endif
+}
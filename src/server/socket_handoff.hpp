@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <vector>
+
+class QLocalServer;
+class QLocalSocket;
+
+// 热重启时在新旧进程之间通过Unix域套接字(SCM_RIGHTS)传递监听套接字。
+// 旧进程调用listen()等待接替者；新进程调用receive()取得描述符。
+class SocketHandoff : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kMaxDescriptors = 64;
+
+    explicit SocketHandoff(QObject *parent = nullptr);
+    ~SocketHandoff() override;
+
+    static bool supported();
+    // 新进程侧：连接path并阻塞接收描述符，旧进程关闭通道后返回
+    static std::vector<qintptr> receive(const QString &path, int timeoutMs, QString *error);
+    static quint16 localPort(qintptr descriptor);
+
+    bool listen(const QString &path, QString *error);
+    void close();
+    bool isListening() const;
+    QString path() const;
+
+    // 旧进程侧：把描述符发给已连接的接替者，随后关闭握手通道
+    bool transfer(const std::vector<qintptr> &descriptors, QString *error);
+
+signals:
+    void successorConnected();
+
+private slots:
+    void handleNewConnection();
+
+private:
+    QLocalServer *server_ = nullptr;
+    QLocalSocket *successor_ = nullptr;
+};
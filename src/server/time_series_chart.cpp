@@ -0,0 +1,89 @@
+#include "time_series_chart.hpp"
+
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPath>
+
+namespace {
+
+QString format_value(double value) {
+    if (value >= 1e6) {
+        return QString::number(value / 1e6, 'f', 1) + QLatin1Char('M');
+    }
+    if (value >= 1e3) {
+        return QString::number(value / 1e3, 'f', 1) + QLatin1Char('K');
+    }
+    return QString::number(value, 'f', value < 10 ? 1 : 0);
+}
+
+}  // namespace
+
+TimeSeriesChart::TimeSeriesChart(const QString &title, const QString &unit, QWidget *parent)
+    : QWidget(parent),
+      title_(title),
+      unit_(unit) {
+    setMinimumHeight(110);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TimeSeriesChart::setSeries(QVector<Series> series, int capacity) {
+    series_ = std::move(series);
+    capacity_ = qMax(2, capacity);
+    update();
+}
+
+QSize TimeSeriesChart::sizeHint() const {
+    return QSize(300, 130);
+}
+
+void TimeSeriesChart::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(0xfa, 0xfa, 0xfa));
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    const QFontMetrics fm(font());
+    const int header = fm.height() + 4;
+    const QRect plot = rect().adjusted(6, header, -6, -4);
+    painter.setPen(QColor(0xd0, 0xd0, 0xd0));
+    painter.drawRect(plot);
+
+    double maxValue = 0.0;
+    for (const auto &s : series_) {
+        for (const double v : s.values) {
+            maxValue = qMax(maxValue, v);
+        }
+    }
+    const double top = maxValue > 0.0 ? maxValue * 1.1 : 1.0;
+
+    // 标题、最新值与纵轴上限
+    painter.setPen(Qt::black);
+    QString headerText = title_;
+    for (const auto &s : series_) {
+        if (!s.values.isEmpty()) {
+            headerText += QStringLiteral("  %1 %2").arg(s.name, format_value(s.values.last()));
+        }
+    }
+    painter.drawText(QRect(6, 2, width() - 12, header), Qt::AlignLeft | Qt::AlignVCenter, headerText);
+    painter.setPen(Qt::gray);
+    painter.drawText(plot.adjusted(2, 0, -2, 0), Qt::AlignRight | Qt::AlignTop,
+                     QStringLiteral("%1 %2").arg(format_value(top), unit_));
+
+    const double step = double(plot.width()) / double(capacity_ - 1);
+    for (const auto &s : series_) {
+        if (s.values.size() < 2) {
+            continue;
+        }
+        QPainterPath path;
+        const int offset = capacity_ - static_cast<int>(s.values.size());
+        for (int i = 0; i < s.values.size(); ++i) {
+            const QPointF point(plot.left() + (offset + i) * step,
+                                plot.bottom() - s.values[i] / top * plot.height());
+            if (i == 0) {
+                path.moveTo(point);
+            } else {
+                path.lineTo(point);
+            }
+        }
+        painter.setPen(QPen(s.color, 1.5));
+        painter.drawPath(path);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QColor>
+#include <QtWidgets/QWidget>
+
+// 轻量折线图：直接用QPainter绘制若干条等间距序列，纵轴自动取最大值，不依赖Qt Charts。
+class TimeSeriesChart : public QWidget {
+    Q_OBJECT
+
+public:
+    struct Series {
+        QString name;
+        QColor color;
+        QVector<double> values;
+    };
+
+    explicit TimeSeriesChart(const QString &title, const QString &unit, QWidget *parent = nullptr);
+
+    // capacity为横轴点数，数据不足时靠右绘制
+    void setSeries(QVector<Series> series, int capacity);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QString title_;
+    QString unit_;
+    QVector<Series> series_;
+    int capacity_ = 1;
+};
@@ -0,0 +1,313 @@
+#include "udp_receiver.hpp"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSocketNotifier>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QNetworkDatagram>
+#include <QtNetwork/QUdpSocket>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "payload_analytics.hpp"
+#include "server_stats.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+constexpr int kReceiveBufferBytes = 8 * 1024 * 1024;
+
+}  // namespace
+
+UdpReceiver::UdpReceiver(std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent)
+    : QObject(parent),
+      runtime_(std::move(runtime)) {
+    if (runtime_->dispatcher) {
+        // 遥测不回ACK，处理结果直接丢弃
+        handlerQueue_ = runtime_->dispatcher->openSession(this, [](const QVector<RespCode> &) {});
+    }
+}
+
+UdpReceiver::~UdpReceiver() {
+    close();
+    if (handlerQueue_) {
+        handlerQueue_->close();
+    }
+}
+
+bool UdpReceiver::open(quint16 port, QString *error) {
+    close();
+#ifdef Q_OS_LINUX
+    const auto fail = [this, error](const char *step) {
+        if (error) {
+            *error = QStringLiteral("%1: %2").arg(QLatin1String(step), QString::fromLocal8Bit(std::strerror(errno)));
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        return false;
+    };
+    // 双栈套接字同时接收IPv4(映射地址)与IPv6
+    fd_ = ::socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return fail("socket");
+    }
+    const int off = 0;
+    ::setsockopt(fd_, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    const int rcvbuf = kReceiveBufferBytes;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        return fail("bind");
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    port_ = ntohs(addr.sin6_port);
+    buffers_.resize(static_cast<std::size_t>(kBatchDatagrams) * kMaxDatagramBytes);
+    notifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+    connect(notifier_, &QSocketNotifier::activated, this, &UdpReceiver::onReadable);
+    return true;
+#else
+    socket_ = new QUdpSocket(this);
+    if (!socket_->bind(QHostAddress::Any, port)) {
+        if (error) {
+            *error = socket_->errorString();
+        }
+        delete socket_;
+        socket_ = nullptr;
+        return false;
+    }
+    socket_->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, kReceiveBufferBytes);
+    port_ = socket_->localPort();
+    connect(socket_, &QUdpSocket::readyRead, this, &UdpReceiver::onReadable);
+    return true;
+#endif
+}
+
+void UdpReceiver::close() {
+#ifdef Q_OS_LINUX
+    delete notifier_;
+    notifier_ = nullptr;
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buffers_.clear();
+    buffers_.shrink_to_fit();
+#else
+    delete socket_;
+    socket_ = nullptr;
+#endif
+    port_ = 0;
+}
+
+bool UdpReceiver::isOpen() const {
+#ifdef Q_OS_LINUX
+    return fd_ >= 0;
+#else
+    return socket_ != nullptr;
+#endif
+}
+
+quint16 UdpReceiver::port() const {
+    return port_;
+}
+
+std::vector<UdpReceiver::SourceStats> UdpReceiver::sources() const {
+    QMutexLocker locker(&mutex_);
+    std::vector<SourceStats> out;
+    out.reserve(static_cast<std::size_t>(sources_.size()));
+    for (const SourceState &source : sources_) {
+        out.push_back(source.stats);
+    }
+    return out;
+}
+
+quint64 UdpReceiver::evictedSources() const {
+    QMutexLocker locker(&mutex_);
+    return evicted_;
+}
+
+UdpReceiver::SourceState &UdpReceiver::admitSource(const SourceKey &key, const QHostAddress &address) {
+    const auto it = sources_.find(key);
+    if (it != sources_.end()) {
+        return it.value();
+    }
+    if (sources_.size() >= kMaxSources) {
+        std::vector<std::pair<qint64, SourceKey>> byAge;
+        byAge.reserve(static_cast<std::size_t>(sources_.size()));
+        for (auto source = sources_.cbegin(); source != sources_.cend(); ++source) {
+            byAge.emplace_back(source.value().stats.lastSeenMs, source.key());
+        }
+        const auto cut = byAge.begin() + kEvictBatch;
+        std::nth_element(byAge.begin(), cut, byAge.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (auto victim = byAge.begin(); victim != cut; ++victim) {
+            sources_.remove(victim->second);
+        }
+        evicted_ += kEvictBatch;
+    }
+    SourceState &source = sources_[key];
+    source.stats.address = address.toString();
+    source.stats.port = key.port;
+    return source;
+}
+
+void UdpReceiver::onReadable() {
+#ifdef Q_OS_LINUX
+    mmsghdr messages[kBatchDatagrams];
+    iovec iovecs[kBatchDatagrams];
+    sockaddr_in6 senders[kBatchDatagrams];
+    // 一次recvmmsg最多取一整批，读到EAGAIN为止，每批只加一次锁
+    while (fd_ >= 0) {
+        for (int i = 0; i < kBatchDatagrams; ++i) {
+            iovecs[i].iov_base = buffers_.data() + static_cast<std::size_t>(i) * kMaxDatagramBytes;
+            iovecs[i].iov_len = kMaxDatagramBytes;
+            std::memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &senders[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+        }
+        const int received = ::recvmmsg(fd_, messages, kBatchDatagrams, MSG_DONTWAIT, nullptr);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        QMutexLocker locker(&mutex_);
+        for (int i = 0; i < received; ++i) {
+            SourceKey key;
+            std::memcpy(&key.high, senders[i].sin6_addr.s6_addr, 8);
+            std::memcpy(&key.low, senders[i].sin6_addr.s6_addr + 8, 8);
+            key.port = ntohs(senders[i].sin6_port);
+            SourceState &source = admitSource(key, QHostAddress(reinterpret_cast<const sockaddr *>(&senders[i])));
+            handleDatagram(static_cast<const char *>(iovecs[i].iov_base), static_cast<qsizetype>(messages[i].msg_len),
+                           source);
+        }
+        if (received < kBatchDatagrams) {
+            return;
+        }
+    }
+#else
+    while (socket_ && socket_->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = socket_->receiveDatagram(kMaxDatagramBytes);
+        const Q_IPV6ADDR address = datagram.senderAddress().toIPv6Address();
+        SourceKey key;
+        std::memcpy(&key.high, address.c, 8);
+        std::memcpy(&key.low, address.c + 8, 8);
+        key.port = static_cast<quint16>(datagram.senderPort());
+        QMutexLocker locker(&mutex_);
+        SourceState &source = admitSource(key, datagram.senderAddress());
+        const QByteArray data = datagram.data();
+        handleDatagram(data.constData(), data.size(), source);
+    }
+#endif
+}
+
+void UdpReceiver::handleDatagram(const char *data, qsizetype size, SourceState &source) {
+    source.stats.datagrams += 1;
+    source.stats.bytes += static_cast<quint64>(size);
+    source.stats.lastSeenMs = QDateTime::currentMSecsSinceEpoch();
+    if (source.analyticsSession == 0) {
+        const QByteArray address = source.stats.address.toUtf8();
+        source.analyticsSession = PayloadAnalytics::sessionKey(
+            QByteArrayLiteral("udp:").append(address).append(':').append(QByteArray::number(source.stats.port)).toStdString());
+        source.analyticsAddress = PayloadAnalytics::addressKey(address.toStdString());
+    }
+
+    // 数据报之间不存在跨报的帧，每个数据报单独解析
+    parser_.clear();
+    parser_.append(data, size);
+    std::vector<HandlerRequest> requests;
+    quint64 frames = 0;
+    FrameView view;
+    while (true) {
+        FrameError error = FrameError::None;
+        if (!parser_.nextFrameView(&view, &error)) {
+            if (error != FrameError::None || parser_.bufferedBytes() > 0) {
+                source.stats.invalid += 1;  // 错误帧或被截断的尾部
+                if (runtime_->counters) {
+                    runtime_->counters->errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            break;
+        }
+        ++frames;
+        RequestHeader header;
+        if (!decode_request_header(view.payload, view.payloadSize, &header)) {
+            continue;
+        }
+        trackMsgId(source, header.msgId);
+        if (header.type == MsgType::Batch) {
+            QVector<QByteArray> entries;
+            if (!split_batch(QByteArray::fromRawData(view.payload, view.payloadSize), &entries, nullptr)) {
+                source.stats.invalid += 1;
+                continue;
+            }
+            for (const QByteArray &entry : std::as_const(entries)) {
+                route(entry, source, &requests);
+            }
+            continue;
+        }
+        route(view.payloadCopy(), source, &requests);
+    }
+    source.stats.frames += frames;
+    if (runtime_->counters) {
+        runtime_->counters->framesIn.fetch_add(frames, std::memory_order_relaxed);
+        runtime_->counters->bytesIn.fetch_add(static_cast<quint64>(size), std::memory_order_relaxed);
+    }
+    if (!requests.empty()) {
+        runtime_->dispatcher->submit(handlerQueue_, std::move(requests));
+    }
+}
+
+void UdpReceiver::trackMsgId(SourceState &source, quint16 msgId) {
+    if (!source.started) {
+        source.started = true;
+        source.nextMsgId = static_cast<quint16>(msgId + 1);
+        return;
+    }
+    // MsgId为16位回绕序号：向前跳过的部分记为丢失，落后的帧视为乱序到达并冲抵一次丢失
+    const auto delta = static_cast<quint16>(msgId - source.nextMsgId);
+    if (delta == 0) {
+        source.nextMsgId = static_cast<quint16>(msgId + 1);
+    } else if (delta < 0x8000) {
+        source.stats.lost += delta;
+        source.nextMsgId = static_cast<quint16>(msgId + 1);
+    } else {
+        source.stats.reordered += 1;
+        if (source.stats.lost > 0) {
+            source.stats.lost -= 1;
+        }
+    }
+}
+
+void UdpReceiver::route(const QByteArray &payload, const SourceState &source, std::vector<HandlerRequest> *requests) {
+    if (runtime_->analytics) {
+        runtime_->analytics->record(PayloadAnalytics::stripeFor(source.analyticsSession), source.analyticsSession,
+                                    source.analyticsAddress, payload.constData(), std::size_t(payload.size()));
+    }
+    RequestHeader header;
+    if (!decode_request_header(payload.constData(), payload.size(), &header)) {
+        return;
+    }
+    if (runtime_->dispatcher && runtime_->dispatcher->hasHandler(uint8_t(header.type))) {
+        requests->push_back(HandlerRequest{QStringLiteral("udp"), header, payload});
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "message_dispatcher.hpp"
+#include "server_runtime.hpp"
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <memory>
+#include <vector>
+
+#include "common/protocol.hpp"
+
+class QHostAddress;
+class QSocketNotifier;
+class QUdpSocket;
+
+// UDP遥测接收：每个数据报携带一个或多个完整帧(与TCP相同的build_frame格式)，不回ACK。
+// Linux上用recvmmsg一次取一批数据报；按来源地址统计MsgId缺口估算丢包。
+// 来源数有上限，超出时淘汰最久未收到数据的来源，伪造源地址的流量不会让统计表无限增长。
+// 对象须在其所属线程中调用open()/close()，统计可从任意线程读取。
+class UdpReceiver : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kBatchDatagrams = 64;
+    static constexpr int kMaxDatagramBytes = 65536;
+    static constexpr int kMaxSources = 4096;
+    // 来源表满时一次淘汰的个数，摊薄查找最旧来源的开销
+    static constexpr int kEvictBatch = kMaxSources / 16;
+
+    struct SourceStats {
+        QString address;
+        quint16 port = 0;
+        quint64 datagrams = 0;
+        quint64 frames = 0;
+        quint64 bytes = 0;
+        quint64 lost = 0;       // MsgId缺口累计，迟到的帧会冲抵
+        quint64 reordered = 0;  // 比已见最大MsgId更旧的帧(乱序或重复)
+        quint64 invalid = 0;    // 数据报中无法解析的帧
+        qint64 lastSeenMs = 0;
+
+        double lossRate() const { return frames + lost == 0 ? 0.0 : double(lost) / double(frames + lost); }
+    };
+
+    explicit UdpReceiver(std::shared_ptr<ServerRuntimeConfig> runtime, QObject *parent = nullptr);
+    ~UdpReceiver() override;
+
+    bool open(quint16 port, QString *error);
+    void close();
+    bool isOpen() const;
+    quint16 port() const;
+
+    std::vector<SourceStats> sources() const;
+    // 因来源表满被淘汰的来源累计数
+    quint64 evictedSources() const;
+
+private slots:
+    void onReadable();
+
+private:
+    struct SourceKey {
+        quint64 high = 0;
+        quint64 low = 0;
+        quint16 port = 0;
+
+        bool operator==(const SourceKey &other) const {
+            return high == other.high && low == other.low && port == other.port;
+        }
+    };
+    friend size_t qHash(const SourceKey &key, size_t seed) noexcept {
+        return qHashMulti(seed, key.high, key.low, key.port);
+    }
+
+    struct SourceState {
+        SourceStats stats;
+        quint16 nextMsgId = 0;
+        bool started = false;
+        quint64 analyticsSession = 0;  // 载荷统计的键，首个数据报时按"udp:地址:端口"与地址计算
+        quint64 analyticsAddress = 0;
+    };
+
+    // 须持有mutex_；新来源在表满时先淘汰最久未见的kEvictBatch个
+    SourceState &admitSource(const SourceKey &key, const QHostAddress &address);
+    void handleDatagram(const char *data, qsizetype size, SourceState &source);
+    void trackMsgId(SourceState &source, quint16 msgId);
+    void route(const QByteArray &payload, const SourceState &source, std::vector<HandlerRequest> *requests);
+
+    std::shared_ptr<ServerRuntimeConfig> runtime_;
+    std::shared_ptr<MessageDispatcher::SessionQueue> handlerQueue_;
+    cs::protocol::ProtocolParser parser_;
+    mutable QMutex mutex_;  // 保护sources_，界面线程定期读取
+    QHash<SourceKey, SourceState> sources_;
+    quint64 evicted_ = 0;
+    quint16 port_ = 0;
+#ifdef Q_OS_LINUX
+    int fd_ = -1;
+    QSocketNotifier *notifier_ = nullptr;
+    std::vector<char> buffers_;  // kBatchDatagrams个接收缓冲，整批复用
+#else
+    QUdpSocket *socket_ = nullptr;
+#endif
+};
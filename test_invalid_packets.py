@@ -201,6 +201,65 @@ def test_case_10_wrong_version(sock):
     sock.sendall(bytes(frame))
     time.sleep(0.5)
 
+def parse_ack_payload(payload):
+    """按协议文档解析ACK: [RespCode(1)][Timestamp(8)][CmdId(1)][CmdPayload(CmdId=1~4时4字节)][Host(仅Redirect，可选)]
+    与C++端AckSchema一致，格式不符时抛出ValueError"""
+    if len(payload) < 10:
+        raise ValueError(f"ACK长度不足: {len(payload)}")
+    code, timestamp, cmd = struct.unpack('>BQB', payload[:10])
+    expected = 14 if cmd in (0x01, 0x02, 0x03, 0x04) else 10
+    # Redirect(0x03)的端口之后可跟最多255字节的目标主机名
+    max_len = expected + 255 if cmd == 0x03 else expected
+    if not expected <= len(payload) <= max_len:
+        raise ValueError(f"CmdId=0x{cmd:02X} 时ACK应为{expected}字节, 实际{len(payload)}")
+    interval = struct.unpack('>I', payload[10:14])[0] if cmd == 0x01 else None
+    return code, timestamp, cmd, interval
+
+def split_frames(data):
+    """从响应字节流中切出完整帧的payload，并校验CRC"""
+    payloads = []
+    offset = 0
+    while offset + 7 <= len(data):
+        if data[offset] != 0xAA:
+            raise ValueError(f"偏移{offset}处不是SOF")
+        length = struct.unpack('>H', data[offset + 2:offset + 4])[0]
+        end = offset + 7 + length
+        if end > len(data):
+            break
+        crc = struct.unpack('>H', data[end - 3:end - 1])[0]
+        if crc != crc16_ibm(data[offset + 1:end - 3]) or data[end - 1] != 0x55:
+            raise ValueError(f"偏移{offset}处的响应帧校验失败")
+        payloads.append(data[offset + 4:end - 3])
+        offset = end
+    return payloads
+
+def test_case_11_payload_fuzz(host, port, rounds=200):
+    """测试用例11: 随机请求payload模糊测试（帧合法、payload任意），校验每个ACK都符合线格式"""
+    print(f"\n[测试11] 发送{rounds}个随机payload的合法帧，校验ACK格式...")
+    import random
+    rng = random.Random(31)
+    with socket.create_connection((host, port), timeout=5.0) as fuzz_sock:
+        for _ in range(rounds):
+            size = rng.randint(0, 24)
+            payload = bytes(rng.randint(0, 255) for _ in range(size))
+            if size and rng.random() < 0.5:
+                payload = bytes([rng.choice([0x01, 0x02, 0x03, 0x04, 0x10])]) + payload[1:]
+            fuzz_sock.sendall(create_valid_frame(payload))
+        time.sleep(1.0)
+        data = b""
+        fuzz_sock.settimeout(0.5)
+        try:
+            while True:
+                chunk = fuzz_sock.recv(65536)
+                if not chunk:
+                    break
+                data += chunk
+        except socket.timeout:
+            pass
+    acks = [parse_ack_payload(p) for p in split_frames(data)]
+    codes = {code for code, _, _, _ in acks}
+    print(f"✓ 收到{len(acks)}个ACK，全部符合线格式 (RespCode集合: {sorted(codes)})")
+
 def main():
     HOST = '127.0.0.1'
     PORT = 8080
@@ -247,6 +306,12 @@ def main():
             except Exception as e:
                 print(f"✗ 测试失败: {e}")
             time.sleep(0.5)
+
+        # 模糊测试使用独立连接，避免前面截断帧残留在服务器解析缓冲区中
+        try:
+            test_case_11_payload_fuzz(HOST, PORT)
+        except Exception as e:
+            print(f"✗ 测试失败: {e}")
         
         print("\n" + "=" * 60)
         print("测试完成！")
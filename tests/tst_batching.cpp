@@ -0,0 +1,227 @@
+#include <QtTest/QtTest>
+
+#include <memory>
+
+#include "client_controller.hpp"
+#include "common/loopback_transport.hpp"
+#include "common/protocol.hpp"
+#include "server_runtime.hpp"
+#include "server_stats.hpp"
+#include "session_worker.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+// 每条子消息请求头3字节加10字节Body，连同SubLen占15字节；64字节的预算恰好容纳3条
+constexpr int kBudgetBytes = 64;
+constexpr int kEntriesPerBatch = 3;
+
+QByteArray body(int i) {
+    return QByteArray::number(i).rightJustified(10, '0');
+}
+
+QByteArray entry(uint16_t msgId, const QByteArray &content) {
+    return build_request_payload(MsgType::Text, msgId, content);
+}
+
+QByteArray batch_of(const QVector<QByteArray> &entries) {
+    QByteArray payload = begin_batch_payload(7);
+    for (const QByteArray &sub : entries) {
+        append_batch_entry(payload, sub);
+    }
+    return payload;
+}
+
+QByteArray with_count(QByteArray payload, uint16_t count) {
+    payload[3] = char(count >> 8);
+    payload[4] = char(count & 0xFF);
+    return payload;
+}
+
+}  // namespace
+
+// 协议层的拆包校验，以及ClientController合并发送与SessionWorker整批应答的端到端行为；
+// 两端经回环传输直连，通知由LoopbackScheduler按顺序执行
+class BatchingTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        runtime_ = std::make_shared<ServerRuntimeConfig>();
+        runtime_->counters = std::make_shared<ServerCounters>();
+        auto [client, server] = cs::common::LoopbackTransport::createPair(&scheduler_);
+        controller_ = std::make_unique<ClientController>();
+        controller_->setTrafficLogging(false);
+        controller_->setTransport(client);
+        worker_ = std::make_unique<SessionWorker>(server, QStringLiteral("test"), runtime_);
+        worker_->start();
+        QSignalSpy connected(controller_.get(), &ClientController::connected);
+        controller_->connectToHost(QStringLiteral("loopback"), 0);
+        scheduler_.runUntilIdle();
+        QCOMPARE(connected.count(), 1);
+    }
+
+    void cleanup() {
+        controller_.reset();
+        scheduler_.runUntilIdle();
+        worker_.reset();
+        scheduler_.runUntilIdle();
+    }
+
+    // 组包后拆出的子消息与写入时一致，Count随每次追加递增
+    void roundTrip() {
+        const QVector<QByteArray> entries = {entry(1, "a"), entry(2, QByteArray()), entry(3, QByteArray(300, 'x'))};
+        const QByteArray payload = batch_of(entries);
+        QCOMPARE(payload.left(kBatchHeaderBytes), QByteArray::fromHex("0300070003"));
+        QVector<QByteArray> split;
+        QString error;
+        QVERIFY2(split_batch(payload, &split, &error), qPrintable(error));
+        QCOMPARE(split, entries);
+
+        QVERIFY(split_batch(begin_batch_payload(1), &split));
+        QVERIFY(split.isEmpty());
+    }
+
+    void malformed_data() {
+        const QByteArray valid = batch_of({entry(1, "a"), entry(2, "b")});
+        QTest::addColumn<QByteArray>("payload");
+        QTest::addColumn<QString>("reason");
+        QTest::newRow("short header") << valid.left(kBatchHeaderBytes - 1) << "Batch header truncated";
+        QTest::newRow("not batch") << entry(1, "abcd") << "Batch header truncated";
+        QTest::newRow("length missing") << with_count(valid, 3) << "Batch entry 2 length missing";
+        QTest::newRow("entry too short") << batch_of({QByteArray("ab")}) << "Batch entry 0 length 2 invalid";
+        QTest::newRow("entry truncated") << valid.left(valid.size() - 1) << "Batch entry 1 length 4 invalid";
+        QTest::newRow("nested") << batch_of({batch_of({entry(1, "a")})}) << "Nested batch not allowed";
+        QTest::newRow("trailing") << with_count(valid, 1) << "Batch has 6 trailing bytes";
+    }
+
+    void malformed() {
+        QFETCH(QByteArray, payload);
+        QFETCH(QString, reason);
+        QVector<QByteArray> split;
+        QString error;
+        QVERIFY(!split_batch(payload, &split, &error));
+        QCOMPARE(error, reason);
+    }
+
+    // 服务器对每条子消息各发一次frameReceived，整批只回一个ACK；格式错误的批量计为错误并回Invalid
+    void serverAcksOncePerBatch() {
+        auto [client, server] = cs::common::LoopbackTransport::createPair(&scheduler_);
+        std::unique_ptr<cs::common::LoopbackTransport> raw(client);
+        SessionWorker worker(server, QStringLiteral("raw"), runtime_);
+        worker.start();
+        QSignalSpy frames(&worker, &SessionWorker::frameReceived);
+        QSignalSpy invalid(&worker, &SessionWorker::invalidPacket);
+
+        const QVector<QByteArray> entries = {entry(1, "a"), entry(2, "b"), entry(3, "c")};
+        const QByteArray valid = batch_of(entries);
+        raw->write(build_frame(kDefaultVersion, valid));
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), entries.size());
+        for (int i = 0; i < entries.size(); ++i) {
+            QCOMPARE(frames.at(i).at(1).toByteArray(), entries.at(i));
+        }
+
+        raw->write(build_frame(kDefaultVersion, valid + 'z'));
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), entries.size());
+        QCOMPARE(invalid.count(), 1);
+        QCOMPARE(invalid.first().at(1).toString(), QStringLiteral("Batch has 1 trailing bytes"));
+
+        ProtocolParser parser;
+        parser.append(raw->readAll());
+        QVector<int> codes;
+        while (const auto parsed = parser.nextFrame()) {
+            AckMessage ack;
+            QVERIFY(decode_ack_payload(parsed->frame.payload.constData(), parsed->frame.payload.size(), &ack));
+            codes.append(int(ack.code));
+        }
+        QCOMPARE(codes, (QVector<int>{int(RespCode::Ok), int(RespCode::Invalid)}));
+        QCOMPARE(runtime_->counters->acks.load(), quint64(2));
+        QCOMPARE(runtime_->counters->errors.load(), quint64(1));
+
+        raw.reset();
+        scheduler_.runUntilIdle();
+    }
+
+    // 预算内的消息在flushBatch()前不发送，发出后服务器按顺序收到全部子消息，客户端只收到一个ACK
+    void flushSendsOneFrame() {
+        QSignalSpy frames(worker_.get(), &SessionWorker::frameReceived);
+        QSignalSpy responses(controller_.get(), &ClientController::responseReceived);
+        controller_->setBatching(kMaxPayloadBytes, 60000);
+        for (int i = 0; i < 5; ++i) {
+            controller_->queuePayload(body(i));
+        }
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), 0);
+
+        controller_->flushBatch();
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), 5);
+        for (int i = 0; i < 5; ++i) {
+            QCOMPARE(frames.at(i).at(1).toByteArray().mid(kRequestHeaderBytes), body(i));
+        }
+        QCOMPARE(responses.count(), 1);
+        QCOMPARE(runtime_->counters->acks.load(), quint64(1));
+    }
+
+    // 下一条放不下时先发出当前批量；最后不满的一批等待flushBatch()
+    void budgetSplitsBatches() {
+        QSignalSpy frames(worker_.get(), &SessionWorker::frameReceived);
+        QSignalSpy responses(controller_.get(), &ClientController::responseReceived);
+        controller_->setBatching(kBudgetBytes, 60000);
+        constexpr int kMessages = kEntriesPerBatch * 3;
+        for (int i = 0; i < kMessages; ++i) {
+            controller_->queuePayload(body(i));
+        }
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), kMessages - kEntriesPerBatch);
+        QCOMPARE(responses.count(), 2);
+
+        controller_->flushBatch();
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), kMessages);
+        for (int i = 0; i < kMessages; ++i) {
+            QCOMPARE(frames.at(i).at(1).toByteArray().mid(kRequestHeaderBytes), body(i));
+        }
+        QCOMPARE(responses.count(), 3);
+    }
+
+    // 超出预算的单条消息先冲刷已排队的批量，再作为普通请求单独发送，顺序不变
+    void oversizedSentAlone() {
+        QSignalSpy frames(worker_.get(), &SessionWorker::frameReceived);
+        QSignalSpy responses(controller_.get(), &ClientController::responseReceived);
+        controller_->setBatching(kBudgetBytes, 60000);
+        const QByteArray large(kBudgetBytes, 'L');
+        controller_->queuePayload(body(0));
+        controller_->queuePayload(large);
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), 2);
+        QCOMPARE(frames.at(0).at(1).toByteArray().mid(kRequestHeaderBytes), body(0));
+        QCOMPARE(frames.at(1).at(1).toByteArray().mid(kRequestHeaderBytes), large);
+        QCOMPARE(responses.count(), 2);
+    }
+
+    // 未开启合并时queuePayload逐条发送
+    void disabledSendsPlainFrames() {
+        QSignalSpy frames(worker_.get(), &SessionWorker::frameReceived);
+        QSignalSpy responses(controller_.get(), &ClientController::responseReceived);
+        controller_->setBatching(0, 0);
+        for (int i = 0; i < 3; ++i) {
+            controller_->queuePayload(body(i));
+        }
+        scheduler_.runUntilIdle();
+        QCOMPARE(frames.count(), 3);
+        QCOMPARE(responses.count(), 3);
+    }
+
+private:
+    cs::common::LoopbackScheduler scheduler_;
+    std::shared_ptr<ServerRuntimeConfig> runtime_;
+    std::unique_ptr<ClientController> controller_;
+    std::unique_ptr<SessionWorker> worker_;
+};
+
+QTEST_GUILESS_MAIN(BatchingTest)
+#include "tst_batching.moc"
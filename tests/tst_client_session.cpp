@@ -0,0 +1,115 @@
+#include <QtTest/QtTest>
+
+#include <memory>
+
+#include "client_controller.hpp"
+#include "client_stream.hpp"
+#include "common/loopback_transport.hpp"
+#include "common/protocol.hpp"
+#include "server_runtime.hpp"
+#include "server_stats.hpp"
+#include "session_worker.hpp"
+
+using namespace cs::protocol;
+
+// ClientController与SessionWorker经进程内回环传输直连，通知全部由LoopbackScheduler按顺序执行，
+// 不依赖网络与事件循环时序；不注册业务处理器，所有ACK都在会话线程上直接应答
+class ClientSessionTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        runtime_ = std::make_shared<ServerRuntimeConfig>();
+        runtime_->counters = std::make_shared<ServerCounters>();
+        auto [client, server] = cs::common::LoopbackTransport::createPair(&scheduler_);
+        controller_ = std::make_unique<ClientController>();
+        controller_->setTrafficLogging(false);
+        controller_->setTransport(client);
+        worker_ = std::make_unique<SessionWorker>(server, QStringLiteral("test"), runtime_);
+        worker_->start();
+        QSignalSpy connected(controller_.get(), &ClientController::connected);
+        controller_->connectToHost(QStringLiteral("loopback"), 0);
+        scheduler_.runUntilIdle();
+        QCOMPARE(connected.count(), 1);
+    }
+
+    void cleanup() {
+        controller_.reset();
+        scheduler_.runUntilIdle();
+        worker_.reset();
+        scheduler_.runUntilIdle();
+    }
+
+    // 每条请求得到一个ACK，按发送顺序到达
+    void acksEveryRequest() {
+        QSignalSpy responses(controller_.get(), &ClientController::responseReceived);
+        for (int i = 0; i < 10; ++i) {
+            controller_->sendPayload(QByteArray::number(i));
+        }
+        scheduler_.runUntilIdle();
+        QCOMPARE(responses.count(), 10);
+        for (const QList<QVariant> &args : std::as_const(responses)) {
+            AckMessage ack;
+            const QByteArray payload = args.at(0).toByteArray();
+            QVERIFY(decode_ack_payload(payload.constData(), payload.size(), &ack));
+            QCOMPARE(ack.code, RespCode::Ok);
+        }
+        QCOMPARE(runtime_->counters->acks.load(), quint64(10));
+        QCOMPARE(runtime_->counters->errors.load(), quint64(0));
+    }
+
+    // 超过额度的消息在客户端排队，随StreamAck归还的额度依次发出，MsgId在流内连续
+    void streamCreditRefills() {
+        ClientStream *stream = controller_->openStream();
+        QVERIFY(stream);
+        QSignalSpy acknowledged(stream, &ClientStream::acknowledged);
+        constexpr int kMessages = kStreamWindow + 8;
+        for (int i = 0; i < kMessages; ++i) {
+            stream->send(QByteArray::number(i));
+        }
+        QCOMPARE(stream->credit(), 0);
+        QCOMPARE(stream->queued(), kMessages - kStreamWindow);
+
+        scheduler_.runUntilIdle();
+        QCOMPARE(acknowledged.count(), kMessages);
+        for (int i = 0; i < kMessages; ++i) {
+            QCOMPARE(acknowledged.at(i).at(0).value<quint16>(), quint16(i + 1));
+            QVERIFY(acknowledged.at(i).at(1).toBool());
+        }
+        QCOMPARE(stream->credit(), kStreamWindow);
+        QCOMPARE(stream->queued(), 0);
+    }
+
+    // 流帧与普通请求交错时，StreamAck交给所属的流，三个ACK都计入控制器的确认数
+    void streamAndPlainInterleave() {
+        ClientStream *stream = controller_->openStream();
+        QVERIFY(stream);
+        QSignalSpy acknowledged(stream, &ClientStream::acknowledged);
+        QSignalSpy stats(controller_.get(), &ClientController::statisticsUpdated);
+        stream->send(QByteArrayLiteral("s1"));
+        controller_->sendPayload(QByteArrayLiteral("p1"));
+        stream->send(QByteArrayLiteral("s2"));
+        scheduler_.runUntilIdle();
+        QCOMPARE(acknowledged.count(), 2);
+        QVERIFY(!stats.isEmpty());
+        QCOMPARE(stats.last().at(1).toInt(), 3);
+    }
+
+    // 客户端断开后会话结束
+    void disconnectFinishesSession() {
+        QSignalSpy finished(worker_.get(), &SessionWorker::finished);
+        controller_->disconnectFromHost();
+        scheduler_.runUntilIdle();
+        QCOMPARE(finished.count(), 1);
+        QCOMPARE(finished.first().at(0).toString(), QStringLiteral("test"));
+    }
+
+private:
+    cs::common::LoopbackScheduler scheduler_;
+    std::shared_ptr<ServerRuntimeConfig> runtime_;
+    std::unique_ptr<ClientController> controller_;
+    std::unique_ptr<SessionWorker> worker_;
+};
+
+QTEST_GUILESS_MAIN(ClientSessionTest)
+#include "tst_client_session.moc"
@@ -0,0 +1,110 @@
+#include <QtTest/QtTest>
+
+#include <vector>
+
+#include "common/crc32c.hpp"
+#include "common/protocol.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+uint32_t crc_of(const QByteArray &data) {
+    return crc32c(reinterpret_cast<const uint8_t *>(data.constData()), std::size_t(data.size()));
+}
+
+}  // namespace
+
+class Crc32cTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    // 标准校验值与RFC 3720(iSCSI)附录B.4的测试向量
+    void knownVectors_data() {
+        QTest::addColumn<QByteArray>("data");
+        QTest::addColumn<uint>("expected");
+        QByteArray increasing(32, 0);
+        QByteArray decreasing(32, 0);
+        for (int i = 0; i < 32; ++i) {
+            increasing[i] = char(i);
+            decreasing[i] = char(31 - i);
+        }
+        QTest::newRow("check") << QByteArrayLiteral("123456789") << 0xE3069283u;
+        QTest::newRow("empty") << QByteArray() << 0x00000000u;
+        QTest::newRow("zeros") << QByteArray(32, '\0') << 0x8A9136AAu;
+        QTest::newRow("ones") << QByteArray(32, char(0xFF)) << 0x62A8AB43u;
+        QTest::newRow("increasing") << increasing << 0x46DD794Eu;
+        QTest::newRow("decreasing") << decreasing << 0x113FDB5Cu;
+    }
+
+    void knownVectors() {
+        QFETCH(QByteArray, data);
+        QFETCH(uint, expected);
+        QCOMPARE(crc_of(data), uint32_t(expected));
+        QCOMPARE(crc32c_software(reinterpret_cast<const uint8_t *>(data.constData()), std::size_t(data.size())),
+                 uint32_t(expected));
+    }
+
+    // 硬件指令与查表实现对任意长度、任意对齐起点结果一致
+    void hardwareMatchesSoftware() {
+        std::vector<uint8_t> data(4096 + 16);
+        uint32_t seed = 12345;
+        for (uint8_t &byte : data) {
+            seed = seed * 1103515245u + 12345u;
+            byte = uint8_t(seed >> 16);
+        }
+        for (std::size_t offset = 0; offset < 8; ++offset) {
+            for (std::size_t size : {std::size_t(0), std::size_t(1), std::size_t(7), std::size_t(8), std::size_t(9),
+                                     std::size_t(63), std::size_t(64), std::size_t(1000), std::size_t(4096)}) {
+                QCOMPARE(crc32c(data.data() + offset, size), crc32c_software(data.data() + offset, size));
+            }
+        }
+    }
+
+    // 0x02帧整帧往返，篡改payload后报CRC错误
+    void frameRoundTrip() {
+        const QByteArray payload = build_request_payload(MsgType::Text, 42, QByteArrayLiteral("crc32c"));
+        const QByteArray frame = build_frame(kVersionCrc32c, payload);
+        QCOMPARE(frame.size(), frame_overhead_bytes(kVersionCrc32c) + payload.size());
+
+        ProtocolParser parser;
+        parser.append(frame);
+        FrameView view;
+        FrameError error = FrameError::None;
+        QVERIFY(parser.nextFrameView(&view, &error));
+        QCOMPARE(view.version, kVersionCrc32c);
+        QCOMPARE(view.payloadCopy(), payload);
+
+        // 出错后解析器跳到下一个SOF继续；后面跟一个正常帧，返回该帧并保留之前的错误
+        QByteArray corrupted = frame;
+        corrupted[5] = char(corrupted[5] ^ 0x01);
+        ProtocolParser strict;
+        strict.append(corrupted + frame);
+        QVERIFY(strict.nextFrameView(&view, &error));
+        QCOMPARE(error, FrameError::InvalidCRC);
+        QCOMPARE(view.payloadCopy(), payload);
+    }
+
+    // 不带校验的0x03帧只在显式开启后接受
+    void uncheckedNeedsOptIn() {
+        const QByteArray frame = build_frame(kVersionUnchecked, build_request_payload(MsgType::Text, 1, QByteArrayLiteral("x")));
+        FrameView view;
+        FrameError error = FrameError::None;
+
+        const QByteArray checked = build_frame(kVersionCrc16, build_request_payload(MsgType::Text, 2, QByteArrayLiteral("y")));
+        ProtocolParser remote;
+        remote.append(frame + checked);
+        QVERIFY(remote.nextFrameView(&view, &error));
+        QCOMPARE(error, FrameError::UnsupportedVersion);
+        QCOMPARE(view.version, kVersionCrc16);
+
+        ProtocolParser local;
+        local.setAcceptUnchecked(true);
+        local.append(frame);
+        QVERIFY(local.nextFrameView(&view, &error));
+        QCOMPARE(view.version, kVersionUnchecked);
+    }
+};
+
+QTEST_GUILESS_MAIN(Crc32cTest)
+#include "tst_crc32c.moc"
@@ -0,0 +1,183 @@
+#include <QtTest/QtTest>
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+
+#include <memory>
+#include <set>
+
+#include "common/frame_trace.hpp"
+
+using cs::common::FrameTracer;
+using Stage = FrameTracer::Stage;
+
+namespace {
+
+QJsonArray read_events(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("traceEvents")).toArray();
+}
+
+// 按 区间名/帧ID 查找区间事件
+QJsonObject find_span(const QJsonArray &events, const QString &name, uint32_t traceId) {
+    for (const QJsonValue &value : events) {
+        const QJsonObject event = value.toObject();
+        if (event.value(QStringLiteral("ph")).toString() == QStringLiteral("X") &&
+            event.value(QStringLiteral("name")).toString() == name &&
+            event.value(QStringLiteral("args")).toObject().value(QStringLiteral("frame")).toInteger() == traceId) {
+            return event;
+        }
+    }
+    return {};
+}
+
+}  // namespace
+
+// 追踪器是进程级单例，每个用例开始前清空各线程的环
+class FrameTraceTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        QVERIFY(dir_.isValid());
+        path_ = dir_.filePath(QStringLiteral("trace.json"));
+        FrameTracer::clear();
+        FrameTracer::setEnabled(true);
+    }
+
+    void cleanup() {
+        FrameTracer::setEnabled(false);
+        FrameTracer::clear();
+    }
+
+    // 未开启时不分配追踪ID，ID为0的打点不写入
+    void disabledRecordsNothing() {
+        FrameTracer::setEnabled(false);
+        QVERIFY(!FrameTracer::enabled());
+        const uint32_t traceId = FrameTracer::begin();
+        QCOMPARE(traceId, 0u);
+        FrameTracer::record(traceId, Stage::Read);
+        FrameTracer::record(traceId, Stage::Parsed);
+        QString error;
+        QCOMPARE(FrameTracer::exportChromeTrace(path_, &error), 0);
+        QVERIFY(read_events(path_).isEmpty());
+    }
+
+    // 按1/N采样：连续N*k帧恰好采中k帧，ID互不相同且非0
+    void samplesOneInN() {
+        FrameTracer::setEnabled(true, 4);
+        std::set<uint32_t> ids;
+        for (int i = 0; i < 40; ++i) {
+            const uint32_t traceId = FrameTracer::begin();
+            if (traceId != 0) {
+                QVERIFY(ids.insert(traceId).second);
+            }
+        }
+        QCOMPARE(ids.size(), std::size_t(10));
+    }
+
+    // 相邻两个时刻都存在才生成区间；时间以最早的打点为原点，单位微秒
+    void exportsSpans() {
+        const uint32_t full = FrameTracer::begin();
+        const uint32_t partial = FrameTracer::begin();
+        QVERIFY(full != 0 && partial != 0);
+        FrameTracer::record(full, Stage::Read, 1000);
+        FrameTracer::record(full, Stage::Parsed, 3000);
+        FrameTracer::record(full, Stage::Dispatched, 6000);
+        FrameTracer::record(full, Stage::AckWritten, 10000);
+        FrameTracer::record(partial, Stage::Read, 2000);
+        FrameTracer::record(partial, Stage::Dispatched, 5000);
+
+        QString error;
+        QCOMPARE(FrameTracer::exportChromeTrace(path_, &error), 3);
+        QVERIFY(FrameTracer::enabled());
+        const QJsonArray events = read_events(path_);
+        const QJsonObject parse = find_span(events, QStringLiteral("parse"), full);
+        QCOMPARE(parse.value(QStringLiteral("ts")).toDouble(), 0.0);
+        QCOMPARE(parse.value(QStringLiteral("dur")).toDouble(), 2.0);
+        const QJsonObject dispatch = find_span(events, QStringLiteral("dispatch"), full);
+        QCOMPARE(dispatch.value(QStringLiteral("ts")).toDouble(), 2.0);
+        QCOMPARE(dispatch.value(QStringLiteral("dur")).toDouble(), 3.0);
+        const QJsonObject ack = find_span(events, QStringLiteral("ack"), full);
+        QCOMPARE(ack.value(QStringLiteral("ts")).toDouble(), 5.0);
+        QCOMPARE(ack.value(QStringLiteral("dur")).toDouble(), 4.0);
+        QVERIFY(find_span(events, QStringLiteral("parse"), partial).isEmpty());
+        QVERIFY(find_span(events, QStringLiteral("dispatch"), partial).isEmpty());
+    }
+
+    // 同一帧的打点分布在两个线程：区间画在结束时刻所在的线程上，线程名取自QThread::objectName()
+    void spansFollowThreads() {
+        const uint32_t traceId = FrameTracer::begin();
+        FrameTracer::record(traceId, Stage::Read, 1000);
+        FrameTracer::record(traceId, Stage::Parsed, 2000);
+        std::unique_ptr<QThread> worker(QThread::create([traceId]() {
+            FrameTracer::record(traceId, Stage::Dispatched, 3000);
+            FrameTracer::record(traceId, Stage::AckWritten, 4000);
+        }));
+        worker->setObjectName(QStringLiteral("trace-worker"));
+        worker->start();
+        QVERIFY(worker->wait(5000));
+
+        QString error;
+        QCOMPARE(FrameTracer::exportChromeTrace(path_, &error), 3);
+        const QJsonArray events = read_events(path_);
+        int workerTid = 0;
+        for (const QJsonValue &value : events) {
+            const QJsonObject event = value.toObject();
+            if (event.value(QStringLiteral("ph")).toString() == QStringLiteral("M") &&
+                event.value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString() ==
+                    QStringLiteral("trace-worker")) {
+                workerTid = event.value(QStringLiteral("tid")).toInt();
+            }
+        }
+        QVERIFY(workerTid != 0);
+        QVERIFY(find_span(events, QStringLiteral("parse"), traceId).value(QStringLiteral("tid")).toInt() != workerTid);
+        QCOMPARE(find_span(events, QStringLiteral("dispatch"), traceId).value(QStringLiteral("tid")).toInt(), workerTid);
+        QCOMPARE(find_span(events, QStringLiteral("ack"), traceId).value(QStringLiteral("tid")).toInt(), workerTid);
+    }
+
+    // 环写满后覆盖最早的事件，导出只包含最近kEventsPerThread条
+    void ringKeepsNewest() {
+        constexpr int kOverwritten = 5;
+        constexpr int kFrames = int(FrameTracer::kEventsPerThread / 2) + kOverwritten;
+        uint32_t first = 0;
+        uint32_t last = 0;
+        for (int i = 0; i < kFrames; ++i) {
+            const uint32_t traceId = FrameTracer::begin();
+            FrameTracer::record(traceId, Stage::Read, 1000 + i);
+            FrameTracer::record(traceId, Stage::Parsed, 2000 + i);
+            first = first == 0 ? traceId : first;
+            last = traceId;
+        }
+        QString error;
+        QCOMPARE(FrameTracer::exportChromeTrace(path_, &error), kFrames - kOverwritten);
+        const QJsonArray events = read_events(path_);
+        QVERIFY(find_span(events, QStringLiteral("parse"), first).isEmpty());
+        QVERIFY(!find_span(events, QStringLiteral("parse"), last).isEmpty());
+    }
+
+    // 无法写入时返回-1并给出原因，追踪状态不受影响
+    void exportFailure() {
+        const uint32_t traceId = FrameTracer::begin();
+        FrameTracer::record(traceId, Stage::Read, 1000);
+        FrameTracer::record(traceId, Stage::Parsed, 2000);
+        QString error;
+        QCOMPARE(FrameTracer::exportChromeTrace(dir_.filePath(QStringLiteral("missing/trace.json")), &error), -1);
+        QVERIFY(!error.isEmpty());
+        QVERIFY(FrameTracer::enabled());
+    }
+
+private:
+    QTemporaryDir dir_;
+    QString path_;
+};
+
+QTEST_GUILESS_MAIN(FrameTraceTest)
+#include "tst_frame_trace.moc"
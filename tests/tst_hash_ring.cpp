@@ -0,0 +1,142 @@
+#include <QtTest/QtTest>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cluster_ring.hpp"
+
+namespace {
+
+constexpr int kKeys = 30000;
+
+std::string client_key(int i) {
+    return "client-" + std::to_string(i);
+}
+
+}  // namespace
+
+class HashRingTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void emptyRing() {
+        const HashRing ring;
+        QVERIFY(ring.empty());
+        QCOMPARE(ring.ownerIndex("client"), -1);
+        QVERIFY(ring.owner("client") == nullptr);
+    }
+
+    // 节点顺序与重复不影响结果：各节点进程独立构造出同一个环
+    void orderIndependent() {
+        const HashRing a({"10.0.0.1:9000", "10.0.0.2:9000", "10.0.0.3:9000"});
+        const HashRing b({"10.0.0.3:9000", "10.0.0.1:9000", "10.0.0.2:9000", "10.0.0.1:9000"});
+        QCOMPARE(a.nodes().size(), std::size_t(3));
+        QVERIFY(a.nodes() == b.nodes());
+        for (int i = 0; i < 1000; ++i) {
+            QCOMPARE(*a.owner(client_key(i)), *b.owner(client_key(i)));
+        }
+    }
+
+    // 每个节点128个虚拟点，三节点时各自的份额偏离均值不超过一半
+    void balanced() {
+        const HashRing ring({"a:1", "b:2", "c:3"});
+        std::vector<int> counts(ring.nodes().size(), 0);
+        for (int i = 0; i < kKeys; ++i) {
+            ++counts[std::size_t(ring.ownerIndex(client_key(i)))];
+        }
+        const int fair = kKeys / int(counts.size());
+        for (const int count : counts) {
+            QVERIFY2(count > fair / 2 && count < fair * 3 / 2, qPrintable(QString::number(count)));
+        }
+    }
+
+    // 加入一个节点只有约1/N的键换了归属，且全部换到新节点；删除节点只影响原属于它的键
+    void minimalMovement() {
+        const HashRing three({"a:1", "b:2", "c:3"});
+        const HashRing four({"a:1", "b:2", "c:3", "d:4"});
+        int moved = 0;
+        for (int i = 0; i < kKeys; ++i) {
+            const std::string key = client_key(i);
+            if (*three.owner(key) != *four.owner(key)) {
+                ++moved;
+                QCOMPARE(*four.owner(key), std::string("d:4"));
+            }
+        }
+        QVERIFY2(moved > kKeys * 15 / 100 && moved < kKeys * 35 / 100, qPrintable(QString::number(moved)));
+
+        const HashRing withoutB({"a:1", "c:3"});
+        for (int i = 0; i < kKeys; i += 7) {
+            const std::string key = client_key(i);
+            if (*three.owner(key) != "b:2") {
+                QCOMPARE(*withoutB.owner(key), *three.owner(key));
+            }
+        }
+    }
+
+    void splitNode_data() {
+        QTest::addColumn<QString>("node");
+        QTest::addColumn<bool>("ok");
+        QTest::addColumn<QByteArray>("host");
+        QTest::addColumn<int>("port");
+        QTest::newRow("host") << "example.com:9000" << true << QByteArray("example.com") << 9000;
+        QTest::newRow("empty host") << ":9001" << true << QByteArray() << 9001;
+        QTest::newRow("ipv6") << "[::1]:80" << true << QByteArray("[::1]") << 80;
+        QTest::newRow("max port") << "h:65535" << true << QByteArray("h") << 65535;
+        QTest::newRow("no colon") << "example.com" << false << QByteArray() << 0;
+        QTest::newRow("no port") << "h:" << false << QByteArray() << 0;
+        QTest::newRow("zero") << "h:0" << false << QByteArray() << 0;
+        QTest::newRow("too large") << "h:65536" << false << QByteArray() << 0;
+        QTest::newRow("overflow") << "h:99999999999" << false << QByteArray() << 0;
+        QTest::newRow("not digits") << "h:12a" << false << QByteArray() << 0;
+    }
+
+    void splitNode() {
+        QFETCH(QString, node);
+        QFETCH(bool, ok);
+        QFETCH(QByteArray, host);
+        QFETCH(int, port);
+        const std::string text = node.toStdString();
+        QByteArray parsedHost;
+        quint16 parsedPort = 0;
+        QCOMPARE(HashRing::splitNode(text, &parsedHost, &parsedPort), ok);
+        if (ok) {
+            QCOMPARE(parsedHost, host);
+            QCOMPARE(int(parsedPort), port);
+        }
+    }
+
+    // 未组成集群、空标识或归属本节点时不重定向
+    void routerRedirects() {
+        ClusterRouter router;
+        router.setSelf("a:1");
+        QVERIFY(!router.redirectTarget("client-1"));
+
+        auto ring = std::make_shared<const HashRing>(std::vector<std::string>{"a:1", "b:2"});
+        router.update(ring);
+        QVERIFY(!router.redirectTarget(""));
+        int local = 0;
+        int foreign = 0;
+        for (int i = 0; i < 200; ++i) {
+            const std::string key = client_key(i);
+            const auto target = router.redirectTarget(key);
+            if (*ring->owner(key) == "a:1") {
+                QVERIFY(!target);
+                ++local;
+            } else {
+                QVERIFY(target);
+                QCOMPARE(*target, std::string("b:2"));
+                ++foreign;
+            }
+        }
+        QVERIFY(local > 0 && foreign > 0);
+
+        router.update(nullptr);
+        for (int i = 0; i < 200; ++i) {
+            QVERIFY(!router.redirectTarget(client_key(i)));
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(HashRingTest)
+#include "tst_hash_ring.moc"
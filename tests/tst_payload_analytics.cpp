@@ -0,0 +1,140 @@
+#include <QtTest/QtTest>
+
+#include <memory>
+
+#include "common/protocol.hpp"
+#include "payload_analytics.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+void record(PayloadAnalytics &analytics, quint64 session, quint64 address, const QByteArray &payload) {
+    analytics.record(PayloadAnalytics::stripeFor(session), session, address, payload.constData(),
+                     std::size_t(payload.size()));
+}
+
+int slot_of(uint8_t type) {
+    for (int slot = 0; slot < PayloadAnalytics::kTypeSlots; ++slot) {
+        if (PayloadAnalytics::slotType(slot) == type) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+class PayloadAnalyticsTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    // count-min只会高估；误差上界为总量的 e/kSketchWidth
+    void countMinNeverUnderestimates() {
+        auto analytics = std::make_unique<PayloadAnalytics>();
+        const QByteArray payload = build_request_payload(MsgType::Text, 1, QByteArrayLiteral("x"));
+        const quint64 address = PayloadAnalytics::addressKey("10.0.0.1");
+        quint64 total = 0;
+        for (int i = 0; i < 500; ++i) {
+            const quint64 session = PayloadAnalytics::sessionKey(QStringLiteral("s%1").arg(i).toStdString());
+            for (int n = 0; n <= i % 7; ++n) {
+                record(*analytics, session, address, payload);
+                ++total;
+            }
+        }
+        const quint64 hot = PayloadAnalytics::sessionKey("hot");
+        for (int n = 0; n < 1000; ++n) {
+            record(*analytics, hot, address, payload);
+        }
+        total += 1000;
+
+        const PayloadAnalytics::Snapshot snapshot = analytics->snapshot();
+        const auto slack = quint64(2.72 * double(2 * total) / PayloadAnalytics::kSketchWidth) + 1;
+        QVERIFY(snapshot.estimateFrames(hot) >= 1000);
+        QVERIFY(snapshot.estimateFrames(hot) <= 1000 + slack);
+        QVERIFY(snapshot.estimateBytes(hot) >= 1000 * quint64(payload.size()));
+        for (int i = 0; i < 500; i += 37) {
+            const quint64 session = PayloadAnalytics::sessionKey(QStringLiteral("s%1").arg(i).toStdString());
+            QVERIFY(snapshot.estimateFrames(session) >= quint64(i % 7 + 1));
+        }
+        // 地址与会话共用草图，前缀不同互不冲突
+        QVERIFY(snapshot.estimateFrames(address) >= total);
+        QCOMPARE(snapshot.totalFrames(), total);
+    }
+
+    // 各分片合并后与单一分片记录的结果一致
+    void stripesMerge() {
+        auto analytics = std::make_unique<PayloadAnalytics>();
+        const quint64 session = PayloadAnalytics::sessionKey("merged");
+        const quint64 address = PayloadAnalytics::addressKey("::1");
+        const QByteArray payload = build_request_payload(MsgType::Binary, 7, QByteArray(100, 'b'));
+        for (int stripe = 0; stripe < PayloadAnalytics::kStripes; ++stripe) {
+            analytics->record(stripe, session, address, payload.constData(), std::size_t(payload.size()));
+        }
+        const PayloadAnalytics::Snapshot snapshot = analytics->snapshot();
+        QCOMPARE(snapshot.estimateFrames(session), quint64(PayloadAnalytics::kStripes));
+        QCOMPARE(snapshot.estimateBytes(session), quint64(PayloadAnalytics::kStripes) * quint64(payload.size()));
+        QVERIFY(snapshot.distinctPayloads() < 1.5);
+    }
+
+    // HyperLogLog：标准误差约1.6%，这里允许5%；只有MsgId不同的内容计为一个
+    void distinctEstimate() {
+        auto analytics = std::make_unique<PayloadAnalytics>();
+        const quint64 session = PayloadAnalytics::sessionKey("hll");
+        const quint64 address = PayloadAnalytics::addressKey("127.0.0.1");
+        constexpr int kDistinct = 20000;
+        for (int i = 0; i < kDistinct; ++i) {
+            const QByteArray body = QByteArray::number(i);
+            record(*analytics, session, address, build_request_payload(MsgType::Text, uint16_t(i), body));
+            record(*analytics, session, address, build_request_payload(MsgType::Text, uint16_t(i + 1), body));
+        }
+        const double estimate = analytics->snapshot().distinctPayloads();
+        QVERIFY2(qAbs(estimate - kDistinct) < 0.05 * kDistinct, qPrintable(QString::number(estimate)));
+
+        auto small = std::make_unique<PayloadAnalytics>();
+        for (int i = 0; i < 100; ++i) {
+            record(*small, session, address, build_request_payload(MsgType::Text, uint16_t(i), QByteArrayLiteral("same")));
+        }
+        QVERIFY(qAbs(small->snapshot().distinctPayloads() - 1.0) < 0.5);
+    }
+
+    // 批量与逻辑流各有独立槽位，未知类型落在"其他"(type=0)
+    void typeSlots() {
+        auto analytics = std::make_unique<PayloadAnalytics>();
+        const quint64 session = PayloadAnalytics::sessionKey("types");
+        const quint64 address = PayloadAnalytics::addressKey("127.0.0.1");
+        for (const MsgType type : {MsgType::Text, MsgType::Binary, MsgType::Batch, MsgType::Stream, MsgType::Command,
+                                   MsgType::Subscribe, MsgType::Unsubscribe}) {
+            QVERIFY2(slot_of(uint8_t(type)) >= 0, qPrintable(QString::number(int(type), 16)));
+        }
+        record(*analytics, session, address, build_request_payload(MsgType::Batch, 1, QByteArray(10, 'a')));
+        record(*analytics, session, address, build_request_payload(MsgType::Stream, 2, QByteArray(10, 'a')));
+        record(*analytics, session, address, build_request_payload(MsgType::Stream, 3, QByteArray(10, 'b')));
+        record(*analytics, session, address, build_request_payload(MsgType::Hello, 4, QByteArrayLiteral("client")));
+
+        const auto types = analytics->typeStats();
+        QCOMPARE(types[std::size_t(slot_of(uint8_t(MsgType::Batch)))].frames, quint64(1));
+        QCOMPARE(types[std::size_t(slot_of(uint8_t(MsgType::Stream)))].frames, quint64(2));
+        QCOMPARE(types[std::size_t(slot_of(0))].frames, quint64(1));
+        QCOMPARE(types[std::size_t(slot_of(uint8_t(MsgType::Text)))].frames, quint64(0));
+    }
+
+    // 大小分位数取所在2的幂分桶的上界
+    void sizeQuantiles() {
+        auto analytics = std::make_unique<PayloadAnalytics>();
+        const quint64 session = PayloadAnalytics::sessionKey("sizes");
+        const quint64 address = PayloadAnalytics::addressKey("127.0.0.1");
+        for (int i = 0; i < 99; ++i) {
+            record(*analytics, session, address, build_request_payload(MsgType::Text, 1, QByteArray(10 - kRequestHeaderBytes, 's')));
+        }
+        record(*analytics, session, address, build_request_payload(MsgType::Text, 1, QByteArray(5000, 'l')));
+        const auto types = analytics->typeStats();
+        const PayloadAnalytics::TypeStats &text = types[std::size_t(slot_of(uint8_t(MsgType::Text)))];
+        QCOMPARE(text.sizeQuantile(0.5), quint64(15));   // 10字节位于[8,16)
+        QCOMPARE(text.sizeQuantile(1.0), quint64(8191));  // 5003字节位于[4096,8192)
+        QCOMPARE(PayloadAnalytics::TypeStats{}.sizeQuantile(0.99), quint64(0));
+    }
+};
+
+QTEST_GUILESS_MAIN(PayloadAnalyticsTest)
+#include "tst_payload_analytics.moc"
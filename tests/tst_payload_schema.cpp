@@ -0,0 +1,176 @@
+#include <QtTest/QtTest>
+
+#include <array>
+#include <cstdint>
+
+#include "common/payload_schema.hpp"
+#include "common/protocol.hpp"
+
+using namespace cs::protocol;
+
+namespace {
+
+// 两个可选字段由同一标记的不同取值决定，覆盖protocol.hpp之外的组合
+enum class Kind : uint8_t { Plain = 0, WithShort = 1, WithLong = 2, WithBoth = 3 };
+
+struct Sample {
+    Kind kind = Kind::Plain;
+    uint32_t id = 0;
+    uint16_t extra = 0;
+    uint64_t wide = 0;
+};
+
+using SampleSchema =
+    schema::Schema<Sample, schema::Fixed<schema::Field<&Sample::kind>, schema::Field<&Sample::id>>,
+                   schema::Optional<schema::OptionalField<&Sample::extra, &Sample::kind, Kind::WithShort, Kind::WithBoth>,
+                                    schema::OptionalField<&Sample::wide, &Sample::kind, Kind::WithLong, Kind::WithBoth>>>;
+
+static_assert(SampleSchema::kFixedBytes == 5);
+static_assert(SampleSchema::kMaxBytes == 15);
+static_assert(kRequestHeaderBytes == 3);
+static_assert(kBatchHeaderBytes == 5);
+static_assert(kStreamHeaderBytes == 3);
+static_assert(kAckPayloadMinBytes == 10 && kAckPayloadMaxBytes == 14);
+
+// 编解码均为constexpr：编译期完成一次往返
+constexpr bool constexpr_round_trip() {
+    Sample in;
+    in.kind = Kind::WithBoth;
+    in.id = 0xDEADBEEF;
+    in.extra = 0x1234;
+    in.wide = 0x0102030405060708ULL;
+    uint8_t buffer[SampleSchema::kMaxBytes] = {};
+    const std::size_t size = SampleSchema::encode(in, buffer);
+    Sample out;
+    std::size_t consumed = 0;
+    return size == SampleSchema::kMaxBytes && SampleSchema::decode(buffer, size, &out, &consumed) &&
+           consumed == size && out.kind == in.kind && out.id == in.id && out.extra == in.extra && out.wide == in.wide;
+}
+static_assert(constexpr_round_trip());
+
+QByteArray bytes(const uint8_t *data, std::size_t size) {
+    return QByteArray(reinterpret_cast<const char *>(data), qsizetype(size));
+}
+
+}  // namespace
+
+class PayloadSchemaTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    // 多字节字段为大端序，枚举按底层类型写出
+    void bigEndianLayout() {
+        std::array<uint8_t, 8> buffer {};
+        schema::store_be<uint16_t>(buffer.data(), 0x1234);
+        QCOMPARE(bytes(buffer.data(), 2), QByteArray::fromHex("1234"));
+        schema::store_be<uint64_t>(buffer.data(), 0x0102030405060708ULL);
+        QCOMPARE(bytes(buffer.data(), 8), QByteArray::fromHex("0102030405060708"));
+        QCOMPARE(schema::load_be<uint64_t>(buffer.data()), uint64_t(0x0102030405060708ULL));
+        schema::store_be<MsgType>(buffer.data(), MsgType::Hello);
+        QCOMPARE(int(buffer[0]), 0x13);
+        QCOMPARE(schema::load_be<MsgType>(buffer.data()), MsgType::Hello);
+    }
+
+    // 可选字段按标记出现，解码时按同一规则读取，consumed之后为变长Body
+    void optionalFields_data() {
+        QTest::addColumn<int>("kind");
+        QTest::addColumn<int>("size");
+        QTest::newRow("plain") << int(Kind::Plain) << 5;
+        QTest::newRow("short") << int(Kind::WithShort) << 7;
+        QTest::newRow("long") << int(Kind::WithLong) << 13;
+        QTest::newRow("both") << int(Kind::WithBoth) << 15;
+    }
+
+    void optionalFields() {
+        QFETCH(int, kind);
+        QFETCH(int, size);
+        Sample in;
+        in.kind = Kind(kind);
+        in.id = 42;
+        in.extra = 0xBEEF;
+        in.wide = 0xFFFFFFFF00000001ULL;
+        std::array<uint8_t, SampleSchema::kMaxBytes + 3> buffer {};
+        QCOMPARE(SampleSchema::encoded_size(in), std::size_t(size));
+        QCOMPARE(SampleSchema::encode(in, buffer.data()), std::size_t(size));
+
+        // 尾部追加Body不影响解码
+        Sample out;
+        std::size_t consumed = 0;
+        QVERIFY(SampleSchema::decode(buffer.data(), std::size_t(size) + 3, &out, &consumed));
+        QCOMPARE(consumed, std::size_t(size));
+        QCOMPARE(out.kind, in.kind);
+        QCOMPARE(out.id, in.id);
+        const bool hasExtra = in.kind == Kind::WithShort || in.kind == Kind::WithBoth;
+        const bool hasWide = in.kind == Kind::WithLong || in.kind == Kind::WithBoth;
+        QCOMPARE(out.extra, hasExtra ? in.extra : uint16_t(0));
+        QCOMPARE(out.wide, hasWide ? in.wide : uint64_t(0));
+
+        // 定长部分不足、或标记存在的可选字段被截断时失败
+        for (int truncated = 0; truncated < size; ++truncated) {
+            Sample partial;
+            QVERIFY2(!SampleSchema::decode(buffer.data(), std::size_t(truncated), &partial),
+                     qPrintable(QString::number(truncated)));
+        }
+    }
+
+    void requestHeader() {
+        const QByteArray payload = build_request_payload(MsgType::Binary, 0xBEEF, QByteArrayLiteral("body"));
+        QCOMPARE(payload.left(kRequestHeaderBytes), QByteArray::fromHex("02beef"));
+        RequestHeader header;
+        QVERIFY(decode_request_header(payload.constData(), payload.size(), &header));
+        QCOMPARE(header.type, MsgType::Binary);
+        QCOMPARE(header.msgId, uint16_t(0xBEEF));
+        QCOMPARE(payload.mid(kRequestHeaderBytes), QByteArrayLiteral("body"));
+        QVERIFY(!decode_request_header(payload.constData(), kRequestHeaderBytes - 1, &header));
+    }
+
+    void streamHeader() {
+        const QByteArray inner = build_request_payload(MsgType::Text, 7, QByteArrayLiteral("x"));
+        const QByteArray payload = build_stream_payload(0x0102, inner);
+        StreamHeader header;
+        QVERIFY(decode_stream_header(payload.constData(), payload.size(), &header));
+        QCOMPARE(header.streamId, uint16_t(0x0102));
+        QCOMPARE(payload.mid(kStreamHeaderBytes), inner);
+        // 类型不是Stream的payload不按流头解析
+        QVERIFY(!decode_stream_header(inner.constData(), inner.size(), &header));
+    }
+
+    // ACK：CmdId为0x01~0x04时带4字节CmdPayload，否则只有定长部分
+    void ackRoundTrip_data() {
+        QTest::addColumn<int>("cmd");
+        QTest::addColumn<int>("size");
+        QTest::newRow("none") << int(CmdId::None) << kAckPayloadMinBytes;
+        QTest::newRow("interval") << int(CmdId::SetInterval) << kAckPayloadMaxBytes;
+        QTest::newRow("retry") << int(CmdId::RetryAfter) << kAckPayloadMaxBytes;
+        QTest::newRow("redirect") << int(CmdId::Redirect) << kAckPayloadMaxBytes;
+        QTest::newRow("stream") << int(CmdId::StreamAck) << kAckPayloadMaxBytes;
+    }
+
+    void ackRoundTrip() {
+        QFETCH(int, cmd);
+        QFETCH(int, size);
+        AckMessage in;
+        in.code = RespCode::Command;
+        in.timestamp = 0x0000018F12345678ULL;
+        in.cmd = CmdId(cmd);
+        in.cmdPayload = in.cmd == CmdId::None ? 0 : pack_stream_ack(3, 1);
+        char buffer[kAckPayloadMaxBytes];
+        QCOMPARE(encode_ack_payload(in, buffer), size);
+        AckMessage out;
+        QVERIFY(decode_ack_payload(buffer, size, &out));
+        QCOMPARE(out.code, in.code);
+        QCOMPARE(out.timestamp, in.timestamp);
+        QCOMPARE(out.cmd, in.cmd);
+        QCOMPARE(out.cmdPayload, in.cmdPayload);
+        QVERIFY(!decode_ack_payload(buffer, size - 1, &out));
+    }
+
+    void streamAckPacking() {
+        constexpr uint32_t packed = pack_stream_ack(0xABCD, 32);
+        static_assert(stream_ack_id(packed) == 0xABCD && stream_ack_credit(packed) == 32);
+        QCOMPARE(packed, 0xABCD0020u);
+    }
+};
+
+QTEST_GUILESS_MAIN(PayloadSchemaTest)
+#include "tst_payload_schema.moc"
@@ -0,0 +1,70 @@
+#include <QtTest/QtTest>
+
+#include <memory>
+
+#include "rate_controller.hpp"
+
+namespace {
+
+constexpr int kTickMs = 20;
+
+RateController::Settings fast_settings() {
+    RateController::Settings settings;
+    settings.tickMs = kTickMs;
+    settings.minIntervalMs = 100;
+    return settings;
+}
+
+}  // namespace
+
+class RateControllerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    // 未启用时定时器不运行，不产生任何采样
+    void disabledDoesNotSample() {
+        RateController controller(std::make_shared<ServerRuntimeConfig>());
+        controller.setSettings(fast_settings());
+        QSignalSpy sampled(&controller, &RateController::loadSampled);
+        QVERIFY(!sampled.wait(5 * kTickMs));
+    }
+
+    // 启用后首个周期即为每个会话下发目标间隔，且不快于最短间隔
+    void pushesTargetWhenEnabled() {
+        auto runtime = std::make_shared<ServerRuntimeConfig>();
+        RateController controller(runtime);
+        controller.setSettings(fast_settings());
+        auto metrics = std::make_shared<SessionMetrics>();
+        controller.addSession(QStringLiteral("s1"), metrics);
+        QSignalSpy changed(&controller, &RateController::intervalChanged);
+
+        controller.setEnabled(true);
+        QVERIFY(runtime->adaptiveInterval.load());
+        QVERIFY(changed.wait(20 * kTickMs));
+        QCOMPARE(changed.first().at(0).toString(), QStringLiteral("s1"));
+        const int intervalMs = changed.first().at(1).toInt();
+        QVERIFY(intervalMs >= 100);
+        QCOMPARE(metrics->targetIntervalMs.load(), intervalMs);
+    }
+
+    // 关闭后停止采样并清除各会话的目标，ACK回到固定间隔或不带间隔
+    void disableStopsSampling() {
+        auto runtime = std::make_shared<ServerRuntimeConfig>();
+        RateController controller(runtime);
+        controller.setSettings(fast_settings());
+        auto metrics = std::make_shared<SessionMetrics>();
+        controller.addSession(QStringLiteral("s1"), metrics);
+        QSignalSpy sampled(&controller, &RateController::loadSampled);
+        controller.setEnabled(true);
+        QVERIFY(sampled.wait(20 * kTickMs));
+
+        controller.setEnabled(false);
+        QVERIFY(!runtime->adaptiveInterval.load());
+        QCOMPARE(metrics->targetIntervalMs.load(), 0);
+        sampled.clear();
+        QVERIFY(!sampled.wait(5 * kTickMs));
+    }
+};
+
+QTEST_GUILESS_MAIN(RateControllerTest)
+#include "tst_rate_controller.moc"
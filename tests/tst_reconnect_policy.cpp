@@ -0,0 +1,106 @@
+#include <QtTest/QtTest>
+
+#include <limits>
+#include <set>
+
+#include "reconnect_policy.hpp"
+
+namespace {
+
+constexpr int kTrials = 200;
+
+}  // namespace
+
+class ReconnectPolicyTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void defaults() {
+        const ReconnectPolicy policy;
+        QCOMPARE(policy.baseMs(), ReconnectPolicy::kDefaultBaseMs);
+        QCOMPARE(policy.maxMs(), ReconnectPolicy::kDefaultMaxMs);
+        QCOMPARE(policy.attempts(), 0);
+    }
+
+    // 基数至少1毫秒，上限不小于基数
+    void clampsBackoff() {
+        ReconnectPolicy policy;
+        policy.setBackoff(0, -5);
+        QCOMPARE(policy.baseMs(), 1);
+        QCOMPARE(policy.maxMs(), 1);
+        policy.setBackoff(100, 50);
+        QCOMPARE(policy.baseMs(), 100);
+        QCOMPARE(policy.maxMs(), 100);
+    }
+
+    // 第n次失败的等待落在[0, min(maxMs, baseMs·2^n)]内，且在区间内散开而不是集中在某个值
+    void fullJitterWithinCeiling() {
+        ReconnectPolicy policy;
+        policy.setBackoff(100, 1000);
+        constexpr int kAttempts = 8;
+        std::set<int> capped;
+        int low = 0;
+        for (int trial = 0; trial < kTrials; ++trial) {
+            policy.reset();
+            for (int n = 0; n < kAttempts; ++n) {
+                const int ceiling = qMin(1000, 100 << n);
+                const int delay = policy.nextDelayMs();
+                QVERIFY2(delay >= 0 && delay <= ceiling, qPrintable(QStringLiteral("%1: %2").arg(n).arg(delay)));
+                QCOMPARE(policy.attempts(), n + 1);
+                if (ceiling == 1000) {
+                    capped.insert(delay);
+                    low += delay < 500 ? 1 : 0;
+                }
+            }
+        }
+        // 达到上限后的样本覆盖整个区间的两半
+        const int samples = kTrials * (kAttempts - 4);
+        QVERIFY2(capped.size() > 100, qPrintable(QString::number(capped.size())));
+        QVERIFY2(low > samples / 4 && low < samples * 3 / 4, qPrintable(QString::number(low)));
+    }
+
+    // 失败次数很大或上限很大时位移不溢出
+    void largeAttemptsDoNotOverflow() {
+        ReconnectPolicy policy;
+        policy.setBackoff(100000, std::numeric_limits<int>::max());
+        for (int n = 0; n < 64; ++n) {
+            QVERIFY(policy.nextDelayMs() >= 0);
+        }
+        QCOMPARE(policy.attempts(), 64);
+    }
+
+    // RetryAfter只作用于下一次重连，原样采用且计入失败次数，之后恢复指数退避
+    void retryAfterOverridesOnce() {
+        ReconnectPolicy policy;
+        policy.setBackoff(10, 40);
+        policy.setRetryAfter(55);
+        QCOMPARE(policy.nextDelayMs(), 55);
+        QCOMPARE(policy.attempts(), 1);
+        for (int i = 0; i < 20; ++i) {
+            QVERIFY(policy.nextDelayMs() <= 40);
+        }
+
+        // 取值限制在[0, 2·maxMs]
+        policy.setRetryAfter(-1);
+        QCOMPARE(policy.nextDelayMs(), 0);
+        policy.setRetryAfter(1000000);
+        QCOMPARE(policy.nextDelayMs(), 80);
+    }
+
+    // 连接成功后清零失败次数并丢弃未使用的RetryAfter
+    void resetClearsState() {
+        ReconnectPolicy policy;
+        policy.setBackoff(1, 1000);
+        for (int i = 0; i < 5; ++i) {
+            policy.nextDelayMs();
+        }
+        policy.setRetryAfter(900);
+        policy.reset();
+        QCOMPARE(policy.attempts(), 0);
+        // 第0次的上限即基数
+        QVERIFY(policy.nextDelayMs() <= 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(ReconnectPolicyTest)
+#include "tst_reconnect_policy.moc"
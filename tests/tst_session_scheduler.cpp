@@ -0,0 +1,70 @@
+#include <QtTest/QtTest>
+
+#include <utility>
+#include <vector>
+
+#include "session_scheduler.hpp"
+
+namespace {
+
+using Moves = std::vector<std::pair<std::size_t, int>>;
+using Candidate = SessionScheduler::Candidate;
+
+Candidate on(int thread, double cost, bool movable = true) {
+    Candidate candidate;
+    candidate.thread = thread;
+    candidate.cost = cost;
+    candidate.movable = movable;
+    return candidate;
+}
+
+}  // namespace
+
+class SessionSchedulerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    // 差距未超过阈值，或最忙线程负载低于minBusy时不迁移
+    void staysWhenBalanced() {
+        const SessionScheduler::Settings settings;
+        QVERIFY(SessionScheduler::plan({0.5, 0.45}, {on(0, 0.1), on(0, 0.2)}, settings).empty());
+        QVERIFY(SessionScheduler::plan({0.15, 0.0}, {on(0, 0.1)}, settings).empty());
+        QVERIFY(SessionScheduler::plan({0.9}, {on(0, 0.5)}, settings).empty());
+    }
+
+    // 选开销小于差距且最接近差距一半的会话，只从最忙线程移到最闲线程
+    void picksCostNearestHalfGap() {
+        const SessionScheduler::Settings settings;
+        const std::vector<Candidate> candidates = {on(0, 0.9), on(0, 0.5), on(0, 0.38), on(0, 0.1), on(1, 0.1)};
+        QCOMPARE(SessionScheduler::plan({1.0, 0.2}, candidates, settings), (Moves{{2, 1}}));
+    }
+
+    // 比差距还大的会话不动：移过去只是换一个线程过载
+    void keepsOversizedSession() {
+        const SessionScheduler::Settings settings;
+        QVERIFY(SessionScheduler::plan({1.0, 0.0}, {on(0, 1.0)}, settings).empty());
+        QVERIFY(SessionScheduler::plan({1.0, 0.0}, {on(0, 0.0)}, settings).empty());
+    }
+
+    // 冷却期内的会话不参与
+    void skipsCoolingDown() {
+        const SessionScheduler::Settings settings;
+        QCOMPARE(SessionScheduler::plan({1.0, 0.2}, {on(0, 0.4, false), on(0, 0.1)}, settings), (Moves{{1, 1}}));
+    }
+
+    // 每步按更新后的负载重新选最忙/最闲线程，同一会话不会被选两次，步数受maxMovesPerTick限制
+    void spreadsAcrossThreads() {
+        SessionScheduler::Settings settings;
+        settings.maxMovesPerTick = 5;
+        const std::vector<Candidate> candidates = {on(0, 0.3), on(0, 0.3), on(0, 0.3), on(0, 0.3)};
+        QCOMPARE(SessionScheduler::plan({1.2, 0.0, 0.0}, candidates, settings), (Moves{{0, 1}, {1, 2}}));
+
+        settings.maxMovesPerTick = 1;
+        QCOMPARE(SessionScheduler::plan({1.2, 0.0, 0.0}, candidates, settings), (Moves{{0, 1}}));
+        settings.maxMovesPerTick = 0;
+        QVERIFY(SessionScheduler::plan({1.2, 0.0, 0.0}, candidates, settings).empty());
+    }
+};
+
+QTEST_GUILESS_MAIN(SessionSchedulerTest)
+#include "tst_session_scheduler.moc"